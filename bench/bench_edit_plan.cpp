@@ -0,0 +1,143 @@
+// 编辑计划基准：同一段随机的 i / d / s 脚本，对比逐条在活区上执行与编译成计划后一遍执行。
+// 逐条执行时每条命令都要沿链表找到目标行；计划只在行槽数组上模拟，最后沿链表走一遍，
+// 插入后又删除的行和施加在被删除行上的替换不会到达活区
+//
+// 用法: bench_edit_plan [活区行数=10000] [命令条数=20000]
+
+#include "active_zone.h"
+#include "edit_plan.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+struct Edit {
+    char kind;          // 'i'、'd' 或 's'
+    LineNo first;
+    LineNo last;
+    std::string text;   // 插入的文本或替换的旧字符串
+};
+
+struct Random {
+    unsigned long long state;
+    unsigned long long next(unsigned long long range) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 33) % range;
+    }
+};
+
+// 生成在执行时刻都有效的命令：活区行数保持在初始值附近
+std::vector<Edit> makeScript(int lines, int commands) {
+    Random random{ 7 };
+    std::vector<Edit> script;
+    LineNo count = lines;
+    for (int i = 0; i < commands; i++) {
+        Edit edit;
+        unsigned long long roll = random.next(10);
+        LineNo at = 1 + static_cast<LineNo>(random.next(static_cast<unsigned long long>(count)));
+        if (roll < 4 || count < 8) {
+            edit.kind = 'i';
+            edit.first = edit.last = at - 1;
+            edit.text = "inserted line " + std::to_string(i) + " status=new";
+            count++;
+        } else if (roll < 8) {
+            edit.kind = 'd';
+            edit.first = at;
+            edit.last = std::min(count, at + static_cast<LineNo>(random.next(3)));
+            count -= edit.last - edit.first + 1;
+        } else {
+            edit.kind = 's';
+            edit.first = at;
+            edit.last = std::min(count, at + static_cast<LineNo>(random.next(20)));
+            edit.text = roll == 8 ? "status" : "line";
+        }
+        script.push_back(edit);
+    }
+    return script;
+}
+
+void fill(ActiveZone& zone, int lines) {
+    for (int i = 0; i < lines; i++) {
+        std::string text = "line " + std::to_string(i) + " status=ok latency=" + std::to_string(i * 31 % 997) + "ms";
+        zone.appendLine(new Line(text.c_str()));
+    }
+}
+
+std::string contents(const ActiveZone& zone) {
+    std::string text;
+    for (const Line* line = zone.head(); line; line = line->next()) {
+        text += line->getText();
+        text += '\n';
+    }
+    return text;
+}
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    int lines = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int commands = argc > 2 ? std::atoi(argv[2]) : 20000;
+    if (lines <= 0 || commands <= 0) {
+        std::fprintf(stderr, "usage: %s [zone-lines] [commands]\n", argv[0]);
+        return 1;
+    }
+    // 插入可能使行数超过初始值，上限留足余量，两边都不会挤掉开头的行
+    int maxLines = lines + commands;
+    std::vector<Edit> script = makeScript(lines, commands);
+
+    ActiveZone sequential(maxLines);
+    fill(sequential, lines);
+    auto start = std::chrono::steady_clock::now();
+    for (const Edit& edit : script) {
+        if (edit.kind == 'i') {
+            sequential.insert(edit.first, edit.text.c_str());
+        } else if (edit.kind == 'd') {
+            sequential.deleteRange(edit.first, edit.last);
+        } else {
+            sequential.replaceInRange(edit.first, edit.last, edit.text, "LINE", false);
+        }
+    }
+    double sequentialTime = seconds(start);
+
+    ActiveZone planned(maxLines);
+    fill(planned, lines);
+    start = std::chrono::steady_clock::now();
+    EditPlan plan(planned.startLineNo(), planned.lineCount(), planned.maxLines());
+    for (const Edit& edit : script) {
+        if (edit.kind == 'i') {
+            plan.insert(edit.first, edit.text);
+        } else if (edit.kind == 'd') {
+            plan.erase(edit.first, edit.last);
+        } else {
+            plan.substitute(edit.first, edit.last, edit.text, "LINE", false);
+        }
+    }
+    double compileTime = seconds(start);
+    start = std::chrono::steady_clock::now();
+    planned.apply(plan);
+    double applyTime = seconds(start);
+
+    if (contents(sequential) != contents(planned)) {
+        std::fprintf(stderr, "plan result differs from sequential execution\n");
+        return 1;
+    }
+
+    std::printf("%d lines, %d commands -> %d lines\n", lines, commands, planned.lineCount());
+    std::printf("sequential     %8.2f ms\n", sequentialTime * 1000.0);
+    std::printf("plan compile   %8.2f ms\n", compileTime * 1000.0);
+    std::printf("plan apply     %8.2f ms\n", applyTime * 1000.0);
+    std::printf("plan total     %8.2f ms  (%.1fx)\n", (compileTime + applyTime) * 1000.0,
+                sequentialTime / (compileTime + applyTime));
+    std::printf("dropped: %zu inserted lines, %zu substitutions on deleted lines\n",
+                plan.droppedInserts(), plan.droppedSubstitutions());
+    return 0;
+}
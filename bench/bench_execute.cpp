@@ -0,0 +1,105 @@
+// 命令执行开销基准：在 1000 行的活区上反复验证并执行一组典型的脚本命令，
+// 分别报告不取消息（脚本模式）和每条都格式化消息（交互模式）时每条命令的耗时，
+// 以及行号越界时抛出异常的 validate 与返回 ParseError 的 validate 的耗时
+//
+// 用法: bench_execute [命令条数=1000000]
+
+#include "command_executor.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+const int ZONE_LINES = 1000;
+
+// 插入和删除成对出现，活区行数保持不变；s3@zzz@ 找不到内容，走失败路径
+const char* const SAMPLES[] = {
+    "i10 inserted line of ordinary length",
+    "d11",
+    "s17@timeout@timeout@",
+    "s3@zzz@y@",
+    "mERROR disk",
+    "d100 101",
+    "i99 line one",
+    "i100 line two",
+    "m~1timeuot",
+};
+
+template <typename Step>
+void run(const char* name, long count, Step step) {
+    size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < count; i++) {
+        checksum += step(static_cast<size_t>(i));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-16s %8.1f ns/command  (checksum %zu)\n", name, seconds * 1e9 / count, checksum);
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    long count = argc > 1 ? std::atol(argv[1]) : 1000000;
+    if (count <= 0) {
+        std::fprintf(stderr, "usage: %s [commands]\n", argv[0]);
+        return 1;
+    }
+
+    ActiveZone zone(ZONE_LINES * 2);
+    for (int i = 0; i < ZONE_LINES; i++) {
+        std::string text = "2024-05-01T12:00:00 host" + std::to_string(i % 64) + " status=ok";
+        text += i % 50 == 0 ? " ERROR disk timeout" : " latency=" + std::to_string(i * 31 % 997) + "ms";
+        zone.appendLine(new Line(text.c_str()));
+    }
+    FileManager fileMgr;
+    CommandExecutor executor(zone, fileMgr);
+    CommandParser parser;
+
+    std::vector<Command> commands;
+    for (const char* sample : SAMPLES) {
+        commands.push_back(parser.parse(sample));
+    }
+    const size_t kinds = commands.size();
+    std::printf("%ld commands, %zu kinds, %d lines\n", count, kinds, ZONE_LINES);
+
+    auto execute = [&](const Command& cmd) {
+        ParseError invalid;
+        if (!parser.validate(cmd, zone.startLineNo(), zone.startLineNo() + zone.lineCount() - 1, invalid)) {
+            return ExecutionResult::failure(invalid.code, ResultKind::ERROR_TEXT);
+        }
+        return executor.execute(cmd);
+    };
+    run("status only", count, [&](size_t i) {
+        ExecutionResult result = execute(commands[i % kinds]);
+        return static_cast<size_t>(result.ok()) + result.count;
+    });
+    std::string message;
+    run("with message", count, [&](size_t i) {
+        const Command& cmd = commands[i % kinds];
+        ExecutionResult result = execute(cmd);
+        message.clear();
+        result.appendMessage(cmd, message);
+        return message.size();
+    });
+
+    Command outside = parser.parse("d5000");
+    run("validate throw", count, [&](size_t) -> size_t {
+        try {
+            parser.validate(outside, zone.startLineNo(), zone.lineCount());
+            return 0;
+        } catch (const EditorException& e) {
+            return static_cast<size_t>(e.code());
+        }
+    });
+    run("validate status", count, [&](size_t) {
+        ParseError invalid;
+        parser.validate(outside, zone.startLineNo(), zone.lineCount(), invalid);
+        return static_cast<size_t>(invalid.code);
+    });
+    return 0;
+}
@@ -0,0 +1,93 @@
+// 全文件并行查找基准：在映射的文件上按 1、2、4 ... 个线程查找，报告吞吐量和加速比
+//   - 字面量（SIMD 子串查找）、带必需字面量的正则、多模式自动机三种匹配方式
+//   - 默认生成临时文件；给出路径时直接查找该文件（例如放在真实磁盘上的大文件）
+//
+// 用法: bench_file_search [文件MB=256] [最大线程数=硬件线程数] [文件路径]
+
+#include "file_search.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+bool writeSample(const std::string& path, size_t megabytes) {
+    std::ofstream out(path, std::ios::binary);
+    std::string line;
+    unsigned long long written = 0;
+    for (unsigned long long i = 0; written < megabytes * 1024ULL * 1024ULL; i++) {
+        line = "2024-05-01T12:00:00 host" + std::to_string(i % 64) + " status=ok latency=" +
+               std::to_string(i * 31 % 997) + "ms";
+        if (i % 5000 == 0) {
+            line += " ERROR disk timeout";
+        }
+        line += '\n';
+        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+        written += line.size();
+    }
+    return static_cast<bool>(out);
+}
+
+template <typename Matcher>
+void bench(const char* name, const MappedFile& file, const Matcher& matcher, unsigned maxThreads) {
+    double gigabytes = static_cast<double>(file.size()) / (1024.0 * 1024.0 * 1024.0);
+    double single = 0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        ParallelSearchOptions options;
+        options.threads = threads;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<LineNo> lines = findLinesParallel(file.data(), file.size(), matcher, options);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (threads == 1) {
+            single = seconds;
+        }
+        std::printf("%-8s %3u threads  %8.2f GB/s  speedup %5.2fx  (%zu lines)\n",
+                    name, threads, gigabytes / seconds, single / seconds, lines.size());
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 256;
+    unsigned maxThreads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2]))
+                                   : std::thread::hardware_concurrency();
+    std::string path = argc > 3 ? argv[3] : "";
+    if (megabytes == 0 || maxThreads == 0) {
+        std::fprintf(stderr, "usage: %s [file-MB] [max-threads] [file]\n", argv[0]);
+        return 1;
+    }
+
+    bool generated = path.empty();
+    if (generated) {
+        const char* dir = std::getenv("TMPDIR");
+        path = std::string(dir ? dir : "/tmp") + "/bench_file_search.txt";
+        if (!writeSample(path, megabytes)) {
+            std::fprintf(stderr, "cannot write %s\n", path.c_str());
+            return 1;
+        }
+    }
+
+    MappedFile file;
+    if (!file.open(path)) {
+        std::fprintf(stderr, "cannot map %s\n", path.c_str());
+        return 1;
+    }
+    std::printf("%s: %.1f MB\n", path.c_str(), static_cast<double>(file.size()) / (1024.0 * 1024.0));
+
+    bench("literal", file, Searcher("ERROR disk"), maxThreads);
+    bench("regex", file, Regex("ERROR \\w+ timeout$"), maxThreads);
+    bench("multi", file, MultiSearcher({ "ERROR", "FATAL", "panic" }), maxThreads);
+
+    file.close();
+    if (generated) {
+        std::remove(path.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+// 近似查找基准：同一个文件上对比精确查找与编辑距离 k = 1、2、3 的近似查找
+//   - 整文件并行路径（findLinesParallel，片段预过滤 + 候选行位并行比对）
+//   - 活区块链路径（逐行查片段再比对），以及关闭预过滤时纯位并行比对的吞吐量
+//
+// 用法: bench_fuzzy_search [文件MB=64] [线程数=硬件线程数]
+
+#include "file_search.h"
+#include "line.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+std::string sample(size_t megabytes) {
+    std::string data;
+    for (unsigned long long i = 0; data.size() < megabytes * 1024ULL * 1024ULL; i++) {
+        data += "2024-05-01T12:00:00 host" + std::to_string(i % 64) + " status=ok latency=" +
+                std::to_string(i * 31 % 997) + "ms";
+        if (i % 5000 == 0) {
+            data += " ERROR disk timeout while flushing";
+        } else if (i % 5000 == 2500) {
+            data += " ERROR dsk timeuot while flushing";      // 损坏的记录
+        }
+        data += '\n';
+    }
+    return data;
+}
+
+template <typename Matcher>
+double timeFile(const std::string& data, const Matcher& matcher, unsigned threads, size_t& found) {
+    ParallelSearchOptions options;
+    options.threads = threads;
+    auto start = std::chrono::steady_clock::now();
+    found = findLinesParallel(data.data(), data.size(), matcher, options).size();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Match>
+double timeLines(const std::vector<Line*>& lines, Match match, size_t& found) {
+    auto start = std::chrono::steady_clock::now();
+    found = 0;
+    for (const Line* line : lines) {
+        found += match(line) ? 1 : 0;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 64;
+    unsigned threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2]))
+                                : std::thread::hardware_concurrency();
+    if (megabytes == 0) {
+        std::fprintf(stderr, "usage: %s [file-MB] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    const std::string pattern = "disk timeout while";
+    std::string data = sample(megabytes);
+    double gigabytes = static_cast<double>(data.size()) / (1024.0 * 1024.0 * 1024.0);
+    std::printf("%.1f MB, pattern '%s', %u threads\n", static_cast<double>(data.size()) / (1024.0 * 1024.0),
+                pattern.c_str(), threads);
+
+    size_t found = 0;
+    double exact = timeFile(data, Searcher(pattern), threads, found);
+    std::printf("file  exact     %8.2f GB/s  (%zu lines)\n", gigabytes / exact, found);
+    for (int k = 1; k <= 3; k++) {
+        double seconds = timeFile(data, FuzzySearcher(pattern, k), threads, found);
+        std::printf("file  k=%d       %8.2f GB/s  %5.2fx exact  (%zu lines)\n",
+                    k, gigabytes / seconds, seconds / exact, found);
+    }
+
+    // 活区路径：按行建块链，取前 1/8 的数据
+    std::vector<Line*> lines;
+    size_t limit = data.size() / 8;
+    for (size_t start = 0; start < limit;) {
+        size_t end = data.find('\n', start);
+        lines.push_back(new Line(data.substr(start, end - start).c_str()));
+        start = end + 1;
+    }
+    double zoneGigabytes = static_cast<double>(limit) / (1024.0 * 1024.0 * 1024.0);
+    Searcher searcher(pattern);
+    double zoneExact = timeLines(lines, [&](const Line* line) { return searcher.matches(line->head()); }, found);
+    std::printf("zone  exact     %8.2f GB/s  (%zu lines)\n", zoneGigabytes / zoneExact, found);
+    for (int k = 1; k <= 3; k++) {
+        FuzzySearcher fuzzy(pattern, k);
+        double seconds = timeLines(lines, [&](const Line* line) { return fuzzy.matches(line->head()); }, found);
+        std::printf("zone  k=%d       %8.2f GB/s  %5.2fx exact  (%zu lines)\n",
+                    k, zoneGigabytes / seconds, seconds / zoneExact, found);
+    }
+    FuzzySearcher unfiltered(pattern, 2);
+    double seconds = timeLines(lines, [&](const Line* line) { return unfiltered.verify(line->head()); }, found);
+    std::printf("zone  k=2 bitpar %7.2f GB/s  %5.2fx exact  (%zu lines, no prefilter)\n",
+                zoneGigabytes / seconds, seconds / zoneExact, found);
+
+    for (Line* line : lines) {
+        delete line;
+    }
+    return 0;
+}
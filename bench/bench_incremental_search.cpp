@@ -0,0 +1,98 @@
+// 边输入边查找基准：在 10 万行的活区上逐键输入模式再逐键删除，
+// 报告每次按键的平均和最长耗时，并与每次按键都重新扫描整个活区对比
+//
+// 用法: bench_incremental_search [活区行数=100000] [模式="ERROR disk timeout"]
+
+#include "incremental_search.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace line_editor;
+
+namespace {
+
+struct Timing {
+    double total = 0;
+    double worst = 0;
+    int keys = 0;
+
+    void add(double seconds) {
+        total += seconds;
+        worst = std::max(worst, seconds);
+        keys++;
+    }
+    void print(const char* name) const {
+        std::printf("%-12s %4d keys  avg %8.3f ms  max %8.3f ms\n",
+                    name, keys, total / keys * 1000.0, worst * 1000.0);
+    }
+};
+
+// 不用缓存，每次按键扫描整个活区
+size_t fullScan(const ActiveZone& zone, const std::string& pattern) {
+    Searcher searcher(pattern);
+    size_t hits = 0;
+    for (const Line* line = zone.head(); line; line = line->next()) {
+        hits += searcher.matches(line->head(), line->isAscii()) ? 1 : 0;
+    }
+    return hits;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    int lines = argc > 1 ? std::atoi(argv[1]) : 100000;
+    std::string pattern = argc > 2 ? argv[2] : "ERROR disk timeout";
+    if (lines <= 0 || pattern.empty()) {
+        std::fprintf(stderr, "usage: %s [zone-lines] [pattern]\n", argv[0]);
+        return 1;
+    }
+
+    ActiveZone zone(lines);
+    for (int i = 0; i < lines; i++) {
+        std::string text = "2024-05-01T12:00:00 host" + std::to_string(i % 64) + " status=ok latency=" +
+                           std::to_string(i * 31 % 997) + "ms";
+        if (i % 50 == 0) {
+            text += " ERROR disk timeout";
+        } else if (i % 10 == 0) {
+            text += " ERROR retry";
+        }
+        zone.appendLine(new Line(text.c_str()));
+    }
+    std::printf("%d lines, pattern '%s'\n", lines, pattern.c_str());
+
+    IncrementalSearch search(zone);
+    Timing incremental;
+    Timing rescan;
+    size_t hits = 0;
+    auto key = [&](const std::string& typed, bool erase) {
+        auto start = std::chrono::steady_clock::now();
+        hits = (erase ? search.backspace() : search.type(typed.back())).size();
+        incremental.add(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        start = std::chrono::steady_clock::now();
+        size_t expected = typed.empty() ? 0 : fullScan(zone, typed);
+        rescan.add(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        if (expected != hits) {
+            std::fprintf(stderr, "mismatch at '%s': %zu vs %zu\n", typed.c_str(), hits, expected);
+            std::exit(1);
+        }
+    };
+
+    std::string typed;
+    for (char c : pattern) {
+        typed += c;
+        key(typed, false);
+    }
+    std::printf("'%s': %zu lines\n", typed.c_str(), hits);
+    while (!typed.empty()) {
+        typed.pop_back();
+        key(typed, true);
+    }
+
+    incremental.print("incremental");
+    rescan.print("rescan");
+    return 0;
+}
@@ -0,0 +1,138 @@
+// 多模式查找基准：Aho-Corasick 自动机与逐个 Searcher 依次查找比较
+//   - 构建时间：一个自动机 vs N 个预编译的 Searcher
+//   - 扫描吞吐：活区逐行（块链）和整块缓冲，报告每秒扫描的字节数
+//
+// 用法: bench_multi_search [行长=200] [轮数=200] [缓冲MB=16]
+
+#include "active_zone.h"
+#include "line.h"
+#include "multi_search.h"
+#include "text_search.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+std::string fillerLine(int seed, size_t length) {
+    std::string text;
+    while (text.size() < length) {
+        text += "status=ok latency=" + std::to_string((seed * 31 + text.size()) % 997) + "ms ";
+    }
+    text.resize(length);
+    return text;
+}
+
+// 形如 ERR-00042 的错误码，填充文本中不会出现
+std::vector<std::string> makeCodes(size_t count) {
+    std::vector<std::string> codes;
+    for (size_t i = 0; i < count; i++) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "ERR-%05zu", i * 7919 % 100000);
+        codes.push_back(buf);
+    }
+    return codes;
+}
+
+template <typename Fn>
+double timeIt(int rounds, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        fn();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void bench(size_t patternCount, size_t lineLength, int rounds, size_t megabytes) {
+    std::vector<std::string> codes = makeCodes(patternCount);
+
+    std::unique_ptr<MultiSearcher> automaton;
+    double buildAc = timeIt(1, [&] { automaton.reset(new MultiSearcher(codes)); });
+    std::vector<std::unique_ptr<Searcher>> singles;
+    double buildSingles = timeIt(1, [&] {
+        for (const std::string& code : codes) {
+            singles.emplace_back(new Searcher(code));
+        }
+    });
+
+    // 活区：每 10 行放一个错误码
+    ActiveZone zone;
+    size_t zoneBytes = 0;
+    for (int i = 0; i < DEFAULT_MAX_LINES; i++) {
+        std::string text = fillerLine(i, lineLength);
+        if (i % 10 == 0) {
+            text.replace(lineLength / 2, codes[i % codes.size()].size(), codes[i % codes.size()]);
+        }
+        zoneBytes += text.size();
+        zone.appendLine(new Line(text.c_str()));
+    }
+
+    size_t hits = 0;
+    double zoneAc = timeIt(rounds, [&] { hits += zone.findPatterns(*automaton).size(); });
+    double zoneSingles = timeIt(rounds, [&] {
+        for (const auto& searcher : singles) {
+            hits += zone.findPattern(*searcher).size();
+        }
+    });
+
+    std::string buffer;
+    for (int i = 0; buffer.size() < megabytes * 1024 * 1024; i++) {
+        std::string line = fillerLine(i, 120);
+        if (i % 100 == 0) {
+            line.replace(40, 9, codes[i % codes.size()]);
+        }
+        buffer += line;
+        buffer += '\n';
+    }
+    std::vector<size_t> found;
+    double bufAc = timeIt(1, [&] {
+        automaton->matchedPatterns(buffer.data(), buffer.size(), found);
+    });
+    // 两边都扫描整个缓冲：逐个模式时找出每个模式的全部出现
+    double bufSingles = timeIt(1, [&] {
+        for (const auto& searcher : singles) {
+            size_t offset = 0;
+            while (offset < buffer.size()) {
+                size_t pos = searcher->find(buffer.data() + offset, buffer.size() - offset);
+                if (pos == SEARCH_NOT_FOUND) break;
+                hits++;
+                offset += pos + 1;
+            }
+        }
+    });
+
+    double zoneMb = static_cast<double>(zoneBytes) * rounds / (1024.0 * 1024.0);
+    double bufMb = static_cast<double>(buffer.size()) / (1024.0 * 1024.0);
+    std::printf("%5zu patterns  build AC %8.3f ms (%6zu states)  singles %8.3f ms\n",
+                patternCount, buildAc * 1000.0, automaton->stateCount(), buildSingles * 1000.0);
+    std::printf("               zone   AC %8.1f MB/s  singles %8.1f MB/s\n",
+                zoneMb / zoneAc, zoneMb / zoneSingles);
+    std::printf("               buffer AC %8.1f MB/s  singles %8.1f MB/s\n",
+                bufMb / bufAc, bufMb / bufSingles);
+    if (hits == 0) {
+        std::printf("  (no hits)\n");
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    size_t lineLength = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 200;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 200;
+    size_t megabytes = argc > 3 ? static_cast<size_t>(std::atoi(argv[3])) : 16;
+    if (lineLength < 20 || rounds <= 0 || megabytes == 0) {
+        std::fprintf(stderr, "usage: %s [line-length>=20] [rounds] [buffer-MB]\n", argv[0]);
+        return 1;
+    }
+
+    size_t counts[] = { 1, 4, 16, 64, 256, 1024 };
+    for (size_t count : counts) {
+        bench(count, lineLength, rounds, megabytes);
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+// 页缓存污染基准：分别用普通读写和 --bypass-cache 模式改写同一个大文件，
+// 报告吞吐量以及输入、输出文件在页缓存中的驻留比例。
+//
+// 用法: bench_page_cache [大小MB=256] [目录=$TMPDIR]
+
+#include "file_manager.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace line_editor;
+
+namespace {
+
+std::string tempDir() {
+    const char* dirs[] = { "TMPDIR", "TEMP", "TMP" };
+    for (const char* name : dirs) {
+        const char* value = std::getenv(name);
+        if (value) return value;
+    }
+#ifdef _WIN32
+    return ".";
+#else
+    return "/tmp";
+#endif
+}
+
+// 文件在页缓存中的驻留比例，平台不支持时返回 -1
+double residentRatio(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return -1;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return -1;
+
+    long pageSize = ::sysconf(_SC_PAGESIZE);
+    size_t pages = (size + pageSize - 1) / pageSize;
+#ifdef __APPLE__
+    std::vector<char> vec(pages);
+#else
+    std::vector<unsigned char> vec(pages);
+#endif
+    double ratio = -1;
+    if (::mincore(addr, size, vec.data()) == 0) {
+        size_t resident = 0;
+        for (auto v : vec) {
+            resident += (v & 1);
+        }
+        ratio = static_cast<double>(resident) / pages;
+    }
+    ::munmap(addr, size);
+    return ratio;
+#else
+    (void)path;
+    return -1;
+#endif
+}
+
+// 把文件写回磁盘并从页缓存中逐出，让每轮都从冷缓存开始
+void evict(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    ::fsync(fd);
+#ifdef POSIX_FADV_DONTNEED
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    ::close(fd);
+#else
+    (void)path;
+#endif
+}
+
+void generate(const std::string& path, long long megabytes) {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    std::string line;
+    long long target = megabytes * 1024 * 1024;
+    long long written = 0;
+    for (long long i = 0; written < target; i++) {
+        line = "2024-01-01T00:00:00Z host-" + std::to_string(i % 97) +
+               " request=" + std::to_string(i) + " status=200 bytes=" +
+               std::to_string((i * 7919) % 100000) + "\n";
+        ofs << line;
+        written += static_cast<long long>(line.size());
+    }
+}
+
+std::string percent(double ratio) {
+    if (ratio < 0) return "n/a";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f%%", ratio * 100);
+    return buf;
+}
+
+// 逐行读入、写出，模拟夜间改写任务
+void rewrite(const std::string& input, const std::string& output, bool bypass,
+             long long megabytes) {
+    evict(input);
+    std::remove(output.c_str());
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        FileManager fm;
+        fm.setCacheBypass(bypass);
+        fm.openInput(input);
+        fm.openOutput(output);
+
+        std::vector<std::string> lines;
+        while (fm.readLines(lines, 4096) > 0) {
+            fm.writeLines(lines);
+        }
+        fm.close();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-10s %8.2f s %9.1f MB/s   input cached %7s   output cached %7s\n",
+                bypass ? "bypass" : "buffered", seconds, megabytes / seconds,
+                percent(residentRatio(input)).c_str(),
+                percent(residentRatio(output)).c_str());
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    long long megabytes = argc > 1 ? std::atoll(argv[1]) : 256;
+    std::string dir = argc > 2 ? argv[2] : tempDir();
+    if (megabytes <= 0) {
+        std::cerr << "usage: " << argv[0] << " [size-MB] [directory]\n";
+        return 1;
+    }
+
+    std::string input = dir + "/line_editor_bench_in.txt";
+    std::string output = dir + "/line_editor_bench_out.txt";
+
+    std::printf("generating %lld MB in %s\n", megabytes, dir.c_str());
+    generate(input, megabytes);
+
+    rewrite(input, output, false, megabytes);
+    rewrite(input, output, true, megabytes);
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+    return 0;
+}
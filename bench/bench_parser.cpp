@@ -0,0 +1,98 @@
+// 命令解析基准：反复解析一组典型的脚本命令，报告每秒解析的命令数和每条命令的堆分配次数。
+// tryParse 只产生指向输入的视图；parse 还要把结果复制成带 std::string 的 Command
+//
+// 用法: bench_parser [命令条数=2000000]
+
+#include "command_parser.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+size_t allocations = 0;
+
+const char* const SAMPLES[] = {
+    "i120 inserted line of ordinary length",
+    "d42",
+    "d100 250",
+    "s17@timeout@deadline@g",
+    "s3 9@http:@https:@",
+    "mERROR disk",
+    "m/err(or)?\\/[0-9]+/i",
+    "m|alpha|beta|gam\\|ma",
+    "m~2connection",
+    "M/^2024-05/",
+    "g1048576",
+    "p3",
+    "n",
+    "dx",
+};
+
+template <typename Parse>
+void run(const char* name, const std::vector<std::string>& script, Parse parse) {
+    size_t checksum = 0;
+    size_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& line : script) {
+        checksum += parse(line);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-10s %10.0f commands/s  %5.2f allocations/command  (checksum %zu)\n",
+                name, script.size() / seconds,
+                static_cast<double>(allocations - before) / script.size(), checksum);
+}
+
+} // anonymous namespace
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+int main(int argc, char* argv[]) {
+    long count = argc > 1 ? std::atol(argv[1]) : 2000000;
+    if (count <= 0) {
+        std::fprintf(stderr, "usage: %s [commands]\n", argv[0]);
+        return 1;
+    }
+
+    const size_t kinds = sizeof(SAMPLES) / sizeof(SAMPLES[0]);
+    std::vector<std::string> script;
+    script.reserve(static_cast<size_t>(count));
+    for (long i = 0; i < count; i++) {
+        script.emplace_back(SAMPLES[static_cast<size_t>(i) % kinds]);
+    }
+    std::printf("%ld commands, %zu kinds\n", count, kinds);
+
+    CommandParser parser;
+    run("tryParse", script, [&](const std::string& line) {
+        ParseResult result = parser.tryParse(line);
+        return result.ok() ? static_cast<size_t>(result.command.lineNo) + result.command.pattern.size() : 1;
+    });
+    run("parse", script, [&](const std::string& line) -> size_t {
+        try {
+            Command cmd = parser.parse(line);
+            return static_cast<size_t>(cmd.lineNo) + cmd.pattern.size();
+        } catch (const EditorException&) {
+            return 1;
+        }
+    });
+    return 0;
+}
@@ -0,0 +1,108 @@
+// 正则查找基准：惰性 DFA 引擎与 std::regex 在同一批日志行上比较，
+// 另外测量回溯引擎的病态模式在长行上的耗时。
+//
+// 用法: bench_regex [行数=100000]
+
+#include "regex_engine.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+std::vector<std::string> makeLines(int count) {
+    const char* levels[] = { "INFO", "DEBUG", "WARN", "ERROR" };
+    std::vector<std::string> lines;
+    for (int i = 0; i < count; i++) {
+        std::string line = "2024-05-" + std::to_string(10 + i % 20) + " 12:" +
+            std::to_string(10 + i % 50) + ":" + std::to_string(10 + i % 49) + " " +
+            levels[(i * 7) % 4] + " worker-" + std::to_string(i % 16) +
+            " request id=" + std::to_string(i * 2654435761u % 1000000) +
+            " latency=" + std::to_string(i % 997) + "ms";
+        if (i % 50 == 0) {
+            line += " timeout after retry";
+        }
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+template <typename Fn>
+double timeIt(Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchPattern(const std::vector<std::string>& lines, size_t bytes, const char* pattern) {
+    Regex regex(pattern);
+    size_t hits = 0;
+    double dfa = timeIt([&] {
+        for (const std::string& line : lines) {
+            hits += regex.search(line.data(), line.size());
+        }
+    });
+
+    std::regex reference(pattern);
+    size_t refHits = 0;
+    double std = timeIt([&] {
+        for (const std::string& line : lines) {
+            refHits += std::regex_search(line, reference);
+        }
+    });
+
+    double mb = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    std::printf("%-34s hits %7zu  Regex %8.1f MB/s  std::regex %7.1f MB/s  (%zu DFA states)%s\n",
+                pattern, hits, mb / dfa, mb / std, regex.dfaStates(),
+                hits == refHits ? "" : "  (mismatch!)");
+}
+
+void benchHostile(const char* pattern, size_t length) {
+    std::string text(length, 'a');
+    Regex regex(pattern);
+    bool found = false;
+    double seconds = timeIt([&] { found = regex.search(text.data(), text.size()); });
+    std::printf("hostile %-12s on %zu bytes: %8.3f ms (%s)\n",
+                pattern, length, seconds * 1000.0, found ? "match" : "no match");
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+    if (count <= 0) {
+        std::fprintf(stderr, "usage: %s [lines]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> lines = makeLines(count);
+    size_t bytes = 0;
+    for (const std::string& line : lines) {
+        bytes += line.size();
+    }
+    std::printf("%d lines, %.1f MB\n", count, static_cast<double>(bytes) / (1024.0 * 1024.0));
+
+    const char* patterns[] = {
+        "timeout after",
+        "ERROR.*latency=9\\d\\dms",
+        "id=\\d{6} ",
+        "worker-(3|7|11) .*timeout",
+        "^2024-05-1\\d 12:3\\d",
+        "(WARN|ERROR) worker-\\d+ request",
+    };
+    for (const char* pattern : patterns) {
+        benchPattern(lines, bytes, pattern);
+    }
+
+    std::printf("\n");
+    benchHostile("(a*)*b", 1 << 20);
+    benchHostile("(a|aa)*c", 1 << 20);
+    benchHostile("^(a+)+$", 1 << 20);
+
+    return 0;
+}
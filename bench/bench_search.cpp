@@ -0,0 +1,174 @@
+// 子串查找基准：在不同模式长度和命中率下比较
+//   - 活区逐行：getText() + std::string::find、Line::contains、预编译的 Searcher、
+//     不区分大小写的 Searcher（纯 ASCII 行走向量折叠）
+//   - 整块缓冲（模拟整文件扫描）：std::string::find 与 Searcher（区分/不区分大小写）
+// 报告每秒扫描的字节数。
+//
+// 用法: bench_search [行长=400] [轮数=500] [缓冲MB=64]
+
+#include "active_zone.h"
+#include "line.h"
+#include "text_search.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace line_editor;
+
+namespace {
+
+// 不含模式首字节以外字母的填充文本，命中只来自人为放置的模式
+std::string fillerLine(int seed, size_t length) {
+    std::string text;
+    while (text.size() < length) {
+        text += "status=ok latency=" + std::to_string((seed * 31 + text.size()) % 997) + "ms ";
+    }
+    text.resize(length);
+    return text;
+}
+
+// 长度为 len 的模式，以 'Q' 开头保证填充文本中不会出现
+std::string makePattern(size_t len) {
+    std::string pattern = "Q";
+    const char* body = "uery-timeout-on-replica-set-primary-node-after-retry-";
+    while (pattern.size() < len) {
+        pattern += body[(pattern.size() - 1) % std::strlen(body)];
+    }
+    pattern.resize(len);
+    return pattern;
+}
+
+template <typename Fn>
+double timeRounds(int rounds, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        fn();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchZone(size_t lineLength, int rounds, size_t patternLen, int hitPercent) {
+    std::string pattern = makePattern(patternLen);
+    ActiveZone zone;
+    size_t bytes = 0;
+    for (int i = 0; i < DEFAULT_MAX_LINES; i++) {
+        std::string text = fillerLine(i, lineLength);
+        if (i % 100 < hitPercent && text.size() > pattern.size() + 80) {
+            // 放在第一个块边界附近，覆盖跨块匹配
+            text.replace(80 - pattern.size() / 2, pattern.size(), pattern);
+        }
+        bytes += text.size();
+        zone.appendLine(new Line(text.c_str()));
+    }
+
+    size_t hits = 0;
+    double copyFind = timeRounds(rounds, [&] {
+        for (Line* line = zone.head(); line; line = line->next()) {
+            hits += line->getText().find(pattern) != std::string::npos;
+        }
+    });
+    double contains = timeRounds(rounds, [&] {
+        for (Line* line = zone.head(); line; line = line->next()) {
+            hits += line->contains(pattern.c_str());
+        }
+    });
+    Searcher searcher(pattern);
+    double compiled = timeRounds(rounds, [&] {
+        hits += zone.findPattern(searcher).size();
+    });
+    Searcher folded(pattern, true);
+    double ignoreCase = timeRounds(rounds, [&] {
+        hits += zone.findPattern(folded).size();
+    });
+
+    double mb = static_cast<double>(bytes) * rounds / (1024.0 * 1024.0);
+    std::printf("zone   len %3zu hit %3d%%  getText+find %8.1f  contains %8.1f  Searcher %8.1f  /i %8.1f MB/s\n",
+                patternLen, hitPercent, mb / copyFind, mb / contains, mb / compiled, mb / ignoreCase);
+    if (hits == 0 && hitPercent > 0) {
+        std::printf("  (no hits found, pattern too long for line length)\n");
+    }
+}
+
+void benchBuffer(size_t megabytes, size_t patternLen, int hitPercent) {
+    std::string pattern = makePattern(patternLen);
+    std::string buffer;
+    buffer.reserve(megabytes * 1024 * 1024);
+    for (int i = 0; buffer.size() < megabytes * 1024 * 1024; i++) {
+        std::string line = fillerLine(i, 120);
+        if (i % 100 < hitPercent) {
+            line.replace(40, pattern.size(), pattern);
+        }
+        buffer += line;
+        buffer += '\n';
+    }
+
+    size_t stdCount = 0;
+    double stdTime = timeRounds(1, [&] {
+        for (size_t pos = buffer.find(pattern); pos != std::string::npos;
+             pos = buffer.find(pattern, pos + 1)) {
+            stdCount++;
+        }
+    });
+
+    Searcher searcher(pattern);
+    size_t count = 0;
+    double searcherTime = timeRounds(1, [&] {
+        size_t offset = 0;
+        while (offset < buffer.size()) {
+            size_t pos = searcher.find(buffer.data() + offset, buffer.size() - offset);
+            if (pos == SEARCH_NOT_FOUND) break;
+            count++;
+            offset += pos + 1;
+        }
+    });
+
+    Searcher folded(pattern, true);
+    size_t foldedCount = 0;
+    double foldedTime = timeRounds(1, [&] {
+        size_t offset = 0;
+        while (offset < buffer.size()) {
+            size_t pos = folded.find(buffer.data() + offset, buffer.size() - offset);
+            if (pos == SEARCH_NOT_FOUND) break;
+            foldedCount++;
+            offset += pos + 1;
+        }
+    });
+
+    double mb = static_cast<double>(buffer.size()) / (1024.0 * 1024.0);
+    std::printf("buffer len %3zu hit %3d%%  string::find %8.1f  Searcher %8.1f  /i %8.1f MB/s%s\n",
+                patternLen, hitPercent, mb / stdTime, mb / searcherTime, mb / foldedTime,
+                count == stdCount && foldedCount == stdCount ? "" : "  (count mismatch!)");
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    size_t lineLength = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 400;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 500;
+    size_t megabytes = argc > 3 ? static_cast<size_t>(std::atoi(argv[3])) : 64;
+    if (lineLength == 0 || rounds <= 0 || megabytes == 0) {
+        std::fprintf(stderr, "usage: %s [line-length] [rounds] [buffer-MB]\n", argv[0]);
+        return 1;
+    }
+
+    size_t lengths[] = { 1, 4, 16, 48 };
+    int hitRates[] = { 0, 10, 100 };
+
+    std::printf("%d lines x %zu bytes, %d rounds\n", DEFAULT_MAX_LINES, lineLength, rounds);
+    for (size_t len : lengths) {
+        for (int rate : hitRates) {
+            benchZone(lineLength, rounds, len, rate);
+        }
+    }
+
+    std::printf("\n%zu MB buffer\n", megabytes);
+    for (size_t len : lengths) {
+        for (int rate : hitRates) {
+            benchBuffer(megabytes, len, rate);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+// 流式替换基准：同一个文件按 1、2、4 ... 个工作线程整体替换，报告吞吐量和加速比
+//   - 输入输出都经过 FileManager，与 --substitute 的路径相同
+//   - 另测一遍纯内存（字符串流）的吞吐量，排除存储带宽的影响
+//
+// 用法: bench_substitute [文件MB=256] [最大线程数=硬件线程数]
+
+#include "file_manager.h"
+#include "stream_substitute.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace line_editor;
+
+namespace {
+
+std::string makeText(size_t megabytes) {
+    std::string text;
+    for (unsigned long long i = 0; text.size() < megabytes * 1024ULL * 1024ULL; i++) {
+        text += "GET http://example.com/item/" + std::to_string(i % 100000) +
+                " status=200 ref=http://example.org/\n";
+    }
+    return text;
+}
+
+template <typename Fn>
+double timeIt(Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 256;
+    unsigned maxThreads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2]))
+                                   : std::thread::hardware_concurrency();
+    if (megabytes == 0 || maxThreads == 0) {
+        std::fprintf(stderr, "usage: %s [file-MB] [max-threads]\n", argv[0]);
+        return 1;
+    }
+
+    const char* dir = std::getenv("TMPDIR");
+    std::string inPath = std::string(dir ? dir : "/tmp") + "/bench_substitute_in.txt";
+    std::string outPath = std::string(dir ? dir : "/tmp") + "/bench_substitute_out.txt";
+    std::string text = makeText(megabytes);
+    {
+        std::ofstream out(inPath, std::ios::binary);
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+    double mb = static_cast<double>(text.size()) / (1024.0 * 1024.0);
+    std::printf("%.1f MB, replacing every \"http:\" with \"https:\"\n", mb);
+
+    double fileSingle = 0;
+    double memorySingle = 0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        SubstituteOptions options;
+        options.threads = threads;
+        options.global = true;
+        StreamSubstituter substituter("http:", "https:", options);
+
+        SubstituteStats stats;
+        double file = timeIt([&] {
+            FileManager fileMgr;
+            fileMgr.openInput(inPath);
+            fileMgr.openOutput(outPath);
+            stats = substituter.run(fileMgr);
+            fileMgr.close();
+        });
+        double memory = timeIt([&] {
+            std::istringstream in(text);
+            std::ostringstream out;
+            substituter.run(in, out);
+        });
+        if (threads == 1) {
+            fileSingle = file;
+            memorySingle = memory;
+        }
+        std::printf("%3u threads  file %8.1f MB/s (%5.2fx)  memory %8.1f MB/s (%5.2fx)  %llu substitutions\n",
+                    threads, mb / file, fileSingle / file, mb / memory, memorySingle / memory,
+                    stats.substitutions);
+    }
+
+    std::remove(inPath.c_str());
+    std::remove(outPath.c_str());
+    return 0;
+}
@@ -0,0 +1,109 @@
+// trigram 索引基准：构建耗时和索引大小，以及同一查询整文件查找与按索引只查候选块的耗时
+//   - 稀有字面量、带必需字面量的正则、常见字面量（索引几乎无法缩小范围）三种查询
+//   - 默认生成临时文件；给出路径时直接使用该文件
+//
+// 用法: bench_trigram_index [文件MB=256] [块KB=1024] [文件路径]
+
+#include "file_search.h"
+#include "trigram_index.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+bool writeSample(const std::string& path, size_t megabytes) {
+    std::ofstream out(path, std::ios::binary);
+    std::string line;
+    unsigned long long written = 0;
+    for (unsigned long long i = 0; written < megabytes * 1024ULL * 1024ULL; i++) {
+        line = "2024-05-01T12:00:00 host" + std::to_string(i % 64) + " status=ok latency=" +
+               std::to_string(i * 31 % 997) + "ms";
+        if (i % 200000 == 0) {
+            line += " ERROR disk timeout";
+        }
+        line += '\n';
+        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+        written += line.size();
+    }
+    return static_cast<bool>(out);
+}
+
+template <typename Fn>
+double timeIt(Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Matcher>
+void bench(const char* name, const MappedFile& file, const TrigramIndex& index, const Matcher& matcher,
+           const std::vector<std::string>& literals, bool ignoreCase) {
+    std::vector<LineNo> full;
+    std::vector<LineNo> indexed;
+    IndexCandidates candidates;
+    double scan = timeIt([&] { full = findLinesParallel(file.data(), file.size(), matcher); });
+    double query = timeIt([&] {
+        candidates = index.candidates(file, literals, ignoreCase);
+        indexed = findLinesParallel(file.data(), candidates.ranges, matcher);
+    });
+    std::printf("%-8s scan %9.2f ms  indexed %9.2f ms (%5.1fx)  %zu/%zu blocks  %zu lines%s\n",
+                name, scan * 1e3, query * 1e3, scan / query, candidates.candidateBlocks,
+                index.blockCount(), indexed.size(), full == indexed ? "" : "  MISMATCH");
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 256;
+    size_t blockKb = argc > 2 ? static_cast<size_t>(std::atoi(argv[2])) : 1024;
+    std::string path = argc > 3 ? argv[3] : "";
+    if (megabytes == 0 || blockKb == 0) {
+        std::fprintf(stderr, "usage: %s [file-MB] [block-KB] [file]\n", argv[0]);
+        return 1;
+    }
+
+    bool generated = path.empty();
+    if (generated) {
+        const char* dir = std::getenv("TMPDIR");
+        path = std::string(dir ? dir : "/tmp") + "/bench_trigram_index.txt";
+        if (!writeSample(path, megabytes)) {
+            std::fprintf(stderr, "cannot write %s\n", path.c_str());
+            return 1;
+        }
+    }
+    std::string indexPath = TrigramIndex::sidecarPath(path);
+
+    double build = timeIt([&] { TrigramIndex::build(path, indexPath, blockKb * 1024); });
+    MappedFile file;
+    TrigramIndex index;
+    if (!file.open(path) || !index.open(indexPath) || !index.usableFor(file)) {
+        std::fprintf(stderr, "cannot open %s or its index\n", path.c_str());
+        return 1;
+    }
+    {
+        std::ifstream in(indexPath, std::ios::binary | std::ios::ate);
+        double mb = static_cast<double>(file.size()) / (1024.0 * 1024.0);
+        double indexMb = static_cast<double>(in.tellg()) / (1024.0 * 1024.0);
+        std::printf("%s: %.1f MB, index %.1f MB (%.1f%%), %zu trigrams, built in %.2f s (%.1f MB/s)\n",
+                    path.c_str(), mb, indexMb, 100.0 * indexMb / mb, index.trigramCount(), build, mb / build);
+    }
+
+    bench("rare", file, index, Searcher("ERROR disk"), { "ERROR disk" }, false);
+    Regex regex("ERROR \\w+ timeout$");
+    bench("regex", file, index, regex, { regex.requiredLiteral() }, false);
+    bench("common", file, index, Searcher("status=ok"), { "status=ok" }, false);
+
+    index.close();
+    file.close();
+    std::remove(indexPath.c_str());
+    if (generated) {
+        std::remove(path.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// 逐活区脚本基准：同一个文件按 1、2、4 ... 个工作线程把脚本应用到每个活区，
+// 报告吞吐量和加速比，并检查各线程数的输出与单线程逐字节相同
+//
+// 用法: bench_zone_script [行数=1000000] [最大线程数=硬件线程数]
+
+#include "file_manager.h"
+#include "zone_script.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace line_editor;
+
+namespace {
+
+// 每个活区都做的整理：删掉表头、改写状态字段、查找错误行并打印
+const char* const SCRIPT =
+    "d1\n"
+    "s1 79@status=200@status=OK@g\n"
+    "s1 79@http:@https:@g\n"
+    "i0 # zone\n"
+    "m/status=5[0-9][0-9]/\n"
+    "d40 41\n"
+    "p\n";
+
+std::string makeText(int lines) {
+    std::string text;
+    for (int i = 0; i < lines; i++) {
+        text += "GET http://example.com/item/" + std::to_string(i % 100000) + " status=" +
+                (i % 37 == 0 ? "503" : "200") + " ref=http://example.org/\n";
+    }
+    return text;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    int lines = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    unsigned maxThreads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2]))
+                                   : std::thread::hardware_concurrency();
+    if (lines <= 0 || maxThreads == 0) {
+        std::fprintf(stderr, "usage: %s [lines] [max-threads]\n", argv[0]);
+        return 1;
+    }
+
+    const char* dir = std::getenv("TMPDIR");
+    std::string inPath = std::string(dir ? dir : "/tmp") + "/bench_zone_script_in.txt";
+    std::string outPath = std::string(dir ? dir : "/tmp") + "/bench_zone_script_out.txt";
+    {
+        std::string text = makeText(lines);
+        std::ofstream out(inPath, std::ios::binary);
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    std::string expectedData;
+    std::string expectedResults;
+    double single = 0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        ZoneScriptOptions options;
+        options.threads = threads;
+        ZoneScript zoneScript(SCRIPT, options);
+
+        std::ostringstream results;
+        std::ostringstream errors;
+        auto start = std::chrono::steady_clock::now();
+        FileManager fileMgr;
+        fileMgr.openInput(inPath);
+        fileMgr.openOutput(outPath);
+        ZoneScriptStats stats = zoneScript.run(fileMgr, results, errors);
+        fileMgr.close();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (stats.failedLine != 0) {
+            std::fprintf(stderr, "zone %llu failed at script line %zu: %s", stats.failedZone,
+                         stats.failedLine, errors.str().c_str());
+            return 1;
+        }
+        std::string data = readFile(outPath);
+        if (threads == 1) {
+            single = seconds;
+            expectedData = data;
+            expectedResults = results.str();
+            std::printf("%d lines, %llu zones, %zu result bytes\n", lines, stats.zones, expectedResults.size());
+        } else if (data != expectedData || results.str() != expectedResults) {
+            std::fprintf(stderr, "output with %u threads differs from single-threaded run\n", threads);
+            return 1;
+        }
+        std::printf("%2u threads  %8.3f s  %10.0f zones/s  %5.2fx\n", threads, seconds,
+                    static_cast<double>(stats.zones) / seconds, single / seconds);
+    }
+
+    std::remove(inPath.c_str());
+    std::remove(outPath.c_str());
+    return 0;
+}
@@ -1,7 +1,14 @@
 #ifndef ACTIVE_ZONE_H
 #define ACTIVE_ZONE_H
 
+#include "edit_plan.h"
+#include "fuzzy_search.h"
 #include "line.h"
+#include "line_number.h"
+#include "multi_search.h"
+#include "regex_engine.h"
+#include "search_cache.h"
+#include "text_search.h"
 #include <cstddef>
 #include <vector>
 #include <string>
@@ -9,8 +16,14 @@
 namespace line_editor {
 
 constexpr int DEFAULT_MAX_LINES = 100;
+// 每次从输入读入活区的行数，留出插入的余量
+constexpr int ZONE_LOAD_LINES = 80;
 constexpr int PAGE_SIZE = 20;
 
+// display 高亮匹配时使用的 ANSI 反显序列
+constexpr const char* HIGHLIGHT_BEGIN = "\x1b[7m";
+constexpr const char* HIGHLIGHT_END = "\x1b[27m";
+
 class ActiveZone {
 public:
     explicit ActiveZone(int maxLines = DEFAULT_MAX_LINES);
@@ -21,25 +34,52 @@ public:
 
     Line* head() const { return head_; }
     Line* tail() const { return tail_; }
-    int startLineNo() const { return startLineNo_; }
+    LineNo startLineNo() const { return startLineNo_; }
     int lineCount() const { return lineCount_; }
     int maxLines() const { return maxLines_; }
     bool isEmpty() const { return lineCount_ == 0; }
     bool isFull() const { return lineCount_ >= maxLines_; }
 
+    // 通过返回的指针直接修改行内容后，需调用 markChanged 使查找缓存重新检查该行
     Line* getLine(int relativeIndex);
-    Line* getLineByNumber(int lineNo);
-    int getRelativeIndex(int lineNo) const;
-
-    void insert(int afterLineNo, const char* text);
-
-    void deleteLine(int lineNo);
-    void deleteRange(int startLineNo, int endLineNo);
-
-    bool replaceInLine(int lineNo, const char* oldStr, const char* newStr);
-    std::vector<int> findPattern(const char* pattern) const;
+    Line* getLineByNumber(LineNo lineNo);
+    void markChanged(LineNo lineNo);
+    LineNo getRelativeIndex(LineNo lineNo) const;
+    // 读入时下标为 origin 的行现在的行号（见 Line::origin），已被删除时返回 0
+    LineNo findOrigin(int origin) const;
+
+    void insert(LineNo afterLineNo, const char* text);
+
+    // 范围只取与活区相交的部分，起始大于结束时为空范围；不抛异常，返回删除的行数
+    int deleteLine(LineNo lineNo);
+    int deleteRange(LineNo startLineNo, LineNo endLineNo);
+
+    bool replaceInLine(LineNo lineNo, const char* oldStr, const char* newStr);
+    // 一个查找器用于整个范围；global 为 true 时替换每行的全部匹配。返回替换的次数，
+    // 范围的处理与 deleteRange 相同
+    size_t replaceInRange(LineNo startLineNo, LineNo endLineNo, const std::string& oldStr,
+                          const std::string& newStr, bool global);
+    // 沿链表一遍执行编译好的编辑计划，返回每个替换编号的替换次数。被删除的行上的替换
+    // 只在其余行上没有替换时才计入，所以次数为 0 当且仅当逐条执行时这条替换没有匹配。
+    // 计划必须是按活区当前的起始行号和行数编译的
+    std::vector<size_t> apply(const EditPlan& plan);
+    // 子串和正则查找的结果按模式缓存，编辑之后重复查找只重新检查插入或改动过的行
+    std::vector<LineNo> findPattern(const char* pattern) const;
+    std::vector<LineNo> findPattern(const Searcher& searcher) const;
+    std::vector<LineNo> findPattern(const Regex& regex) const;
+    std::vector<LineNo> findPattern(const FuzzySearcher& searcher) const;
+    // 一次扫描找出每行命中的全部模式，只返回至少命中一个的行
+    std::vector<LineMatches> findPatterns(const MultiSearcher& searcher) const;
+
+    // 一遍扫描找出每处不重叠匹配的行号、列和长度，追加到 out；返回追加的个数。
+    // 调用方复用同一个 out 时不再为结果分配内存
+    size_t findMatches(const Searcher& searcher, std::vector<MatchPosition>& out) const;
+    size_t findMatches(const Regex& regex, std::vector<MatchPosition>& out) const;
 
     std::string display(int page = 0) const;
+    // 同上，匹配的文本用 HIGHLIGHT_BEGIN / HIGHLIGHT_END 包围；只查找该页的行
+    std::string display(int page, const Searcher& highlight) const;
+    std::string display(int page, const Regex& highlight) const;
     int totalPages() const;
 
     void clear();
@@ -47,18 +87,29 @@ public:
     Line* removeFirst();
     Line* removeLast();
 
-    void setStartLineNo(int lineNo) { startLineNo_ = lineNo; }
+    void setStartLineNo(LineNo lineNo) { startLineNo_ = lineNo; }
+
+    const SearchCache& searchCache() const { return searchCache_; }
 
 private:
     Line* head_;
     Line* tail_;
-    int startLineNo_;
+    LineNo startLineNo_;
+    // 活区行数受 maxLines_ 限制，保持 int
     int lineCount_;
     int maxLines_;
-
+    // 查找结果以活区内的下标记录，起始行号变化不影响缓存
+    mutable SearchCache searchCache_;
+
+    template <typename Match>
+    std::vector<LineNo> findCached(const std::string& key, Match match) const;
+    template <typename Matcher>
+    size_t findAllLines(const Matcher& matcher, std::vector<MatchPosition>& out) const;
+    template <typename Matcher>
+    std::string displayPage(int page, const Matcher* highlight) const;
     void insertAfter(Line* position, Line* newLine);
     void removeLine(Line* line);
-    Line* findLine(int lineNo) const;
+    Line* findLine(LineNo lineNo) const;
 };
 
 } // namespace line_editor
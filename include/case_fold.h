@@ -0,0 +1,38 @@
+#ifndef CASE_FOLD_H
+#define CASE_FOLD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace line_editor {
+
+/**
+ * Unicode simple case folding (CaseFolding.txt status C and S): maps a code
+ * point to its case-insensitive representative, e.g. 'A' -> 'a',
+ * U+212A KELVIN SIGN -> 'k'. Code points without a folding map to themselves.
+ */
+uint32_t simpleFold(uint32_t cp);
+
+/**
+ * Append the simple case folding of UTF-8 text to out. Invalid bytes are
+ * copied unchanged.
+ *
+ * @param origin If not null, receives for every byte appended to out the
+ *               offset in data of the code point it came from
+ */
+void foldUtf8(const char* data, size_t size, std::string& out, std::vector<size_t>* origin = nullptr);
+
+/**
+ * All code points whose folding equals that of cp, including cp itself,
+ * in ascending order. Used to build case-insensitive character classes.
+ */
+void caseOrbit(uint32_t cp, std::vector<uint32_t>& out);
+
+// 所有参与大小写折叠（折叠等价类多于一个成员）的码点，升序
+const std::vector<uint32_t>& foldableCodePoints();
+
+} // namespace line_editor
+
+#endif // CASE_FOLD_H
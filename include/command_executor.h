@@ -4,19 +4,118 @@
 #include "command_parser.h"
 #include "active_zone.h"
 #include "file_manager.h"
+#include "multi_search.h"
+#include "regex_engine.h"
+#include <memory>
 #include <string>
+#include <variant>
+#include <vector>
 
 namespace line_editor {
 
-struct ExecutionResult {
-    bool success;
-    std::string message;
+// 命令执行后的状态
+enum class ExecStatus : unsigned char {
+    OK,
+    NEEDS_INPUT,    // i 命令没有给出文本，等待插入模式读入
+    EXIT,           // q 命令
+    FAILED          // error 给出错误码
+};
+
+// 命令做了什么：决定 count、lineNo 是否有效，以及 payload 中是哪一种载荷
+enum class ResultKind : unsigned char {
+    NONE,
+    INSERTED,       // lineNo 为插入位置
+    INSERT_PROMPT,
+    DELETED,
+    ZONE_LOADED,    // count 为载入的行数
+    ZONE_WRITTEN,   // 没有更多输入
+    PAGE,           // PagePayload
+    ZONE_EMPTY,
+    REPLACED,       // count 为替换次数
+    MATCHED,        // MatchPayload
+    MULTI_MATCHED,  // MultiMatchPayload
+    FILE_MATCHED,   // FileMatchPayload，count 为模式数
+    JUMPED,         // lineNo 为活区行号，count 为跳过的活区数
+    QUIT,
+    // 以下用于失败的结果
+    NOT_REPLACED,
+    UNKNOWN_COMMAND,
+    ERROR_TEXT      // ErrorPayload
+};
+
+// p：output 为活区内容，脚本模式下也要写出；page 从 0 开始
+struct PagePayload {
+    int page = 0;
+    int pages = 0;
     std::string output;
-    bool shouldExit;
-    bool needsInput;
+};
+
+// m：cacheHit 时 rescanned 为缓存重新检查的行数
+struct MatchPayload {
+    std::vector<LineNo> lines;
+    bool cacheHit = false;
+    size_t rescanned = 0;
+};
+
+// 多模式 m：patterns 只在模式来自文件时填写，否则就是命令中的 cmd.patterns
+struct MultiMatchPayload {
+    std::vector<LineMatches> lineMatches;
+    std::vector<std::string> patterns;
+};
+
+// M：indexed 时其余字段为索引的使用情况
+struct FileMatchPayload {
+    std::vector<LineNo> lines;
+    bool indexed = false;
+    size_t candidateBlocks = 0;
+    size_t indexBlocks = 0;
+    unsigned long long tailBytes = 0;
+};
 
-    ExecutionResult()
-        : success(true), shouldExit(false), needsInput(false) {}
+struct ErrorPayload {
+    std::string detail;     // 完整的错误信息
+};
+
+/**
+ * The outcome of one command: a small header (status, kind, error code and
+ * the two scalars most commands report) plus a payload typed by kind.
+ *
+ * Only p, m, M and exceptional failures carry a payload, held in a variant,
+ * so an edit command's result is a few scalars that cost nothing to build
+ * or destroy. Executing a command only records what happened; the message
+ * a user reads is formatted from the result and the command when a UI asks
+ * for it. Script mode shows nothing for most edits, so it never pays for
+ * building those strings.
+ */
+struct ExecutionResult {
+    using Payload = std::variant<std::monostate, PagePayload, MatchPayload, MultiMatchPayload,
+                                 FileMatchPayload, ErrorPayload>;
+
+    ExecStatus status = ExecStatus::OK;
+    ResultKind kind = ResultKind::NONE;
+    ErrorCode error = ErrorCode::SUCCESS;
+    size_t count = 0;
+    LineNo lineNo = 0;
+    Payload payload;
+
+    static ExecutionResult failure(ErrorCode error, ResultKind kind);
+    static ExecutionResult failure(const EditorException& e);
+
+    bool ok() const { return status != ExecStatus::FAILED; }
+    bool shouldExit() const { return status == ExecStatus::EXIT; }
+    bool needsInput() const { return status == ExecStatus::NEEDS_INPUT; }
+
+    // 载荷不是 T 时返回 nullptr
+    template <typename T>
+    const T* get() const { return std::get_if<T>(&payload); }
+    // p 的活区内容，其他结果为空
+    const std::string& output() const;
+    // m 或 M 命中的行，其他结果为空
+    const std::vector<LineNo>& lines() const;
+
+    // 给用户看的消息，需要时才格式化；cmd 必须是产生这个结果的命令。没有消息时为空
+    std::string message(const Command& cmd) const;
+    void appendMessage(const Command& cmd, std::string& out) const;
 };
 
 class CommandExecutor {
@@ -26,16 +125,32 @@ public:
 
     ExecutionResult execute(const Command& cmd);
 
-    ExecutionResult executeInsert(int lineNo, const std::string& text);
+    ExecutionResult executeInsert(LineNo lineNo, const std::string& text);
 
-    void setPendingInsertLineNo(int lineNo) { pendingInsertLineNo_ = lineNo; }
-    int getPendingInsertLineNo() const { return pendingInsertLineNo_; }
+    void setPendingInsertLineNo(LineNo lineNo) { pendingInsertLineNo_ = lineNo; }
+    LineNo getPendingInsertLineNo() const { return pendingInsertLineNo_; }
     void clearPendingInsert() { pendingInsertLineNo_ = -1; }
 
+    // s 命令没有替换任何内容时的错误信息；按编辑计划执行替换时也用它报告
+    static std::string replaceNotFoundMessage(const Command& cmd);
+
+    // 开启后 p 命令高亮最近一次 m 查找的每处匹配（ANSI 反显，只适合终端）
+    void setHighlight(bool highlight) { highlight_ = highlight; }
+
 private:
     ActiveZone& zone_;
     FileManager& fileMgr_;
-    int pendingInsertLineNo_;
+    LineNo pendingInsertLineNo_;
+    // 当前活区读入的第一行的输入行号，活区内的输入行为 [zoneInputStart_, fileMgr_.linesRead()]
+    long long zoneInputStart_;
+    // 已编译的正则在命令之间复用
+    RegexCache regexCache_;
+    // 最近一次多模式查找的自动机，模式列表不变时直接复用
+    std::unique_ptr<MultiSearcher> multiSearcher_;
+    // 最近一次单模式 m 查找的查找器，供 p 高亮；两者至多一个非空
+    bool highlight_;
+    std::unique_ptr<Searcher> highlightSearcher_;
+    std::shared_ptr<Regex> highlightRegex_;
 
     ExecutionResult executeInsert(const Command& cmd);
     ExecutionResult executeDelete(const Command& cmd);
@@ -43,6 +158,9 @@ private:
     ExecutionResult executePrint(const Command& cmd);
     ExecutionResult executeReplace(const Command& cmd);
     ExecutionResult executeMatch(const Command& cmd);
+    ExecutionResult executeMultiMatch(const Command& cmd);
+    ExecutionResult executeFileMatch(const Command& cmd);
+    ExecutionResult executeGoto(const Command& cmd);
     ExecutionResult executeQuit(const Command& cmd);
 };
 
@@ -8,7 +8,10 @@
 #undef INSERT
 
 #include "error.h"
+#include "line_number.h"
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace line_editor {
 
@@ -19,6 +22,8 @@ enum class CommandType {
     PRINT,
     REPLACE,
     MATCH,
+    FILE_MATCH,
+    GOTO,
     QUIT,
     UNKNOWN
 };
@@ -27,15 +32,78 @@ struct Command {
     CommandType type;
     std::string raw;
 
-    int lineNo;
-    int lineNo2;
+    LineNo lineNo;
+    LineNo lineNo2;
     int pageNum;
     std::string text;
     std::string oldStr;
     std::string newStr;
     std::string pattern;
+    bool regex;                 // m/正则/ 形式，pattern 为正则表达式
+    std::string flags;          // 结尾 '/' 之后的标志
+    bool ignoreCase;            // 标志 i：不区分大小写
+    bool global;                // s...@g：替换每行的全部匹配
+    std::vector<std::string> patterns;  // m|a|b|c 多模式列表
+    std::string patternFile;    // m<文件：每行一个模式
+    bool fuzzy;                 // m~k<模式>：近似查找
+    int maxErrors;              // 近似查找允许的编辑距离 k
 
-    Command() : type(CommandType::UNKNOWN), lineNo(0), lineNo2(0), pageNum(0) {}
+    Command() : type(CommandType::UNKNOWN), lineNo(0), lineNo2(0), pageNum(0), regex(false), ignoreCase(false), global(false),
+                fuzzy(false), maxErrors(0) {}
+};
+
+/**
+ * A parsed command whose text fields are views into the input line.
+ *
+ * Produced by CommandParser::tryParse without copying anything, so the
+ * input must outlive the view. Two fields keep their source form because
+ * decoding them needs new storage: a regex pattern still has its "\/"
+ * escapes, and an m|a|b|c list is kept whole in patternList. toCommand()
+ * decodes both and copies the rest into an owning Command.
+ */
+struct CommandView {
+    CommandType type;
+    std::string_view raw;
+
+    LineNo lineNo;
+    LineNo lineNo2;
+    int pageNum;
+    std::string_view text;
+    std::string_view oldStr;
+    std::string_view newStr;
+    std::string_view pattern;       // 正则时未去掉 \/ 转义
+    bool regex;
+    std::string_view flags;
+    bool ignoreCase;
+    bool global;
+    std::string_view patternList;   // m|a|b|c 中 "m|" 之后的原文，未拆分
+    std::string_view patternFile;
+    bool fuzzy;
+    int maxErrors;
+
+    CommandView() : type(CommandType::UNKNOWN), lineNo(0), lineNo2(0), pageNum(0), regex(false), ignoreCase(false),
+                    global(false), fuzzy(false), maxErrors(0) {}
+
+    Command toCommand() const;
+};
+
+// 解析失败的原因。text 是静态文字，detail 指向输入中出错的部分，需要时才拼成消息
+struct ParseError {
+    ErrorCode code;
+    const char* text;
+    std::string_view detail;
+
+    ParseError() : code(ErrorCode::SUCCESS), text("") {}
+
+    std::string message() const { return std::string(text).append(detail); }
+};
+
+// tryParse 的结果：成功时 command 有效，否则 error 说明原因
+struct ParseResult {
+    CommandView command;
+    ParseError error;
+
+    bool ok() const { return error.code == ErrorCode::SUCCESS; }
 };
 
 class CommandParser {
@@ -43,18 +111,36 @@ public:
     CommandParser() = default;
     ~CommandParser() = default;
 
+    // 解析失败时抛出 EditorException
     Command parse(const std::string& input) const;
 
-    void validate(const Command& cmd, int zoneStart, int zoneEnd) const;
+    // 不分配内存、不抛异常的解析，结果中的文本指向 input
+    ParseResult tryParse(std::string_view input) const;
+
+    // 检查行号是否在活区 [zoneStart, zoneEnd] 内；不符时抛出 EditorException
+    void validate(const Command& cmd, LineNo zoneStart, LineNo zoneEnd) const;
+    // 不抛异常的检查，供脚本等热路径使用；解析结果不必先转换成 Command
+    bool validate(const Command& cmd, LineNo zoneStart, LineNo zoneEnd, ParseError& error) const;
+    bool validate(const CommandView& cmd, LineNo zoneStart, LineNo zoneEnd, ParseError& error) const;
+
+    // 带溢出检查的行号解析，允许前导空白和正负号
+    static LineNo parseLineNumber(const std::string& str);
+    static bool parseLineNumber(std::string_view str, LineNo& value, ParseError& error);
 
-    static int parseLineNumber(const std::string& str);
+    // 解析 <旧字符串>@<新字符串>[@|@g]，s 命令和 --substitute 共用
+    static void parseReplacement(const std::string& spec, std::string& oldStr,
+                                 std::string& newStr, bool& global);
+    static bool parseReplacement(std::string_view spec, std::string_view& oldStr,
+                                 std::string_view& newStr, bool& global, ParseError& error);
 
 private:
-    Command parseInsert(const std::string& input) const;
-    Command parseDelete(const std::string& input) const;
-    Command parsePrint(const std::string& input) const;
-    Command parseReplace(const std::string& input) const;
-    Command parseMatch(const std::string& input) const;
+    bool parseInsert(std::string_view input, ParseResult& result) const;
+    bool parseDelete(std::string_view input, ParseResult& result) const;
+    bool parsePrint(std::string_view input, ParseResult& result) const;
+    bool parseReplace(std::string_view input, ParseResult& result) const;
+    bool parseMatch(std::string_view input, ParseResult& result) const;
+    bool parseFileMatch(std::string_view input, ParseResult& result) const;
+    bool parseGoto(std::string_view input, ParseResult& result) const;
 };
 
 } // namespace line_editor
@@ -0,0 +1,130 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+namespace line_editor {
+
+enum class Compression {
+    NONE,
+    GZIP,
+    ZSTD
+};
+
+/**
+ * Detect a compressed stream by its magic bytes.
+ * gzip starts with 1F 8B, zstd frames with 28 B5 2F FD.
+ *
+ * @param data The beginning of file data
+ * @param size Size of the data
+ * @return Detected compression, NONE if no magic matched
+ */
+Compression detectCompression(const char* data, size_t size);
+
+/**
+ * Choose output compression from the file extension (.gz, .zst).
+ */
+Compression compressionFromFilename(const std::string& filename);
+
+/**
+ * Whether support for the given format was compiled in.
+ */
+bool isCompressionSupported(Compression compression);
+
+const char* compressionName(Compression compression);
+
+// 有界的数据块队列，用于在编辑线程和压缩线程之间传递数据
+class ChunkQueue {
+public:
+    explicit ChunkQueue(size_t capacity);
+
+    bool push(std::string&& chunk);
+    bool pop(std::string& chunk);
+
+    void closeProducer();
+    void closeConsumer();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<std::string> chunks_;
+    size_t capacity_;
+    bool producerClosed_;
+    bool consumerClosed_;
+};
+
+class StreamCodec;
+
+// 解压读缓冲：后台线程从 source 读取压缩数据并解压，编辑线程按需取用
+class DecompressingStreamBuf : public std::streambuf {
+public:
+    DecompressingStreamBuf(Compression compression, std::streambuf* source);
+    ~DecompressingStreamBuf() override;
+
+    DecompressingStreamBuf(const DecompressingStreamBuf&) = delete;
+    DecompressingStreamBuf& operator=(const DecompressingStreamBuf&) = delete;
+
+    bool failed() const;
+    std::string errorMessage() const;
+
+protected:
+    int_type underflow() override;
+
+private:
+    void worker();
+    void setError(const std::string& msg);
+
+    std::unique_ptr<StreamCodec> codec_;
+    std::streambuf* source_;
+    ChunkQueue queue_;
+    std::string current_;
+    mutable std::mutex errorMutex_;
+    std::string error_;
+    std::thread thread_;
+};
+
+// 压缩写缓冲：编辑线程写满一块后交给后台线程压缩并写入 sink
+class CompressingStreamBuf : public std::streambuf {
+public:
+    CompressingStreamBuf(Compression compression, std::streambuf* sink);
+    ~CompressingStreamBuf() override;
+
+    CompressingStreamBuf(const CompressingStreamBuf&) = delete;
+    CompressingStreamBuf& operator=(const CompressingStreamBuf&) = delete;
+
+    // 刷出剩余数据、写入流尾并等待后台线程结束
+    bool finish();
+
+    bool failed() const;
+    std::string errorMessage() const;
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+private:
+    bool handOff();
+    void worker();
+    void setError(const std::string& msg);
+
+    std::unique_ptr<StreamCodec> codec_;
+    std::streambuf* sink_;
+    ChunkQueue queue_;
+    std::string pending_;
+    mutable std::mutex errorMutex_;
+    std::string error_;
+    std::thread thread_;
+    bool finished_;
+};
+
+} // namespace line_editor
+
+#endif // COMPRESSION_H
@@ -0,0 +1,114 @@
+#ifndef EDIT_PLAN_H
+#define EDIT_PLAN_H
+
+#include "line_number.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace line_editor {
+
+/**
+ * A run of edit commands (i, d, s) compiled against the shape of a zone.
+ *
+ * Each command's line numbers refer to the zone as the commands before it
+ * left it. The plan replays the commands on a list of row slots instead of
+ * on the zone itself: a slot is either one of the zone's original rows or
+ * a line the script inserts, plus the substitutions applied to it in
+ * order. Deleting rows drops their slots, so lines inserted and deleted
+ * again, and substitutions on rows deleted later, never reach the zone.
+ * What remains is the final order of the rows; ActiveZone::apply walks the
+ * zone once, erasing each run of dropped original rows, linking each batch
+ * of new lines in one place and running the substitutions on the rows
+ * that get them.
+ *
+ * A substitution still has to know whether it replaced anything, so rows
+ * dropped with substitutions on them are kept aside; apply only runs them
+ * for substitutions that found nothing on the rows that remain.
+ *
+ * Commands must be validated against startLineNo() / endLineNo() before
+ * they are added. Inserting into a full plan drops its first row, as
+ * ActiveZone::insert does.
+ */
+class EditPlan {
+public:
+    struct Substitution {
+        // patterns() 中的下标；相同的旧字符串共用一个查找器
+        size_t pattern;
+        std::string newStr;
+        bool global;
+    };
+
+    // 计划执行后活区中的一行：原活区下标为 origin 的行，或 origin 为 -1 时脚本插入的 text(row)。
+    // 施加在这一行上的替换按顺序串成链表，见 forEachSubstitution
+    struct Row {
+        int origin;
+        int text;
+        int firstApplied;
+        int lastApplied;
+    };
+
+    EditPlan(LineNo startLineNo, int lineCount, int maxLines);
+
+    // 计划执行后活区的行号范围，供验证下一条命令
+    LineNo startLineNo() const { return startLineNo_; }
+    LineNo endLineNo() const { return startLineNo_ + static_cast<LineNo>(rows_.size()) - 1; }
+    int lineCount() const { return static_cast<int>(rows_.size()); }
+
+    LineNo originalStartLineNo() const { return originalStart_; }
+    int originalLineCount() const { return originalCount_; }
+
+    void insert(LineNo afterLineNo, std::string_view text);
+    void erase(LineNo startLineNo, LineNo endLineNo);
+    // 返回这次替换的编号；ActiveZone::apply 按编号报告各自是否替换了内容
+    size_t substitute(LineNo startLineNo, LineNo endLineNo, std::string_view oldStr,
+                      std::string_view newStr, bool global);
+
+    bool empty() const { return commands_ == 0; }
+    size_t commands() const { return commands_; }
+    const std::vector<Row>& rows() const { return rows_; }
+    const std::string& text(const Row& row) const { return texts_[static_cast<size_t>(row.text)]; }
+    const std::vector<std::string>& patterns() const { return patterns_; }
+    const std::vector<Substitution>& substitutions() const { return substitutions_; }
+    // 带着替换被删除的行，按删除顺序
+    const std::vector<Row>& droppedRows() const { return droppedRows_; }
+
+    // 按施加顺序对 row 上的每个替换编号调用 visit
+    template <typename Visit>
+    void forEachSubstitution(const Row& row, Visit visit) const {
+        for (int i = row.firstApplied; i >= 0; i = applied_[static_cast<size_t>(i)].next) {
+            visit(applied_[static_cast<size_t>(i)].substitution);
+        }
+    }
+
+    // 优化掉的编辑：插入后又被删除的行，施加在随后被删除的行上的替换（只在需要判断有无匹配时执行）
+    size_t droppedInserts() const { return droppedInserts_; }
+    size_t droppedSubstitutions() const { return droppedSubstitutions_; }
+
+private:
+    struct Applied {
+        size_t substitution;
+        int next;
+    };
+
+    LineNo originalStart_;
+    int originalCount_;
+    LineNo startLineNo_;
+    int maxLines_;
+    std::vector<Row> rows_;
+    std::vector<std::string> texts_;
+    std::vector<Applied> applied_;
+    std::vector<std::string> patterns_;
+    std::vector<Substitution> substitutions_;
+    std::vector<Row> droppedRows_;
+    size_t commands_;
+    size_t droppedInserts_;
+    size_t droppedSubstitutions_;
+
+    void dropRows(size_t first, size_t count);
+};
+
+} // namespace line_editor
+
+#endif // EDIT_PLAN_H
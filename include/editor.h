@@ -5,7 +5,13 @@
 #include "file_manager.h"
 #include "command_parser.h"
 #include "command_executor.h"
+#include "edit_plan.h"
+#include "trigram_index.h"
+#include <iosfwd>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace line_editor {
 
@@ -18,11 +24,29 @@ public:
 
     void run();
 
+    // 非交互地执行命令序列：不显示欢迎信息、提示符和活区，只输出 p、m 等命令的结果，
+    // 插入模式的文本取自后续命令行（空行结束）。
+    // 某条命令出错时停止执行并放弃输出，返回 false
+    bool runScript(const std::vector<std::string>& commands);
+    bool runScript(std::istream& script);
+    // 逐活区执行脚本时处理一个活区：lines 作为起始行号为 1 的活区执行 script，不读写文件。
+    // 编辑后的各行追加到 data，p、m 等命令的结果写到 output，错误信息写到 errors；
+    // 返回出错的脚本行号，全部成功时返回 0
+    size_t runZone(const std::vector<std::string>& lines, std::istream& script, std::string& data,
+                   std::ostream& output, std::ostream& errors);
+
     void showWelcome() const;
     void showHelp() const;
 
     void displayZone(int page = 0) const;
 
+    void setUtf8Mode(Utf8Mode mode) { fileMgr_.setUtf8Mode(mode); }
+    void setCacheBypass(bool bypass) { fileMgr_.setCacheBypass(bypass); }
+    // 脚本模式出错时不能留下写了一半的输出，见 FileManager::setAtomicOutput；须在 init 之前设置
+    void setAtomicOutput(bool atomic) { fileMgr_.setAtomicOutput(atomic); }
+    // init 时若输入文件的 trigram 索引不存在或已过期，在后台重建；退出前等待构建完成
+    void setBuildIndex(bool build) { buildIndex_ = build; }
+
     bool isInitialized() const { return initialized_; }
     ActiveZone& zone() { return zone_; }
     const ActiveZone& zone() const { return zone_; }
@@ -37,9 +61,47 @@ private:
     std::string inputFile_;
     std::string outputFile_;
 
-    bool processCommand(const std::string& input);
+    bool quiet_;
+    // 脚本模式下：当前命令是否出错、已读到的脚本行号，以及攒着一起写出的命令结果
+    bool failed_;
+    size_t scriptLine_;
+    std::string pendingOutput_;
+    // runZone 期间命令结果和错误信息写到调用方给出的流，由调用方按活区顺序写出
+    std::ostream* outputSink_;
+    std::ostream* errorSink_;
+    // 脚本中连续的编辑命令先编进计划，遇到其他命令时一次执行；
+    // planned_[i] 是替换编号 i 对应的脚本行号和命令原文，用于报告未找到模式
+    std::unique_ptr<EditPlan> plan_;
+    std::vector<std::pair<size_t, std::string>> planned_;
+
+    bool buildIndex_;
+    std::unique_ptr<BackgroundIndexBuild> indexBuild_;
+
+    // 输出写到标准输出时，命令结果改写到标准错误，避免混入数据
+    std::ostream& ui() const;
+    // 写出命令结果；脚本模式下先攒在 pendingOutput_ 中，攒够一批再写
+    void emit(const std::string& text);
+    void flushOutput();
+    // 报告错误：先写出攒着的结果，保持与错误信息的先后顺序，并标记当前命令出错
+    std::ostream& fail();
+
+    bool processCommand(const std::string& input, std::istream& source);
+    // 执行脚本直到结束或出错；返回出错的脚本行号，全部成功时返回 0
+    size_t executeScript(std::istream& script);
+
+    void handleInsertMode(LineNo lineNo, std::istream& source);
+    // 读入插入模式的文本行，到空行或输入结束为止
+    void readInsertText(std::istream& source, std::vector<std::string>& lines);
+
+    // 是 i、d、s 命令且在计划执行后的活区上有效时加入计划并返回 true
+    bool planEdit(const std::string& input, size_t line, std::istream& source);
+    // 执行计划；某个替换没有替换任何内容时报告错误并返回其脚本行号，否则返回 0
+    size_t flushPlan();
+
+    // 逐键更新查找结果；keys 非空时按其中的按键依次输入。确认时返回 true 并给出模式
+    bool searchAsYouType(const std::string& keys, std::string& pattern);
 
-    void handleInsertMode(int lineNo);
+    void finish();
 };
 
 } // namespace line_editor
@@ -2,9 +2,17 @@
 #define ENCODING_UTILS_H
 
 #include <cstddef>
+#include <string>
 
 namespace line_editor {
 
+// 输入中出现非法 UTF-8 时的处理方式
+enum class Utf8Mode {
+    PASS_THROUGH,   // 原样保留
+    REPLACE,        // 替换为 U+FFFD
+    REJECT          // 报错
+};
+
 /**
  * Initialize console encoding for Windows.
  * On Windows, sets console to UTF-8 mode for proper display of Unicode characters.
@@ -14,6 +22,15 @@ namespace line_editor {
  */
 bool initializeConsoleEncoding();
 
+/**
+ * Check whether standard output is a terminal that can show ANSI escape
+ * sequences. On Windows, also turns on virtual terminal processing for the
+ * console.
+ *
+ * @return false when output is redirected or the console lacks support
+ */
+bool enableTerminalEscapes();
+
 /**
  * Detect UTF-8 BOM (Byte Order Mark) in data.
  * UTF-8 BOM is the byte sequence: EF BB BF
@@ -24,6 +41,37 @@ bool initializeConsoleEncoding();
  */
 size_t detectUtf8Bom(const char* data, size_t size);
 
+/**
+ * Check whether data is pure 7-bit ASCII.
+ * With SSE2, scans 64 bytes per step (four vectors OR-ed together), then
+ * 16 bytes at a time; otherwise 8 bytes per step as a 64-bit word.
+ */
+bool isAscii(const char* data, size_t size);
+
+/**
+ * Validate UTF-8 (no overlongs, surrogates or code points above U+10FFFF).
+ * ASCII runs are skipped with the vector scan, multibyte sequences are
+ * checked by a scalar decoder.
+ *
+ * @return true if data is well-formed UTF-8
+ */
+bool validateUtf8(const char* data, size_t size);
+
+/**
+ * Copy data to out, replacing each maximal invalid subsequence with U+FFFD
+ * as recommended by the Unicode standard.
+ *
+ * @return Number of replacements made
+ */
+size_t repairUtf8(const char* data, size_t size, std::string& out);
+
+/**
+ * Parse a mode name ("pass", "replace", "reject").
+ *
+ * @return true if the name is recognised
+ */
+bool parseUtf8Mode(const std::string& name, Utf8Mode& mode);
+
 } // namespace line_editor
 
 #endif // ENCODING_UTILS_H
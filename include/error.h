@@ -17,7 +17,10 @@ enum class ErrorCode {
     MEMORY_ALLOCATION_FAILED,
     INVALID_FORMAT,
     PATTERN_NOT_FOUND,
-    EMPTY_ACTIVE_ZONE
+    EMPTY_ACTIVE_ZONE,
+    COMPRESSION_FAILED,
+    INVALID_ENCODING,
+    INVALID_PATTERN
 };
 
 class EditorException : public std::runtime_error {
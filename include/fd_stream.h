@@ -0,0 +1,101 @@
+#ifndef FD_STREAM_H
+#define FD_STREAM_H
+
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace line_editor {
+
+// 基于文件描述符的流缓冲，可以打开命名文件，也可以接管标准输入/输出
+class FdStreamBuf : public std::streambuf {
+public:
+    enum class Mode {
+        READ,
+        WRITE
+    };
+
+    // BYPASS 尽量用 O_DIRECT 绕过页缓存；不可用或对齐条件不满足时，
+    // 改为在游标之后分段 posix_fadvise(DONTNEED) 释放已处理的页
+    enum class CacheMode {
+        BUFFERED,
+        BYPASS
+    };
+
+    FdStreamBuf();
+    ~FdStreamBuf() override;
+
+    FdStreamBuf(const FdStreamBuf&) = delete;
+    FdStreamBuf& operator=(const FdStreamBuf&) = delete;
+
+    bool open(const std::string& path, Mode mode, CacheMode cache = CacheMode::BUFFERED);
+    // 接管已打开的描述符；owned 为 false 时 close() 不关闭它（stdin/stdout）
+    bool attach(int fd, Mode mode, bool owned, CacheMode cache = CacheMode::BUFFERED);
+    bool close();
+
+    bool isOpen() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+    Mode mode() const { return mode_; }
+    CacheMode cacheMode() const { return cache_; }
+    bool isDirect() const { return direct_; }
+
+    // 关闭 O_DIRECT（外部直接读写描述符之前需要调用），之后退回 fadvise 方式
+    void disableDirect();
+
+    // 预读最多 size 字节但不消费，用于识别魔数（对管道同样有效）
+    size_t peek(char* out, size_t size);
+
+    // 读：已交给调用方的字节数；写：已写入（含缓冲中）的字节数
+    long long position() const;
+
+    // 绕过缓冲直接读写描述符后，同步记录的位置
+    void addExternalRead(unsigned long long bytes);
+    void addExternalWrite(unsigned long long bytes);
+
+protected:
+    int_type underflow() override;
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    int sync() override;
+    // 只支持查询当前位置
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override;
+
+private:
+    bool flushBuffer();
+    bool writeAll(const char* data, size_t size);
+    long long readChunk(char* data, size_t size);
+    void dropBehind(bool final);
+
+    int fd_;
+    bool owned_;
+    Mode mode_;
+    CacheMode cache_;
+    bool direct_;
+    std::vector<char> storage_;
+    char* buffer_;
+    long long fdOffset_;
+    // BYPASS 模式下已释放缓存的位置，以及已发起回写的位置
+    long long droppedTo_;
+    long long flushedTo_;
+};
+
+constexpr unsigned long long COPY_TO_END = ~0ULL;
+
+/**
+ * Copy data between descriptors without parsing it, from the current
+ * position of inFd to the current position of outFd.
+ * Uses copy_file_range, sendfile or splice on Linux and falls back to a
+ * read/write loop elsewhere.
+ *
+ * @param inFd   Source descriptor
+ * @param outFd  Destination descriptor
+ * @param length Bytes to copy, COPY_TO_END for everything
+ * @return Number of bytes copied
+ */
+unsigned long long copyFdData(int inFd, int outFd,
+                              unsigned long long length = COPY_TO_END);
+
+} // namespace line_editor
+
+#endif // FD_STREAM_H
@@ -1,42 +1,132 @@
 #ifndef FILE_MANAGER_H
 #define FILE_MANAGER_H
 
+#include "compression.h"
+#include "encoding_utils.h"
+#include "fd_stream.h"
 #include <string>
 #include <vector>
-#include <fstream>
+#include <istream>
+#include <ostream>
+#include <memory>
+#include <sstream>
 
 namespace line_editor {
 
+// 文件名为 "-" 时输入使用标准输入、输出使用标准输出
+constexpr const char* STDIO_FILENAME = "-";
+
 class FileManager {
 public:
     FileManager() = default;
-    ~FileManager() = default;
+    ~FileManager();
+
+    FileManager(const FileManager&) = delete;
+    FileManager& operator=(const FileManager&) = delete;
 
     bool openInput(const std::string& filename);
     bool openOutput(const std::string& filename);
+    bool openOutput(const std::string& filename, Compression compression);
+    // 原地编辑：输入输出为同一文件，关闭时才替换原文件
+    bool openInPlace(const std::string& filename);
     void close();
 
+    static bool isSameFile(const std::string& first, const std::string& second);
+    // 在 target 同目录下创建临时文件；写完后用 commitTempFile 刷盘并原子地覆盖 target
+    static std::string createTempFileNear(const std::string& target);
+    static bool commitTempFile(const std::string& tempPath, const std::string& target);
+
     int readLines(std::vector<std::string>& lines, int maxLines = 80);
     std::string readLine();
 
     bool writeLine(const std::string& line);
     bool writeLines(const std::vector<std::string>& lines);
 
-    bool isInputOpen() const { return input_.is_open(); }
-    bool isOutputOpen() const { return output_.is_open(); }
+    // 把尚未读取的输入原样追加到输出，不解析成行；返回复制的字节数
+    unsigned long long copyRemainingInput();
+
+    // 不切分行地读写原始字节，供整文件流式处理；读到结尾时返回 0。
+    // 原地编辑时先改为写同目录的临时文件，关闭时再替换原文件
+    size_t readRaw(char* data, size_t size);
+    bool writeRaw(const char* data, size_t size);
+
+    // 出错时放弃本次输出：关闭文件，原地编辑时删除临时文件、保留原文件
+    void abandon();
+
+    bool isInputOpen() const { return inputFile_.isOpen(); }
+    bool isOutputOpen() const { return outputFile_.isOpen() || patching_; }
+    bool isOutputStdout() const { return outputFile_.isOpen() && outputFilename_ == STDIO_FILENAME; }
     bool isInputEof() const { return input_.eof(); }
 
+    void setUtf8Mode(Utf8Mode mode) { utf8Mode_ = mode; }
+    Utf8Mode utf8Mode() const { return utf8Mode_; }
+    long long linesRead() const { return linesRead_; }
+    long long invalidUtf8Lines() const { return invalidUtf8Lines_; }
+
+    // 批量改写大文件时不污染页缓存；在下一次 open 时生效
+    void setCacheBypass(bool bypass) { cacheBypass_ = bypass; }
+    bool cacheBypass() const { return cacheBypass_; }
+
+    // 输出先写到目标同目录的临时文件，close 成功时才原子地替换目标，abandon 时删除，
+    // 目标文件始终保持原样；原地编辑也不再直接回写原文件。标准输出不受影响，在下一次 open 时生效
+    void setAtomicOutput(bool atomic) { atomicOutput_ = atomic; }
+    bool atomicOutput() const { return atomicOutput_; }
+
+    bool isInPlace() const { return inPlace_; }
+    bool isPatchingInPlace() const { return patching_; }
+
+    Compression inputCompression() const { return inputCompression_; }
+    Compression outputCompression() const { return outputCompression_; }
+
     const std::string& inputFilename() const { return inputFilename_; }
-    const std::string& outputFilename() const { return outputFilename_; }
+    const std::string& outputFilename() const {
+        return inPlace_ || replaceOnClose_ ? targetFilename_ : outputFilename_;
+    }
 
 private:
     void skipUtf8Bom();
+    void checkInputCodec() const;
+    void applyUtf8Mode(std::string& line);
+    void attachOutput(Compression compression);
+    long long inputOffset();
+    FdStreamBuf::CacheMode cacheMode() const;
+    void settlePatch();
+    void switchToTempFile(const std::string& pending);
+    void commitInPlace();
+    void discardInPlace();
+    void commitOutput();
+    void discardOutput();
+
+    // 原始文件缓冲；压缩时由编解码缓冲包装，input_/output_ 始终指向实际读写的缓冲
+    FdStreamBuf inputFile_;
+    FdStreamBuf outputFile_;
+    std::unique_ptr<DecompressingStreamBuf> inputCodec_;
+    std::unique_ptr<CompressingStreamBuf> outputCodec_;
+    std::istream input_{nullptr};
+    std::ostream output_{nullptr};
 
-    std::ifstream input_;
-    std::ofstream output_;
     std::string inputFilename_;
     std::string outputFilename_;
+    Compression inputCompression_ = Compression::NONE;
+    Compression outputCompression_ = Compression::NONE;
     bool bomChecked_ = false;
+    Utf8Mode utf8Mode_ = Utf8Mode::PASS_THROUGH;
+    long long linesRead_ = 0;
+    long long invalidUtf8Lines_ = 0;
+    std::string repairBuffer_;
+    bool cacheBypass_ = false;
+    bool atomicOutput_ = false;
+    // 原子输出：outputFilename_ 是临时文件，close 时替换 targetFilename_
+    bool replaceOnClose_ = false;
+
+    // 原地编辑状态：每次写出的长度都与读入的一致时直接回写原文件，
+    // 否则改写到同目录的临时文件，关闭时再原子替换
+    bool inPlace_ = false;
+    bool patching_ = false;
+    std::stringbuf patchBuffer_;
+    unsigned long long patchOffset_ = 0;
+    int patchFd_ = -1;
+    std::string targetFilename_;
 };
 
 } // namespace line_editor
@@ -0,0 +1,100 @@
+#ifndef FILE_SEARCH_H
+#define FILE_SEARCH_H
+
+#include "fuzzy_search.h"
+#include "line_number.h"
+#include "multi_search.h"
+#include "regex_engine.h"
+#include "text_search.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace line_editor {
+
+// 只读映射整个文件；空文件映射成功但 data() 为 nullptr
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return open_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    // 打开时文件的修改时间，单位与平台相关，只用于比较是否相同
+    long long mtime() const { return mtime_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    long long mtime_;
+    bool open_;
+#ifdef _WIN32
+    void* file_;
+    void* mapping_;
+#endif
+};
+
+// 缓冲区中一段由整行组成的区间 [begin, end)，firstLine 是其第一行的行号
+struct LineRange {
+    size_t begin;
+    size_t end;
+    LineNo firstLine;
+};
+
+struct ParallelSearchOptions {
+    static constexpr size_t DEFAULT_CHUNK_BYTES = 16 * 1024 * 1024;
+
+    unsigned threads;       // 0 表示使用全部硬件线程
+    size_t chunkBytes;      // 每个任务的名义大小，实际边界对齐到行首
+
+    ParallelSearchOptions() : threads(0), chunkBytes(DEFAULT_CHUNK_BYTES) {}
+};
+
+/**
+ * Find the lines of a buffer that match, scanning line-aligned chunks on
+ * several threads. Lines are split on '\n' like std::getline, so a final
+ * line without a newline still counts and '\r' stays part of the line.
+ *
+ * Chunks are handed out dynamically; each worker searches its chunk in
+ * cache-sized windows and counts newlines in the same window, so every
+ * byte is read from memory once. Per-chunk line counts are summed after
+ * all workers finish to turn local line indices into global ones.
+ *
+ * @return 1-based numbers of the matching lines, in ascending order
+ */
+std::vector<LineNo> findLinesParallel(const char* data, size_t size, const Searcher& searcher,
+                                      const ParallelSearchOptions& options = ParallelSearchOptions());
+// Regex 的 DFA 缓存不能共享，每个线程按同一模式各自编译一份
+std::vector<LineNo> findLinesParallel(const char* data, size_t size, const Regex& regex,
+                                      const ParallelSearchOptions& options = ParallelSearchOptions());
+// 命中任意一个模式的行
+std::vector<LineNo> findLinesParallel(const char* data, size_t size, const MultiSearcher& searcher,
+                                      const ParallelSearchOptions& options = ParallelSearchOptions());
+// 含有与模式编辑距离不超过 maxErrors 的子串的行；每个线程复制一份查找器
+std::vector<LineNo> findLinesParallel(const char* data, size_t size, const FuzzySearcher& searcher,
+                                      const ParallelSearchOptions& options = ParallelSearchOptions());
+
+// 只查找给定的区间（按 begin 升序、互不重叠），行号从各区间的 firstLine 起算
+std::vector<LineNo> findLinesParallel(const char* data, const std::vector<LineRange>& ranges,
+                                      const Searcher& searcher,
+                                      const ParallelSearchOptions& options = ParallelSearchOptions());
+std::vector<LineNo> findLinesParallel(const char* data, const std::vector<LineRange>& ranges,
+                                      const Regex& regex,
+                                      const ParallelSearchOptions& options = ParallelSearchOptions());
+std::vector<LineNo> findLinesParallel(const char* data, const std::vector<LineRange>& ranges,
+                                      const MultiSearcher& searcher,
+                                      const ParallelSearchOptions& options = ParallelSearchOptions());
+std::vector<LineNo> findLinesParallel(const char* data, const std::vector<LineRange>& ranges,
+                                      const FuzzySearcher& searcher,
+                                      const ParallelSearchOptions& options = ParallelSearchOptions());
+
+} // namespace line_editor
+
+#endif // FILE_SEARCH_H
@@ -0,0 +1,81 @@
+#ifndef FUZZY_SEARCH_H
+#define FUZZY_SEARCH_H
+
+#include "line_block.h"
+#include "text_search.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace line_editor {
+
+/**
+ * Approximate substring search: a line matches when some substring of it is
+ * within edit distance maxErrors (insertions, deletions, substitutions, on
+ * bytes) of the pattern.
+ *
+ * Distances are computed with Myers' bit-parallel algorithm, one 64-bit
+ * word per 64-byte chunk of the pattern; blocks pass the horizontal delta
+ * of the edit distance table to the next word as a carry, so each input
+ * byte costs a few word operations per chunk.
+ *
+ * As a filter, the pattern is cut into maxErrors + 1 pieces: k edits can
+ * touch at most k of them, so every match contains one piece exactly
+ * (Wu-Manber's partitioning). Lines are first tested for the pieces with
+ * the exact substring searcher and only lines holding one are verified.
+ * Pieces shorter than MIN_PIECE_LENGTH select too much text to help and
+ * disable the filter.
+ *
+ * Verification keeps mutable state: do not call matches or verify
+ * concurrently on the same object. Copies are independent.
+ */
+class FuzzySearcher {
+public:
+    static constexpr int MAX_ERRORS = 9;
+    static constexpr size_t MIN_PIECE_LENGTH = 2;
+
+    // 模式为空、maxErrors 超出 [0, MAX_ERRORS] 或不小于模式长度（每行都会匹配）时
+    // 抛出 EditorException(INVALID_PATTERN)
+    FuzzySearcher(const std::string& pattern, int maxErrors);
+
+    const std::string& pattern() const { return pattern_; }
+    int maxErrors() const { return maxErrors_; }
+    size_t wordCount() const { return words_; }
+
+    // 预过滤用的片段；为空表示片段太短，不做预过滤
+    const std::vector<Searcher>& pieces() const { return pieces_; }
+    // 每个匹配必然包含其一的字面量，供 trigram 索引缩小范围；不做预过滤时为空
+    std::vector<std::string> pieceLiterals() const;
+
+    // 先查片段，再做编辑距离比对
+    bool matches(const char* data, size_t size) const;
+    bool matches(const LineBlock* head) const;
+    // 只做编辑距离比对，调用方已确认片段出现在文本中时使用
+    bool verify(const char* data, size_t size) const;
+    bool verify(const LineBlock* head) const;
+
+private:
+    // 各字从初始状态开始；feed 在状态上继续处理一段字节，出现距离不超过 maxErrors_ 的位置时返回 true
+    void reset() const;
+    bool feed(const unsigned char* data, size_t size) const;
+    bool feedWords(const unsigned char* data, size_t size) const;
+
+    std::string pattern_;
+    int maxErrors_;
+    size_t words_;
+    // peq_[byte * words_ + w]：模式第 w 个字中等于 byte 的位置
+    std::vector<uint64_t> peq_;
+    // 最后一个字中对应模式末字节的位
+    uint64_t lastBit_;
+    std::vector<Searcher> pieces_;
+
+    // 比对状态：每个字的正负竖向差分位向量，以及模式末行的当前距离
+    mutable std::vector<uint64_t> pv_;
+    mutable std::vector<uint64_t> mv_;
+    mutable int score_;
+};
+
+} // namespace line_editor
+
+#endif // FUZZY_SEARCH_H
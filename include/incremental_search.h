@@ -0,0 +1,65 @@
+#ifndef INCREMENTAL_SEARCH_H
+#define INCREMENTAL_SEARCH_H
+
+#include "active_zone.h"
+#include "line.h"
+#include "line_number.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace line_editor {
+
+/**
+ * As-you-type substring search over an active zone.
+ *
+ * Every line containing a pattern also contains each of its prefixes, so
+ * the hits of the patterns typed so far form a chain of shrinking sets.
+ * They are kept as a stack: extending the pattern only re-checks the hits
+ * of the previous one, and shrinking it pops back to the cached result of
+ * the longest prefix still typed, then extends from there. Only the first
+ * character scans the whole zone.
+ *
+ * Hits hold pointers to the zone's lines; the zone must not be edited
+ * while the search is in use.
+ */
+class IncrementalSearch {
+public:
+    struct Hit {
+        LineNo lineNo;
+        const Line* line;
+    };
+
+    explicit IncrementalSearch(const ActiveZone& zone);
+
+    // 模式改为 pattern 并返回命中行；空模式没有命中。
+    // pattern 以不完整的 UTF-8 序列结尾时按其完整的部分查找，等序列完整后再缩小
+    const std::vector<Hit>& update(const std::string& pattern);
+    // 模式末尾追加一个字节
+    const std::vector<Hit>& type(char byte) { return update(pattern_ + byte); }
+    // 删除模式末尾的一个完整码点
+    const std::vector<Hit>& backspace();
+
+    const std::string& pattern() const { return pattern_; }
+    const std::vector<Hit>& hits() const;
+    // 最近一次 update 实际检查的行数；命中缓存时为 0
+    size_t checkedLines() const { return checked_; }
+    size_t cachedPatterns() const { return levels_.size(); }
+
+private:
+    struct Level {
+        std::string pattern;
+        std::vector<Hit> hits;
+    };
+
+    const ActiveZone& zone_;
+    std::string pattern_;
+    // levels_[i].pattern 是 levels_[i + 1].pattern 的真前缀，命中集合逐层缩小
+    std::vector<Level> levels_;
+    size_t checked_;
+    std::vector<Hit> none_;
+};
+
+} // namespace line_editor
+
+#endif // INCREMENTAL_SEARCH_H
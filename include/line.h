@@ -2,6 +2,8 @@
 #define LINE_H
 
 #include "line_block.h"
+#include "text_search.h"
+#include <cstddef>
 #include <string>
 
 namespace line_editor {
@@ -29,15 +31,34 @@ public:
     std::string getText() const;
     size_t length() const;
     bool isEmpty() const;
+    bool isAscii() const { return ascii_; }
+    // 从输入读入时在所在活区中的下标，插入的行为 -1；编辑只改内容，不改变它
+    int origin() const { return origin_; }
+    void setOrigin(int origin) { origin_ = origin; }
 
     int find(const char* substr) const;
     bool replace(const char* oldStr, const char* newStr);
+    /**
+     * Replace the first (or, with global, every non-overlapping) occurrence
+     * of the searcher's pattern. Blocks before the first match are left
+     * untouched; the rest of the chain is rewritten in place, reusing its
+     * blocks and only allocating or freeing when the length changes.
+     *
+     * @param searcher Case-sensitive searcher with a non-empty pattern
+     * @return Number of substitutions made
+     */
+    size_t replace(const Searcher& searcher, const std::string& newStr, bool global);
     bool contains(const char* pattern) const;
+    // 按 Unicode 简单大小写折叠比较；纯 ASCII 行走向量折叠的快速路径
+    bool containsIgnoreCase(const char* pattern) const;
 
 private:
     LineBlock* head_;
     Line* prev_;
     Line* next_;
+    bool ascii_;
+    // 放在 ascii_ 后的填充里，不增大 Line
+    int origin_;
 
     void clearBlocks();
     size_t countBlocks() const;
@@ -0,0 +1,16 @@
+#ifndef LINE_NUMBER_H
+#define LINE_NUMBER_H
+
+#include <cstdint>
+#include <limits>
+
+namespace line_editor {
+
+// 行号统一使用 64 位，超过 2^31 行的文件也不会溢出
+using LineNo = std::int64_t;
+
+constexpr LineNo MAX_LINE_NO = std::numeric_limits<LineNo>::max();
+
+} // namespace line_editor
+
+#endif // LINE_NUMBER_H
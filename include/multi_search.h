@@ -0,0 +1,83 @@
+#ifndef MULTI_SEARCH_H
+#define MULTI_SEARCH_H
+
+#include "line_block.h"
+#include "line_number.h"
+#include "text_search.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace line_editor {
+
+/**
+ * Aho-Corasick automaton over a fixed set of substrings.
+ *
+ * The trie is built once and turned into a full transition table over byte
+ * equivalence classes, so a scan costs one table lookup per input byte no
+ * matter how many patterns are loaded. Empty patterns match every input.
+ */
+class MultiSearcher {
+public:
+    explicit MultiSearcher(const std::vector<std::string>& patterns);
+
+    size_t patternCount() const { return patterns_.size(); }
+    const std::string& pattern(size_t index) const { return patterns_[index]; }
+    const std::vector<std::string>& patterns() const { return patterns_; }
+    size_t stateCount() const { return fail_.size(); }
+
+    bool matchesAny(const char* data, size_t size) const;
+    bool matchesAny(const LineBlock* head) const;
+
+    /**
+     * Find where the first occurrence of any pattern ends.
+     *
+     * @return Offset of the last byte of the earliest-ending match (0 when an
+     *         empty pattern is loaded), SEARCH_NOT_FOUND if none occurs
+     */
+    size_t findAny(const char* data, size_t size) const;
+
+    /**
+     * Collect the indices of all patterns occurring in the input.
+     *
+     * @param found Cleared, then filled with distinct indices in ascending order
+     */
+    void matchedPatterns(const char* data, size_t size, std::vector<size_t>& found) const;
+    void matchedPatterns(const LineBlock* head, std::vector<size_t>& found) const;
+
+private:
+    int next(int state, unsigned char byte) const {
+        return delta_[static_cast<size_t>(state) * classCount_ + byteClass_[byte]];
+    }
+    // 扫描一段字节，状态跨调用延续；onOutput(状态, 字节偏移) 返回 true 时提前结束并返回 true
+    template <typename OnOutput>
+    bool scan(const char* data, size_t size, int& state, OnOutput onOutput) const;
+    void collect(int state, std::vector<size_t>& found) const;
+    void finish(std::vector<size_t>& found) const;
+
+    std::vector<std::string> patterns_;
+
+    uint8_t byteClass_[256];
+    size_t classCount_;
+    // 完整转移表：delta_[状态 * classCount_ + 字节类]
+    std::vector<int> delta_;
+    std::vector<int> fail_;
+    // 在该状态结束的模式
+    std::vector<std::vector<size_t>> ends_;
+    // 沿失败链最近的有输出的状态，-1 表示没有
+    std::vector<int> dictLink_;
+    std::vector<uint8_t> hasOutput_;
+    // 所有模式首字节相同时，在根状态用 memchr 跳到下一个候选，-1 表示不适用
+    int rootSkip_;
+};
+
+// 活区中一行命中的模式（模式下标升序）
+struct LineMatches {
+    LineNo lineNo;
+    std::vector<size_t> patterns;
+};
+
+} // namespace line_editor
+
+#endif // MULTI_SEARCH_H
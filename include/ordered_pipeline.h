@@ -0,0 +1,169 @@
+#ifndef ORDERED_PIPELINE_H
+#define ORDERED_PIPELINE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace line_editor {
+
+/**
+ * Read, process in parallel, write in order: the pipeline shared by the
+ * whole-stream substitute and the per-zone script runner.
+ *
+ * The calling thread calls read(job) to fill each job until it returns
+ * false. Worker threads process jobs with a callable that each of them gets
+ * once from makeWorker(), so per-worker state (an Editor, a buffer) lives in
+ * that callable. The calling thread hands every result to write(result) in
+ * the order the jobs were read; write returns false to stop, after which
+ * nothing more is read and results not yet written are dropped. At most
+ * maxInFlight jobs (at least 1) are read but not yet written, so reading
+ * never runs far ahead of writing.
+ *
+ * With threads <= 1 everything runs on the calling thread. An exception
+ * from any callable stops the pipeline, the workers are joined and it is
+ * rethrown on the calling thread.
+ */
+template <typename Job, typename Read, typename MakeWorker, typename Write>
+void runOrderedPipeline(unsigned threads, size_t maxInFlight, Read read, MakeWorker makeWorker, Write write) {
+    using Worker = decltype(makeWorker());
+    using Result = std::decay_t<std::invoke_result_t<Worker&, Job&>>;
+
+    // 只有一个线程时在调用线程里直接处理，不启动流水线
+    if (threads <= 1) {
+        Worker process = makeWorker();
+        while (true) {
+            Job job;
+            if (!read(job)) {
+                return;
+            }
+            Result result = process(job);
+            if (!write(result)) {
+                return;
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable doneReady;
+    std::deque<std::pair<size_t, Job>> jobs;
+    std::map<size_t, Result> done;
+    bool closed = false;
+    std::exception_ptr error;
+
+    auto worker = [&]() {
+        Worker process = makeWorker();
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            jobReady.wait(lock, [&] { return !jobs.empty() || closed; });
+            if (jobs.empty()) {
+                return;
+            }
+            std::pair<size_t, Job> job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+
+            try {
+                Result result = process(job.second);
+                lock.lock();
+                done.emplace(job.first, std::move(result));
+            } catch (...) {
+                if (!lock.owns_lock()) {
+                    lock.lock();
+                }
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            doneReady.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    auto shutdown = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            jobs.clear();
+        }
+        jobReady.notify_all();
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+        pool.clear();
+    };
+
+    size_t nextSeq = 0;
+    size_t nextWrite = 0;
+    bool stopped = false;
+    // 按顺序写出已完成的任务；wait 为真时至少等到 nextWrite 号任务写出
+    auto drain = [&](bool wait) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (nextWrite < nextSeq && !stopped) {
+            if (wait) {
+                doneReady.wait(lock, [&] { return done.count(nextWrite) > 0 || error; });
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            auto it = done.find(nextWrite);
+            if (it == done.end()) {
+                return;
+            }
+            Result result = std::move(it->second);
+            done.erase(it);
+            lock.unlock();
+            stopped = !write(result);
+            lock.lock();
+            nextWrite++;
+            wait = false;
+        }
+    };
+
+    try {
+        while (!stopped) {
+            Job job;
+            if (!read(job)) {
+                break;
+            }
+            // 在途的任务达到上限时先写出最早的任务，读入不会领先写出太多
+            while (nextSeq - nextWrite >= std::max<size_t>(maxInFlight, 1) && !stopped) {
+                drain(true);
+            }
+            if (stopped) {
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.emplace_back(nextSeq++, std::move(job));
+            }
+            jobReady.notify_one();
+            drain(false);
+        }
+
+        while (nextWrite < nextSeq && !stopped) {
+            drain(true);
+        }
+    } catch (...) {
+        shutdown();
+        throw;
+    }
+
+    shutdown();
+}
+
+} // namespace line_editor
+
+#endif // ORDERED_PIPELINE_H
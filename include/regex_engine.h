@@ -0,0 +1,164 @@
+#ifndef REGEX_ENGINE_H
+#define REGEX_ENGINE_H
+
+#include "line_block.h"
+#include "text_search.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace line_editor {
+
+/**
+ * Regular expression compiled to a Thompson NFA and searched with a lazily
+ * built DFA. Work per input byte is bounded by the NFA size, so search time
+ * stays linear in the input whatever the pattern.
+ *
+ * Supported syntax: literals, '.', [classes], [^negated], \d \w \s \D \W \S,
+ * escapes, ^ $, ( ), |, * + ? and {m}, {m,}, {m,n}. Matching is on UTF-8:
+ * '.' and classes consume one whole code point. With ignoreCase, literals
+ * and bracket classes are closed under Unicode simple case folding.
+ *
+ * Search methods keep a mutable DFA cache and must not be called
+ * concurrently on the same object.
+ */
+class Regex {
+public:
+    static constexpr size_t DEFAULT_DFA_CACHE_BYTES = 8 * 1024 * 1024;
+
+    // 编译失败时抛出 EditorException(INVALID_PATTERN)；ignoreCase 按 Unicode 简单折叠匹配；
+    // cacheBytes 是 DFA 缓存的内存上限，超出时清空缓存后继续
+    explicit Regex(const std::string& pattern, bool ignoreCase = false,
+                   size_t cacheBytes = DEFAULT_DFA_CACHE_BYTES);
+    ~Regex();
+
+    Regex(const Regex&) = delete;
+    Regex& operator=(const Regex&) = delete;
+
+    const std::string& pattern() const { return pattern_; }
+    bool ignoreCase() const { return ignoreCase_; }
+
+    // 是否存在匹配：先用字面量预过滤，再跑惰性 DFA
+    bool search(const char* data, size_t size) const;
+    // asciiText 为 true 表示调用方已知文本是纯 ASCII，供预过滤跳过 Unicode 折叠
+    bool search(const LineBlock* head, bool asciiText = false) const;
+
+    /**
+     * Find the leftmost-longest match with an NFA simulation.
+     *
+     * @param start Set to the match start on success
+     * @param end   Set to one past the match end on success
+     * @return true if a match was found
+     */
+    bool find(const char* data, size_t size, size_t& start, size_t& end) const {
+        return find(data, size, 0, start, end);
+    }
+    // 同上，但只找起点不早于 from 的匹配；^ 仍只匹配 data 的开头
+    bool find(const char* data, size_t size, size_t from, size_t& start, size_t& end) const;
+
+    /**
+     * Append every non-overlapping leftmost-longest match in a LineBlock
+     * chain to out. The lazy DFA rejects non-matching lines first; only
+     * matching lines run the NFA, over the block itself or, for lines
+     * spanning several blocks, a reused scratch copy. Empty matches are
+     * not reported.
+     *
+     * @return Number of matches appended
+     */
+    size_t findAll(const LineBlock* head, LineNo lineNo, std::vector<MatchPosition>& out,
+                   bool asciiText = false) const;
+
+    size_t nfaSize() const { return nfa_.size(); }
+    size_t dfaStates() const { return dfaStates_.size(); }
+    size_t dfaCacheResets() const { return cacheResets_; }
+    const std::string& requiredLiteral() const { return literal_; }
+
+private:
+    struct NfaState {
+        enum Op : uint8_t { RANGE, EPSILON, SPLIT, MATCH, LINE_START, LINE_END };
+        Op op;
+        uint8_t lo;
+        uint8_t hi;
+        int out;
+        int out1;
+    };
+
+    // Pike VM 的线程：NFA 状态及其匹配起点
+    struct PikeThread {
+        int state;
+        size_t start;
+    };
+
+    struct DfaState {
+        std::vector<int> nfa;       // 已排序的 NFA 状态集合
+        std::vector<int> next;      // 按字节等价类索引，-1 表示尚未构建
+        bool match;
+        bool dead;                  // 集合为空：之后不可能再匹配
+        int8_t matchAtEnd[2];       // 输入结束时能否匹配，-1 表示尚未计算
+    };
+
+    int startState(bool atStart) const;
+    int step(int state, unsigned char byte) const;
+    bool matchesAtEnd(int state, bool atStart) const;
+    int intern(std::vector<int>& nfaStates) const;
+    void addClosure(std::vector<int>& out, int state, bool atStart, bool atEnd) const;
+    void resetCache() const;
+
+    std::string pattern_;
+    bool ignoreCase_;
+    std::vector<NfaState> nfa_;
+    int nfaStart_;
+
+    // 字面量预过滤：任何匹配都必须包含 literal_；模式本身就是字面量时直接用它判断
+    std::string literal_;
+    std::unique_ptr<Searcher> prefilter_;
+    bool literalOnly_;
+
+    // 字节等价类，DFA 转移表按类而不是按字节存放
+    uint8_t byteClass_[256];
+    int classCount_;
+
+    mutable std::vector<DfaState> dfaStates_;
+    mutable std::unordered_map<std::string, int> dfaIndex_;
+    size_t cacheBudget_;
+    mutable size_t dfaBytes_;
+    mutable int startStates_[2];
+    mutable size_t cacheResets_;
+    mutable std::vector<uint32_t> mark_;
+    mutable uint32_t markGeneration_;
+    // find 的工作区在调用之间复用，逐个匹配查找时不再分配
+    mutable std::vector<PikeThread> pikeCurrent_;
+    mutable std::vector<PikeThread> pikeNext_;
+    mutable std::vector<int> pikeClosure_;
+    mutable std::string scratch_;
+};
+
+// 已编译模式的 LRU 缓存，在命令之间复用编译结果和已构建的 DFA 状态
+class RegexCache {
+public:
+    explicit RegexCache(size_t capacity = 32);
+
+    // 编译失败时抛出 EditorException(INVALID_PATTERN)
+    std::shared_ptr<Regex> get(const std::string& pattern, bool ignoreCase = false);
+
+    size_t size() const { return entries_.size(); }
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+private:
+    typedef std::list<std::pair<std::string, std::shared_ptr<Regex>>> EntryList;
+
+    size_t capacity_;
+    EntryList entries_;
+    std::unordered_map<std::string, EntryList::iterator> index_;
+    size_t hits_;
+    size_t misses_;
+};
+
+} // namespace line_editor
+
+#endif // REGEX_ENGINE_H
@@ -0,0 +1,89 @@
+#ifndef SEARCH_CACHE_H
+#define SEARCH_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace line_editor {
+
+/**
+ * Per-zone cache of search results, kept valid across edits by an edit
+ * journal.
+ *
+ * Rows are identified by their index in the zone. Inserts, erases and
+ * text changes are appended to the journal; before a cached result is
+ * reused, the journal entries recorded since it was last brought up to
+ * date are replayed on it: rows that moved are shifted, erased rows are
+ * dropped, and inserted or changed rows are collected to be checked again.
+ * A repeated query therefore costs one pass over the journal plus one
+ * match per changed row instead of a scan of the whole zone.
+ */
+class SearchCache {
+public:
+    explicit SearchCache(size_t capacity = 16, size_t maxJournal = 1024);
+
+    // 编辑日志；没有缓存条目时不记录
+    void noteInsert(int row, int count);
+    void noteErase(int row, int count);
+    void noteChange(int row);
+    // 活区整体被替换，丢弃全部条目
+    void invalidate();
+
+    // 返回 key 的全部命中行（升序）。未缓存时所有行都交给 matchRows 检查，
+    // 否则只检查日志中插入或改动过的行；matchRows(rows, out) 把 rows 中命中的行按序追加到 out
+    template <typename MatchRows>
+    const std::vector<int>& query(const std::string& key, int rowCount, MatchRows matchRows) {
+        std::vector<int> dirty;
+        Entry& entry = refresh(key, rowCount, dirty);
+        std::vector<int> matched;
+        matchRows(dirty, matched);
+        merge(entry, matched);
+        return entry.rows;
+    }
+
+    size_t size() const { return entries_.size(); }
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    // 命中时重新检查的行数之和
+    size_t rescannedRows() const { return rescanned_; }
+
+private:
+    struct Edit {
+        enum Kind { INSERT, ERASE, CHANGE };
+        Kind kind;
+        int row;
+        int count;
+    };
+
+    struct Entry {
+        std::string key;
+        std::vector<int> rows;
+        // 已回放到的日志位置（绝对序号）
+        size_t synced;
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    Entry& refresh(const std::string& key, int rowCount, std::vector<int>& dirty);
+    void merge(Entry& entry, const std::vector<int>& matched);
+    void record(Edit::Kind kind, int row, int count);
+    void trimJournal();
+
+    size_t capacity_;
+    size_t maxJournal_;
+    EntryList entries_;
+    std::unordered_map<std::string, EntryList::iterator> index_;
+    std::vector<Edit> journal_;
+    // journal_[0] 的绝对序号
+    size_t journalBase_;
+    size_t hits_;
+    size_t misses_;
+    size_t rescanned_;
+};
+
+} // namespace line_editor
+
+#endif // SEARCH_CACHE_H
@@ -0,0 +1,71 @@
+#ifndef STREAM_SUBSTITUTE_H
+#define STREAM_SUBSTITUTE_H
+
+#include "text_search.h"
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace line_editor {
+
+class FileManager;
+
+struct SubstituteOptions {
+    static constexpr size_t DEFAULT_CHUNK_BYTES = 4 * 1024 * 1024;
+
+    unsigned threads;       // 0 表示使用全部硬件线程
+    size_t chunkBytes;      // 每次读入的字节数，块在最后一个换行处切开
+    size_t maxInFlight;     // 已读入但尚未写出的块数上限，0 表示线程数的两倍
+    bool global;            // 替换每行的全部匹配，否则只替换每行第一处
+
+    SubstituteOptions()
+        : threads(0), chunkBytes(DEFAULT_CHUNK_BYTES), maxInFlight(0), global(false) {}
+};
+
+struct SubstituteStats {
+    unsigned long long bytesRead = 0;
+    unsigned long long bytesWritten = 0;
+    unsigned long long substitutions = 0;
+    unsigned long long chunks = 0;
+};
+
+/**
+ * Sed-style substitute over a whole stream, without going through the
+ * active zone.
+ *
+ * The calling thread reads the input in chunks cut at the last newline;
+ * the partial line left over is carried into the next chunk, so every
+ * chunk holds whole lines and no match is split between two chunks.
+ * Worker threads transform chunks in parallel and the calling thread
+ * writes the results back in input order. At most maxInFlight chunks are
+ * buffered at once, so memory stays bounded by the chunk size times the
+ * pipeline depth plus the longest line.
+ */
+class StreamSubstituter {
+public:
+    // 旧字符串为空或包含换行时抛出 EditorException
+    StreamSubstituter(const std::string& oldStr, const std::string& newStr,
+                      const SubstituteOptions& options = SubstituteOptions());
+
+    const SubstituteOptions& options() const { return options_; }
+
+    // 处理 fileMgr 中尚未读取的全部输入；出错时放弃输出（原地编辑时保留原文件）
+    SubstituteStats run(FileManager& fileMgr) const;
+    SubstituteStats run(std::istream& in, std::ostream& out) const;
+
+    // 替换一段由整行组成的文本，结果追加到 out，返回替换次数
+    size_t substituteLines(const char* data, size_t size, std::string& out) const;
+
+private:
+    template <typename Read, typename Write>
+    SubstituteStats pump(Read read, Write write) const;
+
+    Searcher searcher_;
+    std::string newStr_;
+    SubstituteOptions options_;
+};
+
+} // namespace line_editor
+
+#endif // STREAM_SUBSTITUTE_H
@@ -0,0 +1,107 @@
+#ifndef TEXT_SEARCH_H
+#define TEXT_SEARCH_H
+
+#include "line_block.h"
+#include "line_number.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace line_editor {
+
+constexpr size_t SEARCH_NOT_FOUND = static_cast<size_t>(-1);
+
+// 一处匹配：行号、行内起始字节偏移（从 0 起）和匹配的字节数
+struct MatchPosition {
+    LineNo lineNo;
+    size_t column;
+    size_t length;
+};
+
+/**
+ * Find the first occurrence of needle in a contiguous buffer.
+ * Candidates are filtered 16 positions at a time by comparing the first
+ * and last needle bytes (SSE2 where available), then verified with memcmp.
+ *
+ * @return Byte offset of the match, SEARCH_NOT_FOUND if absent
+ */
+size_t findBytes(const char* haystack, size_t size, const char* needle, size_t needleLen);
+
+/**
+ * ASCII case-insensitive findBytes. The needle must already be lower-case;
+ * haystack bytes are folded 16 at a time (A-Z only) before the first/last
+ * byte filter, and other bytes are compared exactly.
+ *
+ * @return Byte offset of the match, SEARCH_NOT_FOUND if absent
+ */
+size_t findBytesIgnoreCase(const char* haystack, size_t size, const char* needle, size_t needleLen);
+
+/**
+ * Find the first occurrence of needle in the text held by a LineBlock chain,
+ * without copying the text. Matches that cross block boundaries are found
+ * by walking the following blocks during verification.
+ *
+ * @return Byte offset from the start of the chain, SEARCH_NOT_FOUND if absent
+ */
+size_t findInBlocks(const LineBlock* head, const char* needle, size_t needleLen);
+
+// 预编译的子串查找器：模式只分析一次，之后对活区每一行、乃至整个文件重复使用。
+// 单字节用 memchr，短模式用首尾字节向量过滤，长模式用 Boyer-Moore-Horspool。
+// 不区分大小写时模式按 Unicode 简单折叠预先折叠：纯 ASCII 文本走向量折叠过滤，
+// 其余文本逐码点折叠后再查找
+class Searcher {
+public:
+    enum class Strategy {
+        EMPTY,
+        SINGLE_BYTE,
+        VECTOR_FILTER,
+        HORSPOOL,
+        CASE_FOLD
+    };
+
+    explicit Searcher(const std::string& pattern, bool ignoreCase = false);
+
+    const std::string& pattern() const { return pattern_; }
+    Strategy strategy() const { return strategy_; }
+    bool ignoreCase() const { return ignoreCase_; }
+
+    // 不区分大小写时返回原文中匹配开始的偏移
+    size_t find(const char* data, size_t size) const;
+    // asciiText 为 true 表示调用方已知文本是纯 ASCII（见 Line::isAscii），可以跳过 Unicode 折叠
+    size_t find(const LineBlock* head, bool asciiText = false) const;
+    bool matches(const LineBlock* head, bool asciiText = false) const {
+        return find(head, asciiText) != SEARCH_NOT_FOUND;
+    }
+
+    /**
+     * Append every non-overlapping occurrence in a LineBlock chain to out,
+     * scanning the blocks once; matches that cross block boundaries are
+     * reported like any other. Reusing out across calls avoids allocation,
+     * except for case-insensitive search of non-ASCII text, which folds a
+     * copy of the line. An empty pattern reports nothing.
+     *
+     * @return Number of matches appended
+     */
+    size_t findAll(const LineBlock* head, LineNo lineNo, std::vector<MatchPosition>& out,
+                   bool asciiText = false) const;
+
+private:
+    size_t findHorspool(const char* data, size_t size) const;
+    size_t findInBlock(const char* data, size_t size) const;
+    size_t findFolded(const char* data, size_t size) const;
+
+    std::string pattern_;
+    Strategy strategy_;
+    bool ignoreCase_;
+    // 折叠后的模式；foldedAscii_ 表示它是纯 ASCII，
+    // asciiSafe_ 表示它的字符都没有非 ASCII 的大小写变体，ASCII 折叠对任何文本都正确
+    std::string folded_;
+    bool foldedAscii_;
+    bool asciiSafe_;
+    // Horspool 坏字符位移表
+    size_t shift_[256];
+};
+
+} // namespace line_editor
+
+#endif // TEXT_SEARCH_H
@@ -0,0 +1,133 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include "file_search.h"
+#include "line_number.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace line_editor {
+
+// 一次索引查询的结果：ranges 交给 findLinesParallel 精确查找
+struct IndexCandidates {
+    std::vector<LineRange> ranges;
+    size_t candidateBlocks = 0;     // 索引内需要查找的块数
+    size_t tailBytes = 0;           // 结尾没有换行、未进索引而必须整段查找的字节数
+};
+
+/**
+ * Sidecar trigram index of a file, stored next to it as "<file>.tri".
+ *
+ * The file (after any UTF-8 BOM) is split into line-aligned blocks of about
+ * blockBytes each. For every trigram of ASCII-lower-cased bytes that occurs
+ * inside a line, the index stores the sorted, delta/varint encoded list of
+ * blocks containing it. A query takes the trigrams of a literal that every
+ * match must contain, intersects their block lists, and leaves only the
+ * surviving blocks to the exact matcher.
+ *
+ * The index is memory-mapped: a query binary-searches the trigram
+ * directory and decodes only the posting lists it needs. Building streams
+ * the file once, spilling sorted (trigram, block) runs to a temporary file
+ * every few hundred blocks and merging them at the end, so memory use does
+ * not grow with the file.
+ *
+ * The index records the size, modification time and a fingerprint of the
+ * bytes it covers. Any change to the size or modification time makes the
+ * index stale and it is ignored, even when the file only grew: a file that
+ * grew may have been edited in the middle. The editor removes the index of
+ * a file it rewrites.
+ */
+class TrigramIndex {
+public:
+    static constexpr size_t DEFAULT_BLOCK_BYTES = 1024 * 1024;
+
+    static std::string sidecarPath(const std::string& path) { return path + ".tri"; }
+
+    // 为 path 构建索引写到 indexPath（先写临时文件再原子替换）；失败时抛出 EditorException。
+    // cancel 置位时尽快放弃，不留下索引文件
+    static void build(const std::string& path, const std::string& indexPath,
+                      size_t blockBytes = DEFAULT_BLOCK_BYTES,
+                      const std::atomic<bool>* cancel = nullptr);
+
+    // path 的索引存在且覆盖整个文件
+    static bool isCurrent(const std::string& path);
+
+    TrigramIndex() = default;
+
+    TrigramIndex(const TrigramIndex&) = delete;
+    TrigramIndex& operator=(const TrigramIndex&) = delete;
+
+    // 文件不存在、格式不符或已损坏时返回 false
+    bool open(const std::string& indexPath);
+    void close() { file_.close(); }
+    bool isOpen() const { return file_.isOpen(); }
+
+    // 索引对 file（映射的源文件）是否仍然可用：大小、修改时间和指纹都与构建时相同
+    bool usableFor(const MappedFile& file) const;
+
+    /**
+     * Line ranges of file that may hold a match. Every match must contain
+     * at least one of literals; an empty list, or a literal with no usable
+     * trigram, disables narrowing. Adjacent candidate blocks are merged and
+     * the unindexed last line (no trailing newline) is always included.
+     */
+    IndexCandidates candidates(const MappedFile& file, const std::vector<std::string>& literals,
+                               bool ignoreCase) const;
+
+    size_t blockCount() const { return blockCount_; }
+    size_t trigramCount() const { return trigramCount_; }
+    unsigned long long indexedBytes() const { return indexedBytes_; }
+
+private:
+    // 读取第 i 个块的起点和首行行号
+    void block(size_t i, unsigned long long& begin, unsigned long long& firstLine) const;
+    // 二分查找 trigram 的倒排表，找不到时返回 false
+    bool lookup(uint32_t trigram, uint32_t& count, unsigned long long& offset) const;
+    bool decode(unsigned long long offset, uint32_t count, std::vector<uint32_t>& blocks) const;
+    // 返回 literal 的候选块（升序）；literal 不能缩小范围时返回 false
+    bool literalBlocks(const std::string& literal, bool ignoreCase, std::vector<uint32_t>& blocks) const;
+
+    MappedFile file_;
+    size_t blockCount_ = 0;
+    size_t trigramCount_ = 0;
+    unsigned long long fileSize_ = 0;
+    long long mtime_ = 0;
+    unsigned long long indexedBytes_ = 0;
+    unsigned long long indexedLines_ = 0;
+    unsigned long long fingerprint_ = 0;
+    unsigned long long blocksOffset_ = 0;
+    unsigned long long postingsOffset_ = 0;
+    unsigned long long directoryOffset_ = 0;
+};
+
+// 在后台线程中构建 path 的索引；析构时等待构建结束
+class BackgroundIndexBuild {
+public:
+    explicit BackgroundIndexBuild(const std::string& path,
+                                  size_t blockBytes = TrigramIndex::DEFAULT_BLOCK_BYTES);
+    ~BackgroundIndexBuild();
+
+    BackgroundIndexBuild(const BackgroundIndexBuild&) = delete;
+    BackgroundIndexBuild& operator=(const BackgroundIndexBuild&) = delete;
+
+    bool finished() const { return finished_; }
+    void wait();
+    // 请求放弃构建，之后仍需 wait
+    void cancel() { cancel_ = true; }
+    // 构建失败时的错误信息；wait 之后读取
+    const std::string& error() const { return error_; }
+
+private:
+    std::atomic<bool> finished_;
+    std::atomic<bool> cancel_;
+    std::string error_;
+    std::thread thread_;
+};
+
+} // namespace line_editor
+
+#endif // TRIGRAM_INDEX_H
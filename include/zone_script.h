@@ -0,0 +1,65 @@
+#ifndef ZONE_SCRIPT_H
+#define ZONE_SCRIPT_H
+
+#include "active_zone.h"
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace line_editor {
+
+class FileManager;
+
+struct ZoneScriptOptions {
+    unsigned threads;       // 0 表示使用全部硬件线程
+    int zoneLines;          // 每个活区的行数，与 n 命令每次读入的行数相同
+    size_t zonesPerJob;     // 每次交给工作线程的活区数
+    size_t maxInFlight;     // 已读入但尚未写出的任务数上限，0 表示线程数的两倍
+
+    ZoneScriptOptions()
+        : threads(0), zoneLines(ZONE_LOAD_LINES), zonesPerJob(64), maxInFlight(0) {}
+};
+
+struct ZoneScriptStats {
+    unsigned long long zones = 0;
+    unsigned long long linesRead = 0;
+    unsigned long long bytesWritten = 0;
+    // 出错的活区（从 1 开始）和脚本行号；没有出错时为 0
+    unsigned long long failedZone = 0;
+    size_t failedLine = 0;
+};
+
+/**
+ * Runs the same script against every zone of the input, like `sed -f`
+ * applied zone by zone.
+ *
+ * The input is cut into zones of zoneLines lines. Each zone is numbered
+ * from line 1 and gets the script on its own, exactly as a script-mode
+ * editor holding only that zone would run it, so the script can only use
+ * commands local to one zone: n, g, M and q are rejected up front. The
+ * calling thread reads batches of zones, worker threads run them with one
+ * Editor (and ActiveZone) each, and the calling thread writes the edited
+ * zones, the command results and any error message back in input order.
+ * The output is therefore byte-identical to running the zones one after
+ * another; the first failing zone stops the run and everything after it
+ * is discarded.
+ */
+class ZoneScript {
+public:
+    // 脚本中有跨活区的命令时抛出 EditorException，消息带脚本行号
+    explicit ZoneScript(const std::string& script, const ZoneScriptOptions& options = ZoneScriptOptions());
+
+    const ZoneScriptOptions& options() const { return options_; }
+
+    // 处理 fileMgr 中尚未读取的全部输入：编辑后的活区写入 fileMgr，p、m 等命令的结果写到
+    // results，错误信息写到 errors。某个活区出错时停止，由调用方放弃输出
+    ZoneScriptStats run(FileManager& fileMgr, std::ostream& results, std::ostream& errors) const;
+
+private:
+    std::string script_;
+    ZoneScriptOptions options_;
+};
+
+} // namespace line_editor
+
+#endif // ZONE_SCRIPT_H
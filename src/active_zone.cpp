@@ -27,16 +27,33 @@ Line* ActiveZone::getLine(int relativeIndex) {
     return current;
 }
 
-Line* ActiveZone::getLineByNumber(int lineNo) {
+Line* ActiveZone::getLineByNumber(LineNo lineNo) {
     return findLine(lineNo);
 }
 
-int ActiveZone::getRelativeIndex(int lineNo) const {
+void ActiveZone::markChanged(LineNo lineNo) {
+    if (lineNo >= startLineNo_ && lineNo < startLineNo_ + lineCount_) {
+        searchCache_.noteChange(static_cast<int>(lineNo - startLineNo_));
+    }
+}
+
+LineNo ActiveZone::getRelativeIndex(LineNo lineNo) const {
     return lineNo - startLineNo_;
 }
 
-void ActiveZone::insert(int afterLineNo, const char* text) {
+LineNo ActiveZone::findOrigin(int origin) const {
+    LineNo no = startLineNo_;
+    for (const Line* line = head_; line; line = line->next(), no++) {
+        if (line->origin() == origin) {
+            return no;
+        }
+    }
+    return 0;
+}
+
+void ActiveZone::insert(LineNo afterLineNo, const char* text) {
     Line* newLine = new Line(text);
+    int row = 0;
 
     if (afterLineNo < startLineNo_) {
         newLine->setNext(head_);
@@ -51,8 +68,10 @@ void ActiveZone::insert(int afterLineNo, const char* text) {
     } else {
         Line* afterLine = findLine(afterLineNo);
         if (afterLine) {
+            row = static_cast<int>(afterLineNo - startLineNo_) + 1;
             insertAfter(afterLine, newLine);
         } else {
+            row = lineCount_;
             if (tail_) {
                 tail_->setNext(newLine);
                 newLine->setPrev(tail_);
@@ -64,6 +83,7 @@ void ActiveZone::insert(int afterLineNo, const char* text) {
             lineCount_++;
         }
     }
+    searchCache_.noteInsert(row, 1);
 
     if (lineCount_ > maxLines_) {
         Line* toRemove = head_;
@@ -78,48 +98,244 @@ void ActiveZone::insert(int afterLineNo, const char* text) {
         delete toRemove;
         lineCount_--;
         startLineNo_++;
+        searchCache_.noteErase(0, 1);
     }
 }
 
-void ActiveZone::deleteLine(int lineNo) {
-    deleteRange(lineNo, lineNo);
+int ActiveZone::deleteLine(LineNo lineNo) {
+    return deleteRange(lineNo, lineNo);
 }
 
-void ActiveZone::deleteRange(int startLineNo, int endLineNo) {
-    if (startLineNo > endLineNo) {
-        throw EditorException(ErrorCode::INVALID_RANGE,
-            "起始行号不能大于结束行号");
+int ActiveZone::deleteRange(LineNo startLineNo, LineNo endLineNo) {
+    // 只遍历与活区相交的部分，超大的行号范围也不会空转
+    LineNo first = std::max(startLineNo, startLineNo_);
+    LineNo last = std::min(endLineNo, startLineNo_ + lineCount_ - 1);
+    if (first > last) {
+        return 0;
     }
 
-    std::vector<Line*> toDelete;
-    for (int no = startLineNo; no <= endLineNo; ++no) {
-        Line* line = findLine(no);
-        if (line) {
-            toDelete.push_back(line);
-        }
-    }
-
-    for (Line* line : toDelete) {
+    int count = static_cast<int>(last - first + 1);
+    searchCache_.noteErase(static_cast<int>(first - startLineNo_), count);
+    Line* line = findLine(first);
+    for (int i = 0; i < count && line; i++) {
+        Line* next = line->next();
         removeLine(line);
+        line = next;
     }
+    return count;
 }
 
-bool ActiveZone::replaceInLine(int lineNo, const char* oldStr, const char* newStr) {
+bool ActiveZone::replaceInLine(LineNo lineNo, const char* oldStr, const char* newStr) {
     Line* line = findLine(lineNo);
     if (!line) {
         return false;
     }
-    return line->replace(oldStr, newStr);
+    if (!line->replace(oldStr, newStr)) {
+        return false;
+    }
+    markChanged(lineNo);
+    return true;
+}
+
+size_t ActiveZone::replaceInRange(LineNo startLineNo, LineNo endLineNo, const std::string& oldStr,
+                                  const std::string& newStr, bool global) {
+    if (oldStr.empty()) {
+        return 0;
+    }
+
+    Searcher searcher(oldStr);
+    size_t count = 0;
+    LineNo first = std::max(startLineNo, startLineNo_);
+    LineNo last = std::min(endLineNo, startLineNo_ + lineCount_ - 1);
+    Line* line = findLine(first);
+    for (LineNo no = first; no <= last && line; ++no) {
+        size_t replaced = line->replace(searcher, newStr, global);
+        if (replaced > 0) {
+            count += replaced;
+            searchCache_.noteChange(static_cast<int>(no - startLineNo_));
+        }
+        line = line->next();
+    }
+    return count;
 }
 
-std::vector<int> ActiveZone::findPattern(const char* pattern) const {
-    std::vector<int> results;
+std::vector<size_t> ActiveZone::apply(const EditPlan& plan) {
+    if (plan.originalStartLineNo() != startLineNo_ || plan.originalLineCount() != lineCount_) {
+        throw EditorException(ErrorCode::INVALID_RANGE,
+            "编辑计划与活区的行号范围不符");
+    }
+
+    // 相同的旧字符串只编译一个查找器
+    std::vector<Searcher> searchers;
+    searchers.reserve(plan.patterns().size());
+    for (const std::string& pattern : plan.patterns()) {
+        searchers.emplace_back(pattern);
+    }
+    const std::vector<EditPlan::Substitution>& substitutions = plan.substitutions();
+    std::vector<size_t> counts(substitutions.size(), 0);
+    auto substitute = [&](Line* line, const EditPlan::Row& row) {
+        bool changed = false;
+        plan.forEachSubstitution(row, [&](size_t id) {
+            const EditPlan::Substitution& substitution = substitutions[id];
+            size_t replaced = line->replace(searchers[substitution.pattern], substitution.newStr, substitution.global);
+            counts[id] += replaced;
+            changed = changed || replaced > 0;
+        });
+        return changed;
+    };
+    // 被删除的行上的替换只用来判断有没有匹配：链上的替换都已在别处替换过时不必执行
+    auto undecided = [&](const EditPlan::Row& row) {
+        bool found = false;
+        plan.forEachSubstitution(row, [&](size_t id) { found = found || counts[id] == 0; });
+        return found;
+    };
+    std::vector<int> droppedOrigins;
+    std::vector<const EditPlan::Row*> droppedInserts;
+    for (const EditPlan::Row& dropped : plan.droppedRows()) {
+        if (dropped.origin < 0) {
+            droppedInserts.push_back(&dropped);
+            continue;
+        }
+        if (droppedOrigins.empty()) {
+            droppedOrigins.assign(static_cast<size_t>(lineCount_), -1);
+        }
+        droppedOrigins[static_cast<size_t>(dropped.origin)] =
+            static_cast<int>(&dropped - plan.droppedRows().data());
+    }
+
+    // current 是下一个未处理的原有行，下标为 origin；previous 是新活区中已就位的最后一行，
+    // 其后的行在新活区中的下标为 row。日志按执行顺序记录，每段删除和每批插入各记一条
     Line* current = head_;
-    int currentNo = startLineNo_;
+    Line* previous = nullptr;
+    int origin = 0;
+    int row = 0;
+    auto eraseUntil = [&](int end) {
+        if (end > origin) {
+            searchCache_.noteErase(row, end - origin);
+        }
+        for (; origin < end; origin++) {
+            Line* next = current->next();
+            int dropped = droppedOrigins.empty() ? -1 : droppedOrigins[static_cast<size_t>(origin)];
+            if (dropped >= 0 && undecided(plan.droppedRows()[static_cast<size_t>(dropped)])) {
+                substitute(current, plan.droppedRows()[static_cast<size_t>(dropped)]);
+            }
+            removeLine(current);
+            current = next;
+        }
+    };
+
+    const std::vector<EditPlan::Row>& rows = plan.rows();
+    for (size_t i = 0; i < rows.size();) {
+        if (rows[i].origin >= 0) {
+            eraseUntil(rows[i].origin);
+            if (substitute(current, rows[i])) {
+                searchCache_.noteChange(row);
+            }
+            previous = current;
+            current = current->next();
+            origin++;
+            row++;
+            i++;
+            continue;
+        }
+
+        size_t batch = i;
+        for (; i < rows.size() && rows[i].origin < 0; i++) {
+            Line* line = new Line(plan.text(rows[i]).c_str());
+            substitute(line, rows[i]);
+            if (previous) {
+                insertAfter(previous, line);
+            } else {
+                line->setNext(head_);
+                if (head_) {
+                    head_->setPrev(line);
+                } else {
+                    tail_ = line;
+                }
+                head_ = line;
+                lineCount_++;
+            }
+            previous = line;
+        }
+        searchCache_.noteInsert(row, static_cast<int>(i - batch));
+        row += static_cast<int>(i - batch);
+    }
+    eraseUntil(plan.originalLineCount());
+    for (const EditPlan::Row* dropped : droppedInserts) {
+        if (undecided(*dropped)) {
+            Line line(plan.text(*dropped).c_str());
+            substitute(&line, *dropped);
+        }
+    }
+
+    startLineNo_ = plan.startLineNo();
+    return counts;
+}
+
+std::vector<LineNo> ActiveZone::findPattern(const char* pattern) const {
+    return findPattern(Searcher(pattern ? pattern : ""));
+}
+
+template <typename Match>
+std::vector<LineNo> ActiveZone::findCached(const std::string& key, Match match) const {
+    const std::vector<int>& rows = searchCache_.query(key, lineCount_,
+        [&](const std::vector<int>& candidates, std::vector<int>& out) {
+            // 候选行升序，沿链表只走一遍
+            const Line* current = head_;
+            int row = 0;
+            for (int candidate : candidates) {
+                while (current && row < candidate) {
+                    current = current->next();
+                    row++;
+                }
+                if (!current) {
+                    break;
+                }
+                if (match(current)) {
+                    out.push_back(candidate);
+                }
+            }
+        });
+
+    std::vector<LineNo> results;
+    results.reserve(rows.size());
+    for (int row : rows) {
+        results.push_back(startLineNo_ + row);
+    }
+    return results;
+}
+
+std::vector<LineNo> ActiveZone::findPattern(const Searcher& searcher) const {
+    std::string key = (searcher.ignoreCase() ? "s/i/" : "s//") + searcher.pattern();
+    return findCached(key, [&](const Line* line) {
+        return searcher.matches(line->head(), line->isAscii());
+    });
+}
+
+std::vector<LineNo> ActiveZone::findPattern(const Regex& regex) const {
+    std::string key = (regex.ignoreCase() ? "r/i/" : "r//") + regex.pattern();
+    return findCached(key, [&](const Line* line) {
+        return regex.search(line->head(), line->isAscii());
+    });
+}
+
+std::vector<LineNo> ActiveZone::findPattern(const FuzzySearcher& searcher) const {
+    std::string key = "f/" + std::to_string(searcher.maxErrors()) + "/" + searcher.pattern();
+    return findCached(key, [&](const Line* line) {
+        return searcher.matches(line->head());
+    });
+}
+
+std::vector<LineMatches> ActiveZone::findPatterns(const MultiSearcher& searcher) const {
+    std::vector<LineMatches> results;
+    std::vector<size_t> found;
+    Line* current = head_;
+    LineNo currentNo = startLineNo_;
 
     while (current) {
-        if (current->contains(pattern)) {
-            results.push_back(currentNo);
+        searcher.matchedPatterns(current->head(), found);
+        if (!found.empty()) {
+            results.push_back(LineMatches{ currentNo, found });
         }
         current = current->next();
         currentNo++;
@@ -128,7 +344,26 @@ std::vector<int> ActiveZone::findPattern(const char* pattern) const {
     return results;
 }
 
-std::string ActiveZone::display(int page) const {
+template <typename Matcher>
+size_t ActiveZone::findAllLines(const Matcher& matcher, std::vector<MatchPosition>& out) const {
+    size_t count = 0;
+    LineNo currentNo = startLineNo_;
+    for (const Line* current = head_; current; current = current->next(), currentNo++) {
+        count += matcher.findAll(current->head(), currentNo, out, current->isAscii());
+    }
+    return count;
+}
+
+size_t ActiveZone::findMatches(const Searcher& searcher, std::vector<MatchPosition>& out) const {
+    return findAllLines(searcher, out);
+}
+
+size_t ActiveZone::findMatches(const Regex& regex, std::vector<MatchPosition>& out) const {
+    return findAllLines(regex, out);
+}
+
+template <typename Matcher>
+std::string ActiveZone::displayPage(int page, const Matcher* highlight) const {
     std::ostringstream oss;
 
     int startIdx = page * PAGE_SIZE;
@@ -136,7 +371,7 @@ std::string ActiveZone::display(int page) const {
 
     Line* current = head_;
     int currentIdx = 0;
-    int currentNo = startLineNo_;
+    LineNo currentNo = startLineNo_;
 
     while (current && currentIdx < startIdx) {
         current = current->next();
@@ -144,8 +379,24 @@ std::string ActiveZone::display(int page) const {
         currentNo++;
     }
 
+    std::vector<MatchPosition> matches;
     while (current && currentIdx < endIdx) {
-        oss << std::setw(4) << currentNo << " " << current->getText() << "\n";
+        std::string text = current->getText();
+        oss << std::setw(4) << currentNo << " ";
+        matches.clear();
+        if (highlight) {
+            highlight->findAll(current->head(), currentNo, matches, current->isAscii());
+        }
+        size_t written = 0;
+        for (const MatchPosition& match : matches) {
+            oss.write(text.data() + written, static_cast<std::streamsize>(match.column - written));
+            oss << HIGHLIGHT_BEGIN;
+            oss.write(text.data() + match.column, static_cast<std::streamsize>(match.length));
+            oss << HIGHLIGHT_END;
+            written = match.column + match.length;
+        }
+        oss.write(text.data() + written, static_cast<std::streamsize>(text.size() - written));
+        oss << "\n";
         current = current->next();
         currentIdx++;
         currentNo++;
@@ -154,6 +405,18 @@ std::string ActiveZone::display(int page) const {
     return oss.str();
 }
 
+std::string ActiveZone::display(int page) const {
+    return displayPage<Searcher>(page, nullptr);
+}
+
+std::string ActiveZone::display(int page, const Searcher& highlight) const {
+    return displayPage(page, &highlight);
+}
+
+std::string ActiveZone::display(int page, const Regex& highlight) const {
+    return displayPage(page, &highlight);
+}
+
 int ActiveZone::totalPages() const {
     return (lineCount_ + PAGE_SIZE - 1) / PAGE_SIZE;
 }
@@ -168,6 +431,7 @@ void ActiveZone::clear() {
     head_ = nullptr;
     tail_ = nullptr;
     lineCount_ = 0;
+    searchCache_.invalidate();
 }
 
 void ActiveZone::appendLine(Line* line) {
@@ -180,6 +444,7 @@ void ActiveZone::appendLine(Line* line) {
         line->setPrev(tail_);
     }
     tail_ = line;
+    searchCache_.noteInsert(lineCount_, 1);
     lineCount_++;
 }
 
@@ -199,6 +464,7 @@ Line* ActiveZone::removeFirst() {
     first->setNext(nullptr);
     lineCount_--;
     startLineNo_++;
+    searchCache_.noteErase(0, 1);
 
     return first;
 }
@@ -218,6 +484,7 @@ Line* ActiveZone::removeLast() {
     last->setPrev(nullptr);
     last->setNext(nullptr);
     lineCount_--;
+    searchCache_.noteErase(lineCount_, 1);
 
     return last;
 }
@@ -268,15 +535,15 @@ void ActiveZone::removeLine(Line* line) {
     lineCount_--;
 }
 
-Line* ActiveZone::findLine(int lineNo) const {
+Line* ActiveZone::findLine(LineNo lineNo) const {
     if (lineNo < startLineNo_ || lineNo >= startLineNo_ + lineCount_) {
         return nullptr;
     }
 
-    int relativeIdx = lineNo - startLineNo_;
+    LineNo relativeIdx = lineNo - startLineNo_;
     Line* current = head_;
 
-    for (int i = 0; i < relativeIdx && current; ++i) {
+    for (LineNo i = 0; i < relativeIdx && current; ++i) {
         current = current->next();
     }
 
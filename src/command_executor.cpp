@@ -1,11 +1,30 @@
 #include "command_executor.h"
-#include <sstream>
-#include <iomanip>
+#include "file_search.h"
+#include "trigram_index.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
 
 namespace line_editor {
 
+namespace {
+
+// 把前 count 个行号以 ", " 分隔追加到 out。脚本中的查找命令很多，逐个 to_chars 比 ostringstream 快得多
+void appendLineList(std::string& out, const std::vector<LineNo>& lines, size_t count) {
+    char digits[24];
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            out += ", ";
+        }
+        std::to_chars_result end = std::to_chars(digits, digits + sizeof(digits), lines[i]);
+        out.append(digits, end.ptr);
+    }
+}
+
+} // anonymous namespace
+
 CommandExecutor::CommandExecutor(ActiveZone& zone, FileManager& fileMgr)
-    : zone_(zone), fileMgr_(fileMgr), pendingInsertLineNo_(-1) {
+    : zone_(zone), fileMgr_(fileMgr), pendingInsertLineNo_(-1), zoneInputStart_(1), highlight_(false) {
 }
 
 ExecutionResult CommandExecutor::execute(const Command& cmd) {
@@ -22,38 +41,37 @@ ExecutionResult CommandExecutor::execute(const Command& cmd) {
             return executeReplace(cmd);
         case CommandType::MATCH:
             return executeMatch(cmd);
+        case CommandType::FILE_MATCH:
+            return executeFileMatch(cmd);
+        case CommandType::GOTO:
+            return executeGoto(cmd);
         case CommandType::QUIT:
             return executeQuit(cmd);
         default:
-            ExecutionResult result;
-            result.success = false;
-            result.message = "未知命令";
-            return result;
+            return ExecutionResult::failure(ErrorCode::UNKNOWN_COMMAND, ResultKind::UNKNOWN_COMMAND);
     }
 }
 
-ExecutionResult CommandExecutor::executeInsert(int lineNo, const std::string& text) {
+ExecutionResult CommandExecutor::executeInsert(LineNo lineNo, const std::string& text) {
     ExecutionResult result;
 
     try {
         zone_.insert(lineNo, text.c_str());
-        result.success = true;
-        result.message = "已在第 " + std::to_string(lineNo) + " 行后插入";
+        result.kind = ResultKind::INSERTED;
+        result.lineNo = lineNo;
     } catch (const EditorException& e) {
-        result.success = false;
-        result.message = e.what();
+        return ExecutionResult::failure(e);
     }
 
     return result;
 }
 
 ExecutionResult CommandExecutor::executeInsert(const Command& cmd) {
-    ExecutionResult result;
-
     if (cmd.text.empty()) {
-        result.needsInput = true;
+        ExecutionResult result;
+        result.status = ExecStatus::NEEDS_INPUT;
+        result.kind = ResultKind::INSERT_PROMPT;
         setPendingInsertLineNo(cmd.lineNo);
-        result.message = "请输入要插入的文本（空行完成）:";
         return result;
     }
 
@@ -61,23 +79,10 @@ ExecutionResult CommandExecutor::executeInsert(const Command& cmd) {
 }
 
 ExecutionResult CommandExecutor::executeDelete(const Command& cmd) {
+    // 行号已由 validate 检查过，deleteRange 本身不抛异常
     ExecutionResult result;
-
-    try {
-        if (cmd.lineNo2 != 0) {
-            zone_.deleteRange(cmd.lineNo, cmd.lineNo2);
-            result.message = "已删除第 " + std::to_string(cmd.lineNo) +
-                           " 到 " + std::to_string(cmd.lineNo2) + " 行";
-        } else {
-            zone_.deleteLine(cmd.lineNo);
-            result.message = "已删除第 " + std::to_string(cmd.lineNo) + " 行";
-        }
-        result.success = true;
-    } catch (const EditorException& e) {
-        result.success = false;
-        result.message = e.what();
-    }
-
+    result.kind = ResultKind::DELETED;
+    result.count = static_cast<size_t>(zone_.deleteRange(cmd.lineNo, cmd.lineNo2 != 0 ? cmd.lineNo2 : cmd.lineNo));
     return result;
 }
 
@@ -91,27 +96,28 @@ ExecutionResult CommandExecutor::executeNextZone(const Command& cmd) {
             }
         }
 
-        int newStart = zone_.startLineNo() + zone_.lineCount();
+        LineNo newStart = zone_.startLineNo() + zone_.lineCount();
         zone_.clear();
         zone_.setStartLineNo(newStart);
+        zoneInputStart_ = fileMgr_.linesRead() + 1;
 
         if (fileMgr_.isInputOpen() && !fileMgr_.isInputEof()) {
             std::vector<std::string> lines;
-            int count = fileMgr_.readLines(lines, 80);
+            int count = fileMgr_.readLines(lines, ZONE_LOAD_LINES);
 
-            for (const auto& lineStr : lines) {
-                zone_.appendLine(new Line(lineStr.c_str()));
+            for (size_t i = 0; i < lines.size(); i++) {
+                Line* line = new Line(lines[i].c_str());
+                line->setOrigin(static_cast<int>(i));
+                zone_.appendLine(line);
             }
 
-            result.message = "活区已刷新。已加载 " + std::to_string(count) + " 行。";
+            result.kind = ResultKind::ZONE_LOADED;
+            result.count = static_cast<size_t>(count);
         } else {
-            result.message = "活区已写入输出。没有更多输入。";
+            result.kind = ResultKind::ZONE_WRITTEN;
         }
-
-        result.success = true;
     } catch (const EditorException& e) {
-        result.success = false;
-        result.message = e.what();
+        return ExecutionResult::failure(e);
     }
 
     return result;
@@ -122,7 +128,7 @@ ExecutionResult CommandExecutor::executePrint(const Command& cmd) {
 
     try {
         if (zone_.isEmpty()) {
-            result.message = "活区为空";
+            result.kind = ResultKind::ZONE_EMPTY;
         } else {
             int totalPages = zone_.totalPages();
             int displayPage = cmd.pageNum;
@@ -133,61 +139,264 @@ ExecutionResult CommandExecutor::executePrint(const Command& cmd) {
                 displayPage = totalPages - 1;
             }
 
-            result.output = zone_.display(displayPage);
-            result.message = "正在显示第 " + std::to_string(displayPage + 1) +
-                           " 页，共 " + std::to_string(totalPages) + " 页";
+            PagePayload& page = result.payload.emplace<PagePayload>();
+            if (highlight_ && highlightRegex_) {
+                page.output = zone_.display(displayPage, *highlightRegex_);
+            } else if (highlight_ && highlightSearcher_) {
+                page.output = zone_.display(displayPage, *highlightSearcher_);
+            } else {
+                page.output = zone_.display(displayPage);
+            }
+            result.kind = ResultKind::PAGE;
+            page.page = displayPage;
+            page.pages = totalPages;
         }
-        result.success = true;
     } catch (const EditorException& e) {
-        result.success = false;
-        result.message = e.what();
+        return ExecutionResult::failure(e);
     }
 
     return result;
 }
 
+namespace {
+
+// s 命令作用的行，如 "第 3 行" 或 "第 3 到 7 行"
+std::string replaceRange(const Command& cmd) {
+    LineNo last = cmd.lineNo2 != 0 ? cmd.lineNo2 : cmd.lineNo;
+    return (last == cmd.lineNo)
+        ? "第 " + std::to_string(cmd.lineNo) + " 行"
+        : "第 " + std::to_string(cmd.lineNo) + " 到 " + std::to_string(last) + " 行";
+}
+
+} // anonymous namespace
+
+std::string CommandExecutor::replaceNotFoundMessage(const Command& cmd) {
+    return "在" + replaceRange(cmd) + "中未找到模式 '" + cmd.oldStr + "'";
+}
+
 ExecutionResult CommandExecutor::executeReplace(const Command& cmd) {
     ExecutionResult result;
 
     try {
-        bool replaced = zone_.replaceInLine(cmd.lineNo, cmd.oldStr.c_str(), cmd.newStr.c_str());
-
-        if (replaced) {
-            result.message = "已在第 " + std::to_string(cmd.lineNo) + " 行将 '" + cmd.oldStr + "' 替换为 '" + cmd.newStr + "'";
-            result.success = true;
+        if (cmd.lineNo2 != 0 || cmd.global) {
+            // 范围或全局替换：整个范围共用一个查找器，报告替换次数
+            LineNo last = cmd.lineNo2 != 0 ? cmd.lineNo2 : cmd.lineNo;
+            result.count = zone_.replaceInRange(cmd.lineNo, last, cmd.oldStr, cmd.newStr, cmd.global);
         } else {
-            result.message = "在第 " + std::to_string(cmd.lineNo) + " 行中未找到模式 '" + cmd.oldStr + "'";
-            result.success = false;
+            result.count = zone_.replaceInLine(cmd.lineNo, cmd.oldStr.c_str(), cmd.newStr.c_str()) ? 1 : 0;
         }
     } catch (const EditorException& e) {
-        result.success = false;
-        result.message = e.what();
+        return ExecutionResult::failure(e);
     }
 
+    if (result.count == 0) {
+        return ExecutionResult::failure(ErrorCode::PATTERN_NOT_FOUND, ResultKind::NOT_REPLACED);
+    }
+    result.kind = ResultKind::REPLACED;
     return result;
 }
 
 ExecutionResult CommandExecutor::executeMatch(const Command& cmd) {
+    if (!cmd.patterns.empty() || !cmd.patternFile.empty()) {
+        return executeMultiMatch(cmd);
+    }
+
     ExecutionResult result;
 
     try {
-        std::vector<int> matches = zone_.findPattern(cmd.pattern.c_str());
+        // 模式只编译一次，活区每一行复用同一个查找器；重复的查找由活区的缓存增量更新
+        const SearchCache& cache = zone_.searchCache();
+        size_t hitsBefore = cache.hits();
+        size_t rescannedBefore = cache.rescannedRows();
+        std::vector<LineNo> matches;
+        if (cmd.fuzzy) {
+            // 近似匹配没有确定的范围，不参与高亮
+            FuzzySearcher searcher(cmd.pattern, cmd.maxErrors);
+            highlightSearcher_.reset();
+            highlightRegex_.reset();
+            matches = zone_.findPattern(searcher);
+        } else if (cmd.regex) {
+            highlightRegex_ = regexCache_.get(cmd.pattern, cmd.ignoreCase);
+            highlightSearcher_.reset();
+            matches = zone_.findPattern(*highlightRegex_);
+        } else {
+            highlightSearcher_.reset(new Searcher(cmd.pattern));
+            highlightRegex_.reset();
+            matches = zone_.findPattern(*highlightSearcher_);
+        }
+
+        result.kind = ResultKind::MATCHED;
+        MatchPayload& found = result.payload.emplace<MatchPayload>();
+        found.lines = std::move(matches);
+        found.cacheHit = cache.hits() > hitsBefore;
+        found.rescanned = cache.rescannedRows() - rescannedBefore;
+    } catch (const EditorException& e) {
+        return ExecutionResult::failure(e);
+    }
+
+    return result;
+}
+
+namespace {
+
+// 模式文件每行一个模式，忽略空行和行尾的 \r
+std::vector<std::string> loadPatternFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw EditorException(ErrorCode::FILE_OPEN_FAILED, "无法打开模式文件: " + path);
+    }
+
+    std::vector<std::string> patterns;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            patterns.push_back(line);
+        }
+    }
+    if (patterns.empty()) {
+        throw EditorException(ErrorCode::MISSING_PARAMETER, "模式文件为空: " + path);
+    }
+    return patterns;
+}
+
+} // anonymous namespace
+
+ExecutionResult CommandExecutor::executeMultiMatch(const Command& cmd) {
+    ExecutionResult result;
+
+    try {
+        std::vector<std::string> patterns =
+            cmd.patternFile.empty() ? cmd.patterns : loadPatternFile(cmd.patternFile);
+        if (!multiSearcher_ || multiSearcher_->patterns() != patterns) {
+            multiSearcher_.reset(new MultiSearcher(patterns));
+        }
+
+        result.kind = ResultKind::MULTI_MATCHED;
+        MultiMatchPayload& found = result.payload.emplace<MultiMatchPayload>();
+        found.lineMatches = zone_.findPatterns(*multiSearcher_);
+        if (!cmd.patternFile.empty()) {
+            found.patterns = std::move(patterns);
+        }
+    } catch (const EditorException& e) {
+        return ExecutionResult::failure(e);
+    }
+
+    return result;
+}
+
+namespace {
+
+// 全文件查找的结果最多列出这么多行号，其余只报告数量
+constexpr size_t MAX_LISTED_LINES = 1000;
 
-        if (matches.empty()) {
-            result.message = "未找到模式 '" + cmd.pattern + "'";
+} // anonymous namespace
+
+ExecutionResult CommandExecutor::executeFileMatch(const Command& cmd) {
+    ExecutionResult result;
+
+    try {
+        const std::string& path = fileMgr_.inputFilename();
+        if (!fileMgr_.isInputOpen() || path == STDIO_FILENAME) {
+            throw EditorException(ErrorCode::FILE_OPEN_FAILED, "全文件查找需要以普通文件作为输入");
+        }
+        if (fileMgr_.inputCompression() != Compression::NONE) {
+            throw EditorException(ErrorCode::FILE_OPEN_FAILED, "全文件查找不支持压缩的输入文件");
+        }
+
+        MappedFile file;
+        if (!file.open(path)) {
+            throw EditorException(ErrorCode::FILE_OPEN_FAILED, "无法映射输入文件: " + path);
+        }
+        // 与逐行读取一致，跳过 UTF-8 BOM
+        const char* data = file.data();
+        size_t size = file.size();
+        size_t bom = detectUtf8Bom(data, size);
+        data += bom;
+        size -= bom;
+
+        // 有可用的 trigram 索引时只查找可能命中的块，literals 是每个匹配必然包含其一的字面量
+        FileMatchPayload found;
+        TrigramIndex index;
+        bool indexed = index.open(TrigramIndex::sidecarPath(path)) && index.usableFor(file);
+        auto search = [&](const auto& matcher, const std::vector<std::string>& literals, bool ignoreCase) {
+            if (!indexed) {
+                return findLinesParallel(data, size, matcher);
+            }
+            IndexCandidates candidates = index.candidates(file, literals, ignoreCase);
+            found.indexed = true;
+            found.candidateBlocks = candidates.candidateBlocks;
+            found.indexBlocks = index.blockCount();
+            found.tailBytes = candidates.tailBytes;
+            return findLinesParallel(file.data(), candidates.ranges, matcher);
+        };
+
+        if (!cmd.patterns.empty() || !cmd.patternFile.empty()) {
+            std::vector<std::string> patterns =
+                cmd.patternFile.empty() ? cmd.patterns : loadPatternFile(cmd.patternFile);
+            if (!multiSearcher_ || multiSearcher_->patterns() != patterns) {
+                multiSearcher_.reset(new MultiSearcher(patterns));
+            }
+            found.lines = search(*multiSearcher_, patterns, false);
+            result.count = patterns.size();
+        } else if (cmd.fuzzy) {
+            // 每个近似匹配都原样包含至少一个片段；没有片段时索引不缩小范围
+            FuzzySearcher searcher(cmd.pattern, cmd.maxErrors);
+            found.lines = search(searcher, searcher.pieceLiterals(), false);
+        } else if (cmd.regex) {
+            std::shared_ptr<Regex> regex = regexCache_.get(cmd.pattern, cmd.ignoreCase);
+            found.lines = search(*regex, std::vector<std::string>{ regex->requiredLiteral() }, cmd.ignoreCase);
         } else {
-            std::ostringstream oss;
-            oss << "模式 '" << cmd.pattern << "' 在以下行中找到: ";
-            for (size_t i = 0; i < matches.size(); ++i) {
-                if (i > 0) oss << ", ";
-                oss << matches[i];
+            found.lines = search(Searcher(cmd.pattern), std::vector<std::string>{ cmd.pattern }, false);
+        }
+        result.kind = ResultKind::FILE_MATCHED;
+        result.payload = std::move(found);
+    } catch (const EditorException& e) {
+        return ExecutionResult::failure(e);
+    }
+
+    return result;
+}
+
+ExecutionResult CommandExecutor::executeGoto(const Command& cmd) {
+    ExecutionResult result;
+
+    try {
+        if (!fileMgr_.isInputOpen()) {
+            throw EditorException(ErrorCode::FILE_OPEN_FAILED, "没有打开的输入文件");
+        }
+        // 输入是顺序读取的，已经写出的活区不能再回到
+        if (cmd.lineNo < zoneInputStart_) {
+            throw EditorException(ErrorCode::LINE_NUMBER_OUT_OF_RANGE,
+                "输入第 " + std::to_string(cmd.lineNo) + " 行所在的活区已经写出，只能向后跳转");
+        }
+
+        int skipped = 0;
+        while (cmd.lineNo > fileMgr_.linesRead() && !fileMgr_.isInputEof()) {
+            ExecutionResult next = executeNextZone(cmd);
+            if (!next.ok()) {
+                return next;
             }
-            result.message = oss.str();
+            skipped++;
+        }
+        if (cmd.lineNo > fileMgr_.linesRead()) {
+            throw EditorException(ErrorCode::LINE_NUMBER_OUT_OF_RANGE,
+                "输入文件只有 " + std::to_string(fileMgr_.linesRead()) + " 行");
+        }
+
+        // 活区可能已经编辑过，按每行读入时的下标找到目标行现在的位置
+        LineNo lineNo = zone_.findOrigin(static_cast<int>(cmd.lineNo - zoneInputStart_));
+        if (lineNo == 0) {
+            throw EditorException(ErrorCode::LINE_NUMBER_OUT_OF_RANGE,
+                "输入第 " + std::to_string(cmd.lineNo) + " 行已从活区中删除");
         }
-        result.success = true;
+        result.kind = ResultKind::JUMPED;
+        result.lineNo = lineNo;
+        result.count = static_cast<size_t>(skipped);
     } catch (const EditorException& e) {
-        result.success = false;
-        result.message = e.what();
+        return ExecutionResult::failure(e);
     }
 
     return result;
@@ -195,10 +404,173 @@ ExecutionResult CommandExecutor::executeMatch(const Command& cmd) {
 
 ExecutionResult CommandExecutor::executeQuit(const Command& cmd) {
     ExecutionResult result;
-    result.success = true;
-    result.shouldExit = true;
-    result.message = "正在退出编辑器...";
+    result.status = ExecStatus::EXIT;
+    result.kind = ResultKind::QUIT;
+    return result;
+}
+
+ExecutionResult ExecutionResult::failure(ErrorCode error, ResultKind kind) {
+    ExecutionResult result;
+    result.status = ExecStatus::FAILED;
+    result.kind = kind;
+    result.error = error;
+    return result;
+}
+
+ExecutionResult ExecutionResult::failure(const EditorException& e) {
+    ExecutionResult result = failure(e.code(), ResultKind::ERROR_TEXT);
+    result.payload = ErrorPayload{ e.what() };
     return result;
 }
 
+const std::string& ExecutionResult::output() const {
+    static const std::string none;
+    const PagePayload* page = get<PagePayload>();
+    return page ? page->output : none;
+}
+
+const std::vector<LineNo>& ExecutionResult::lines() const {
+    static const std::vector<LineNo> none;
+    if (const MatchPayload* found = get<MatchPayload>()) {
+        return found->lines;
+    }
+    const FileMatchPayload* found = get<FileMatchPayload>();
+    return found ? found->lines : none;
+}
+
+std::string ExecutionResult::message(const Command& cmd) const {
+    std::string text;
+    appendMessage(cmd, text);
+    return text;
+}
+
+void ExecutionResult::appendMessage(const Command& cmd, std::string& out) const {
+    switch (kind) {
+        case ResultKind::NONE:
+            break;
+        case ResultKind::INSERTED:
+            out += "已在第 " + std::to_string(lineNo) + " 行后插入";
+            break;
+        case ResultKind::INSERT_PROMPT:
+            out += "请输入要插入的文本（空行完成）:";
+            break;
+        case ResultKind::DELETED:
+            out += "已删除第 " + std::to_string(cmd.lineNo);
+            if (cmd.lineNo2 != 0) {
+                out += " 到 " + std::to_string(cmd.lineNo2);
+            }
+            out += " 行";
+            break;
+        case ResultKind::ZONE_LOADED:
+            out += "活区已刷新。已加载 " + std::to_string(count) + " 行。";
+            break;
+        case ResultKind::ZONE_WRITTEN:
+            out += "活区已写入输出。没有更多输入。";
+            break;
+        case ResultKind::PAGE: {
+            const PagePayload& shown = std::get<PagePayload>(payload);
+            out += "正在显示第 " + std::to_string(shown.page + 1) + " 页，共 " + std::to_string(shown.pages) + " 页";
+            break;
+        }
+        case ResultKind::ZONE_EMPTY:
+            out += "活区为空";
+            break;
+        case ResultKind::REPLACED:
+            if (cmd.lineNo2 != 0 || cmd.global) {
+                out += "已在" + replaceRange(cmd) + "将 '" + cmd.oldStr + "' 替换为 '" + cmd.newStr +
+                       "'，共 " + std::to_string(count) + " 处";
+            } else {
+                out += "已在第 " + std::to_string(cmd.lineNo) + " 行将 '" + cmd.oldStr + "' 替换为 '" + cmd.newStr + "'";
+            }
+            break;
+        case ResultKind::MATCHED: {
+            const MatchPayload& found = std::get<MatchPayload>(payload);
+            std::string label = "模式 '" + cmd.pattern + "'";
+            if (cmd.fuzzy) {
+                label += "（编辑距离 ≤ " + std::to_string(cmd.maxErrors) + "）";
+            }
+            if (found.lines.empty()) {
+                out += "未找到" + label;
+            } else {
+                out += label + " 在以下行中找到: ";
+                appendLineList(out, found.lines, found.lines.size());
+            }
+            if (found.cacheHit) {
+                out += "（缓存命中，重新检查 " + std::to_string(found.rescanned) + " 行）";
+            }
+            break;
+        }
+        case ResultKind::MULTI_MATCHED: {
+            const MultiMatchPayload& found = std::get<MultiMatchPayload>(payload);
+            const std::vector<std::string>& names = found.patterns.empty() ? cmd.patterns : found.patterns;
+            if (found.lineMatches.empty()) {
+                out += "未找到任何模式（共 " + std::to_string(names.size()) + " 个）";
+                break;
+            }
+            std::vector<bool> hit(names.size(), false);
+            std::string list;
+            for (const LineMatches& match : found.lineMatches) {
+                list += "\n  " + std::to_string(match.lineNo) + ": ";
+                for (size_t i = 0; i < match.patterns.size(); ++i) {
+                    if (i > 0) list += ", ";
+                    list += names[match.patterns[i]];
+                    hit[match.patterns[i]] = true;
+                }
+            }
+            out += std::to_string(std::count(hit.begin(), hit.end(), true)) + "/" + std::to_string(names.size()) +
+                   " 个模式在 " + std::to_string(found.lineMatches.size()) + " 行中找到:" + list;
+            break;
+        }
+        case ResultKind::FILE_MATCHED: {
+            const FileMatchPayload& found = std::get<FileMatchPayload>(payload);
+            const std::vector<LineNo>& lines = found.lines;
+            std::string label;
+            if (!cmd.patterns.empty() || !cmd.patternFile.empty()) {
+                label = std::to_string(count) + " 个模式中的任意一个";
+            } else if (cmd.fuzzy) {
+                label = "模式 '" + cmd.pattern + "'（编辑距离 ≤ " + std::to_string(cmd.maxErrors) + "）";
+            } else {
+                label = "模式 '" + cmd.pattern + "'";
+            }
+            std::string indexNote;
+            if (found.indexed) {
+                indexNote = "（索引: 查找 " + std::to_string(found.candidateBlocks) + "/" +
+                            std::to_string(found.indexBlocks) + " 个块";
+                if (found.tailBytes > 0) {
+                    indexNote += "，及结尾未索引的 " + std::to_string(found.tailBytes) + " 字节";
+                }
+                indexNote += "）";
+            }
+            if (lines.empty()) {
+                out += "输入文件中未找到" + label + indexNote;
+                break;
+            }
+            out += label + " 在输入文件的 " + std::to_string(lines.size()) + " 行中找到: ";
+            size_t listed = std::min(lines.size(), MAX_LISTED_LINES);
+            appendLineList(out, lines, listed);
+            if (listed < lines.size()) {
+                out += " ...（另有 " + std::to_string(lines.size() - listed) + " 行）";
+            }
+            out += indexNote + "\n用 g<行号> 跳到所在的活区";
+            break;
+        }
+        case ResultKind::JUMPED:
+            out += "输入第 " + std::to_string(cmd.lineNo) + " 行位于活区第 " + std::to_string(lineNo) +
+                   " 行（跳过 " + std::to_string(count) + " 个活区）";
+            break;
+        case ResultKind::QUIT:
+            out += "正在退出编辑器...";
+            break;
+        case ResultKind::NOT_REPLACED:
+            out += CommandExecutor::replaceNotFoundMessage(cmd);
+            break;
+        case ResultKind::UNKNOWN_COMMAND:
+            out += "未知命令";
+            break;
+        case ResultKind::ERROR_TEXT:
+            out += std::get<ErrorPayload>(payload).detail;
+            break;
+    }
+}
+
 } // namespace line_editor
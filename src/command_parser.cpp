@@ -1,208 +1,465 @@
 #include "command_parser.h"
 #include <cctype>
-#include <sstream>
-#include <algorithm>
+#include <charconv>
+#include <limits>
 
 namespace line_editor {
 
-Command CommandParser::parse(const std::string& input) const {
-    std::string trimmed = input;
-    trimmed.erase(trimmed.begin(), std::find_if(trimmed.begin(), trimmed.end(),
-        [](int ch) { return !std::isspace(ch); }));
-    trimmed.erase(std::find_if(trimmed.rbegin(), trimmed.rend(),
-        [](int ch) { return !std::isspace(ch); }).base(), trimmed.end());
+namespace {
 
-    if (trimmed.empty()) {
-        Command cmd;
-        cmd.type = CommandType::UNKNOWN;
-        cmd.raw = input;
-        return cmd;
+bool isSpace(char ch) {
+    return std::isspace(static_cast<unsigned char>(ch)) != 0;
+}
+
+std::string_view trimLeft(std::string_view text) {
+    size_t i = 0;
+    while (i < text.size() && isSpace(text[i])) {
+        ++i;
+    }
+    return text.substr(i);
+}
+
+std::string_view trim(std::string_view text) {
+    text = trimLeft(text);
+    size_t n = text.size();
+    while (n > 0 && isSpace(text[n - 1])) {
+        --n;
+    }
+    return text.substr(0, n);
+}
+
+bool fail(ParseError& error, ErrorCode code, const char* text, std::string_view detail = std::string_view()) {
+    error.code = code;
+    error.text = text;
+    error.detail = detail;
+    return false;
+}
+
+// 去掉正则模式中 \/ 的转义，其他转义原样交给正则引擎
+std::string unescapeSlash(std::string_view body) {
+    std::string pattern;
+    pattern.reserve(body.size());
+    for (size_t i = 0; i < body.length(); ++i) {
+        if (body[i] == '\\' && i + 1 < body.length()) {
+            if (body[i + 1] != '/') {
+                pattern += body[i];
+            }
+            pattern += body[i + 1];
+            ++i;
+        } else {
+            pattern += body[i];
+        }
+    }
+    return pattern;
+}
+
+// 按未转义的 '|' 拆分 m|a|b|c 的模式列表，\| 表示字面的 '|'，空项忽略
+void splitPatterns(std::string_view list, std::vector<std::string>& patterns) {
+    std::string current;
+    for (size_t i = 0; i <= list.length(); ++i) {
+        if (i == list.length() || list[i] == '|') {
+            if (!current.empty()) {
+                patterns.push_back(current);
+            }
+            current.clear();
+        } else if (list[i] == '\\' && i + 1 < list.length() && list[i + 1] == '|') {
+            current += '|';
+            ++i;
+        } else {
+            current += list[i];
+        }
     }
+}
+
+} // anonymous namespace
 
+Command CommandView::toCommand() const {
     Command cmd;
-    cmd.raw = input;
+    cmd.type = type;
+    cmd.raw = std::string(raw);
+    cmd.lineNo = lineNo;
+    cmd.lineNo2 = lineNo2;
+    cmd.pageNum = pageNum;
+    cmd.text = std::string(text);
+    cmd.oldStr = std::string(oldStr);
+    cmd.newStr = std::string(newStr);
+    cmd.pattern = regex ? unescapeSlash(pattern) : std::string(pattern);
+    cmd.regex = regex;
+    cmd.flags = std::string(flags);
+    cmd.ignoreCase = ignoreCase;
+    cmd.global = global;
+    splitPatterns(patternList, cmd.patterns);
+    cmd.patternFile = std::string(patternFile);
+    cmd.fuzzy = fuzzy;
+    cmd.maxErrors = maxErrors;
+    return cmd;
+}
 
-    char first = std::tolower(trimmed[0]);
+Command CommandParser::parse(const std::string& input) const {
+    ParseResult result = tryParse(input);
+    if (!result.ok()) {
+        throw EditorException(result.error.code, result.error.message());
+    }
+    return result.command.toCommand();
+}
 
-    switch (first) {
+ParseResult CommandParser::tryParse(std::string_view input) const {
+    ParseResult result;
+    result.command.raw = input;
+    std::string_view trimmed = trim(input);
+    if (trimmed.empty()) {
+        return result;
+    }
+
+    // 大写 M 查找整个输入文件，与活区内的 m 区分
+    if (trimmed[0] == 'M') {
+        parseFileMatch(trimmed, result);
+        return result;
+    }
+
+    switch (std::tolower(static_cast<unsigned char>(trimmed[0]))) {
         case 'i':
-            return parseInsert(trimmed);
+            parseInsert(trimmed, result);
+            break;
         case 'd':
-            return parseDelete(trimmed);
+            parseDelete(trimmed, result);
+            break;
         case 'n':
-            cmd.type = CommandType::NEXT_ZONE;
-            return cmd;
+            result.command.type = CommandType::NEXT_ZONE;
+            break;
         case 'p':
-            return parsePrint(trimmed);
+            parsePrint(trimmed, result);
+            break;
         case 's':
-            return parseReplace(trimmed);
+            parseReplace(trimmed, result);
+            break;
         case 'm':
-            return parseMatch(trimmed);
+            parseMatch(trimmed, result);
+            break;
+        case 'g':
+            parseGoto(trimmed, result);
+            break;
         case 'q':
-            cmd.type = CommandType::QUIT;
-            return cmd;
+            result.command.type = CommandType::QUIT;
+            break;
         default:
-            cmd.type = CommandType::UNKNOWN;
-            return cmd;
+            break;
     }
+    return result;
 }
 
-void CommandParser::validate(const Command& cmd, int zoneStart, int zoneEnd) const {
+namespace {
+
+// 只用到类型和行号，Command 与 CommandView 共用
+template <typename Cmd>
+bool validateLines(const Cmd& cmd, LineNo zoneStart, LineNo zoneEnd, ParseError& error) {
     switch (cmd.type) {
         case CommandType::INSERT:
             if (cmd.lineNo < zoneStart - 1 || cmd.lineNo > zoneEnd) {
-                throw EditorException(ErrorCode::LINE_NUMBER_OUT_OF_RANGE,
-                    "插入行号超出范围");
+                return fail(error, ErrorCode::LINE_NUMBER_OUT_OF_RANGE, "插入行号超出范围");
             }
             break;
 
         case CommandType::DELETE:
             if (cmd.lineNo < zoneStart || cmd.lineNo > zoneEnd) {
-                throw EditorException(ErrorCode::LINE_NUMBER_OUT_OF_RANGE,
-                    "删除行号超出范围");
+                return fail(error, ErrorCode::LINE_NUMBER_OUT_OF_RANGE, "删除行号超出范围");
             }
             if (cmd.lineNo2 != 0) {
                 if (cmd.lineNo2 < zoneStart || cmd.lineNo2 > zoneEnd) {
-                    throw EditorException(ErrorCode::LINE_NUMBER_OUT_OF_RANGE,
-                        "删除结束行号超出范围");
+                    return fail(error, ErrorCode::LINE_NUMBER_OUT_OF_RANGE, "删除结束行号超出范围");
                 }
                 if (cmd.lineNo > cmd.lineNo2) {
-                    throw EditorException(ErrorCode::INVALID_RANGE,
-                        "起始行号大于结束行号");
+                    return fail(error, ErrorCode::INVALID_RANGE, "起始行号大于结束行号");
                 }
             }
             break;
 
         case CommandType::REPLACE:
             if (cmd.lineNo < zoneStart || cmd.lineNo > zoneEnd) {
-                throw EditorException(ErrorCode::LINE_NUMBER_OUT_OF_RANGE,
-                    "替换行号超出范围");
+                return fail(error, ErrorCode::LINE_NUMBER_OUT_OF_RANGE, "替换行号超出范围");
+            }
+            if (cmd.lineNo2 != 0) {
+                if (cmd.lineNo2 < zoneStart || cmd.lineNo2 > zoneEnd) {
+                    return fail(error, ErrorCode::LINE_NUMBER_OUT_OF_RANGE, "替换结束行号超出范围");
+                }
+                if (cmd.lineNo > cmd.lineNo2) {
+                    return fail(error, ErrorCode::INVALID_RANGE, "起始行号大于结束行号");
+                }
             }
             break;
 
         default:
             break;
     }
+    return true;
 }
 
-int CommandParser::parseLineNumber(const std::string& str) {
-    try {
-        return std::stoi(str);
-    } catch (...) {
-        throw EditorException(ErrorCode::INVALID_FORMAT,
-            "无效的行号: " + str);
+} // anonymous namespace
+
+void CommandParser::validate(const Command& cmd, LineNo zoneStart, LineNo zoneEnd) const {
+    ParseError error;
+    if (!validateLines(cmd, zoneStart, zoneEnd, error)) {
+        throw EditorException(error.code, error.message());
     }
 }
 
-Command CommandParser::parseInsert(const std::string& input) const {
-    Command cmd;
+bool CommandParser::validate(const Command& cmd, LineNo zoneStart, LineNo zoneEnd, ParseError& error) const {
+    return validateLines(cmd, zoneStart, zoneEnd, error);
+}
+
+bool CommandParser::validate(const CommandView& cmd, LineNo zoneStart, LineNo zoneEnd, ParseError& error) const {
+    return validateLines(cmd, zoneStart, zoneEnd, error);
+}
+
+LineNo CommandParser::parseLineNumber(const std::string& str) {
+    LineNo value = 0;
+    ParseError error;
+    if (!parseLineNumber(str, value, error)) {
+        throw EditorException(error.code, error.message());
+    }
+    return value;
+}
+
+bool CommandParser::parseLineNumber(std::string_view str, LineNo& value, ParseError& error) {
+    // 与 std::stoi 一样跳过前导空白、接受 '+'，忽略数字之后的内容
+    std::string_view digits = trimLeft(str);
+    if (!digits.empty() && digits[0] == '+') {
+        digits.remove_prefix(1);
+    }
+
+    const char* begin = digits.data();
+    std::from_chars_result result = std::from_chars(begin, begin + digits.size(), value);
+    if (result.ec == std::errc::result_out_of_range) {
+        return fail(error, ErrorCode::INVALID_FORMAT, "行号超出范围: ", str);
+    }
+    if (result.ec != std::errc() || result.ptr == begin) {
+        return fail(error, ErrorCode::INVALID_FORMAT, "无效的行号: ", str);
+    }
+    return true;
+}
+
+bool CommandParser::parseInsert(std::string_view input, ParseResult& result) const {
+    CommandView& cmd = result.command;
     cmd.type = CommandType::INSERT;
 
     if (input.length() < 2) {
-        throw EditorException(ErrorCode::MISSING_PARAMETER,
+        return fail(result.error, ErrorCode::MISSING_PARAMETER,
             "插入命令需要行号: i<行号>");
     }
 
     size_t spacePos = input.find(' ', 1);
-    std::string numStr;
-
-    if (spacePos != std::string::npos) {
-        numStr = input.substr(1, spacePos - 1);
+    std::string_view numStr = input.substr(1, spacePos == std::string_view::npos ? std::string_view::npos : spacePos - 1);
+    if (spacePos != std::string_view::npos) {
         cmd.text = input.substr(spacePos + 1);
-    } else {
-        numStr = input.substr(1);
     }
 
-    cmd.lineNo = parseLineNumber(numStr);
-    return cmd;
+    return parseLineNumber(numStr, cmd.lineNo, result.error);
 }
 
-Command CommandParser::parseDelete(const std::string& input) const {
-    Command cmd;
+bool CommandParser::parseDelete(std::string_view input, ParseResult& result) const {
+    CommandView& cmd = result.command;
     cmd.type = CommandType::DELETE;
 
     if (input.length() < 2) {
-        throw EditorException(ErrorCode::MISSING_PARAMETER,
+        return fail(result.error, ErrorCode::MISSING_PARAMETER,
             "删除命令需要行号: d<行号> 或 d<起始> <结束>");
     }
 
     size_t spacePos = input.find(' ', 1);
-
-    if (spacePos != std::string::npos) {
-        std::string startStr = input.substr(1, spacePos - 1);
-        std::string endStr = input.substr(spacePos + 1);
-        endStr.erase(endStr.begin(), std::find_if(endStr.begin(), endStr.end(),
-            [](int ch) { return !std::isspace(ch); }));
-
-        cmd.lineNo = parseLineNumber(startStr);
-        cmd.lineNo2 = parseLineNumber(endStr);
-    } else {
-        cmd.lineNo = parseLineNumber(input.substr(1));
-        cmd.lineNo2 = 0;
+    if (spacePos == std::string_view::npos) {
+        return parseLineNumber(input.substr(1), cmd.lineNo, result.error);
     }
-
-    return cmd;
+    return parseLineNumber(input.substr(1, spacePos - 1), cmd.lineNo, result.error) &&
+           parseLineNumber(trimLeft(input.substr(spacePos + 1)), cmd.lineNo2, result.error);
 }
 
-Command CommandParser::parseReplace(const std::string& input) const {
-    Command cmd;
+bool CommandParser::parseReplace(std::string_view input, ParseResult& result) const {
+    CommandView& cmd = result.command;
     cmd.type = CommandType::REPLACE;
 
     if (input.length() < 3) {
-        throw EditorException(ErrorCode::MISSING_PARAMETER,
+        return fail(result.error, ErrorCode::MISSING_PARAMETER,
             "替换命令需要: s<行号>@<旧字符串>@<新字符串>");
     }
 
     size_t at1 = input.find('@', 1);
-    if (at1 == std::string::npos) {
-        throw EditorException(ErrorCode::INVALID_FORMAT,
+    if (at1 == std::string_view::npos) {
+        return fail(result.error, ErrorCode::INVALID_FORMAT,
             "替换命令需要 @ 分隔符: s<行号>@<旧字符串>@<新字符串>");
     }
 
     size_t at2 = input.find('@', at1 + 1);
-    if (at2 == std::string::npos) {
-        throw EditorException(ErrorCode::INVALID_FORMAT,
+    if (at2 == std::string_view::npos) {
+        return fail(result.error, ErrorCode::INVALID_FORMAT,
             "替换命令需要两个 @ 分隔符: s<行号>@<旧字符串>@<新字符串>");
     }
 
-    std::string lineStr = input.substr(1, at1 - 1);
-    cmd.lineNo = parseLineNumber(lineStr);
-    cmd.oldStr = input.substr(at1 + 1, at2 - at1 - 1);
-    cmd.newStr = input.substr(at2 + 1);
+    // 行号部分可以是 <n> 或 <起始> <结束>
+    std::string_view lineStr = input.substr(1, at1 - 1);
+    size_t spacePos = lineStr.find_first_of(" \t", lineStr.find_first_not_of(" \t"));
+    if (spacePos != std::string_view::npos && lineStr.find_first_not_of(" \t", spacePos) != std::string_view::npos) {
+        if (!parseLineNumber(lineStr.substr(0, spacePos), cmd.lineNo, result.error) ||
+            !parseLineNumber(lineStr.substr(spacePos), cmd.lineNo2, result.error)) {
+            return false;
+        }
+    } else if (!parseLineNumber(lineStr, cmd.lineNo, result.error)) {
+        return false;
+    }
+    return parseReplacement(input.substr(at1 + 1), cmd.oldStr, cmd.newStr, cmd.global, result.error);
+}
+
+void CommandParser::parseReplacement(const std::string& spec, std::string& oldStr,
+                                     std::string& newStr, bool& global) {
+    std::string_view oldView;
+    std::string_view newView;
+    ParseError error;
+    if (!parseReplacement(spec, oldView, newView, global, error)) {
+        throw EditorException(error.code, error.message());
+    }
+    oldStr = std::string(oldView);
+    newStr = std::string(newView);
+}
 
-    return cmd;
+bool CommandParser::parseReplacement(std::string_view spec, std::string_view& oldStr,
+                                     std::string_view& newStr, bool& global, ParseError& error) {
+    size_t at = spec.find('@');
+    if (at == std::string_view::npos) {
+        return fail(error, ErrorCode::INVALID_FORMAT,
+            "替换需要 @ 分隔旧字符串和新字符串: <旧字符串>@<新字符串>[@g]");
+    }
+    oldStr = spec.substr(0, at);
+
+    // 结尾可选的 @ 或 @g；之后不是标志时 @ 属于新字符串
+    size_t last = spec.rfind('@');
+    std::string_view suffix = spec.substr(last + 1);
+    if (last > at && (suffix.empty() || suffix == "g")) {
+        newStr = spec.substr(at + 1, last - at - 1);
+        global = suffix == "g";
+    } else {
+        newStr = spec.substr(at + 1);
+        global = false;
+    }
+    return true;
 }
 
-Command CommandParser::parseMatch(const std::string& input) const {
-    Command cmd;
+bool CommandParser::parseMatch(std::string_view input, ParseResult& result) const {
+    CommandView& cmd = result.command;
     cmd.type = CommandType::MATCH;
 
-    if (input.length() > 1) {
-        cmd.pattern = input.substr(1);
-    } else {
-        cmd.pattern = "";
+    // m|a|b|c：多模式查找，列表留给 toCommand 拆分；只要有 '|' 以外的字符就至少有一项
+    if (input.length() > 1 && input[1] == '|') {
+        cmd.patternList = input.substr(2);
+        if (cmd.patternList.find_first_not_of('|') == std::string_view::npos) {
+            return fail(result.error, ErrorCode::MISSING_PARAMETER,
+                "多模式查找需要: m|<模式1>|<模式2>...");
+        }
+        return true;
     }
 
-    return cmd;
+    // m<文件：模式列表从文件读取
+    if (input.length() > 1 && input[1] == '<') {
+        size_t start = input.find_first_not_of(" \t", 2);
+        if (start == std::string_view::npos) {
+            return fail(result.error, ErrorCode::MISSING_PARAMETER,
+                "多模式查找需要: m<模式文件>");
+        }
+        cmd.patternFile = input.substr(start);
+        return true;
+    }
+
+    // m~k<模式>：编辑距离不超过 k（一位数字）的近似查找
+    if (input.length() > 1 && input[1] == '~') {
+        if (input.length() < 3 || !std::isdigit(static_cast<unsigned char>(input[2]))) {
+            return fail(result.error, ErrorCode::INVALID_FORMAT,
+                "近似查找格式: m~<编辑距离0-9><模式>");
+        }
+        if (input.length() == 3) {
+            return fail(result.error, ErrorCode::MISSING_PARAMETER,
+                "近似查找需要模式: m~<编辑距离><模式>");
+        }
+        cmd.fuzzy = true;
+        cmd.maxErrors = input[2] - '0';
+        cmd.pattern = input.substr(3);
+        return true;
+    }
+
+    // m/正则/：找最后一个未转义的 '/'；没有结尾 '/' 时仍按普通子串处理
+    if (input.length() > 2 && input[1] == '/') {
+        size_t close = std::string_view::npos;
+        for (size_t i = 2; i < input.length(); ++i) {
+            if (input[i] == '\\' && i + 1 < input.length()) {
+                ++i;
+            } else if (input[i] == '/') {
+                close = i;
+            }
+        }
+        if (close != std::string_view::npos) {
+            cmd.regex = true;
+            cmd.pattern = input.substr(2, close - 2);
+            cmd.flags = input.substr(close + 1);
+            for (size_t i = 0; i < cmd.flags.size(); ++i) {
+                if (cmd.flags[i] != 'i') {
+                    return fail(result.error, ErrorCode::INVALID_FORMAT,
+                        "未知的正则标志: ", cmd.flags.substr(i, 1));
+                }
+                cmd.ignoreCase = true;
+            }
+            return true;
+        }
+    }
+
+    cmd.pattern = input.substr(1);
+    return true;
 }
 
-Command CommandParser::parsePrint(const std::string& input) const {
-    Command cmd;
+bool CommandParser::parseFileMatch(std::string_view input, ParseResult& result) const {
+    if (!parseMatch(input, result)) {
+        return false;
+    }
+    CommandView& cmd = result.command;
+    cmd.type = CommandType::FILE_MATCH;
+
+    // 空模式会列出文件的每一行，对大文件没有意义
+    if (!cmd.regex && cmd.patternList.empty() && cmd.patternFile.empty() && cmd.pattern.empty()) {
+        return fail(result.error, ErrorCode::MISSING_PARAMETER,
+            "全文件查找需要模式: M<模式>、M/正则/ 或 M|<模式1>|<模式2>...");
+    }
+    return true;
+}
+
+bool CommandParser::parseGoto(std::string_view input, ParseResult& result) const {
+    CommandView& cmd = result.command;
+    cmd.type = CommandType::GOTO;
+
+    if (input.length() < 2) {
+        return fail(result.error, ErrorCode::MISSING_PARAMETER,
+            "跳转命令需要输入文件的行号: g<行号>");
+    }
+
+    if (!parseLineNumber(input.substr(1), cmd.lineNo, result.error)) {
+        return false;
+    }
+    if (cmd.lineNo < 1) {
+        return fail(result.error, ErrorCode::LINE_NUMBER_OUT_OF_RANGE,
+            "跳转行号必须从 1 开始");
+    }
+    return true;
+}
+
+bool CommandParser::parsePrint(std::string_view input, ParseResult& result) const {
+    CommandView& cmd = result.command;
     cmd.type = CommandType::PRINT;
 
     if (input.length() > 1) {
-        try {
-            int page = parseLineNumber(input.substr(1));
-            cmd.pageNum = (page > 0) ? (page - 1) : 0;
-        } catch (...) {
-            throw EditorException(ErrorCode::INVALID_FORMAT,
-                "无效的页码: " + input.substr(1));
+        LineNo page = 0;
+        if (!parseLineNumber(input.substr(1), page, result.error)) {
+            return fail(result.error, ErrorCode::INVALID_FORMAT,
+                "无效的页码: ", input.substr(1));
         }
-    } else {
-        cmd.pageNum = 0;
+        cmd.pageNum = (page > 0 && page <= std::numeric_limits<int>::max())
+            ? static_cast<int>(page - 1) : 0;
     }
-
-    return cmd;
+    return true;
 }
 
 } // namespace line_editor
@@ -0,0 +1,558 @@
+#include "compression.h"
+#include "error.h"
+#include <vector>
+
+#ifdef LINE_EDITOR_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef LINE_EDITOR_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace line_editor {
+
+namespace {
+
+constexpr size_t CHUNK_SIZE = 256 * 1024;
+constexpr size_t READ_SIZE = 64 * 1024;
+constexpr size_t QUEUE_DEPTH = 4;
+
+bool endsWith(const std::string& str, const char* suffix) {
+    std::string s(suffix);
+    return str.size() >= s.size() &&
+           str.compare(str.size() - s.size(), s.size(), s) == 0;
+}
+
+} // anonymous namespace
+
+// 流式编解码器：process 消费全部输入并把产生的数据追加到 out
+class StreamCodec {
+public:
+    virtual ~StreamCodec() = default;
+
+    virtual bool process(const char* data, size_t size, std::string& out) = 0;
+    virtual bool finish(std::string& out) = 0;
+
+    const std::string& error() const { return error_; }
+
+protected:
+    std::string error_;
+};
+
+namespace {
+
+#ifdef LINE_EDITOR_HAVE_ZLIB
+
+class GzipDecoder : public StreamCodec {
+public:
+    GzipDecoder() : ended_(false) {
+        // 15 + 32: 自动识别 gzip/zlib 头
+        if (inflateInit2(&zs_, 15 + 32) != Z_OK) {
+            throw EditorException(ErrorCode::COMPRESSION_FAILED,
+                "Failed to initialize gzip decoder");
+        }
+    }
+
+    ~GzipDecoder() override { inflateEnd(&zs_); }
+
+    bool process(const char* data, size_t size, std::string& out) override {
+        char buffer[READ_SIZE];
+        zs_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        zs_.avail_in = static_cast<uInt>(size);
+
+        do {
+            // 多个 gzip 成员拼接在一起时继续解下一个成员
+            if (ended_ && zs_.avail_in > 0) {
+                inflateReset(&zs_);
+                ended_ = false;
+            }
+
+            zs_.next_out = reinterpret_cast<Bytef*>(buffer);
+            zs_.avail_out = sizeof(buffer);
+
+            int ret = inflate(&zs_, Z_NO_FLUSH);
+            size_t produced = sizeof(buffer) - zs_.avail_out;
+            out.append(buffer, produced);
+
+            if (ret == Z_STREAM_END) {
+                ended_ = true;
+            } else if (ret == Z_BUF_ERROR) {
+                if (produced == 0) {
+                    break;
+                }
+            } else if (ret != Z_OK) {
+                error_ = std::string("Corrupt gzip stream: ") + (zs_.msg ? zs_.msg : "unknown error");
+                return false;
+            }
+        } while (zs_.avail_in > 0 || zs_.avail_out == 0);
+
+        return true;
+    }
+
+    bool finish(std::string&) override {
+        if (!ended_) {
+            error_ = "Truncated gzip stream";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    z_stream zs_{};
+    bool ended_;
+};
+
+class GzipEncoder : public StreamCodec {
+public:
+    GzipEncoder() {
+        // 15 + 16: 输出 gzip 头而不是 zlib 头
+        if (deflateInit2(&zs_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw EditorException(ErrorCode::COMPRESSION_FAILED,
+                "Failed to initialize gzip encoder");
+        }
+    }
+
+    ~GzipEncoder() override { deflateEnd(&zs_); }
+
+    bool process(const char* data, size_t size, std::string& out) override {
+        zs_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        zs_.avail_in = static_cast<uInt>(size);
+        return run(Z_NO_FLUSH, out);
+    }
+
+    bool finish(std::string& out) override {
+        zs_.next_in = nullptr;
+        zs_.avail_in = 0;
+        return run(Z_FINISH, out);
+    }
+
+private:
+    bool run(int flush, std::string& out) {
+        char buffer[READ_SIZE];
+        int ret;
+        do {
+            zs_.next_out = reinterpret_cast<Bytef*>(buffer);
+            zs_.avail_out = sizeof(buffer);
+            ret = deflate(&zs_, flush);
+            if (ret == Z_STREAM_ERROR) {
+                error_ = "gzip compression failed";
+                return false;
+            }
+            out.append(buffer, sizeof(buffer) - zs_.avail_out);
+        } while (zs_.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+        return true;
+    }
+
+    z_stream zs_{};
+};
+
+#endif // LINE_EDITOR_HAVE_ZLIB
+
+#ifdef LINE_EDITOR_HAVE_ZSTD
+
+class ZstdDecoder : public StreamCodec {
+public:
+    ZstdDecoder() : stream_(ZSTD_createDStream()), lastRet_(0) {
+        if (!stream_ || ZSTD_isError(ZSTD_initDStream(stream_))) {
+            ZSTD_freeDStream(stream_);
+            throw EditorException(ErrorCode::COMPRESSION_FAILED,
+                "Failed to initialize zstd decoder");
+        }
+    }
+
+    ~ZstdDecoder() override { ZSTD_freeDStream(stream_); }
+
+    bool process(const char* data, size_t size, std::string& out) override {
+        char buffer[READ_SIZE];
+        ZSTD_inBuffer in = { data, size, 0 };
+
+        while (true) {
+            ZSTD_outBuffer output = { buffer, sizeof(buffer), 0 };
+            lastRet_ = ZSTD_decompressStream(stream_, &output, &in);
+            if (ZSTD_isError(lastRet_)) {
+                error_ = std::string("Corrupt zstd stream: ") + ZSTD_getErrorName(lastRet_);
+                return false;
+            }
+            out.append(buffer, output.pos);
+            if (in.pos == in.size && output.pos < output.size) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool finish(std::string&) override {
+        if (lastRet_ != 0) {
+            error_ = "Truncated zstd stream";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    ZSTD_DStream* stream_;
+    size_t lastRet_;
+};
+
+class ZstdEncoder : public StreamCodec {
+public:
+    ZstdEncoder() : ctx_(ZSTD_createCCtx()) {
+        if (!ctx_) {
+            throw EditorException(ErrorCode::COMPRESSION_FAILED,
+                "Failed to initialize zstd encoder");
+        }
+        ZSTD_CCtx_setParameter(ctx_, ZSTD_c_compressionLevel, 3);
+    }
+
+    ~ZstdEncoder() override { ZSTD_freeCCtx(ctx_); }
+
+    bool process(const char* data, size_t size, std::string& out) override {
+        return run(data, size, ZSTD_e_continue, out);
+    }
+
+    bool finish(std::string& out) override {
+        return run(nullptr, 0, ZSTD_e_end, out);
+    }
+
+private:
+    bool run(const char* data, size_t size, ZSTD_EndDirective mode, std::string& out) {
+        char buffer[READ_SIZE];
+        ZSTD_inBuffer in = { data, size, 0 };
+
+        while (true) {
+            ZSTD_outBuffer output = { buffer, sizeof(buffer), 0 };
+            size_t remaining = ZSTD_compressStream2(ctx_, &output, &in, mode);
+            if (ZSTD_isError(remaining)) {
+                error_ = std::string("zstd compression failed: ") + ZSTD_getErrorName(remaining);
+                return false;
+            }
+            out.append(buffer, output.pos);
+
+            bool done = (mode == ZSTD_e_end) ? (remaining == 0) : (in.pos == in.size);
+            if (done) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    ZSTD_CCtx* ctx_;
+};
+
+#endif // LINE_EDITOR_HAVE_ZSTD
+
+std::unique_ptr<StreamCodec> makeCodec(Compression compression, bool decode) {
+    switch (compression) {
+#ifdef LINE_EDITOR_HAVE_ZLIB
+        case Compression::GZIP:
+            if (decode) return std::unique_ptr<StreamCodec>(new GzipDecoder());
+            return std::unique_ptr<StreamCodec>(new GzipEncoder());
+#endif
+#ifdef LINE_EDITOR_HAVE_ZSTD
+        case Compression::ZSTD:
+            if (decode) return std::unique_ptr<StreamCodec>(new ZstdDecoder());
+            return std::unique_ptr<StreamCodec>(new ZstdEncoder());
+#endif
+        default:
+            break;
+    }
+    throw EditorException(ErrorCode::COMPRESSION_FAILED,
+        std::string("This build has no ") + compressionName(compression) + " support");
+}
+
+} // anonymous namespace
+
+Compression detectCompression(const char* data, size_t size) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+
+    if (size >= 2 && p[0] == 0x1F && p[1] == 0x8B) {
+        return Compression::GZIP;
+    }
+    if (size >= 4 && p[0] == 0x28 && p[1] == 0xB5 && p[2] == 0x2F && p[3] == 0xFD) {
+        return Compression::ZSTD;
+    }
+    return Compression::NONE;
+}
+
+Compression compressionFromFilename(const std::string& filename) {
+    if (endsWith(filename, ".gz")) {
+        return Compression::GZIP;
+    }
+    if (endsWith(filename, ".zst")) {
+        return Compression::ZSTD;
+    }
+    return Compression::NONE;
+}
+
+bool isCompressionSupported(Compression compression) {
+    switch (compression) {
+        case Compression::NONE:
+            return true;
+        case Compression::GZIP:
+#ifdef LINE_EDITOR_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Compression::ZSTD:
+#ifdef LINE_EDITOR_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char* compressionName(Compression compression) {
+    switch (compression) {
+        case Compression::GZIP: return "gzip";
+        case Compression::ZSTD: return "zstd";
+        default: return "none";
+    }
+}
+
+// ChunkQueue
+
+ChunkQueue::ChunkQueue(size_t capacity)
+    : capacity_(capacity), producerClosed_(false), consumerClosed_(false) {
+}
+
+bool ChunkQueue::push(std::string&& chunk) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notFull_.wait(lock, [this] { return chunks_.size() < capacity_ || consumerClosed_; });
+    if (consumerClosed_) {
+        return false;
+    }
+    chunks_.push_back(std::move(chunk));
+    notEmpty_.notify_one();
+    return true;
+}
+
+bool ChunkQueue::pop(std::string& chunk) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notEmpty_.wait(lock, [this] { return !chunks_.empty() || producerClosed_; });
+    if (chunks_.empty()) {
+        return false;
+    }
+    chunk = std::move(chunks_.front());
+    chunks_.pop_front();
+    notFull_.notify_one();
+    return true;
+}
+
+void ChunkQueue::closeProducer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    producerClosed_ = true;
+    notEmpty_.notify_all();
+}
+
+void ChunkQueue::closeConsumer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    consumerClosed_ = true;
+    chunks_.clear();
+    notFull_.notify_all();
+}
+
+// DecompressingStreamBuf
+
+DecompressingStreamBuf::DecompressingStreamBuf(Compression compression, std::streambuf* source)
+    : codec_(makeCodec(compression, true)), source_(source), queue_(QUEUE_DEPTH) {
+    setg(nullptr, nullptr, nullptr);
+    thread_ = std::thread(&DecompressingStreamBuf::worker, this);
+}
+
+DecompressingStreamBuf::~DecompressingStreamBuf() {
+    queue_.closeConsumer();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool DecompressingStreamBuf::failed() const {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    return !error_.empty();
+}
+
+std::string DecompressingStreamBuf::errorMessage() const {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    return error_;
+}
+
+void DecompressingStreamBuf::setError(const std::string& msg) {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    if (error_.empty()) {
+        error_ = msg;
+    }
+}
+
+DecompressingStreamBuf::int_type DecompressingStreamBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    if (!queue_.pop(current_)) {
+        return traits_type::eof();
+    }
+
+    char* begin = &current_[0];
+    setg(begin, begin, begin + current_.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+void DecompressingStreamBuf::worker() {
+    std::vector<char> input(READ_SIZE);
+    std::string output;
+    bool ok = true;
+
+    while (true) {
+        std::streamsize n = source_->sgetn(input.data(), static_cast<std::streamsize>(input.size()));
+        if (n <= 0) {
+            break;
+        }
+
+        if (!codec_->process(input.data(), static_cast<size_t>(n), output)) {
+            setError(codec_->error());
+            ok = false;
+            break;
+        }
+
+        // 攒够一块再交出，保证首块足以容纳 BOM 检测所需的回退
+        if (output.size() >= CHUNK_SIZE) {
+            if (!queue_.push(std::move(output))) {
+                queue_.closeProducer();
+                return;
+            }
+            output = std::string();
+        }
+    }
+
+    if (ok && !codec_->finish(output)) {
+        setError(codec_->error());
+    }
+
+    if (!output.empty()) {
+        queue_.push(std::move(output));
+    }
+    queue_.closeProducer();
+}
+
+// CompressingStreamBuf
+
+CompressingStreamBuf::CompressingStreamBuf(Compression compression, std::streambuf* sink)
+    : codec_(makeCodec(compression, false)), sink_(sink), queue_(QUEUE_DEPTH),
+      pending_(CHUNK_SIZE, '\0'), finished_(false) {
+    setp(&pending_[0], &pending_[0] + pending_.size());
+    thread_ = std::thread(&CompressingStreamBuf::worker, this);
+}
+
+CompressingStreamBuf::~CompressingStreamBuf() {
+    finish();
+}
+
+bool CompressingStreamBuf::failed() const {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    return !error_.empty();
+}
+
+std::string CompressingStreamBuf::errorMessage() const {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    return error_;
+}
+
+void CompressingStreamBuf::setError(const std::string& msg) {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    if (error_.empty()) {
+        error_ = msg;
+    }
+}
+
+bool CompressingStreamBuf::handOff() {
+    if (finished_) {
+        return false;
+    }
+
+    size_t used = static_cast<size_t>(pptr() - pbase());
+    if (used > 0) {
+        pending_.resize(used);
+        if (!queue_.push(std::move(pending_))) {
+            return false;
+        }
+        pending_ = std::string(CHUNK_SIZE, '\0');
+        setp(&pending_[0], &pending_[0] + pending_.size());
+    }
+
+    return !failed();
+}
+
+CompressingStreamBuf::int_type CompressingStreamBuf::overflow(int_type ch) {
+    if (!handOff()) {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int CompressingStreamBuf::sync() {
+    return handOff() ? 0 : -1;
+}
+
+bool CompressingStreamBuf::finish() {
+    if (finished_) {
+        return !failed();
+    }
+
+    handOff();
+    finished_ = true;
+    setp(nullptr, nullptr);
+
+    queue_.closeProducer();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    return !failed();
+}
+
+void CompressingStreamBuf::worker() {
+    std::string chunk;
+    std::string output;
+
+    auto flushOutput = [this, &output]() {
+        if (output.empty()) {
+            return true;
+        }
+        std::streamsize n = static_cast<std::streamsize>(output.size());
+        bool ok = sink_->sputn(output.data(), n) == n;
+        output.clear();
+        return ok;
+    };
+
+    while (queue_.pop(chunk)) {
+        if (!codec_->process(chunk.data(), chunk.size(), output)) {
+            setError(codec_->error());
+            queue_.closeConsumer();
+            return;
+        }
+        if (!flushOutput()) {
+            setError("Failed to write compressed output");
+            queue_.closeConsumer();
+            return;
+        }
+    }
+
+    if (!codec_->finish(output)) {
+        setError(codec_->error());
+        return;
+    }
+    if (!flushOutput() || sink_->pubsync() != 0) {
+        setError("Failed to write compressed output");
+    }
+}
+
+} // namespace line_editor
@@ -0,0 +1,86 @@
+#include "edit_plan.h"
+#include <algorithm>
+
+namespace line_editor {
+
+EditPlan::EditPlan(LineNo startLineNo, int lineCount, int maxLines)
+    : originalStart_(startLineNo),
+      originalCount_(lineCount),
+      startLineNo_(startLineNo),
+      maxLines_(maxLines),
+      commands_(0),
+      droppedInserts_(0),
+      droppedSubstitutions_(0) {
+    rows_.reserve(static_cast<size_t>(std::max(lineCount, maxLines)) + 1);
+    for (int i = 0; i < lineCount; i++) {
+        rows_.push_back(Row{ i, -1, -1, -1 });
+    }
+}
+
+void EditPlan::insert(LineNo afterLineNo, std::string_view text) {
+    // 与 ActiveZone::insert 相同：起始行之前插到开头，超出末尾追加到最后
+    size_t position = 0;
+    if (afterLineNo >= startLineNo_) {
+        position = std::min(static_cast<size_t>(afterLineNo - startLineNo_) + 1, rows_.size());
+    }
+    texts_.emplace_back(text);
+    Row row{ -1, static_cast<int>(texts_.size() - 1), -1, -1 };
+    rows_.insert(rows_.begin() + static_cast<std::ptrdiff_t>(position), row);
+    commands_++;
+
+    if (static_cast<int>(rows_.size()) > maxLines_) {
+        dropRows(0, 1);
+        startLineNo_++;
+    }
+}
+
+void EditPlan::erase(LineNo startLineNo, LineNo endLineNo) {
+    LineNo first = std::max(startLineNo, startLineNo_);
+    LineNo last = std::min(endLineNo, this->endLineNo());
+    commands_++;
+    if (first <= last) {
+        dropRows(static_cast<size_t>(first - startLineNo_), static_cast<size_t>(last - first + 1));
+    }
+}
+
+size_t EditPlan::substitute(LineNo startLineNo, LineNo endLineNo, std::string_view oldStr,
+                            std::string_view newStr, bool global) {
+    // 脚本里的替换模式通常不多，线性查找即可
+    size_t pattern = std::find(patterns_.begin(), patterns_.end(), oldStr) - patterns_.begin();
+    if (pattern == patterns_.size()) {
+        patterns_.emplace_back(oldStr);
+    }
+    size_t id = substitutions_.size();
+    substitutions_.push_back(Substitution{ pattern, std::string(newStr), global });
+    commands_++;
+
+    LineNo first = std::max(startLineNo, startLineNo_);
+    LineNo last = std::min(endLineNo, this->endLineNo());
+    for (LineNo no = first; no <= last; no++) {
+        Row& row = rows_[static_cast<size_t>(no - startLineNo_)];
+        int index = static_cast<int>(applied_.size());
+        applied_.push_back(Applied{ id, -1 });
+        if (row.lastApplied >= 0) {
+            applied_[static_cast<size_t>(row.lastApplied)].next = index;
+        } else {
+            row.firstApplied = index;
+        }
+        row.lastApplied = index;
+    }
+    return id;
+}
+
+void EditPlan::dropRows(size_t first, size_t count) {
+    auto begin = rows_.begin() + static_cast<std::ptrdiff_t>(first);
+    auto end = begin + static_cast<std::ptrdiff_t>(count);
+    for (auto row = begin; row != end; ++row) {
+        droppedInserts_ += row->origin < 0 ? 1 : 0;
+        if (row->firstApplied >= 0) {
+            forEachSubstitution(*row, [this](size_t) { droppedSubstitutions_++; });
+            droppedRows_.push_back(*row);
+        }
+    }
+    rows_.erase(begin, end);
+}
+
+} // namespace line_editor
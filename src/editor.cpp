@@ -1,25 +1,125 @@
 #include "editor.h"
+#include "incremental_search.h"
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+
+#ifdef _WIN32
+#include <conio.h>
+#include <cstdio>
+#include <io.h>
+#else
+#include <termios.h>
+#include <unistd.h>
+#endif
 
 namespace line_editor {
 
+namespace {
+
+// 标准输入是终端时切换到逐键读取、不回显的模式，析构时恢复
+class RawKeyboard {
+public:
+    RawKeyboard() : active_(false) {
+#ifdef _WIN32
+        active_ = _isatty(_fileno(stdin)) != 0;
+#else
+        if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved_) == 0) {
+            termios raw = saved_;
+            raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO | ISIG);
+            raw.c_cc[VMIN] = 1;
+            raw.c_cc[VTIME] = 0;
+            active_ = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+        }
+#endif
+    }
+
+    ~RawKeyboard() {
+#ifndef _WIN32
+        if (active_) {
+            tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
+        }
+#endif
+    }
+
+    RawKeyboard(const RawKeyboard&) = delete;
+    RawKeyboard& operator=(const RawKeyboard&) = delete;
+
+    bool active() const { return active_; }
+
+    // 返回读到的一个字节，输入结束时返回 -1
+    int read() {
+#ifdef _WIN32
+        int key = _getch();
+        // 功能键先返回 0 或 0xE0，再返回扫描码，整个丢弃
+        if (key == 0 || key == 0xE0) {
+            _getch();
+            return 0;
+        }
+        return key;
+#else
+        unsigned char byte;
+        return ::read(STDIN_FILENO, &byte, 1) == 1 ? byte : -1;
+#endif
+    }
+
+private:
+    bool active_;
+#ifndef _WIN32
+    termios saved_;
+#endif
+};
+
+// 在同一行上刷新当前模式和命中的行号；不支持转义序列时每次另起一行
+void showSearchProgress(const IncrementalSearch& search, bool escapes) {
+    constexpr size_t MAX_SHOWN = 8;
+    const std::vector<IncrementalSearch::Hit>& hits = search.hits();
+    std::ostringstream oss;
+    oss << "/" << search.pattern() << "  ";
+    if (search.pattern().empty()) {
+        oss << "（输入模式，回车确认，Esc 取消）";
+    } else {
+        oss << hits.size() << " 行";
+        for (size_t i = 0; i < hits.size() && i < MAX_SHOWN; i++) {
+            oss << (i == 0 ? ": " : ", ") << hits[i].lineNo;
+        }
+        if (hits.size() > MAX_SHOWN) {
+            oss << " ...";
+        }
+    }
+    std::cout << (escapes ? "\r\x1b[K" : "\n") << oss.str();
+    std::cout.flush();
+}
+
+} // anonymous namespace
+
 Editor::Editor()
     : zone_(DEFAULT_MAX_LINES),
       executor_(zone_, fileMgr_),
-      initialized_(false) {
+      initialized_(false),
+      quiet_(false),
+      failed_(false),
+      scriptLine_(0),
+      outputSink_(nullptr),
+      errorSink_(nullptr),
+      buildIndex_(false) {
 }
 
 bool Editor::init(const std::string& inputFile, const std::string& outputFile) {
-    if (inputFile == outputFile && !inputFile.empty()) {
-        std::cerr << "错误: 输入文件和输出文件不能相同。\n";
-        return false;
-    }
-
     inputFile_ = inputFile;
     outputFile_ = outputFile;
 
-    if (!inputFile.empty()) {
+    // 输入输出为同一文件时进入原地编辑模式
+    bool inPlace = FileManager::isSameFile(inputFile, outputFile);
+
+    if (inPlace) {
+        try {
+            fileMgr_.openInPlace(inputFile);
+        } catch (const EditorException& e) {
+            std::cerr << "错误: " << e.what() << "\n";
+            return false;
+        }
+    } else if (!inputFile.empty()) {
         try {
             fileMgr_.openInput(inputFile);
         } catch (const EditorException& e) {
@@ -28,7 +128,7 @@ bool Editor::init(const std::string& inputFile, const std::string& outputFile) {
         }
     }
 
-    if (!outputFile.empty()) {
+    if (!outputFile.empty() && !inPlace) {
         try {
             fileMgr_.openOutput(outputFile);
         } catch (const EditorException& e) {
@@ -39,10 +139,27 @@ bool Editor::init(const std::string& inputFile, const std::string& outputFile) {
 
     if (fileMgr_.isInputOpen()) {
         std::vector<std::string> lines;
-        fileMgr_.readLines(lines, 80);
+        try {
+            fileMgr_.readLines(lines, ZONE_LOAD_LINES);
+        } catch (const EditorException& e) {
+            std::cerr << "错误: " << e.what() << "\n";
+            return false;
+        }
 
-        for (const auto& lineStr : lines) {
-            zone_.appendLine(new Line(lineStr.c_str()));
+        for (size_t i = 0; i < lines.size(); i++) {
+            Line* line = new Line(lines[i].c_str());
+            line->setOrigin(static_cast<int>(i));
+            zone_.appendLine(line);
+        }
+    }
+
+    if (buildIndex_) {
+        // 索引描述磁盘上的输入文件；原地编辑会改写它，压缩文件和标准输入无法按偏移查找
+        if (inPlace || !fileMgr_.isInputOpen() || inputFile == STDIO_FILENAME ||
+            fileMgr_.inputCompression() != Compression::NONE) {
+            std::cerr << "警告: 只能为未压缩的普通输入文件（非原地编辑）构建索引，已忽略 --index\n";
+        } else if (!TrigramIndex::isCurrent(inputFile)) {
+            indexBuild_.reset(new BackgroundIndexBuild(inputFile));
         }
     }
 
@@ -56,6 +173,8 @@ void Editor::run() {
         return;
     }
 
+    // 只在交互终端上高亮，输出写到标准输出时不混入转义序列
+    executor_.setHighlight(!fileMgr_.isOutputStdout() && enableTerminalEscapes());
     showWelcome();
 
     std::string input;
@@ -69,16 +188,217 @@ void Editor::run() {
             break;
         }
 
-        running = processCommand(input);
+        running = processCommand(input, std::cin);
+    }
+
+    finish();
+}
+
+bool Editor::runScript(const std::vector<std::string>& commands) {
+    std::stringstream script;
+    for (const auto& command : commands) {
+        script << command << "\n";
+    }
+    return runScript(script);
+}
+
+bool Editor::runScript(std::istream& script) {
+    if (!initialized_) {
+        std::cerr << "编辑器未初始化。请先调用 init()。\n";
+        return false;
+    }
+
+    quiet_ = true;
+    size_t failedLine = executeScript(script);
+    if (failedLine != 0) {
+        // 后面的命令可能依赖出错命令的结果，继续执行只会得到难以预料的输出
+        std::cerr << "脚本第 " << failedLine << " 行出错，已停止执行，放弃其余输出。\n";
+        fileMgr_.abandon();
+        indexBuild_.reset();
+        return false;
+    }
+
+    flushOutput();
+    finish();
+    return true;
+}
+
+size_t Editor::runZone(const std::vector<std::string>& lines, std::istream& script, std::string& data,
+                       std::ostream& output, std::ostream& errors) {
+    zone_.clear();
+    zone_.setStartLineNo(1);
+    for (const std::string& text : lines) {
+        zone_.appendLine(new Line(text.c_str()));
+    }
+
+    quiet_ = true;
+    outputSink_ = &output;
+    errorSink_ = &errors;
+    size_t failedLine = executeScript(script);
+    flushOutput();
+    outputSink_ = nullptr;
+    errorSink_ = nullptr;
+
+    if (failedLine == 0) {
+        for (const Line* line = zone_.head(); line; line = line->next()) {
+            data += line->getText();
+            data += '\n';
+        }
+    }
+    return failedLine;
+}
+
+size_t Editor::executeScript(std::istream& script) {
+    scriptLine_ = 0;
+
+    std::string input;
+    size_t failedLine = 0;
+    bool running = true;
+    while (running && std::getline(script, input)) {
+        size_t line = ++scriptLine_;
+        if (planEdit(input, line, script)) {
+            continue;
+        }
+        // 其他命令要看到之前的编辑结果，先执行计划
+        failedLine = flushPlan();
+        if (failedLine != 0) {
+            break;
+        }
+        running = processCommand(input, script);
+        if (failed_) {
+            failedLine = line;
+            break;
+        }
+    }
+    if (failedLine == 0) {
+        failedLine = flushPlan();
     }
+    if (failedLine != 0) {
+        plan_.reset();
+        planned_.clear();
+    }
+    return failedLine;
+}
 
+bool Editor::planEdit(const std::string& input, size_t line, std::istream& source) {
+    ParseResult parsed = parser_.tryParse(input);
+    CommandType type = parsed.command.type;
+    if (!parsed.ok() ||
+        (type != CommandType::INSERT && type != CommandType::DELETE && type != CommandType::REPLACE)) {
+        return false;
+    }
+
+    if (!plan_) {
+        plan_.reset(new EditPlan(zone_.startLineNo(), zone_.lineCount(), zone_.maxLines()));
+    }
+    // 直接在解析结果上验证：无效的命令执行完计划后由 processCommand 按同样的活区报告
+    ParseError invalid;
+    if (!parser_.validate(parsed.command, plan_->startLineNo(), plan_->endLineNo(), invalid)) {
+        return false;
+    }
+
+    const CommandView& cmd = parsed.command;
+    LineNo last = cmd.lineNo2 != 0 ? cmd.lineNo2 : cmd.lineNo;
+    if (type == CommandType::INSERT) {
+        if (!cmd.text.empty()) {
+            plan_->insert(cmd.lineNo, cmd.text);
+        } else {
+            std::vector<std::string> lines;
+            readInsertText(source, lines);
+            for (size_t i = 0; i < lines.size(); i++) {
+                plan_->insert(cmd.lineNo + static_cast<LineNo>(i), lines[i]);
+            }
+        }
+    } else if (type == CommandType::DELETE) {
+        plan_->erase(cmd.lineNo, last);
+    } else {
+        plan_->substitute(cmd.lineNo, last, cmd.oldStr, cmd.newStr, cmd.global);
+        planned_.emplace_back(line, input);
+    }
+    return true;
+}
+
+size_t Editor::flushPlan() {
+    if (!plan_) {
+        return 0;
+    }
+    std::unique_ptr<EditPlan> plan = std::move(plan_);
+    std::vector<std::pair<size_t, std::string>> planned;
+    planned.swap(planned_);
+
+    std::vector<size_t> counts = zone_.apply(*plan);
+    for (size_t id = 0; id < counts.size(); id++) {
+        if (counts[id] == 0) {
+            Command cmd = parser_.parse(planned[id].second);
+            fail() << "错误: " << CommandExecutor::replaceNotFoundMessage(cmd) << "\n";
+            return planned[id].first;
+        }
+    }
+    return 0;
+}
+
+void Editor::finish() {
     if (fileMgr_.isOutputOpen() && !zone_.isEmpty()) {
         for (Line* line = zone_.head(); line; line = line->next()) {
             fileMgr_.writeLine(line->getText());
         }
     }
 
+    // 活区之后未读取的输入原样写入输出
+    if (fileMgr_.isOutputOpen()) {
+        unsigned long long copied = fileMgr_.copyRemainingInput();
+        if (copied > 0 && !quiet_) {
+            std::cout << "已将剩余的 " << copied << " 字节输入原样写入输出。\n";
+        }
+    }
+
     fileMgr_.close();
+
+    if (indexBuild_) {
+        if (!indexBuild_->finished() && !quiet_) {
+            std::cout << "等待后台索引构建完成...\n";
+        }
+        indexBuild_->wait();
+        if (!indexBuild_->error().empty()) {
+            std::cerr << "索引构建失败: " << indexBuild_->error() << "\n";
+        } else if (!quiet_) {
+            std::cout << "索引已写入 " << TrigramIndex::sidecarPath(inputFile_) << "\n";
+        }
+        indexBuild_.reset();
+    }
+}
+
+std::ostream& Editor::ui() const {
+    if (outputSink_) {
+        return *outputSink_;
+    }
+    return fileMgr_.isOutputStdout() ? std::cerr : std::cout;
+}
+
+void Editor::emit(const std::string& text) {
+    constexpr size_t BATCH_BYTES = 64 * 1024;
+    if (!quiet_) {
+        ui() << text;
+        return;
+    }
+    pendingOutput_ += text;
+    if (pendingOutput_.size() >= BATCH_BYTES) {
+        flushOutput();
+    }
+}
+
+void Editor::flushOutput() {
+    if (!pendingOutput_.empty()) {
+        ui().write(pendingOutput_.data(), static_cast<std::streamsize>(pendingOutput_.size()));
+        ui().flush();
+        pendingOutput_.clear();
+    }
+}
+
+std::ostream& Editor::fail() {
+    flushOutput();
+    failed_ = true;
+    return errorSink_ ? *errorSink_ : std::cerr;
 }
 
 void Editor::showWelcome() const {
@@ -105,7 +425,15 @@ void Editor::showHelp() const {
     std::cout << "  n            - 下一活区（保存当前，加载下一个）\n";
     std::cout << "  p [n]        - 打印当前活区（n=页码，默认第1页）\n";
     std::cout << "  s<n>@o@n     - 在第 n 行将 'o' 替换为 'n'\n";
+    std::cout << "  s<n1> <n2>@o@n@g - 在第 n1 到 n2 行替换（g: 每行全部替换），报告替换次数\n";
     std::cout << "  m<pattern>   - 在活区中查找模式\n";
+    std::cout << "  m/正则/[i]   - 按正则表达式查找（i: 不区分大小写）\n";
+    std::cout << "  m|a|b|...    - 一次查找多个模式，列出每行命中的模式\n";
+    std::cout << "  m<文件       - 同上，模式从文件读取（每行一个）\n";
+    std::cout << "  /            - 边输入边查找活区（回车按 m 执行，Esc 取消）；/<模式> 直接查找\n";
+    std::cout << "  m~k<pattern> - 近似查找：与模式的编辑距离不超过 k（0-9）的行（M~k 查找整个文件）\n";
+    std::cout << "  M<pattern>   - 多线程查找整个输入文件，报告输入行号（也支持 M/正则/、M|a|b）\n";
+    std::cout << "  g<n>         - 向后跳到输入第 n 行所在的活区（途经的活区写入输出）\n";
     std::cout << "  h            - 显示此帮助\n";
     std::cout << "  q            - 退出编辑器\n";
 }
@@ -121,96 +449,163 @@ void Editor::displayZone(int page) const {
               << (zone_.startLineNo() + zone_.lineCount() - 1) << " 行。\n";
 }
 
-bool Editor::processCommand(const std::string& input) {
+bool Editor::processCommand(const std::string& input, std::istream& source) {
+    failed_ = false;
     if (input.empty()) {
         return true;
     }
 
     if (input[0] == 'h' || input[0] == 'H') {
-        showHelp();
+        if (!quiet_) {
+            showHelp();
+        }
         return true;
     }
 
     Command cmd;
-    try {
-        cmd = parser_.parse(input);
-    } catch (const EditorException& e) {
-        std::cerr << "解析错误: " << e.what() << "\n";
-        return true;
+    if (input[0] == '/') {
+        // 边输入边查找，确认的模式按 m<模式> 执行
+        std::string pattern;
+        if (!searchAsYouType(input.substr(1), pattern)) {
+            return true;
+        }
+        cmd.type = CommandType::MATCH;
+        cmd.raw = input;
+        cmd.pattern = pattern;
+    } else {
+        ParseResult parsed = parser_.tryParse(input);
+        if (!parsed.ok()) {
+            fail() << "解析错误: " << parsed.error.message() << "\n";
+            return true;
+        }
+        cmd = parsed.command.toCommand();
     }
 
     if (cmd.type == CommandType::UNKNOWN) {
-        std::cerr << "未知命令: " << input << "\n";
-        std::cerr << "输入 'h' 获取帮助。\n";
+        fail() << "未知命令: " << input << "\n";
+        if (!quiet_) {
+            std::cerr << "输入 'h' 获取帮助。\n";
+        }
         return true;
     }
 
-    try {
-        parser_.validate(cmd, zone_.startLineNo(),
-                        zone_.startLineNo() + zone_.lineCount() - 1);
-    } catch (const EditorException& e) {
-        std::cerr << "验证错误: " << e.what() << "\n";
+    ParseError invalid;
+    if (!parser_.validate(cmd, zone_.startLineNo(), zone_.startLineNo() + zone_.lineCount() - 1, invalid)) {
+        fail() << "验证错误: " << invalid.message() << "\n";
         return true;
     }
 
     ExecutionResult result = executor_.execute(cmd);
 
-    if (!result.success) {
-        std::cerr << "错误: " << result.message << "\n";
+    if (!result.ok()) {
+        fail() << "错误: " << result.message(cmd) << "\n";
         return true;
     }
 
-    if (result.shouldExit) {
-        std::cout << result.message << "\n";
+    // 消息只在要显示时才格式化：脚本模式下只有查找命令的结果需要写出
+    if (result.shouldExit()) {
+        if (!quiet_) {
+            std::cout << result.message(cmd) << "\n";
+        }
         return false;
     }
 
-    if (result.needsInput) {
-        std::cout << result.message << "\n";
-        handleInsertMode(executor_.getPendingInsertLineNo());
+    if (result.needsInput()) {
+        if (!quiet_) {
+            std::cout << result.message(cmd) << "\n";
+        }
+        handleInsertMode(executor_.getPendingInsertLineNo(), source);
         return true;
     }
 
-    if (!result.message.empty()) {
-        std::cout << result.message << "\n";
+    if (!quiet_) {
+        std::string message = result.message(cmd);
+        if (!message.empty()) {
+            std::cout << message << "\n";
+        }
+    } else if (cmd.type == CommandType::MATCH || cmd.type == CommandType::FILE_MATCH) {
+        // 查找结果就是查找命令要求的输出，脚本模式下也写出
+        std::string message = result.message(cmd);
+        if (!message.empty()) {
+            message += '\n';
+            emit(message);
+        }
     }
 
-    if (!result.output.empty()) {
-        std::cout << "\n" << result.output;
+    // p、m 等命令的结果即使在脚本模式下也要输出
+    if (!result.output().empty()) {
+        emit(quiet_ ? result.output() : "\n" + result.output());
     }
 
-    if (cmd.type == CommandType::INSERT || cmd.type == CommandType::DELETE ||
-        cmd.type == CommandType::REPLACE) {
+    if (!quiet_ && (cmd.type == CommandType::INSERT || cmd.type == CommandType::DELETE ||
+        cmd.type == CommandType::REPLACE || cmd.type == CommandType::GOTO)) {
         displayZone();
     }
 
     return true;
 }
 
-void Editor::handleInsertMode(int lineNo) {
-    std::string text;
-    int insertedCount = 0;
+bool Editor::searchAsYouType(const std::string& keys, std::string& pattern) {
+    IncrementalSearch search(zone_);
+    if (!keys.empty()) {
+        // 命令行上给出的按键依次输入，DEL 或退格删除前一个字符
+        for (char key : keys) {
+            if (key == '\x7f' || key == '\b') {
+                search.backspace();
+            } else {
+                search.type(key);
+            }
+        }
+        pattern = search.pattern();
+        return !pattern.empty();
+    }
 
+    RawKeyboard keyboard;
+    if (quiet_ || !keyboard.active()) {
+        fail() << "边输入边查找需要终端；非交互时用 /<模式>\n";
+        return false;
+    }
+    bool escapes = enableTerminalEscapes();
+    showSearchProgress(search, escapes);
     while (true) {
-        std::cout << "  ";
-        if (!std::getline(std::cin, text)) {
-            break;
+        int key = keyboard.read();
+        if (key < 0 || key == 0x1b || key == 0x03) {
+            std::cout << "\n已取消查找\n";
+            return false;
         }
-
-        if (text.empty()) {
+        if (key == '\r' || key == '\n') {
             break;
         }
+        if (key == 0x7f || key == '\b') {
+            search.backspace();
+        } else if (key >= 0x20) {
+            search.type(static_cast<char>(key));
+        } else {
+            continue;
+        }
+        showSearchProgress(search, escapes);
+    }
+    std::cout << "\n";
+    pattern = search.pattern();
+    return !pattern.empty();
+}
+
+void Editor::handleInsertMode(LineNo lineNo, std::istream& source) {
+    std::vector<std::string> lines;
+    readInsertText(source, lines);
+    int insertedCount = 0;
 
+    for (const std::string& text : lines) {
         try {
             zone_.insert(lineNo + insertedCount, text.c_str());
             insertedCount++;
         } catch (const EditorException& e) {
-            std::cerr << "Error: " << e.what() << "\n";
+            fail() << "错误: " << e.what() << "\n";
             break;
         }
     }
 
-    if (insertedCount > 0) {
+    if (insertedCount > 0 && !quiet_) {
         std::cout << "已插入 " << insertedCount << " 行。\n";
         displayZone();
     }
@@ -218,4 +613,22 @@ void Editor::handleInsertMode(int lineNo) {
     executor_.clearPendingInsert();
 }
 
+void Editor::readInsertText(std::istream& source, std::vector<std::string>& lines) {
+    std::string text;
+    while (true) {
+        if (!quiet_) {
+            std::cout << "  ";
+        }
+        if (!std::getline(source, text)) {
+            break;
+        }
+        scriptLine_++;
+
+        if (text.empty()) {
+            break;
+        }
+        lines.push_back(text);
+    }
+}
+
 } // namespace line_editor
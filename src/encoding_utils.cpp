@@ -1,12 +1,111 @@
 #include "encoding_utils.h"
+#include <cstdint>
+#include <cstring>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LINE_EDITOR_HAVE_SSE2 1
+#include <emmintrin.h>
 #endif
 
 namespace line_editor {
 
+namespace {
+
+// 从 data 开始的 ASCII 前缀长度
+size_t asciiPrefix(const char* data, size_t size) {
+    size_t i = 0;
+
+#ifdef LINE_EDITOR_HAVE_SSE2
+    // 每次检查 64 字节，四个向量的最高位或在一起
+    while (i + 64 <= size) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 48));
+        __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        if (_mm_movemask_epi8(any) != 0) {
+            break;
+        }
+        i += 64;
+    }
+    while (i + 16 <= size) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(v) != 0) {
+            break;
+        }
+        i += 16;
+    }
+#else
+    // 无 SSE2 时一次检查 8 字节
+    while (i + 8 <= size) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        if (word & 0x8080808080808080ULL) {
+            break;
+        }
+        i += 8;
+    }
+#endif
+
+    while (i < size && static_cast<unsigned char>(data[i]) < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+// 以非 ASCII 字节开头的合法序列长度；非法时返回 0，
+// 并通过 invalidLen 给出最大非法子序列的长度
+size_t decodeSequence(const unsigned char* p, size_t avail, size_t& invalidLen) {
+    unsigned char c = p[0];
+    size_t len;
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xBF;
+
+    if (c >= 0xC2 && c <= 0xDF) {
+        len = 2;
+    } else if (c == 0xE0) {
+        len = 3; lo = 0xA0;         // 排除过长编码
+    } else if ((c >= 0xE1 && c <= 0xEC) || c == 0xEE || c == 0xEF) {
+        len = 3;
+    } else if (c == 0xED) {
+        len = 3; hi = 0x9F;         // 排除代理区 D800-DFFF
+    } else if (c == 0xF0) {
+        len = 4; lo = 0x90;
+    } else if (c >= 0xF1 && c <= 0xF3) {
+        len = 4;
+    } else if (c == 0xF4) {
+        len = 4; hi = 0x8F;         // 不超过 U+10FFFF
+    } else {
+        invalidLen = 1;
+        return 0;
+    }
+
+    for (size_t i = 1; i < len; ++i) {
+        if (i >= avail) {
+            invalidLen = i;
+            return 0;
+        }
+        unsigned char b = p[i];
+        unsigned char low = (i == 1) ? lo : 0x80;
+        unsigned char high = (i == 1) ? hi : 0xBF;
+        if (b < low || b > high) {
+            invalidLen = i;
+            return 0;
+        }
+    }
+
+    return len;
+}
+
+} // anonymous namespace
+
 // CP_UTF8 is already defined in windows.h as 65001
 
 bool initializeConsoleEncoding() {
@@ -22,6 +121,23 @@ bool initializeConsoleEncoding() {
 #endif
 }
 
+bool enableTerminalEscapes() {
+#ifdef _WIN32
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+    HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    if (out == INVALID_HANDLE_VALUE || !GetConsoleMode(out, &mode)) {
+        return false;
+    }
+    return (mode & ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0 ||
+           SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0;
+#else
+    return isatty(STDOUT_FILENO) != 0;
+#endif
+}
+
 size_t detectUtf8Bom(const char* data, size_t size) {
     // UTF-8 BOM is: EF BB BF
     if (size >= 3 &&
@@ -33,4 +149,74 @@ size_t detectUtf8Bom(const char* data, size_t size) {
     return 0;
 }
 
+bool isAscii(const char* data, size_t size) {
+    return asciiPrefix(data, size) == size;
+}
+
+bool validateUtf8(const char* data, size_t size) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    size_t i = 0;
+
+    while (i < size) {
+        i += asciiPrefix(data + i, size - i);
+        if (i >= size) {
+            break;
+        }
+
+        size_t invalidLen = 0;
+        size_t len = decodeSequence(p + i, size - i, invalidLen);
+        if (len == 0) {
+            return false;
+        }
+        i += len;
+    }
+
+    return true;
+}
+
+size_t repairUtf8(const char* data, size_t size, std::string& out) {
+    static const char replacement[] = "\xEF\xBF\xBD";
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    size_t replaced = 0;
+    size_t i = 0;
+
+    out.clear();
+    out.reserve(size);
+
+    while (i < size) {
+        size_t run = asciiPrefix(data + i, size - i);
+        out.append(data + i, run);
+        i += run;
+        if (i >= size) {
+            break;
+        }
+
+        size_t invalidLen = 0;
+        size_t len = decodeSequence(p + i, size - i, invalidLen);
+        if (len > 0) {
+            out.append(data + i, len);
+            i += len;
+        } else {
+            out.append(replacement, 3);
+            i += invalidLen;
+            replaced++;
+        }
+    }
+
+    return replaced;
+}
+
+bool parseUtf8Mode(const std::string& name, Utf8Mode& mode) {
+    if (name == "pass") {
+        mode = Utf8Mode::PASS_THROUGH;
+    } else if (name == "replace") {
+        mode = Utf8Mode::REPLACE;
+    } else if (name == "reject") {
+        mode = Utf8Mode::REJECT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 } // namespace line_editor
@@ -0,0 +1,496 @@
+#include "fd_stream.h"
+#include "error.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+namespace line_editor {
+
+namespace {
+
+constexpr size_t BUFFER_SIZE = 64 * 1024;
+// O_DIRECT 要求缓冲地址、长度和文件偏移按逻辑块对齐，4096 覆盖常见设备
+constexpr size_t DIRECT_ALIGNMENT = 4096;
+// 每处理这么多数据释放一次游标之后的页缓存
+constexpr long long DROP_WINDOW = 8LL * 1024 * 1024;
+
+bool isAligned(long long value) {
+    return value % static_cast<long long>(DIRECT_ALIGNMENT) == 0;
+}
+
+void adviseDontNeed(int fd, long long offset, long long length) {
+#ifdef POSIX_FADV_DONTNEED
+    ::posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_DONTNEED);
+#else
+    (void)fd; (void)offset; (void)length;
+#endif
+}
+
+// 脏页不会被 DONTNEED 释放，先发起（wait 为真时等待）回写
+void writeBack(int fd, long long offset, long long length, bool wait) {
+#if defined(__linux__)
+    unsigned int flags = SYNC_FILE_RANGE_WRITE;
+    if (wait) {
+        flags |= SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WAIT_AFTER;
+    }
+    ::sync_file_range(fd, static_cast<off64_t>(offset), static_cast<off64_t>(length), flags);
+#elif !defined(_WIN32)
+    if (wait) {
+        ::fsync(fd);
+    }
+    (void)offset; (void)length;
+#else
+    (void)fd; (void)offset; (void)length; (void)wait;
+#endif
+}
+
+long long readFd(int fd, char* data, size_t size) {
+    while (true) {
+#ifdef _WIN32
+        int n = _read(fd, data, static_cast<unsigned int>(size));
+#else
+        ssize_t n = ::read(fd, data, size);
+#endif
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return static_cast<long long>(n);
+    }
+}
+
+bool writeFd(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, static_cast<unsigned int>(std::min<size_t>(size, 1 << 30)));
+#else
+        ssize_t n = ::write(fd, data, size);
+#endif
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+#ifdef __linux__
+// 这些错误表示当前内核路径不适用于这对描述符，换下一种方式
+bool shouldFallBack(int err) {
+    return err == EXDEV || err == EINVAL || err == ENOSYS || err == EOPNOTSUPP ||
+           err == EBADF || err == ESPIPE;
+}
+#endif
+
+} // anonymous namespace
+
+FdStreamBuf::FdStreamBuf()
+    : fd_(-1), owned_(false), mode_(Mode::READ), cache_(CacheMode::BUFFERED),
+      direct_(false), buffer_(nullptr), fdOffset_(0), droppedTo_(0), flushedTo_(0) {
+}
+
+FdStreamBuf::~FdStreamBuf() {
+    close();
+}
+
+bool FdStreamBuf::open(const std::string& path, Mode mode, CacheMode cache) {
+    close();
+
+#ifdef _WIN32
+    int fd = (mode == Mode::READ)
+        ? _open(path.c_str(), _O_RDONLY | _O_BINARY)
+        : _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    bool direct = false;
+#else
+    int flags = (mode == Mode::READ)
+        ? (O_RDONLY | O_CLOEXEC)
+        : (O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC);
+    int fd = -1;
+    bool direct = false;
+#ifdef O_DIRECT
+    if (cache == CacheMode::BYPASS) {
+        // tmpfs 等文件系统不支持 O_DIRECT，打开失败时退回普通打开
+        fd = ::open(path.c_str(), flags | O_DIRECT, 0666);
+        direct = fd >= 0;
+    }
+#endif
+    if (fd < 0) {
+        fd = ::open(path.c_str(), flags, 0666);
+    }
+#ifdef F_NOCACHE
+    if (fd >= 0 && cache == CacheMode::BYPASS) {
+        ::fcntl(fd, F_NOCACHE, 1);
+    }
+#endif
+#endif
+    if (fd < 0) {
+        return false;
+    }
+    if (!attach(fd, mode, true, cache)) {
+        return false;
+    }
+    direct_ = direct;
+    return true;
+}
+
+bool FdStreamBuf::attach(int fd, Mode mode, bool owned, CacheMode cache) {
+    close();
+    if (fd < 0) {
+        return false;
+    }
+
+#ifdef _WIN32
+    _setmode(fd, _O_BINARY);
+#endif
+
+    fd_ = fd;
+    owned_ = owned;
+    mode_ = mode;
+    cache_ = cache;
+    direct_ = false;
+    fdOffset_ = 0;
+    droppedTo_ = 0;
+    flushedTo_ = 0;
+
+    // 多分配一个对齐单位，让缓冲起点满足 O_DIRECT 的对齐要求
+    storage_.assign(BUFFER_SIZE + DIRECT_ALIGNMENT, '\0');
+    size_t misalign = reinterpret_cast<size_t>(storage_.data()) % DIRECT_ALIGNMENT;
+    buffer_ = storage_.data() + (misalign ? DIRECT_ALIGNMENT - misalign : 0);
+
+    if (mode == Mode::READ) {
+        setg(buffer_, buffer_, buffer_);
+        setp(nullptr, nullptr);
+    } else {
+        setg(nullptr, nullptr, nullptr);
+        setp(buffer_, buffer_ + BUFFER_SIZE);
+    }
+    return true;
+}
+
+bool FdStreamBuf::close() {
+    if (fd_ < 0) {
+        return true;
+    }
+
+    bool ok = true;
+    if (mode_ == Mode::WRITE) {
+        ok = flushBuffer();
+    }
+    if (cache_ == CacheMode::BYPASS) {
+        dropBehind(true);
+    }
+    if (owned_) {
+#ifdef _WIN32
+        ok = (_close(fd_) == 0) && ok;
+#else
+        ok = (::close(fd_) == 0) && ok;
+#endif
+    }
+
+    fd_ = -1;
+    owned_ = false;
+    direct_ = false;
+    setg(nullptr, nullptr, nullptr);
+    setp(nullptr, nullptr);
+    std::vector<char>().swap(storage_);
+    buffer_ = nullptr;
+    return ok;
+}
+
+void FdStreamBuf::disableDirect() {
+#if !defined(_WIN32) && defined(O_DIRECT)
+    if (direct_) {
+        int flags = ::fcntl(fd_, F_GETFL);
+        if (flags >= 0) {
+            ::fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+        }
+    }
+#endif
+    direct_ = false;
+}
+
+void FdStreamBuf::addExternalRead(unsigned long long bytes) {
+    fdOffset_ += static_cast<long long>(bytes);
+    if (cache_ == CacheMode::BYPASS) {
+        dropBehind(false);
+    }
+}
+
+void FdStreamBuf::addExternalWrite(unsigned long long bytes) {
+    fdOffset_ += static_cast<long long>(bytes);
+    if (cache_ == CacheMode::BYPASS) {
+        dropBehind(false);
+    }
+}
+
+void FdStreamBuf::dropBehind(bool final) {
+    if (direct_ && !final) {
+        return;
+    }
+
+    if (mode_ == Mode::READ) {
+        if (final || fdOffset_ - droppedTo_ >= DROP_WINDOW) {
+            adviseDontNeed(fd_, droppedTo_, fdOffset_ - droppedTo_);
+            droppedTo_ = fdOffset_;
+        }
+        return;
+    }
+
+    if (final) {
+        writeBack(fd_, droppedTo_, fdOffset_ - droppedTo_, true);
+        adviseDontNeed(fd_, droppedTo_, fdOffset_ - droppedTo_);
+        droppedTo_ = flushedTo_ = fdOffset_;
+        return;
+    }
+
+    // 写入时流水化：发起当前窗口的回写，等待上一个窗口完成后释放它
+    if (fdOffset_ - flushedTo_ >= DROP_WINDOW) {
+        writeBack(fd_, flushedTo_, fdOffset_ - flushedTo_, false);
+        if (flushedTo_ > droppedTo_) {
+            writeBack(fd_, droppedTo_, flushedTo_ - droppedTo_, true);
+            adviseDontNeed(fd_, droppedTo_, flushedTo_ - droppedTo_);
+            droppedTo_ = flushedTo_;
+        }
+        flushedTo_ = fdOffset_;
+    }
+}
+
+long long FdStreamBuf::position() const {
+    if (mode_ == Mode::READ) {
+        return fdOffset_ - static_cast<long long>(egptr() - gptr());
+    }
+    return fdOffset_ + static_cast<long long>(pptr() - pbase());
+}
+
+size_t FdStreamBuf::peek(char* out, size_t size) {
+    if (fd_ < 0 || mode_ != Mode::READ) {
+        return 0;
+    }
+
+    size_t available = static_cast<size_t>(egptr() - gptr());
+    if (available < size) {
+        // 把未读部分移到缓冲开头，再补读到 size 字节或 EOF
+        std::memmove(buffer_, gptr(), available);
+        while (available < size) {
+            long long n = readChunk(buffer_ + available, BUFFER_SIZE - available);
+            if (n <= 0) {
+                break;
+            }
+            available += static_cast<size_t>(n);
+        }
+        setg(buffer_, buffer_, buffer_ + available);
+    }
+
+    size_t count = std::min(size, available);
+    std::memcpy(out, gptr(), count);
+    return count;
+}
+
+FdStreamBuf::int_type FdStreamBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    if (fd_ < 0 || mode_ != Mode::READ) {
+        return traits_type::eof();
+    }
+
+    long long n = readChunk(buffer_, BUFFER_SIZE);
+    if (n <= 0) {
+        return traits_type::eof();
+    }
+
+    setg(buffer_, buffer_, buffer_ + n);
+    return traits_type::to_int_type(*gptr());
+}
+
+long long FdStreamBuf::readChunk(char* data, size_t size) {
+    if (direct_ && (!isAligned(fdOffset_) || !isAligned(static_cast<long long>(size)) ||
+                    reinterpret_cast<size_t>(data) % DIRECT_ALIGNMENT != 0)) {
+        disableDirect();
+    }
+
+    long long n = readFd(fd_, data, size);
+    if (n < 0 && direct_ && errno == EINVAL) {
+        disableDirect();
+        n = readFd(fd_, data, size);
+    }
+    if (n > 0) {
+        fdOffset_ += n;
+        if (cache_ == CacheMode::BYPASS) {
+            dropBehind(false);
+        }
+    }
+    return n;
+}
+
+bool FdStreamBuf::writeAll(const char* data, size_t size) {
+    // 只有对齐的整块能走 O_DIRECT，收尾的零头改回普通写入
+    if (direct_ && (!isAligned(fdOffset_) || !isAligned(static_cast<long long>(size)) ||
+                    reinterpret_cast<size_t>(data) % DIRECT_ALIGNMENT != 0)) {
+        disableDirect();
+    }
+
+    if (!writeFd(fd_, data, size)) {
+        if (!direct_ || errno != EINVAL) {
+            return false;
+        }
+        disableDirect();
+        if (!writeFd(fd_, data, size)) {
+            return false;
+        }
+    }
+    fdOffset_ += static_cast<long long>(size);
+    if (cache_ == CacheMode::BYPASS) {
+        dropBehind(false);
+    }
+    return true;
+}
+
+bool FdStreamBuf::flushBuffer() {
+    if (fd_ < 0 || mode_ != Mode::WRITE) {
+        return false;
+    }
+
+    size_t used = static_cast<size_t>(pptr() - pbase());
+    if (used == 0) {
+        return true;
+    }
+    if (!writeAll(pbase(), used)) {
+        return false;
+    }
+    setp(buffer_, buffer_ + BUFFER_SIZE);
+    return true;
+}
+
+FdStreamBuf::int_type FdStreamBuf::overflow(int_type ch) {
+    if (!flushBuffer()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize FdStreamBuf::xsputn(const char* s, std::streamsize n) {
+    if (fd_ < 0 || mode_ != Mode::WRITE) {
+        return 0;
+    }
+
+    size_t size = static_cast<size_t>(n);
+    size_t space = static_cast<size_t>(epptr() - pptr());
+    if (size <= space) {
+        std::memcpy(pptr(), s, size);
+        pbump(static_cast<int>(size));
+        return n;
+    }
+
+    if (!flushBuffer()) {
+        return 0;
+    }
+    // 大块数据直接写，不经过缓冲；O_DIRECT 下调用方的数据未必对齐，仍走缓冲
+    if (size >= BUFFER_SIZE) {
+        if (direct_) {
+            return std::streambuf::xsputn(s, n);
+        }
+        return writeAll(s, size) ? n : 0;
+    }
+    std::memcpy(pptr(), s, size);
+    pbump(static_cast<int>(size));
+    return n;
+}
+
+int FdStreamBuf::sync() {
+    if (mode_ == Mode::WRITE) {
+        return flushBuffer() ? 0 : -1;
+    }
+    return 0;
+}
+
+FdStreamBuf::pos_type FdStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                           std::ios_base::openmode) {
+    if (fd_ < 0 || off != 0 || dir != std::ios_base::cur) {
+        return pos_type(off_type(-1));
+    }
+    return pos_type(off_type(position()));
+}
+
+unsigned long long copyFdData(int inFd, int outFd, unsigned long long length) {
+    unsigned long long copied = 0;
+
+#ifdef __linux__
+    // 依次尝试 copy_file_range（文件到文件，可 reflink）、sendfile（文件到任意）、
+    // splice（管道参与），都不适用时退回读写循环
+    int method = 0;
+    while (copied < length && method < 3) {
+        size_t chunk = static_cast<size_t>(std::min<unsigned long long>(length - copied, 1ULL << 30));
+        ssize_t n;
+
+        if (method == 0) {
+            n = ::copy_file_range(inFd, nullptr, outFd, nullptr, chunk, 0);
+        } else if (method == 1) {
+            n = ::sendfile(outFd, inFd, nullptr, chunk);
+        } else {
+            n = ::splice(inFd, nullptr, outFd, nullptr, chunk, SPLICE_F_MOVE);
+        }
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (shouldFallBack(errno)) {
+                method++;
+                continue;
+            }
+            throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+                std::string("Failed to copy data: ") + std::strerror(errno));
+        }
+        if (n == 0) {
+            return copied;
+        }
+        copied += static_cast<unsigned long long>(n);
+    }
+    if (copied >= length) {
+        return copied;
+    }
+#endif
+
+    std::vector<char> buffer(BUFFER_SIZE);
+    while (copied < length) {
+        size_t want = static_cast<size_t>(std::min<unsigned long long>(length - copied, buffer.size()));
+        long long n = readFd(inFd, buffer.data(), want);
+        if (n < 0) {
+            throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+                std::string("Failed to read data: ") + std::strerror(errno));
+        }
+        if (n == 0) {
+            break;
+        }
+        if (!writeFd(outFd, buffer.data(), static_cast<size_t>(n))) {
+            throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+                std::string("Failed to write data: ") + std::strerror(errno));
+        }
+        copied += static_cast<unsigned long long>(n);
+    }
+
+    return copied;
+}
+
+} // namespace line_editor
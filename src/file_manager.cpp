@@ -1,51 +1,457 @@
 #include "file_manager.h"
 #include "error.h"
 #include "encoding_utils.h"
+#include "trigram_index.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace line_editor {
 
+namespace {
+
+// 绕过页缓存时尾部复制的分段大小，每段之后释放对应的缓存
+constexpr unsigned long long BYPASS_COPY_CHUNK = 64ULL * 1024 * 1024;
+
+// 在目标文件同目录下创建临时文件，保证最后的 rename 不跨文件系统
+std::string createSiblingTempFile(const std::string& target) {
+#ifdef _WIN32
+    std::string path = target + ".tmp" + std::to_string(GetCurrentProcessId()) +
+                       "_" + std::to_string(rand());
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        throw EditorException(ErrorCode::FILE_OPEN_FAILED,
+            "Failed to create temporary file: " + path);
+    }
+    std::fclose(f);
+    return path;
+#else
+    size_t slash = target.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "" : target.substr(0, slash + 1);
+    std::string base = (slash == std::string::npos) ? target : target.substr(slash + 1);
+    std::string path = dir + "." + base + ".tmpXXXXXX";
+
+    int fd = ::mkstemp(&path[0]);
+    if (fd < 0) {
+        throw EditorException(ErrorCode::FILE_OPEN_FAILED,
+            "Failed to create temporary file next to: " + target);
+    }
+
+    // 沿用目标的权限；目标还不存在时与直接创建一样按 umask
+    struct stat st;
+    if (::stat(target.c_str(), &st) == 0) {
+        ::fchmod(fd, st.st_mode & 07777);
+    } else {
+        mode_t mask = ::umask(0);
+        ::umask(mask);
+        ::fchmod(fd, 0666 & ~mask);
+    }
+    ::close(fd);
+    return path;
+#endif
+}
+
+bool syncFile(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    return ::close(fd) == 0 && ok;
+#endif
+}
+
+bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// 改写文件之后它的 trigram 索引已经不对应新内容，删掉以免留下过时的索引
+void removeIndexOf(const std::string& path) {
+    std::remove(TrigramIndex::sidecarPath(path).c_str());
+}
+
+} // anonymous namespace
+
+std::string FileManager::createTempFileNear(const std::string& target) {
+    return createSiblingTempFile(target);
+}
+
+bool FileManager::commitTempFile(const std::string& tempPath, const std::string& target) {
+    return syncFile(tempPath) && replaceFile(tempPath, target);
+}
+
+FileManager::~FileManager() {
+    try {
+        close();
+    } catch (...) {
+        // 析构时无法报告错误
+    }
+}
+
 bool FileManager::openInput(const std::string& filename) {
     if (filename.empty()) {
         return true;
     }
 
-    input_.close();
-    input_.open(filename);
+    input_.rdbuf(nullptr);
+    inputCodec_.reset();
+    inputFile_.close();
     inputFilename_ = filename;
+    inputCompression_ = Compression::NONE;
     bomChecked_ = false;  // Reset BOM flag for new file
+    linesRead_ = 0;
+    invalidUtf8Lines_ = 0;
 
-    if (!input_.is_open()) {
+    bool opened = (filename == STDIO_FILENAME)
+        ? inputFile_.attach(0, FdStreamBuf::Mode::READ, false, cacheMode())
+        : inputFile_.open(filename, FdStreamBuf::Mode::READ, cacheMode());
+    if (!opened) {
         throw EditorException(ErrorCode::FILE_OPEN_FAILED,
             "Failed to open input file: " + filename);
     }
 
+    char magic[4] = {0};
+    size_t got = inputFile_.peek(magic, sizeof(magic));
+    inputCompression_ = detectCompression(magic, got);
+
+    if (inputCompression_ == Compression::NONE) {
+        input_.rdbuf(&inputFile_);
+    } else {
+        inputCodec_.reset(new DecompressingStreamBuf(inputCompression_, &inputFile_));
+        input_.rdbuf(inputCodec_.get());
+    }
+
     return true;
 }
 
 bool FileManager::openOutput(const std::string& filename) {
+    return openOutput(filename, compressionFromFilename(filename));
+}
+
+bool FileManager::openOutput(const std::string& filename, Compression compression) {
     if (filename.empty()) {
         return false;
     }
 
-    output_.close();
-    output_.open(filename);
+    output_.rdbuf(nullptr);
+    if (outputCodec_) {
+        outputCodec_->finish();
+        outputCodec_.reset();
+    }
+    outputFile_.close();
+    discardOutput();
     outputFilename_ = filename;
+    outputCompression_ = compression;
+
+    if (atomicOutput_ && filename != STDIO_FILENAME) {
+        targetFilename_ = filename;
+        outputFilename_ = createSiblingTempFile(filename);
+        replaceOnClose_ = true;
+    }
 
-    if (!output_.is_open()) {
+    bool opened = (filename == STDIO_FILENAME)
+        ? outputFile_.attach(1, FdStreamBuf::Mode::WRITE, false, cacheMode())
+        : outputFile_.open(outputFilename_, FdStreamBuf::Mode::WRITE, cacheMode());
+    if (!opened) {
+        discardOutput();
         throw EditorException(ErrorCode::FILE_OPEN_FAILED,
             "Failed to open output file: " + filename);
     }
 
+    attachOutput(compression);
     return true;
 }
 
+void FileManager::attachOutput(Compression compression) {
+    if (compression == Compression::NONE) {
+        output_.rdbuf(&outputFile_);
+    } else {
+        outputCodec_.reset(new CompressingStreamBuf(compression, &outputFile_));
+        output_.rdbuf(outputCodec_.get());
+    }
+}
+
+bool FileManager::openInPlace(const std::string& filename) {
+    if (filename.empty()) {
+        return false;
+    }
+
+    openInput(filename);
+
+    inPlace_ = true;
+    targetFilename_ = filename;
+    outputCompression_ = inputCompression_;
+    patchOffset_ = 0;
+    patchBuffer_.str("");
+
+#ifndef _WIN32
+    // 未压缩的文件先尝试直接回写，一旦长度变化再退回临时文件；原子输出要求出错时原文件不变
+    if (inputCompression_ == Compression::NONE && !atomicOutput_) {
+        patchFd_ = ::open(filename.c_str(), O_WRONLY | O_CLOEXEC);
+        if (patchFd_ >= 0) {
+            patching_ = true;
+            output_.rdbuf(&patchBuffer_);
+            return true;
+        }
+    }
+#endif
+
+    switchToTempFile("");
+    return true;
+}
+
+bool FileManager::isSameFile(const std::string& first, const std::string& second) {
+    if (first.empty() || second.empty() ||
+        first == STDIO_FILENAME || second == STDIO_FILENAME) {
+        return false;
+    }
+    if (first == second) {
+        return true;
+    }
+#ifndef _WIN32
+    struct stat a;
+    struct stat b;
+    if (::stat(first.c_str(), &a) == 0 && ::stat(second.c_str(), &b) == 0) {
+        return a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+    }
+#endif
+    return false;
+}
+
+FdStreamBuf::CacheMode FileManager::cacheMode() const {
+    return cacheBypass_ ? FdStreamBuf::CacheMode::BYPASS : FdStreamBuf::CacheMode::BUFFERED;
+}
+
+long long FileManager::inputOffset() {
+    if (inputCodec_ || !inputFile_.isOpen()) {
+        return -1;
+    }
+    return inputFile_.position();
+}
+
+void FileManager::settlePatch() {
+    if (!patching_) {
+        return;
+    }
+
+    std::string pending = patchBuffer_.str();
+    long long consumed = inputOffset();
+
+    if (consumed < 0 || patchOffset_ + pending.size() != static_cast<unsigned long long>(consumed)) {
+        switchToTempFile(pending);
+        return;
+    }
+
+#ifndef _WIN32
+    // 写出长度与读入长度一致，覆盖的都是已经读过的字节
+    if (patchOffset_ == 0 && !pending.empty()) {
+        removeIndexOf(targetFilename_);
+    }
+    size_t done = 0;
+    while (done < pending.size()) {
+        ssize_t n = ::pwrite(patchFd_, pending.data() + done, pending.size() - done,
+                             static_cast<off_t>(patchOffset_ + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+                "Failed to write to file: " + targetFilename_);
+        }
+        done += static_cast<size_t>(n);
+    }
+#endif
+    patchOffset_ += pending.size();
+    patchBuffer_.str("");
+}
+
+void FileManager::switchToTempFile(const std::string& pending) {
+    std::string tempPath = createSiblingTempFile(targetFilename_);
+
+    outputFilename_ = tempPath;
+    if (!outputFile_.open(tempPath, FdStreamBuf::Mode::WRITE, cacheMode())) {
+        std::remove(tempPath.c_str());
+        throw EditorException(ErrorCode::FILE_OPEN_FAILED,
+            "Failed to open temporary file: " + tempPath);
+    }
+
+    // 已经回写到原文件的前缀就是目前为止的输出
+    if (patchOffset_ > 0) {
+        FdStreamBuf prefix;
+        if (!prefix.open(targetFilename_, FdStreamBuf::Mode::READ)) {
+            throw EditorException(ErrorCode::FILE_OPEN_FAILED,
+                "Failed to open input file: " + targetFilename_);
+        }
+        outputFile_.addExternalWrite(copyFdData(prefix.fd(), outputFile_.fd(), patchOffset_));
+    }
+
+#ifndef _WIN32
+    if (patchFd_ >= 0) {
+        ::close(patchFd_);
+        patchFd_ = -1;
+    }
+#endif
+    patching_ = false;
+    patchBuffer_.str("");
+
+    attachOutput(outputCompression_);
+    output_ << pending;
+}
+
+void FileManager::commitInPlace() {
+    inPlace_ = false;
+
+#ifndef _WIN32
+    if (patchFd_ >= 0) {
+        bool ok = ::fsync(patchFd_) == 0;
+        ok = ::close(patchFd_) == 0 && ok;
+        patchFd_ = -1;
+        if (!ok) {
+            patching_ = false;
+            throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+                "Failed to write to file: " + targetFilename_);
+        }
+    }
+#endif
+
+    if (patching_) {
+        patching_ = false;
+        return;
+    }
+
+    if (!syncFile(outputFilename_) || !replaceFile(outputFilename_, targetFilename_)) {
+        std::remove(outputFilename_.c_str());
+        throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+            "Failed to replace file: " + targetFilename_);
+    }
+    outputFilename_ = targetFilename_;
+    removeIndexOf(targetFilename_);
+}
+
+void FileManager::discardInPlace() {
+    inPlace_ = false;
+
+#ifndef _WIN32
+    if (patchFd_ >= 0) {
+        ::close(patchFd_);
+        patchFd_ = -1;
+    }
+#endif
+
+    if (!patching_) {
+        output_.rdbuf(nullptr);
+        outputCodec_.reset();
+        outputFile_.close();
+        if (!outputFilename_.empty() && outputFilename_ != targetFilename_) {
+            std::remove(outputFilename_.c_str());
+        }
+    }
+    patching_ = false;
+}
+
+void FileManager::commitOutput() {
+    replaceOnClose_ = false;
+    if (!syncFile(outputFilename_) || !replaceFile(outputFilename_, targetFilename_)) {
+        std::remove(outputFilename_.c_str());
+        throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+            "Failed to replace file: " + targetFilename_);
+    }
+    outputFilename_ = targetFilename_;
+    removeIndexOf(targetFilename_);
+}
+
+void FileManager::discardOutput() {
+    if (replaceOnClose_) {
+        replaceOnClose_ = false;
+        std::remove(outputFilename_.c_str());
+    }
+}
+
 void FileManager::close() {
-    if (input_.is_open()) {
-        input_.close();
+    if (inPlace_ && inputFile_.isOpen()) {
+        // 原地编辑必须先把剩余内容补齐，否则替换后会丢失数据
+        try {
+            copyRemainingInput();
+            settlePatch();
+        } catch (...) {
+            discardInPlace();
+            throw;
+        }
     }
-    if (output_.is_open()) {
-        output_.close();
+
+    input_.rdbuf(nullptr);
+    inputCodec_.reset();
+    inputFile_.close();
+
+    bool codecFailed = false;
+    std::string codecError;
+    bool writeFailed = false;
+    if (output_.rdbuf()) {
+        output_.flush();
+        writeFailed = output_.fail();
+    }
+    if (outputCodec_) {
+        if (!outputCodec_->finish()) {
+            codecFailed = true;
+            codecError = outputCodec_->errorMessage();
+        }
+    }
+    output_.rdbuf(nullptr);
+    outputCodec_.reset();
+    if (!outputFile_.close()) {
+        writeFailed = true;
+    }
+
+    if (codecFailed) {
+        if (inPlace_) {
+            discardInPlace();
+        }
+        discardOutput();
+        throw EditorException(ErrorCode::COMPRESSION_FAILED,
+            "Failed to compress output file: " + codecError);
+    }
+
+    if (writeFailed && !patching_) {
+        if (inPlace_) {
+            discardInPlace();
+        }
+        discardOutput();
+        throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+            "Failed to write to output file");
+    }
+
+    if (inPlace_) {
+        commitInPlace();
+    } else if (replaceOnClose_) {
+        commitOutput();
+    }
+}
+
+void FileManager::checkInputCodec() const {
+    if (inputCodec_ && inputCodec_->failed()) {
+        throw EditorException(ErrorCode::COMPRESSION_FAILED,
+            "Failed to decompress input file: " + inputCodec_->errorMessage());
     }
 }
 
@@ -53,62 +459,98 @@ void FileManager::skipUtf8Bom() {
     if (bomChecked_) {
         return;
     }
+    bomChecked_ = true;
 
-    if (!input_.is_open() || input_.tellg() != 0) {
+    std::streambuf* buf = input_.rdbuf();
+    if (!buf) {
         return;
     }
 
+    // 逐字节窥视，不是 BOM 时把已取出的字节退回缓冲
+    static const unsigned char utf8Bom[3] = {0xEF, 0xBB, 0xBF};
     char bom[3] = {0};
-    input_.read(bom, 3);
-    std::streamsize bytesRead = input_.gcount();
+    size_t taken = 0;
+    while (taken < 3) {
+        std::streambuf::int_type ch = buf->sgetc();
+        if (std::streambuf::traits_type::eq_int_type(ch, std::streambuf::traits_type::eof()) ||
+            static_cast<unsigned char>(ch) != utf8Bom[taken]) {
+            break;
+        }
+        bom[taken++] = std::streambuf::traits_type::to_char_type(ch);
+        buf->sbumpc();
+    }
 
-    // Only check BOM if we actually read 3 bytes
-    if (bytesRead == 3 && detectUtf8Bom(bom, 3) == 3) {
+    if (taken == 3 && detectUtf8Bom(bom, 3) == 3) {
         // BOM found and skipped, we're past it
-    } else {
-        // Not a BOM or file too small, seek back
-        input_.clear();  // Clear any flags (especially eofbit)
-        input_.seekg(0, std::ios::beg);
+        return;
+    }
+
+    // Not a BOM or file too small, put the bytes back
+    while (taken-- > 0) {
+        buf->sungetc();
     }
-    bomChecked_ = true;
+}
+
+void FileManager::applyUtf8Mode(std::string& line) {
+    linesRead_++;
+
+    if (utf8Mode_ == Utf8Mode::PASS_THROUGH || validateUtf8(line.data(), line.size())) {
+        return;
+    }
+
+    invalidUtf8Lines_++;
+
+    if (utf8Mode_ == Utf8Mode::REJECT) {
+        throw EditorException(ErrorCode::INVALID_ENCODING,
+            "Invalid UTF-8 in input line " + std::to_string(linesRead_));
+    }
+
+    repairUtf8(line.data(), line.size(), repairBuffer_);
+    line.swap(repairBuffer_);
 }
 
 int FileManager::readLines(std::vector<std::string>& lines, int maxLines) {
     lines.clear();
 
-    if (!input_.is_open() || input_.eof()) {
+    if (!inputFile_.isOpen() || input_.eof()) {
         return 0;
     }
 
+    settlePatch();
     skipUtf8Bom();
 
     std::string line;
     int count = 0;
 
     while (count < maxLines && std::getline(input_, line)) {
+        applyUtf8Mode(line);
         lines.push_back(line);
         count++;
     }
 
+    checkInputCodec();
     return count;
 }
 
 std::string FileManager::readLine() {
-    if (!input_.is_open() || input_.eof()) {
+    if (!inputFile_.isOpen() || input_.eof()) {
         return "";
     }
 
+    settlePatch();
     skipUtf8Bom();
 
     std::string line;
     if (std::getline(input_, line)) {
+        applyUtf8Mode(line);
         return line;
     }
+    checkInputCodec();
     return "";
 }
 
 bool FileManager::writeLine(const std::string& line) {
-    if (!output_.is_open()) {
+    if (!isOutputOpen()) {
         return false;
     }
 
@@ -123,7 +565,7 @@ bool FileManager::writeLine(const std::string& line) {
 }
 
 bool FileManager::writeLines(const std::vector<std::string>& lines) {
-    if (!output_.is_open()) {
+    if (!isOutputOpen()) {
         return false;
     }
 
@@ -139,4 +581,135 @@ bool FileManager::writeLines(const std::vector<std::string>& lines) {
     return true;
 }
 
+size_t FileManager::readRaw(char* data, size_t size) {
+    if (!inputFile_.isOpen() || input_.eof()) {
+        return 0;
+    }
+
+    settlePatch();
+    if (patching_) {
+        // 流式处理会提前读入多块，无法保证写出位置与读入位置一致
+        switchToTempFile("");
+    }
+    skipUtf8Bom();
+
+    std::streamsize n = input_.rdbuf()->sgetn(data, static_cast<std::streamsize>(size));
+    if (n < static_cast<std::streamsize>(size)) {
+        input_.setstate(std::ios::eofbit);
+    }
+    checkInputCodec();
+    return n > 0 ? static_cast<size_t>(n) : 0;
+}
+
+bool FileManager::writeRaw(const char* data, size_t size) {
+    if (!isOutputOpen()) {
+        return false;
+    }
+
+    output_.write(data, static_cast<std::streamsize>(size));
+
+    if (output_.fail()) {
+        throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+            "Failed to write to output file");
+    }
+
+    return true;
+}
+
+void FileManager::abandon() {
+    if (inPlace_) {
+        discardInPlace();
+    }
+
+    input_.rdbuf(nullptr);
+    inputCodec_.reset();
+    inputFile_.close();
+
+    output_.rdbuf(nullptr);
+    outputCodec_.reset();
+    outputFile_.close();
+    discardOutput();
+}
+
+unsigned long long FileManager::copyRemainingInput() {
+    if (!inputFile_.isOpen() || !isOutputOpen() || input_.eof()) {
+        return 0;
+    }
+
+    skipUtf8Bom();
+    unsigned long long copied = 0;
+
+    settlePatch();
+    if (patching_) {
+        // 原地回写且长度未变：剩余内容本来就在原位置
+        input_.setstate(std::ios::eofbit);
+        return 0;
+    }
+
+    if (utf8Mode_ != Utf8Mode::PASS_THROUGH) {
+        // 需要逐行检查编码时只能走行路径
+        std::string line;
+        while (std::getline(input_, line)) {
+            applyUtf8Mode(line);
+            writeLine(line);
+            copied += line.size() + 1;
+        }
+        checkInputCodec();
+        return copied;
+    }
+
+    if (!inputCodec_ && !outputCodec_) {
+        // 先把已读入缓冲的部分写出，剩下的交给内核在描述符之间复制
+        char buffer[64 * 1024];
+        std::streamsize buffered;
+        while ((buffered = inputFile_.in_avail()) > 0) {
+            std::streamsize n = inputFile_.sgetn(buffer, std::min<std::streamsize>(buffered, sizeof(buffer)));
+            output_.write(buffer, n);
+            copied += static_cast<unsigned long long>(n);
+        }
+        output_.flush();
+        if (output_.fail()) {
+            throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+                "Failed to write to output file");
+        }
+
+        // 内核复制不满足 O_DIRECT 的对齐要求；绕过缓存时分段复制，边复制边释放
+        inputFile_.disableDirect();
+        outputFile_.disableDirect();
+        unsigned long long chunk = cacheBypass_ ? BYPASS_COPY_CHUNK : COPY_TO_END;
+        unsigned long long direct = 0;
+        while (true) {
+            unsigned long long n = copyFdData(inputFile_.fd(), outputFile_.fd(), chunk);
+            inputFile_.addExternalRead(n);
+            outputFile_.addExternalWrite(n);
+            direct += n;
+            if (n < chunk) {
+                break;
+            }
+        }
+        input_.setstate(std::ios::eofbit);
+        return copied + direct;
+    }
+
+    // 通用路径：流缓冲之间整块复制，仍然不切分行
+    char buffer[64 * 1024];
+    std::streambuf* in = input_.rdbuf();
+    std::streambuf* out = output_.rdbuf();
+    while (true) {
+        std::streamsize n = in->sgetn(buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        if (out->sputn(buffer, n) != n) {
+            throw EditorException(ErrorCode::FILE_WRITE_FAILED,
+                "Failed to write to output file");
+        }
+        copied += static_cast<unsigned long long>(n);
+    }
+    input_.setstate(std::ios::eofbit);
+    checkInputCodec();
+
+    return copied;
+}
+
 } // namespace line_editor
@@ -0,0 +1,480 @@
+#include "file_search.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LINE_EDITOR_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace line_editor {
+
+MappedFile::MappedFile()
+    : data_(nullptr), size_(0), mtime_(0), open_(false)
+#ifdef _WIN32
+    , file_(INVALID_HANDLE_VALUE), mapping_(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) ||
+        static_cast<unsigned long long>(size.QuadPart) > static_cast<size_t>(-1)) {
+        CloseHandle(file);
+        return false;
+    }
+    FILETIME written;
+    if (GetFileTime(file, nullptr, nullptr, &written)) {
+        mtime_ = static_cast<long long>((static_cast<unsigned long long>(written.dwHighDateTime) << 32) |
+                                        written.dwLowDateTime);
+    }
+    file_ = file;
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ > 0) {
+        mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            close();
+            return false;
+        }
+        data_ = static_cast<const char*>(view);
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        static_cast<unsigned long long>(st.st_size) > static_cast<size_t>(-1)) {
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+#ifdef __APPLE__
+    mtime_ = static_cast<long long>(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    mtime_ = static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+    if (size_ > 0) {
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const char*>(addr);
+    }
+    // 映射建立后不再需要描述符
+    ::close(fd);
+#endif
+
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mtime_ = 0;
+    open_ = false;
+}
+
+namespace {
+
+// 每个窗口先查找再数换行，两遍都落在缓存里
+constexpr size_t WINDOW_BYTES = 256 * 1024;
+
+size_t countNewlines(const char* data, size_t size) {
+    size_t count = 0;
+    size_t i = 0;
+#ifdef LINE_EDITOR_HAVE_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    while (size - i >= 16) {
+        // 每个字节计数器最多累加 255 次，再用 SAD 横向求和
+        size_t rounds = std::min<size_t>((size - i) / 16, 255);
+        __m128i acc = zero;
+        for (size_t r = 0; r < rounds; r++, i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(bytes, newline));
+        }
+        __m128i sums = _mm_sad_epu8(acc, zero);
+        count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) +
+                 static_cast<size_t>(_mm_extract_epi16(sums, 4));
+    }
+#endif
+    for (; i < size; i++) {
+        count += data[i] == '\n';
+    }
+    return count;
+}
+
+// offset 处或之后的第一个行首；offset 为 0 或到达 end 时原样返回
+size_t alignToLine(const char* data, size_t end, size_t offset) {
+    if (offset == 0 || offset >= end) {
+        return std::min(offset, end);
+    }
+    const void* newline = std::memchr(data + offset - 1, '\n', end - offset + 1);
+    return newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) + 1 : end;
+}
+
+// 提前发起整个任务范围的预读，映射大文件时让多个线程的 I/O 同时在途
+void prefetch(const char* data, size_t size) {
+#ifndef _WIN32
+    static const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(static_cast<uintptr_t>(pageSize) - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+    ::posix_madvise(reinterpret_cast<void*>(begin), end - begin, POSIX_MADV_WILLNEED);
+#else
+    (void)data; (void)size;
+#endif
+}
+
+struct ChunkResult {
+    std::vector<LineNo> lines;      // 块内从 0 开始的行序号
+    LineNo newlines = 0;
+};
+
+/**
+ * Scan [begin, end), which starts at a line start. Scan::find proposes a
+ * candidate offset inside the remaining window; the line holding it is then
+ * checked with Scan::confirm. Both are told about whole lines only, so a
+ * match can never straddle a window or chunk boundary.
+ */
+template <typename Scan>
+void scanRange(const char* data, size_t begin, size_t end, Scan& scan, ChunkResult& result) {
+    LineNo line = 0;
+    size_t pos = begin;
+    while (pos < end) {
+        size_t windowEnd = alignToLine(data, end, std::min(end, pos + WINDOW_BYTES));
+        size_t p = pos;
+        while (p < windowEnd) {
+            size_t candidate = scan.find(data + p, windowEnd - p);
+            if (candidate == SEARCH_NOT_FOUND) {
+                break;
+            }
+            size_t hit = p + candidate;
+            size_t lineStart = hit;
+            while (lineStart > p && data[lineStart - 1] != '\n') {
+                lineStart--;
+            }
+            line += static_cast<LineNo>(countNewlines(data + p, lineStart - p));
+
+            const void* newline = std::memchr(data + hit, '\n', windowEnd - hit);
+            size_t lineEnd = newline
+                ? static_cast<size_t>(static_cast<const char*>(newline) - data) : windowEnd;
+            if (scan.confirm(data + lineStart, lineEnd - lineStart)) {
+                result.lines.push_back(line);
+            }
+            if (lineEnd == windowEnd) {
+                p = windowEnd;
+                break;
+            }
+            line++;
+            p = lineEnd + 1;
+        }
+        line += static_cast<LineNo>(countNewlines(data + p, windowEnd - p));
+        pos = windowEnd;
+    }
+    result.newlines = line;
+}
+
+// 每个线程构造一个 Scan（参数相同），动态领取任务块，最后按块顺序合并行号。
+// 每个区间各自切块，块边界只在区间内对齐到行首
+template <typename Scan, typename... Args>
+std::vector<LineNo> runRanges(const char* data, const std::vector<LineRange>& ranges,
+                              const ParallelSearchOptions& options, const Args&... args) {
+    struct Task {
+        size_t range;
+        size_t index;       // 区间内的块序号
+    };
+    size_t chunkBytes = std::max<size_t>(options.chunkBytes, 1);
+    std::vector<Task> tasks;
+    for (size_t r = 0; r < ranges.size(); r++) {
+        size_t size = ranges[r].end > ranges[r].begin ? ranges[r].end - ranges[r].begin : 0;
+        size_t count = size == 0 ? 0 : (size - 1) / chunkBytes + 1;
+        for (size_t k = 0; k < count; k++) {
+            tasks.push_back(Task{ r, k });
+        }
+    }
+    size_t chunkCount = tasks.size();
+    std::vector<ChunkResult> results(chunkCount);
+
+    std::atomic<size_t> next(0);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto worker = [&]() {
+        try {
+            Scan scan(args...);
+            while (true) {
+                size_t t = next.fetch_add(1);
+                if (t >= chunkCount) {
+                    break;
+                }
+                const LineRange& range = ranges[tasks[t].range];
+                size_t k = tasks[t].index;
+                size_t begin = k == 0 ? range.begin
+                                      : alignToLine(data, range.end, range.begin + k * chunkBytes);
+                size_t end = std::min(range.end, range.begin + (k + 1) * chunkBytes);
+                end = end == range.end ? end : alignToLine(data, range.end, end);
+                if (begin < end) {
+                    prefetch(data + begin, end - begin);
+                    scanRange(data, begin, end, scan, results[t]);
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next = chunkCount;
+        }
+    };
+
+    size_t threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    threads = std::min(std::max<size_t>(threads, 1), std::max<size_t>(chunkCount, 1));
+    if (threads == 1) {
+        worker();
+    } else {
+        std::vector<std::thread> pool;
+        pool.reserve(threads - 1);
+        for (size_t t = 1; t < threads; t++) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    size_t total = 0;
+    for (const ChunkResult& result : results) {
+        total += result.lines.size();
+    }
+    std::vector<LineNo> lines;
+    lines.reserve(total);
+    LineNo base = 0;
+    for (size_t t = 0; t < chunkCount; t++) {
+        if (tasks[t].index == 0) {
+            base = ranges[tasks[t].range].firstLine;
+        }
+        for (LineNo local : results[t].lines) {
+            lines.push_back(base + local);
+        }
+        base += results[t].newlines;
+    }
+    return lines;
+}
+
+template <typename Scan, typename... Args>
+std::vector<LineNo> runChunks(const char* data, size_t size, const ParallelSearchOptions& options,
+                              const Args&... args) {
+    return runRanges<Scan>(data, std::vector<LineRange>{ LineRange{ 0, size, 1 } }, options, args...);
+}
+
+// 字面量：查找器命中的行就是匹配行
+class LiteralScan {
+public:
+    explicit LiteralScan(const Searcher& searcher) : searcher_(searcher) {}
+    size_t find(const char* data, size_t size) const { return searcher_.find(data, size); }
+    bool confirm(const char*, size_t) const { return true; }
+
+private:
+    const Searcher& searcher_;
+};
+
+// 正则：有必需字面量时用它挑出候选行，否则逐行交给本线程的 DFA
+class RegexScan {
+public:
+    RegexScan(const Regex& regex, const Searcher* prefilter)
+        : regex_(regex.pattern(), regex.ignoreCase()), prefilter_(prefilter) {}
+    size_t find(const char* data, size_t size) const {
+        return prefilter_ ? prefilter_->find(data, size) : 0;
+    }
+    bool confirm(const char* line, size_t size) const { return regex_.search(line, size); }
+
+private:
+    Regex regex_;
+    const Searcher* prefilter_;
+};
+
+// 多模式：自动机连续扫描整个窗口；只有模式含换行时才需要在行内复核
+class MultiScan {
+public:
+    MultiScan(const MultiSearcher& searcher, bool exact) : searcher_(searcher), exact_(exact) {}
+    size_t find(const char* data, size_t size) const { return searcher_.findAny(data, size); }
+    bool confirm(const char* line, size_t size) const {
+        return exact_ || searcher_.matchesAny(line, size);
+    }
+
+private:
+    const MultiSearcher& searcher_;
+    bool exact_;
+};
+
+// 近似查找：各片段在窗口内的下一处出现缓存起来，取最早的一处作为候选行，
+// 候选行再做编辑距离比对；片段太短时逐行比对
+class FuzzyScan {
+public:
+    explicit FuzzyScan(const FuzzySearcher& searcher)
+        : searcher_(searcher), next_(searcher.pieces().size(), nullptr), windowEnd_(nullptr) {}
+    size_t find(const char* data, size_t size) {
+        const std::vector<Searcher>& pieces = searcher_.pieces();
+        if (pieces.empty()) {
+            return 0;
+        }
+        const char* end = data + size;
+        if (end != windowEnd_) {
+            std::fill(next_.begin(), next_.end(), nullptr);
+            windowEnd_ = end;
+        }
+        // next_[i] 为 end 表示窗口剩余部分中没有该片段
+        const char* best = end;
+        for (size_t i = 0; i < pieces.size(); i++) {
+            if (!next_[i] || next_[i] < data) {
+                size_t pos = pieces[i].find(data, size);
+                next_[i] = pos == SEARCH_NOT_FOUND ? end : data + pos;
+            }
+            best = std::min(best, next_[i]);
+        }
+        return best == end ? SEARCH_NOT_FOUND : static_cast<size_t>(best - data);
+    }
+    bool confirm(const char* line, size_t size) const { return searcher_.verify(line, size); }
+
+private:
+    FuzzySearcher searcher_;
+    std::vector<const char*> next_;
+    const char* windowEnd_;
+};
+
+} // anonymous namespace
+
+namespace {
+
+bool hasNewline(const std::string& text) {
+    return text.find('\n') != std::string::npos;
+}
+
+// 正则的必需字面量预过滤器由所有线程共享；字面量含换行时不可用
+std::unique_ptr<Searcher> regexPrefilter(const Regex& regex) {
+    const std::string& literal = regex.requiredLiteral();
+    if (literal.empty() || hasNewline(literal)) {
+        return nullptr;
+    }
+    return std::unique_ptr<Searcher>(new Searcher(literal, regex.ignoreCase()));
+}
+
+bool multiExact(const MultiSearcher& searcher) {
+    for (const std::string& pattern : searcher.patterns()) {
+        if (hasNewline(pattern)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+std::vector<LineNo> findLinesParallel(const char* data, size_t size, const Searcher& searcher,
+                                      const ParallelSearchOptions& options) {
+    // 行内不含换行符，包含换行的模式不可能匹配任何一行
+    if (hasNewline(searcher.pattern())) {
+        return std::vector<LineNo>();
+    }
+    return runChunks<LiteralScan>(data, size, options, searcher);
+}
+
+std::vector<LineNo> findLinesParallel(const char* data, size_t size, const Regex& regex,
+                                      const ParallelSearchOptions& options) {
+    std::unique_ptr<Searcher> prefilter = regexPrefilter(regex);
+    const Searcher* shared = prefilter.get();
+    return runChunks<RegexScan>(data, size, options, regex, shared);
+}
+
+std::vector<LineNo> findLinesParallel(const char* data, size_t size, const MultiSearcher& searcher,
+                                      const ParallelSearchOptions& options) {
+    return runChunks<MultiScan>(data, size, options, searcher, multiExact(searcher));
+}
+
+std::vector<LineNo> findLinesParallel(const char* data, size_t size, const FuzzySearcher& searcher,
+                                      const ParallelSearchOptions& options) {
+    return runChunks<FuzzyScan>(data, size, options, searcher);
+}
+
+std::vector<LineNo> findLinesParallel(const char* data, const std::vector<LineRange>& ranges,
+                                      const Searcher& searcher, const ParallelSearchOptions& options) {
+    if (hasNewline(searcher.pattern())) {
+        return std::vector<LineNo>();
+    }
+    return runRanges<LiteralScan>(data, ranges, options, searcher);
+}
+
+std::vector<LineNo> findLinesParallel(const char* data, const std::vector<LineRange>& ranges,
+                                      const Regex& regex, const ParallelSearchOptions& options) {
+    std::unique_ptr<Searcher> prefilter = regexPrefilter(regex);
+    const Searcher* shared = prefilter.get();
+    return runRanges<RegexScan>(data, ranges, options, regex, shared);
+}
+
+std::vector<LineNo> findLinesParallel(const char* data, const std::vector<LineRange>& ranges,
+                                      const MultiSearcher& searcher, const ParallelSearchOptions& options) {
+    return runRanges<MultiScan>(data, ranges, options, searcher, multiExact(searcher));
+}
+
+std::vector<LineNo> findLinesParallel(const char* data, const std::vector<LineRange>& ranges,
+                                      const FuzzySearcher& searcher, const ParallelSearchOptions& options) {
+    return runRanges<FuzzyScan>(data, ranges, options, searcher);
+}
+
+} // namespace line_editor
@@ -0,0 +1,168 @@
+#include "fuzzy_search.h"
+#include "error.h"
+
+namespace line_editor {
+
+namespace {
+
+constexpr uint64_t HIGH_BIT = 1ULL << 63;
+
+} // anonymous namespace
+
+FuzzySearcher::FuzzySearcher(const std::string& pattern, int maxErrors)
+    : pattern_(pattern), maxErrors_(maxErrors), words_(0), lastBit_(0), score_(0) {
+    if (pattern_.empty()) {
+        throw EditorException(ErrorCode::INVALID_PATTERN, "近似查找的模式不能为空");
+    }
+    if (maxErrors_ < 0 || maxErrors_ > MAX_ERRORS) {
+        throw EditorException(ErrorCode::INVALID_PATTERN,
+            "近似查找的编辑距离必须在 0 到 " + std::to_string(MAX_ERRORS) + " 之间");
+    }
+    if (static_cast<size_t>(maxErrors_) >= pattern_.size()) {
+        throw EditorException(ErrorCode::INVALID_PATTERN,
+            "编辑距离必须小于模式长度，否则每一行都会匹配");
+    }
+
+    size_t m = pattern_.size();
+    words_ = (m + 63) / 64;
+    peq_.assign(256 * words_, 0);
+    for (size_t i = 0; i < m; i++) {
+        unsigned char byte = static_cast<unsigned char>(pattern_[i]);
+        peq_[byte * words_ + i / 64] |= 1ULL << (i % 64);
+    }
+    lastBit_ = 1ULL << ((m - 1) % 64);
+    pv_.resize(words_);
+    mv_.resize(words_);
+
+    size_t parts = static_cast<size_t>(maxErrors_) + 1;
+    if (m / parts >= MIN_PIECE_LENGTH) {
+        for (size_t i = 0; i < parts; i++) {
+            size_t begin = i * m / parts;
+            size_t end = (i + 1) * m / parts;
+            pieces_.emplace_back(pattern_.substr(begin, end - begin));
+        }
+    }
+}
+
+std::vector<std::string> FuzzySearcher::pieceLiterals() const {
+    std::vector<std::string> literals;
+    for (const Searcher& piece : pieces_) {
+        literals.push_back(piece.pattern());
+    }
+    return literals;
+}
+
+void FuzzySearcher::reset() const {
+    for (size_t w = 0; w < words_; w++) {
+        pv_[w] = ~0ULL;
+        mv_[w] = 0;
+    }
+    score_ = static_cast<int>(pattern_.size());
+}
+
+bool FuzzySearcher::feed(const unsigned char* data, size_t size) const {
+    if (words_ > 1) {
+        return feedWords(data, size);
+    }
+
+    // 模式不超过 64 字节：整列放在一个字里，状态留在寄存器中
+    uint64_t pv = pv_[0];
+    uint64_t mv = mv_[0];
+    int score = score_;
+    bool found = false;
+    for (size_t i = 0; i < size; i++) {
+        uint64_t eq = peq_[data[i]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & lastBit_) {
+            score++;
+        } else if (mh & lastBit_) {
+            score--;
+        }
+        // 查找时文本可以从任意位置开始，首行的横向差分为 0，移入 0
+        ph <<= 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        if (score <= maxErrors_) {
+            found = true;
+            break;
+        }
+    }
+    pv_[0] = pv;
+    mv_[0] = mv;
+    score_ = score;
+    return found;
+}
+
+bool FuzzySearcher::feedWords(const unsigned char* data, size_t size) const {
+    for (size_t i = 0; i < size; i++) {
+        const uint64_t* eqs = &peq_[static_cast<size_t>(data[i]) * words_];
+        // carry 是上一个字最后一行的横向差分（+1、0、-1），作为下一个字的首行输入
+        int carry = 0;
+        for (size_t w = 0; w < words_; w++) {
+            uint64_t pv = pv_[w];
+            uint64_t mv = mv_[w];
+            uint64_t eq = eqs[w];
+            uint64_t xv = eq | mv;
+            if (carry < 0) {
+                eq |= 1;
+            }
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+            uint64_t top = w + 1 == words_ ? lastBit_ : HIGH_BIT;
+            int out = (ph & top) ? 1 : ((mh & top) ? -1 : 0);
+            ph <<= 1;
+            mh <<= 1;
+            if (carry < 0) {
+                mh |= 1;
+            } else if (carry > 0) {
+                ph |= 1;
+            }
+            pv_[w] = mh | ~(xv | ph);
+            mv_[w] = ph & xv;
+            carry = out;
+        }
+        score_ += carry;
+        if (score_ <= maxErrors_) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FuzzySearcher::verify(const char* data, size_t size) const {
+    reset();
+    return feed(reinterpret_cast<const unsigned char*>(data), size);
+}
+
+bool FuzzySearcher::verify(const LineBlock* head) const {
+    reset();
+    for (const LineBlock* block = head; block; block = block->next()) {
+        if (feed(reinterpret_cast<const unsigned char*>(block->data()), block->used())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FuzzySearcher::matches(const char* data, size_t size) const {
+    bool candidate = pieces_.empty();
+    for (size_t i = 0; i < pieces_.size() && !candidate; i++) {
+        candidate = pieces_[i].find(data, size) != SEARCH_NOT_FOUND;
+    }
+    return candidate && verify(data, size);
+}
+
+bool FuzzySearcher::matches(const LineBlock* head) const {
+    bool candidate = pieces_.empty();
+    for (size_t i = 0; i < pieces_.size() && !candidate; i++) {
+        candidate = pieces_[i].matches(head);
+    }
+    return candidate && verify(head);
+}
+
+} // namespace line_editor
@@ -0,0 +1,89 @@
+#include "incremental_search.h"
+#include "text_search.h"
+#include <utility>
+
+namespace line_editor {
+
+namespace {
+
+bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// text 末尾不完整的 UTF-8 序列的字节数
+size_t incompleteTail(const std::string& text) {
+    size_t n = text.size();
+    size_t i = n;
+    while (i > 0 && n - i < 4 && (static_cast<unsigned char>(text[i - 1]) & 0xC0) == 0x80) {
+        i--;
+    }
+    if (i == 0) {
+        return 0;
+    }
+    unsigned char lead = static_cast<unsigned char>(text[i - 1]);
+    size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    size_t have = n - (i - 1);
+    return have < need ? have : 0;
+}
+
+} // anonymous namespace
+
+IncrementalSearch::IncrementalSearch(const ActiveZone& zone)
+    : zone_(zone), checked_(0) {
+}
+
+const std::vector<IncrementalSearch::Hit>& IncrementalSearch::hits() const {
+    // 每次 update 之后栈顶就是模式完整部分的结果
+    return levels_.empty() ? none_ : levels_.back().hits;
+}
+
+const std::vector<IncrementalSearch::Hit>& IncrementalSearch::update(const std::string& pattern) {
+    pattern_ = pattern;
+    checked_ = 0;
+    std::string complete = pattern.substr(0, pattern.size() - incompleteTail(pattern));
+
+    // 退回到仍是新模式前缀的最长缓存
+    while (!levels_.empty() && !startsWith(complete, levels_.back().pattern)) {
+        levels_.pop_back();
+    }
+    if (complete.empty() || (!levels_.empty() && levels_.back().pattern == complete)) {
+        return hits();
+    }
+
+    Searcher searcher(complete);
+    Level level;
+    level.pattern = complete;
+    if (levels_.empty()) {
+        LineNo no = zone_.startLineNo();
+        for (const Line* line = zone_.head(); line; line = line->next(), no++) {
+            if (searcher.matches(line->head(), line->isAscii())) {
+                level.hits.push_back(Hit{ no, line });
+            }
+        }
+        checked_ = static_cast<size_t>(zone_.lineCount());
+    } else {
+        // 包含新模式的行一定包含它的前缀，只需检查上一层的命中
+        const std::vector<Hit>& previous = levels_.back().hits;
+        for (const Hit& hit : previous) {
+            if (searcher.matches(hit.line->head(), hit.line->isAscii())) {
+                level.hits.push_back(hit);
+            }
+        }
+        checked_ = previous.size();
+    }
+    levels_.push_back(std::move(level));
+    return hits();
+}
+
+const std::vector<IncrementalSearch::Hit>& IncrementalSearch::backspace() {
+    if (pattern_.empty()) {
+        return none_;
+    }
+    size_t end = pattern_.size() - 1;
+    while (end > 0 && (static_cast<unsigned char>(pattern_[end]) & 0xC0) == 0x80) {
+        end--;
+    }
+    return update(pattern_.substr(0, end));
+}
+
+} // namespace line_editor
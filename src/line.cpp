@@ -1,13 +1,18 @@
 #include "line.h"
+#include "encoding_utils.h"
+#include "text_search.h"
 #include <algorithm>
 #include <cstring>
 
 namespace line_editor {
 
-Line::Line() : head_(nullptr), prev_(nullptr), next_(nullptr) {
+// 行号放在活区里，不进入每个节点；64 位行号不应让节点变大
+static_assert(sizeof(Line) <= 4 * sizeof(void*), "Line node must stay compact");
+
+Line::Line() : head_(nullptr), prev_(nullptr), next_(nullptr), ascii_(true), origin_(-1) {
 }
 
-Line::Line(const char* text) : head_(nullptr), prev_(nullptr), next_(nullptr) {
+Line::Line(const char* text) : head_(nullptr), prev_(nullptr), next_(nullptr), ascii_(true), origin_(-1) {
     setText(text);
 }
 
@@ -16,10 +21,11 @@ Line::~Line() {
 }
 
 Line::Line(Line&& other) noexcept
-    : head_(other.head_), prev_(other.prev_), next_(other.next_) {
+    : head_(other.head_), prev_(other.prev_), next_(other.next_), ascii_(other.ascii_), origin_(other.origin_) {
     other.head_ = nullptr;
     other.prev_ = nullptr;
     other.next_ = nullptr;
+    other.ascii_ = true;
 }
 
 Line& Line::operator=(Line&& other) noexcept {
@@ -29,16 +35,20 @@ Line& Line::operator=(Line&& other) noexcept {
         head_ = other.head_;
         prev_ = other.prev_;
         next_ = other.next_;
+        ascii_ = other.ascii_;
+        origin_ = other.origin_;
 
         other.head_ = nullptr;
         other.prev_ = nullptr;
         other.next_ = nullptr;
+        other.ascii_ = true;
     }
     return *this;
 }
 
 void Line::setText(const char* text) {
     clearBlocks();
+    ascii_ = true;
 
     if (!text || text[0] == '\0') {
         return;
@@ -48,6 +58,7 @@ void Line::setText(const char* text) {
     LineBlock* current = head_;
 
     size_t textLen = std::strlen(text);
+    ascii_ = line_editor::isAscii(text, textLen);
     size_t offset = 0;
 
     while (offset < textLen) {
@@ -114,31 +125,100 @@ int Line::find(const char* substr) const {
         return 0;
     }
 
-    std::string text = getText();
-    size_t pos = text.find(substr);
+    // 直接在块链上查找，不拼接整行
+    size_t pos = findInBlocks(head_, substr, std::strlen(substr));
 
-    return (pos == std::string::npos) ? -1 : static_cast<int>(pos);
+    return (pos == SEARCH_NOT_FOUND) ? -1 : static_cast<int>(pos);
 }
 
 bool Line::contains(const char* pattern) const {
     return find(pattern) != -1;
 }
 
+bool Line::containsIgnoreCase(const char* pattern) const {
+    return Searcher(pattern ? pattern : "", true).matches(head_, ascii_);
+}
+
 bool Line::replace(const char* oldStr, const char* newStr) {
     if (!oldStr || oldStr[0] == '\0') {
         return false;
     }
+    return replace(Searcher(oldStr), newStr ? newStr : "", false) > 0;
+}
 
-    std::string text = getText();
-    size_t pos = text.find(oldStr);
+size_t Line::replace(const Searcher& searcher, const std::string& newStr, bool global) {
+    const std::string& pattern = searcher.pattern();
+    if (pattern.empty()) {
+        return 0;
+    }
 
-    if (pos == std::string::npos) {
-        return false;
+    size_t pos = searcher.find(head_, ascii_);
+    if (pos == SEARCH_NOT_FOUND) {
+        return 0;
+    }
+
+    // 找到第一处匹配所在的块，之前的块保持不变
+    LineBlock* prev = nullptr;
+    LineBlock* first = head_;
+    while (pos >= first->used()) {
+        pos -= first->used();
+        prev = first;
+        first = first->next();
+    }
+
+    // 只把从该块开始的后缀拼成连续缓冲，在上面连续查找后续匹配
+    std::string tail;
+    for (const LineBlock* block = first; block; block = block->next()) {
+        tail.append(block->data(), block->used());
+    }
+    std::string result;
+    result.reserve(tail.size() + newStr.size());
+    size_t count = 0;
+    size_t from = 0;
+    while (pos != SEARCH_NOT_FOUND) {
+        result.append(tail, from, pos - from);
+        result += newStr;
+        from = pos + pattern.size();
+        count++;
+        if (!global || from > tail.size()) {
+            break;
+        }
+        size_t next = searcher.find(tail.data() + from, tail.size() - from);
+        pos = (next == SEARCH_NOT_FOUND) ? SEARCH_NOT_FOUND : from + next;
     }
+    result.append(tail, from, std::string::npos);
 
-    text.replace(pos, std::strlen(oldStr), newStr ? newStr : "");
-    setText(text.c_str());
-    return true;
+    // 结果依次写回原有的块，不够时追加新块，多出的块释放
+    LineBlock* block = first;
+    LineBlock* last = prev;
+    size_t offset = 0;
+    while (offset < result.size()) {
+        if (!block) {
+            block = last->createNext();
+        }
+        block->clear();
+        offset += block->append(result.data() + offset, result.size() - offset);
+        last = block;
+        block = block->next();
+    }
+    if (block) {
+        if (last) {
+            last->setNext(nullptr);
+        } else {
+            head_ = nullptr;
+        }
+        delete block;
+    }
+
+    if (ascii_) {
+        ascii_ = line_editor::isAscii(newStr.data(), newStr.size());
+    } else {
+        ascii_ = true;
+        for (const LineBlock* b = head_; b && ascii_; b = b->next()) {
+            ascii_ = line_editor::isAscii(b->data(), b->used());
+        }
+    }
+    return count;
 }
 
 } // namespace line_editor
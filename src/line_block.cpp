@@ -4,6 +4,9 @@
 
 namespace line_editor {
 
+static_assert(sizeof(LineBlock) <= BLOCK_SIZE + sizeof(size_t) + sizeof(LineBlock*) + alignof(LineBlock),
+              "LineBlock must not grow beyond its payload and links");
+
 LineBlock::LineBlock() : used_(0), next_(nullptr) {
     data_[0] = '\0';
 }
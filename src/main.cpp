@@ -1,20 +1,106 @@
 #include "editor.h"
 #include "error.h"
 #include "encoding_utils.h"
+#include "stream_substitute.h"
+#include "zone_script.h"
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
 #include <exception>
 #include <new>
 
 using namespace line_editor;
 
 void printUsage(const char* programName) {
-    std::cout << "用法: " << programName << " [输入文件] [输出文件]\n";
+    std::cout << "用法: " << programName << " [选项] [输入文件] [输出文件]\n";
     std::cout << "\n参数:\n";
-    std::cout << "  输入文件     - 可选的要编辑的输入文件（空表示新建文件）\n";
-    std::cout << "  输出文件     - 用于保存结果的输出文件\n";
+    std::cout << "  输入文件     - 可选的要编辑的输入文件（空表示新建文件，- 表示标准输入）\n";
+    std::cout << "  输出文件     - 用于保存结果的输出文件（- 表示标准输出）\n";
+    std::cout << "\n选项:\n";
+    std::cout << "  -e <命令>     - 非交互地执行命令，可重复；命令内的换行分隔多条命令\n";
+    std::cout << "  --script <文件> - 非交互地执行文件中的命令，每行一条（- 表示标准输入）；可与 -e 混用，按出现顺序执行\n";
+    std::cout << "  --bypass-cache - 读写时绕过页缓存（O_DIRECT 或 fadvise），用于批量处理大文件\n";
+    std::cout << "  --utf8=<模式> - 非法 UTF-8 的处理: pass（原样保留，默认）、replace（替换为 U+FFFD）、reject（报错）\n";
+    std::cout << "  --index       - 在后台为输入文件构建 trigram 索引（<输入>.tri），供 M 只查找候选块\n";
+    std::cout << "  --substitute <旧>@<新>[@g] - 不进入编辑器，多线程流式替换整个输入并写入输出（g: 每行全部替换）\n";
+    std::cout << "  --each-zone   - 把脚本分别应用到输入的每个活区（每个活区从第 1 行编号），多线程并行执行；不能使用 n、g、M、q\n";
+    std::cout << "  --threads=<n> - --substitute 和 --each-zone 使用的工作线程数（默认全部硬件线程）\n";
     std::cout << "\n示例:\n";
     std::cout << "  " << programName << " input.txt output.txt\n";
+    std::cout << "  cat input.txt | " << programName << " - - -e 'd1' -e 's2@old@new@'\n";
+    std::cout << "  " << programName << " --script edits.txt input.txt output.txt\n";
+    std::cout << "  " << programName << " --substitute 'http:@https:@g' big.log big.log\n";
+    std::cout << "  " << programName << " --each-zone --script zone.txt big.log out.log\n";
+    std::cout << "\n脚本模式下任一命令出错时停止执行，输出文件（包括原地编辑的输入文件）保持原样，退出状态为 1。\n";
+}
+
+// 流式替换整个输入，不经过活区；结果统计写到标准错误，标准输出可能就是数据
+int runSubstitute(const std::string& spec, unsigned threads, bool bypassCache,
+                  const std::string& inputFile, const std::string& outputFile) {
+    SubstituteOptions options;
+    options.threads = threads;
+    std::string oldStr;
+    std::string newStr;
+    CommandParser::parseReplacement(spec, oldStr, newStr, options.global);
+    StreamSubstituter substituter(oldStr, newStr, options);
+
+    FileManager fileMgr;
+    fileMgr.setCacheBypass(bypassCache);
+    if (FileManager::isSameFile(inputFile, outputFile)) {
+        fileMgr.openInPlace(inputFile);
+    } else {
+        fileMgr.openInput(inputFile);
+        fileMgr.openOutput(outputFile);
+    }
+
+    SubstituteStats stats = substituter.run(fileMgr);
+    fileMgr.close();
+
+    std::cerr << "已替换 " << stats.substitutions << " 处（读入 " << stats.bytesRead
+              << " 字节，写出 " << stats.bytesWritten << " 字节，"
+              << substituter.options().threads << " 个线程）\n";
+    return 0;
+}
+
+// 逐活区并行执行脚本；命令结果的去向与脚本模式相同，出错时放弃输出
+int runEachZone(const std::string& script, unsigned threads, bool bypassCache, Utf8Mode utf8Mode,
+                const std::string& inputFile, const std::string& outputFile) {
+    ZoneScriptOptions options;
+    options.threads = threads;
+    ZoneScript zoneScript(script, options);
+
+    FileManager fileMgr;
+    fileMgr.setCacheBypass(bypassCache);
+    fileMgr.setUtf8Mode(utf8Mode);
+    fileMgr.setAtomicOutput(true);
+    if (FileManager::isSameFile(inputFile, outputFile)) {
+        fileMgr.openInPlace(inputFile);
+    } else {
+        fileMgr.openInput(inputFile);
+        fileMgr.openOutput(outputFile);
+    }
+
+    std::ostream& results = fileMgr.isOutputStdout() ? std::cerr : std::cout;
+    ZoneScriptStats stats;
+    try {
+        stats = zoneScript.run(fileMgr, results, std::cerr);
+    } catch (...) {
+        fileMgr.abandon();
+        throw;
+    }
+    results.flush();
+    if (stats.failedLine != 0) {
+        unsigned long long firstLine = (stats.failedZone - 1) * static_cast<unsigned long long>(options.zoneLines) + 1;
+        std::cerr << "第 " << stats.failedZone << " 个活区（输入第 " << firstLine << " 行起）执行脚本第 "
+                  << stats.failedLine << " 行出错，已停止执行，放弃其余输出。\n";
+        fileMgr.abandon();
+        return 1;
+    }
+    fileMgr.close();
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
@@ -24,19 +110,145 @@ int main(int argc, char* argv[]) {
 
     try {
         std::string inputFile, outputFile;
+        std::vector<std::string> positional;
+        // -e 和 --script 给出的命令按出现顺序拼接，每条以换行结束
+        std::string script;
+        bool hasScript = false;
+        Utf8Mode utf8Mode = Utf8Mode::PASS_THROUGH;
+        bool bypassCache = false;
+        bool buildIndex = false;
+        std::string substitute;
+        bool hasSubstitute = false;
+        unsigned threads = 0;
+        bool scriptFromStdin = false;
+        bool eachZone = false;
 
-        if (argc > 1) {
-            if (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help") {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "-h" || arg == "--help") {
                 printUsage(argv[0]);
                 return 0;
             }
-            inputFile = argv[1];
+            if (arg == "-e") {
+                if (i + 1 >= argc) {
+                    std::cerr << "-e 缺少命令参数\n";
+                    return 1;
+                }
+                script += argv[++i];
+                script += '\n';
+                hasScript = true;
+                continue;
+            }
+            if (arg == "--script") {
+                if (i + 1 >= argc) {
+                    std::cerr << "--script 缺少脚本文件参数\n";
+                    return 1;
+                }
+                std::string scriptFile = argv[++i];
+                std::ostringstream contents;
+                if (scriptFile == STDIO_FILENAME) {
+                    contents << std::cin.rdbuf();
+                } else {
+                    std::ifstream in(scriptFile, std::ios::binary);
+                    if (!in) {
+                        std::cerr << "无法打开脚本文件: " << scriptFile << "\n";
+                        return 1;
+                    }
+                    contents << in.rdbuf();
+                }
+                script += contents.str();
+                if (!script.empty() && script.back() != '\n') {
+                    script += '\n';
+                }
+                hasScript = true;
+                scriptFromStdin = scriptFromStdin || scriptFile == STDIO_FILENAME;
+                continue;
+            }
+            if (arg == "--substitute") {
+                if (i + 1 >= argc) {
+                    std::cerr << "--substitute 缺少 <旧>@<新>[@g] 参数\n";
+                    return 1;
+                }
+                substitute = argv[++i];
+                hasSubstitute = true;
+                continue;
+            }
+            if (arg.compare(0, 10, "--threads=") == 0) {
+                int n = std::atoi(arg.c_str() + 10);
+                if (n <= 0) {
+                    std::cerr << "无效的线程数: " << arg.substr(10) << "\n";
+                    return 1;
+                }
+                threads = static_cast<unsigned>(n);
+                continue;
+            }
+            if (arg == "--each-zone") {
+                eachZone = true;
+                continue;
+            }
+            if (arg == "--index") {
+                buildIndex = true;
+                continue;
+            }
+            if (arg == "--bypass-cache") {
+                bypassCache = true;
+                continue;
+            }
+            if (arg.compare(0, 7, "--utf8=") == 0) {
+                if (!parseUtf8Mode(arg.substr(7), utf8Mode)) {
+                    std::cerr << "无效的 UTF-8 模式: " << arg.substr(7) << "\n";
+                    return 1;
+                }
+                continue;
+            }
+            positional.push_back(arg);
+        }
+
+        if (positional.size() > 0) {
+            inputFile = positional[0];
+        }
+        if (positional.size() > 1) {
+            outputFile = positional[1];
         }
-        if (argc > 2) {
-            outputFile = argv[2];
+
+        if (hasSubstitute) {
+            if (hasScript || utf8Mode != Utf8Mode::PASS_THROUGH) {
+                std::cerr << "--substitute 不能与 -e、--script 或 --utf8 同时使用。\n";
+                return 1;
+            }
+            if (inputFile.empty() || outputFile.empty()) {
+                std::cerr << "--substitute 需要输入文件和输出文件。\n";
+                return 1;
+            }
+            return runSubstitute(substitute, threads, bypassCache, inputFile, outputFile);
         }
 
-        if (inputFile.empty() && outputFile.empty()) {
+        if (eachZone) {
+            if (!hasScript || buildIndex) {
+                std::cerr << "--each-zone 需要 -e 或 --script 给出脚本，且不能与 --index 同时使用。\n";
+                return 1;
+            }
+            if (inputFile.empty() || outputFile.empty()) {
+                std::cerr << "--each-zone 需要输入文件和输出文件。\n";
+                return 1;
+            }
+            if (inputFile == STDIO_FILENAME && scriptFromStdin) {
+                std::cerr << "输入文件和脚本不能都来自标准输入。\n";
+                return 1;
+            }
+            return runEachZone(script, threads, bypassCache, utf8Mode, inputFile, outputFile);
+        }
+
+        if (inputFile == STDIO_FILENAME && !hasScript) {
+            std::cerr << "从标准输入读取时必须用 -e 或 --script 指定命令。\n";
+            return 1;
+        }
+        if (inputFile == STDIO_FILENAME && scriptFromStdin) {
+            std::cerr << "输入文件和脚本不能都来自标准输入。\n";
+            return 1;
+        }
+
+        if (inputFile.empty() && outputFile.empty() && !hasScript) {
             std::cout << "未指定文件。请输入输入文件名（留空表示无）: ";
             std::getline(std::cin, inputFile);
 
@@ -47,15 +259,23 @@ int main(int argc, char* argv[]) {
         }
 
         Editor editor;
+        editor.setUtf8Mode(utf8Mode);
+        editor.setCacheBypass(bypassCache);
+        editor.setBuildIndex(buildIndex);
+        editor.setAtomicOutput(hasScript);
 
         if (!editor.init(inputFile, outputFile)) {
             std::cerr << "初始化编辑器失败。\n";
             return 1;
         }
 
-        editor.run();
+        if (!hasScript) {
+            editor.run();
+            return 0;
+        }
 
-        return 0;
+        std::istringstream commands(script);
+        return editor.runScript(commands) ? 0 : 1;
     }
     catch (const std::bad_alloc& e) {
         std::cerr << "致命错误: 内存不足 - " << e.what() << "\n";
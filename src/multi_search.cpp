@@ -0,0 +1,171 @@
+#include "multi_search.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+namespace line_editor {
+
+MultiSearcher::MultiSearcher(const std::vector<std::string>& patterns)
+    : patterns_(patterns), classCount_(1), rootSkip_(-1) {
+    // 模式中没有出现的字节共用第 0 类，在任何状态下都回到根
+    bool used[256] = {};
+    for (const std::string& p : patterns_) {
+        for (char c : p) {
+            used[static_cast<unsigned char>(c)] = true;
+        }
+    }
+    for (int b = 0; b < 256; b++) {
+        byteClass_[b] = used[b] ? static_cast<uint8_t>(classCount_++) : 0;
+    }
+
+    // 建 trie，未建立的边暂记为 -1
+    delta_.assign(classCount_, -1);
+    ends_.emplace_back();
+    for (size_t i = 0; i < patterns_.size(); i++) {
+        int state = 0;
+        for (char c : patterns_[i]) {
+            size_t slot = static_cast<size_t>(state) * classCount_ + byteClass_[static_cast<unsigned char>(c)];
+            if (delta_[slot] < 0) {
+                delta_[slot] = static_cast<int>(ends_.size());
+                ends_.emplace_back();
+                delta_.resize(delta_.size() + classCount_, -1);
+            }
+            state = delta_[slot];
+        }
+        ends_[state].push_back(i);
+    }
+
+    // 按深度广度优先计算失败链，同时把缺失的边补成失败状态的边
+    size_t states = ends_.size();
+    fail_.assign(states, 0);
+    dictLink_.assign(states, -1);
+    std::deque<int> queue;
+    for (size_t c = 0; c < classCount_; c++) {
+        int& target = delta_[c];
+        if (target < 0) {
+            target = 0;
+        } else {
+            queue.push_back(target);
+        }
+    }
+    while (!queue.empty()) {
+        int state = queue.front();
+        queue.pop_front();
+        int f = fail_[state];
+        dictLink_[state] = !ends_[f].empty() ? f : dictLink_[f];
+        for (size_t c = 0; c < classCount_; c++) {
+            size_t slot = static_cast<size_t>(state) * classCount_ + c;
+            int fallback = delta_[static_cast<size_t>(f) * classCount_ + c];
+            if (delta_[slot] < 0) {
+                delta_[slot] = fallback;
+            } else {
+                fail_[delta_[slot]] = fallback;
+                queue.push_back(delta_[slot]);
+            }
+        }
+    }
+
+    hasOutput_.resize(states);
+    for (size_t s = 0; s < states; s++) {
+        hasOutput_[s] = !ends_[s].empty() || dictLink_[s] >= 0;
+    }
+
+    int first = -1;
+    bool shared = ends_[0].empty();
+    for (const std::string& p : patterns_) {
+        int b = static_cast<unsigned char>(p[0]);
+        if (first >= 0 && b != first) {
+            shared = false;
+        }
+        first = b;
+    }
+    if (shared && first >= 0) {
+        rootSkip_ = first;
+    }
+}
+
+template <typename OnOutput>
+bool MultiSearcher::scan(const char* data, size_t size, int& state, OnOutput onOutput) const {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        if (state == 0 && rootSkip_ >= 0) {
+            const void* hit = std::memchr(p + i, rootSkip_, size - i);
+            if (!hit) {
+                return false;
+            }
+            i = static_cast<size_t>(static_cast<const unsigned char*>(hit) - p);
+        }
+        state = next(state, p[i]);
+        if (hasOutput_[state] && onOutput(state, i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MultiSearcher::collect(int state, std::vector<size_t>& found) const {
+    if (ends_[state].empty()) {
+        state = dictLink_[state];
+    }
+    while (state >= 0) {
+        found.insert(found.end(), ends_[state].begin(), ends_[state].end());
+        state = dictLink_[state];
+    }
+}
+
+void MultiSearcher::finish(std::vector<size_t>& found) const {
+    // 空模式停在根上，匹配任何输入
+    found.insert(found.end(), ends_[0].begin(), ends_[0].end());
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+}
+
+bool MultiSearcher::matchesAny(const char* data, size_t size) const {
+    if (!ends_[0].empty()) {
+        return true;
+    }
+    int state = 0;
+    return scan(data, size, state, [](int, size_t) { return true; });
+}
+
+bool MultiSearcher::matchesAny(const LineBlock* head) const {
+    if (!ends_[0].empty()) {
+        return true;
+    }
+    int state = 0;
+    for (const LineBlock* block = head; block; block = block->next()) {
+        if (scan(block->data(), block->used(), state, [](int, size_t) { return true; })) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t MultiSearcher::findAny(const char* data, size_t size) const {
+    if (!ends_[0].empty()) {
+        return 0;
+    }
+    int state = 0;
+    size_t last = SEARCH_NOT_FOUND;
+    scan(data, size, state, [&](int, size_t i) { last = i; return true; });
+    return last;
+}
+
+void MultiSearcher::matchedPatterns(const char* data, size_t size, std::vector<size_t>& found) const {
+    found.clear();
+    int state = 0;
+    scan(data, size, state, [&](int s, size_t) { collect(s, found); return false; });
+    finish(found);
+}
+
+void MultiSearcher::matchedPatterns(const LineBlock* head, std::vector<size_t>& found) const {
+    found.clear();
+    // 自动机状态跨块延续，跨块的匹配不需要特殊处理
+    int state = 0;
+    for (const LineBlock* block = head; block; block = block->next()) {
+        scan(block->data(), block->used(), state, [&](int s, size_t) { collect(s, found); return false; });
+    }
+    finish(found);
+}
+
+} // namespace line_editor
@@ -0,0 +1,1169 @@
+#include "regex_engine.h"
+#include "case_fold.h"
+#include "error.h"
+#include <algorithm>
+#include <cctype>
+
+namespace line_editor {
+
+namespace {
+
+// NFA 状态数上限：决定了每个输入字节的最坏开销
+constexpr size_t MAX_NFA_STATES = 20000;
+// 计数重复 {m,n} 的上限
+constexpr int MAX_REPEAT = 1000;
+constexpr uint32_t MAX_CODE_POINT = 0x10FFFF;
+
+struct ByteRange {
+    uint8_t lo;
+    uint8_t hi;
+};
+
+typedef std::vector<ByteRange> ByteSequence;
+
+struct CodeRange {
+    uint32_t lo;
+    uint32_t hi;
+};
+
+struct Node {
+    enum Kind { EMPTY, CLASS, CONCAT, ALTERNATE, REPEAT, LINE_START, LINE_END };
+
+    explicit Node(Kind k) : kind(k), min(0), max(0) {}
+
+    Kind kind;
+    std::vector<ByteSequence> sequences;        // CLASS：任选其一的字节序列
+    std::vector<std::unique_ptr<Node>> children;
+    int min;
+    int max;                                    // REPEAT：-1 表示无上限
+};
+
+typedef std::unique_ptr<Node> NodePtr;
+
+size_t encodeUtf8(uint32_t cp, uint8_t* out) {
+    if (cp < 0x80) {
+        out[0] = static_cast<uint8_t>(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = static_cast<uint8_t>(0xC0 | (cp >> 6));
+        out[1] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = static_cast<uint8_t>(0xE0 | (cp >> 12));
+        out[1] = static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<uint8_t>(0xF0 | (cp >> 18));
+    out[1] = static_cast<uint8_t>(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// 把码点区间拆成若干字节区间序列，每个序列匹配区间内一段编码长度相同的码点
+void splitUtf8(uint32_t lo, uint32_t hi, std::vector<ByteSequence>& out) {
+    static const uint32_t limits[] = { 0x7F, 0x7FF, 0xFFFF };
+    for (uint32_t limit : limits) {
+        if (lo <= limit && hi > limit) {
+            splitUtf8(lo, limit, out);
+            splitUtf8(limit + 1, hi, out);
+            return;
+        }
+    }
+
+    if (hi < 0x80) {
+        out.push_back(ByteSequence{ ByteRange{ static_cast<uint8_t>(lo), static_cast<uint8_t>(hi) } });
+        return;
+    }
+
+    // 让低位的续字节都覆盖 80-BF 全区间，只在前缀上留区间
+    for (int i = 1; i < 4; i++) {
+        uint32_t mask = (1u << (6 * i)) - 1;
+        if ((lo & ~mask) != (hi & ~mask)) {
+            if ((lo & mask) != 0) {
+                splitUtf8(lo, lo | mask, out);
+                splitUtf8((lo | mask) + 1, hi, out);
+                return;
+            }
+            if ((hi & mask) != mask) {
+                splitUtf8(lo, (hi & ~mask) - 1, out);
+                splitUtf8(hi & ~mask, hi, out);
+                return;
+            }
+        }
+    }
+
+    uint8_t a[4];
+    uint8_t b[4];
+    size_t n = encodeUtf8(lo, a);
+    encodeUtf8(hi, b);
+    ByteSequence seq;
+    for (size_t i = 0; i < n; i++) {
+        seq.push_back(ByteRange{ a[i], b[i] });
+    }
+    out.push_back(seq);
+}
+
+void normalize(std::vector<CodeRange>& ranges) {
+    std::sort(ranges.begin(), ranges.end(),
+              [](const CodeRange& x, const CodeRange& y) { return x.lo < y.lo; });
+    std::vector<CodeRange> merged;
+    for (const CodeRange& r : ranges) {
+        if (!merged.empty() && r.lo <= merged.back().hi + 1) {
+            merged.back().hi = std::max(merged.back().hi, r.hi);
+        } else {
+            merged.push_back(r);
+        }
+    }
+    ranges.swap(merged);
+}
+
+std::vector<CodeRange> negate(const std::vector<CodeRange>& ranges) {
+    std::vector<CodeRange> result;
+    uint32_t next = 0;
+    for (const CodeRange& r : ranges) {
+        if (r.lo > next) {
+            result.push_back(CodeRange{ next, r.lo - 1 });
+        }
+        next = r.hi + 1;
+    }
+    if (next <= MAX_CODE_POINT) {
+        result.push_back(CodeRange{ next, MAX_CODE_POINT });
+    }
+    return result;
+}
+
+NodePtr makeClass(std::vector<CodeRange> ranges) {
+    normalize(ranges);
+    NodePtr node(new Node(Node::CLASS));
+    for (const CodeRange& r : ranges) {
+        // 代理区不是合法的 UTF-8 码点
+        if (r.lo <= 0xDFFF && r.hi >= 0xD800) {
+            if (r.lo < 0xD800) splitUtf8(r.lo, 0xD7FF, node->sequences);
+            if (r.hi > 0xDFFF) splitUtf8(0xE000, r.hi, node->sequences);
+        } else {
+            splitUtf8(r.lo, r.hi, node->sequences);
+        }
+    }
+    return node;
+}
+
+NodePtr makeByteLiteral(uint8_t byte) {
+    NodePtr node(new Node(Node::CLASS));
+    node->sequences.push_back(ByteSequence{ ByteRange{ byte, byte } });
+    return node;
+}
+
+void addPerlClass(char letter, std::vector<CodeRange>& ranges) {
+    std::vector<CodeRange> base;
+    switch (letter) {
+        case 'd': case 'D':
+            base.push_back({ '0', '9' });
+            break;
+        case 'w': case 'W':
+            base.push_back({ '0', '9' });
+            base.push_back({ 'A', 'Z' });
+            base.push_back({ '_', '_' });
+            base.push_back({ 'a', 'z' });
+            break;
+        default:
+            base.push_back({ '\t', '\r' });
+            base.push_back({ ' ', ' ' });
+            break;
+    }
+    if (letter == 'D' || letter == 'W' || letter == 'S') {
+        normalize(base);
+        base = negate(base);
+    }
+    ranges.insert(ranges.end(), base.begin(), base.end());
+}
+
+class Parser {
+public:
+    Parser(const std::string& pattern, bool foldCase)
+        : p_(pattern), pos_(0), anchors_(false), foldCase_(foldCase) {}
+
+    NodePtr parse() {
+        NodePtr node = parseAlternate();
+        if (pos_ < p_.size()) {
+            fail("多余的 ')'");
+        }
+        return node;
+    }
+
+    bool hasAnchors() const { return anchors_; }
+
+private:
+    [[noreturn]] void fail(const std::string& what) const {
+        throw EditorException(ErrorCode::INVALID_PATTERN,
+            "正则表达式错误（位置 " + std::to_string(pos_) + "）: " + what);
+    }
+
+    bool atEnd() const { return pos_ >= p_.size(); }
+
+    // 读取一个 UTF-8 码点；遇到非法序列时只读一个字节并返回 false
+    bool readCodePoint(uint32_t& cp) {
+        unsigned char c = static_cast<unsigned char>(p_[pos_]);
+        size_t len = c < 0x80 ? 1 : c >= 0xF8 ? 0 : c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 0;
+        if (len == 0 || pos_ + len > p_.size()) {
+            pos_++;
+            cp = c;
+            return false;
+        }
+        uint32_t value = len == 1 ? c : (c & (0xFF >> (len + 1)));
+        for (size_t i = 1; i < len; i++) {
+            unsigned char cc = static_cast<unsigned char>(p_[pos_ + i]);
+            if ((cc & 0xC0) != 0x80) {
+                pos_++;
+                cp = c;
+                return false;
+            }
+            value = (value << 6) | (cc & 0x3F);
+        }
+        pos_ += len;
+        cp = value;
+        return true;
+    }
+
+    uint32_t readClassMember() {
+        uint32_t cp;
+        readCodePoint(cp);
+        return cp;
+    }
+
+    NodePtr literal(uint32_t cp) {
+        if (foldCase_) {
+            std::vector<uint32_t> orbit;
+            caseOrbit(cp, orbit);
+            if (orbit.size() > 1) {
+                std::vector<CodeRange> ranges;
+                for (uint32_t member : orbit) {
+                    ranges.push_back(CodeRange{ member, member });
+                }
+                return makeClass(ranges);
+            }
+        }
+        if (cp < 0x80) {
+            return makeByteLiteral(static_cast<uint8_t>(cp));
+        }
+        uint8_t bytes[4];
+        size_t n = encodeUtf8(cp, bytes);
+        NodePtr node(new Node(Node::CONCAT));
+        for (size_t i = 0; i < n; i++) {
+            node->children.push_back(makeByteLiteral(bytes[i]));
+        }
+        return node;
+    }
+
+    NodePtr parseAlternate() {
+        NodePtr first = parseConcat();
+        if (atEnd() || p_[pos_] != '|') {
+            return first;
+        }
+        NodePtr node(new Node(Node::ALTERNATE));
+        node->children.push_back(std::move(first));
+        while (!atEnd() && p_[pos_] == '|') {
+            pos_++;
+            node->children.push_back(parseConcat());
+        }
+        return node;
+    }
+
+    NodePtr parseConcat() {
+        NodePtr node(new Node(Node::CONCAT));
+        while (!atEnd() && p_[pos_] != '|' && p_[pos_] != ')') {
+            node->children.push_back(parseRepeat());
+        }
+        if (node->children.empty()) {
+            return NodePtr(new Node(Node::EMPTY));
+        }
+        if (node->children.size() == 1) {
+            return std::move(node->children[0]);
+        }
+        return node;
+    }
+
+    bool readNumber(int& value) {
+        size_t start = pos_;
+        value = 0;
+        while (!atEnd() && p_[pos_] >= '0' && p_[pos_] <= '9') {
+            value = value * 10 + (p_[pos_] - '0');
+            if (value > MAX_REPEAT) {
+                fail("重复次数超过 " + std::to_string(MAX_REPEAT));
+            }
+            pos_++;
+        }
+        return pos_ > start;
+    }
+
+    // 解析 {m}、{m,}、{m,n}；不是合法的计数重复时回退，'{' 按字面处理
+    bool parseCount(int& min, int& max) {
+        size_t save = pos_;
+        pos_++;
+        if (!readNumber(min)) {
+            pos_ = save;
+            return false;
+        }
+        max = min;
+        if (!atEnd() && p_[pos_] == ',') {
+            pos_++;
+            if (!readNumber(max)) {
+                max = -1;
+            }
+        }
+        if (atEnd() || p_[pos_] != '}') {
+            pos_ = save;
+            return false;
+        }
+        pos_++;
+        if (max != -1 && max < min) {
+            fail("重复次数范围无效");
+        }
+        return true;
+    }
+
+    NodePtr parseRepeat() {
+        NodePtr atom = parseAtom();
+        while (!atEnd()) {
+            char c = p_[pos_];
+            int min;
+            int max;
+            if (c == '*') {
+                min = 0; max = -1; pos_++;
+            } else if (c == '+') {
+                min = 1; max = -1; pos_++;
+            } else if (c == '?') {
+                min = 0; max = 1; pos_++;
+            } else if (c == '{' && parseCount(min, max)) {
+            } else {
+                break;
+            }
+            // 非贪婪后缀不影响是否匹配，接受后忽略
+            if (!atEnd() && p_[pos_] == '?') {
+                pos_++;
+            }
+            NodePtr node(new Node(Node::REPEAT));
+            node->min = min;
+            node->max = max;
+            node->children.push_back(std::move(atom));
+            atom = std::move(node);
+        }
+        return atom;
+    }
+
+    NodePtr parseAtom() {
+        char c = p_[pos_];
+        switch (c) {
+            case '(': {
+                pos_++;
+                // 接受 (?: ...) 写法，本引擎不区分捕获组
+                if (p_.compare(pos_, 2, "?:") == 0) {
+                    pos_ += 2;
+                }
+                NodePtr inner = parseAlternate();
+                if (atEnd() || p_[pos_] != ')') {
+                    fail("缺少 ')'");
+                }
+                pos_++;
+                return inner;
+            }
+            case '[':
+                return parseClass();
+            case '.': {
+                pos_++;
+                // 按行匹配，'.' 匹配任意一个码点（包括换行）
+                return makeClass({ { 0, MAX_CODE_POINT } });
+            }
+            case '^':
+                pos_++;
+                anchors_ = true;
+                return NodePtr(new Node(Node::LINE_START));
+            case '$':
+                pos_++;
+                anchors_ = true;
+                return NodePtr(new Node(Node::LINE_END));
+            case '*': case '+': case '?':
+                fail("重复符号前没有可重复的内容");
+            case '\\':
+                return parseEscape();
+            default: {
+                uint32_t cp;
+                if (!readCodePoint(cp)) {
+                    // 模式里的非法 UTF-8 字节按原样匹配
+                    return makeByteLiteral(static_cast<uint8_t>(cp));
+                }
+                return literal(cp);
+            }
+        }
+    }
+
+    // 转义得到单个码点时返回 true；\d 等类别追加到 ranges 并返回 false
+    bool readEscape(uint32_t& cp, std::vector<CodeRange>& ranges) {
+        pos_++;
+        if (atEnd()) {
+            fail("末尾的 '\\'");
+        }
+        char c = p_[pos_];
+        switch (c) {
+            case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+                pos_++;
+                addPerlClass(c, ranges);
+                return false;
+            case 't': pos_++; cp = '\t'; return true;
+            case 'n': pos_++; cp = '\n'; return true;
+            case 'r': pos_++; cp = '\r'; return true;
+            case 'f': pos_++; cp = '\f'; return true;
+            case 'v': pos_++; cp = '\v'; return true;
+            case 'x': {
+                pos_++;
+                cp = 0;
+                for (int i = 0; i < 2; i++) {
+                    if (atEnd() || !std::isxdigit(static_cast<unsigned char>(p_[pos_]))) {
+                        fail("\\x 需要两位十六进制数");
+                    }
+                    char h = p_[pos_++];
+                    cp = cp * 16 + static_cast<uint32_t>(std::isdigit(static_cast<unsigned char>(h))
+                        ? h - '0' : (std::tolower(static_cast<unsigned char>(h)) - 'a' + 10));
+                }
+                return true;
+            }
+            default:
+                if (std::isalnum(static_cast<unsigned char>(c))) {
+                    fail(std::string("不支持的转义 \\") + c);
+                }
+                cp = readClassMember();
+                return true;
+        }
+    }
+
+    NodePtr parseEscape() {
+        uint32_t cp = 0;
+        std::vector<CodeRange> ranges;
+        if (readEscape(cp, ranges)) {
+            return literal(cp);
+        }
+        return makeClass(ranges);
+    }
+
+    NodePtr parseClass() {
+        pos_++;
+        bool negated = false;
+        if (!atEnd() && p_[pos_] == '^') {
+            negated = true;
+            pos_++;
+        }
+
+        std::vector<CodeRange> ranges;
+        bool first = true;
+        while (true) {
+            if (atEnd()) {
+                fail("缺少 ']'");
+            }
+            if (p_[pos_] == ']' && !first) {
+                pos_++;
+                break;
+            }
+            first = false;
+
+            uint32_t lo;
+            if (p_[pos_] == '\\') {
+                if (!readEscape(lo, ranges)) {
+                    continue;
+                }
+            } else {
+                lo = readClassMember();
+            }
+
+            uint32_t hi = lo;
+            if (pos_ + 1 < p_.size() && p_[pos_] == '-' && p_[pos_ + 1] != ']') {
+                pos_++;
+                if (p_[pos_] == '\\') {
+                    std::vector<CodeRange> unused;
+                    if (!readEscape(hi, unused)) {
+                        fail("字符类区间的端点不能是类别");
+                    }
+                } else {
+                    hi = readClassMember();
+                }
+                if (hi < lo) {
+                    fail("字符类区间无效");
+                }
+            }
+            ranges.push_back(CodeRange{ lo, hi });
+        }
+
+        if (foldCase_) {
+            addCaseVariants(ranges);
+        }
+        if (negated) {
+            normalize(ranges);
+            ranges = negate(ranges);
+        }
+        return makeClass(ranges);
+    }
+
+    // 不区分大小写：把与集合中码点大小写等价的码点都加入集合
+    void addCaseVariants(std::vector<CodeRange>& ranges) const {
+        normalize(ranges);
+        std::vector<CodeRange> extra;
+        std::vector<uint32_t> orbit;
+        size_t r = 0;
+        for (uint32_t cp : foldableCodePoints()) {
+            while (r < ranges.size() && ranges[r].hi < cp) {
+                r++;
+            }
+            if (r == ranges.size()) {
+                break;
+            }
+            if (ranges[r].lo <= cp) {
+                caseOrbit(cp, orbit);
+                for (uint32_t member : orbit) {
+                    extra.push_back(CodeRange{ member, member });
+                }
+            }
+        }
+        ranges.insert(ranges.end(), extra.begin(), extra.end());
+    }
+
+    const std::string& p_;
+    size_t pos_;
+    bool anchors_;
+    bool foldCase_;
+};
+
+// 字面量分析：exact 表示节点只能匹配这一个字符串，best 是任何匹配都必含的最长字面量
+struct LiteralInfo {
+    bool exact;
+    std::string text;
+    std::string best;
+};
+
+LiteralInfo analyzeLiteral(const Node& node) {
+    LiteralInfo info{ false, std::string(), std::string() };
+    switch (node.kind) {
+        case Node::EMPTY:
+        case Node::LINE_START:
+        case Node::LINE_END:
+            info.exact = true;
+            return info;
+
+        case Node::CLASS:
+            if (node.sequences.size() == 1) {
+                info.exact = true;
+                for (const ByteRange& r : node.sequences[0]) {
+                    if (r.lo != r.hi) {
+                        info.exact = false;
+                        info.text.clear();
+                        break;
+                    }
+                    info.text += static_cast<char>(r.lo);
+                }
+                info.best = info.text;
+            }
+            return info;
+
+        case Node::CONCAT: {
+            info.exact = true;
+            std::string run;
+            for (const NodePtr& child : node.children) {
+                LiteralInfo sub = analyzeLiteral(*child);
+                if (sub.best.size() > info.best.size()) {
+                    info.best = sub.best;
+                }
+                if (sub.exact) {
+                    run += sub.text;
+                    info.text += sub.text;
+                } else {
+                    info.exact = false;
+                    run.clear();
+                }
+                if (run.size() > info.best.size()) {
+                    info.best = run;
+                }
+            }
+            if (!info.exact) {
+                info.text.clear();
+            }
+            return info;
+        }
+
+        case Node::REPEAT: {
+            LiteralInfo sub = analyzeLiteral(*node.children[0]);
+            if (node.min >= 1) {
+                info.best = sub.best;
+            }
+            if (sub.exact && node.min == node.max && sub.text.size() * node.min <= 256) {
+                info.exact = true;
+                for (int i = 0; i < node.min; i++) {
+                    info.text += sub.text;
+                }
+                info.best = info.text;
+            }
+            return info;
+        }
+
+        case Node::ALTERNATE:
+        default:
+            return info;
+    }
+}
+
+
+// Thompson 构造：每个片段有一个入口和一组待回填的出口
+struct Instruction {
+    enum Op : uint8_t { RANGE, EPSILON, SPLIT, MATCH, LINE_START, LINE_END };
+    Op op;
+    uint8_t lo;
+    uint8_t hi;
+    int out;
+    int out1;
+};
+
+struct Fragment {
+    int start;
+    std::vector<std::pair<int, int>> exits;     // (状态, 0 = out / 1 = out1)
+};
+
+class Compiler {
+public:
+    std::vector<Instruction> compile(const Node& root) {
+        Fragment body = build(root);
+        int match = emit(Instruction::MATCH);
+        patch(body, match);
+        start_ = body.start;
+        return std::move(program_);
+    }
+
+    int start() const { return start_; }
+
+private:
+    int emit(Instruction::Op op, uint8_t lo = 0, uint8_t hi = 0) {
+        if (program_.size() >= MAX_NFA_STATES) {
+            throw EditorException(ErrorCode::INVALID_PATTERN,
+                "正则表达式错误: 模式过于复杂（超过 " + std::to_string(MAX_NFA_STATES) + " 个状态）");
+        }
+        program_.push_back(Instruction{ op, lo, hi, -1, -1 });
+        return static_cast<int>(program_.size() - 1);
+    }
+
+    void patch(const Fragment& frag, int target) {
+        for (const auto& exit : frag.exits) {
+            if (exit.second == 0) {
+                program_[exit.first].out = target;
+            } else {
+                program_[exit.first].out1 = target;
+            }
+        }
+    }
+
+    Fragment single(Instruction::Op op, uint8_t lo = 0, uint8_t hi = 0) {
+        int s = emit(op, lo, hi);
+        return Fragment{ s, { { s, 0 } } };
+    }
+
+    Fragment alternate(std::vector<Fragment>& branches) {
+        Fragment result = branches.back();
+        for (size_t i = branches.size() - 1; i-- > 0;) {
+            int split = emit(Instruction::SPLIT);
+            program_[split].out = branches[i].start;
+            program_[split].out1 = result.start;
+            result.start = split;
+            result.exits.insert(result.exits.end(), branches[i].exits.begin(), branches[i].exits.end());
+        }
+        return result;
+    }
+
+    Fragment concat(Fragment first, const Fragment& second) {
+        patch(first, second.start);
+        first.exits = second.exits;
+        return first;
+    }
+
+    Fragment build(const Node& node) {
+        switch (node.kind) {
+            case Node::EMPTY:
+                return single(Instruction::EPSILON);
+            case Node::LINE_START:
+                return single(Instruction::LINE_START);
+            case Node::LINE_END:
+                return single(Instruction::LINE_END);
+
+            case Node::CLASS: {
+                if (node.sequences.empty()) {
+                    // 空字符类永远不匹配：lo > hi 的区间
+                    return single(Instruction::RANGE, 1, 0);
+                }
+                std::vector<Fragment> branches;
+                for (const ByteSequence& seq : node.sequences) {
+                    Fragment frag = single(Instruction::RANGE, seq[0].lo, seq[0].hi);
+                    for (size_t i = 1; i < seq.size(); i++) {
+                        frag = concat(frag, single(Instruction::RANGE, seq[i].lo, seq[i].hi));
+                    }
+                    branches.push_back(frag);
+                }
+                return alternate(branches);
+            }
+
+            case Node::CONCAT: {
+                Fragment result = build(*node.children[0]);
+                for (size_t i = 1; i < node.children.size(); i++) {
+                    result = concat(result, build(*node.children[i]));
+                }
+                return result;
+            }
+
+            case Node::ALTERNATE: {
+                std::vector<Fragment> branches;
+                for (const NodePtr& child : node.children) {
+                    branches.push_back(build(*child));
+                }
+                return alternate(branches);
+            }
+
+            case Node::REPEAT:
+            default:
+                return repeat(*node.children[0], node.min, node.max);
+        }
+    }
+
+    // x{m,n} 展开为 m 个 x 后接 n-m 个可选的 x；无上限时最后接 x*
+    Fragment repeat(const Node& child, int min, int max) {
+        bool haveResult = false;
+        Fragment result{ -1, {} };
+        auto append = [&](Fragment frag) {
+            result = haveResult ? concat(result, frag) : frag;
+            haveResult = true;
+        };
+
+        for (int i = 0; i < min; i++) {
+            append(build(child));
+        }
+
+        if (max == -1) {
+            Fragment body = build(child);
+            int split = emit(Instruction::SPLIT);
+            program_[split].out = body.start;
+            patch(body, split);
+            append(Fragment{ split, { { split, 1 } } });
+        } else {
+            // 嵌套的可选项 (x(x(x)?)?)? 保持状态数线性
+            std::vector<int> splits;
+            for (int i = min; i < max; i++) {
+                int split = emit(Instruction::SPLIT);
+                Fragment body = build(child);
+                program_[split].out = body.start;
+                splits.push_back(split);
+                append(Fragment{ split, body.exits });
+            }
+            for (int split : splits) {
+                result.exits.push_back({ split, 1 });
+            }
+        }
+
+        if (!haveResult) {
+            return single(Instruction::EPSILON);
+        }
+        return result;
+    }
+
+    std::vector<Instruction> program_;
+    int start_ = -1;
+};
+
+// 闭包标记使用代数计数，避免每次清零整个数组
+void nextGeneration(std::vector<uint32_t>& mark, uint32_t& generation) {
+    if (++generation == 0) {
+        std::fill(mark.begin(), mark.end(), 0);
+        generation = 1;
+    }
+}
+
+} // anonymous namespace
+
+Regex::Regex(const std::string& pattern, bool ignoreCase, size_t cacheBytes)
+    : pattern_(pattern), ignoreCase_(ignoreCase), nfaStart_(0), literalOnly_(false), classCount_(0),
+      cacheBudget_(cacheBytes), dfaBytes_(0), cacheResets_(0), markGeneration_(0) {
+    Parser parser(pattern_, ignoreCase_);
+    NodePtr root = parser.parse();
+
+    Compiler compiler;
+    std::vector<Instruction> program = compiler.compile(*root);
+    nfaStart_ = compiler.start();
+    nfa_.reserve(program.size());
+    for (const Instruction& inst : program) {
+        nfa_.push_back(NfaState{ static_cast<NfaState::Op>(inst.op), inst.lo, inst.hi, inst.out, inst.out1 });
+    }
+    mark_.assign(nfa_.size(), 0);
+
+    // 不区分大小写时字面量改由折叠查找器预过滤，分析要在未折叠的语法树上做
+    NodePtr literalRoot;
+    if (ignoreCase_) {
+        literalRoot = Parser(pattern_, false).parse();
+    }
+    LiteralInfo info = analyzeLiteral(ignoreCase_ ? *literalRoot : *root);
+    literal_ = info.exact ? info.text : info.best;
+    literalOnly_ = info.exact && !parser.hasAnchors();
+    if (!literal_.empty()) {
+        prefilter_.reset(new Searcher(literal_, ignoreCase_));
+    }
+
+    // 按所有字节区间的边界划分等价类
+    bool boundary[257] = {};
+    for (const NfaState& state : nfa_) {
+        if (state.op == NfaState::RANGE && state.lo <= state.hi) {
+            boundary[state.lo] = true;
+            boundary[state.hi + 1] = true;
+        }
+    }
+    int cls = 0;
+    for (int b = 0; b < 256; b++) {
+        if (b > 0 && boundary[b]) {
+            cls++;
+        }
+        byteClass_[b] = static_cast<uint8_t>(cls);
+    }
+    classCount_ = cls + 1;
+
+    startStates_[0] = startStates_[1] = -1;
+}
+
+Regex::~Regex() = default;
+
+void Regex::addClosure(std::vector<int>& out, int state, bool atStart, bool atEnd) const {
+    std::vector<int> stack(1, state);
+    while (!stack.empty()) {
+        int s = stack.back();
+        stack.pop_back();
+        if (s < 0 || mark_[s] == markGeneration_) {
+            continue;
+        }
+        mark_[s] = markGeneration_;
+
+        const NfaState& st = nfa_[s];
+        switch (st.op) {
+            case NfaState::EPSILON:
+                stack.push_back(st.out);
+                break;
+            case NfaState::SPLIT:
+                stack.push_back(st.out1);
+                stack.push_back(st.out);
+                break;
+            case NfaState::LINE_START:
+                if (atStart) {
+                    stack.push_back(st.out);
+                }
+                break;
+            case NfaState::LINE_END:
+                // 是否到达行尾要等输入结束才知道，先留在集合里
+                if (atEnd) {
+                    stack.push_back(st.out);
+                } else {
+                    out.push_back(s);
+                }
+                break;
+            default:
+                out.push_back(s);
+                break;
+        }
+    }
+}
+
+void Regex::resetCache() const {
+    dfaStates_.clear();
+    dfaIndex_.clear();
+    dfaBytes_ = 0;
+    startStates_[0] = startStates_[1] = -1;
+    cacheResets_++;
+}
+
+int Regex::intern(std::vector<int>& nfaStates) const {
+    std::sort(nfaStates.begin(), nfaStates.end());
+    std::string key(reinterpret_cast<const char*>(nfaStates.data()), nfaStates.size() * sizeof(int));
+    auto it = dfaIndex_.find(key);
+    if (it != dfaIndex_.end()) {
+        return it->second;
+    }
+
+    size_t cost = sizeof(DfaState) + key.size() * 2 + classCount_ * sizeof(int) + 64;
+    if (dfaBytes_ + cost > cacheBudget_ && !dfaStates_.empty()) {
+        resetCache();
+    }
+    dfaBytes_ += cost;
+
+    bool match = false;
+    for (int s : nfaStates) {
+        if (nfa_[s].op == NfaState::MATCH) {
+            match = true;
+            break;
+        }
+    }
+    dfaStates_.push_back(DfaState{ nfaStates, std::vector<int>(classCount_, -1), match,
+                                  nfaStates.empty(), { -1, -1 } });
+    int index = static_cast<int>(dfaStates_.size() - 1);
+    dfaIndex_.emplace(std::move(key), index);
+    return index;
+}
+
+int Regex::startState(bool atStart) const {
+    int& cached = startStates_[atStart ? 1 : 0];
+    if (cached < 0) {
+        nextGeneration(mark_, markGeneration_);
+        std::vector<int> set;
+        addClosure(set, nfaStart_, atStart, false);
+        cached = intern(set);
+    }
+    return cached;
+}
+
+int Regex::step(int state, unsigned char byte) const {
+    int cls = byteClass_[byte];
+    int cached = dfaStates_[state].next[cls];
+    if (cached >= 0) {
+        return cached;
+    }
+
+    nextGeneration(mark_, markGeneration_);
+    std::vector<int> set;
+    for (int s : dfaStates_[state].nfa) {
+        const NfaState& st = nfa_[s];
+        if (st.op == NfaState::RANGE && st.lo <= byte && byte <= st.hi) {
+            addClosure(set, st.out, false, false);
+        }
+    }
+    // 非锚定查找：每个位置都可以开始新的匹配
+    addClosure(set, nfaStart_, false, false);
+
+    size_t resets = cacheResets_;
+    int next = intern(set);
+    if (resets == cacheResets_) {
+        dfaStates_[state].next[cls] = next;
+    }
+    return next;
+}
+
+bool Regex::matchesAtEnd(int state, bool atStart) const {
+    int8_t& cached = dfaStates_[state].matchAtEnd[atStart ? 1 : 0];
+    if (cached >= 0) {
+        return cached != 0;
+    }
+
+    bool match = dfaStates_[state].match;
+    if (!match) {
+        nextGeneration(mark_, markGeneration_);
+        std::vector<int> set;
+        for (int s : dfaStates_[state].nfa) {
+            if (nfa_[s].op == NfaState::LINE_END) {
+                addClosure(set, nfa_[s].out, atStart, true);
+            }
+        }
+        for (int s : set) {
+            if (nfa_[s].op == NfaState::MATCH) {
+                match = true;
+                break;
+            }
+        }
+    }
+    dfaStates_[state].matchAtEnd[atStart ? 1 : 0] = match ? 1 : 0;
+    return match;
+}
+
+bool Regex::search(const char* data, size_t size) const {
+    if (literalOnly_) {
+        return !prefilter_ || prefilter_->find(data, size) != SEARCH_NOT_FOUND;
+    }
+    if (prefilter_ && prefilter_->find(data, size) == SEARCH_NOT_FOUND) {
+        return false;
+    }
+
+    int state = startState(true);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        const DfaState& current = dfaStates_[state];
+        if (current.match || current.dead) {
+            return current.match;
+        }
+        int next = current.next[byteClass_[p[i]]];
+        state = next >= 0 ? next : step(state, p[i]);
+    }
+    return dfaStates_[state].match || matchesAtEnd(state, size == 0);
+}
+
+bool Regex::search(const LineBlock* head, bool asciiText) const {
+    if (literalOnly_) {
+        return !prefilter_ || prefilter_->matches(head, asciiText);
+    }
+    if (prefilter_ && !prefilter_->matches(head, asciiText)) {
+        return false;
+    }
+
+    int state = startState(true);
+    bool empty = true;
+    for (const LineBlock* block = head; block; block = block->next()) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(block->data());
+        size_t used = block->used();
+        for (size_t i = 0; i < used; i++) {
+            const DfaState& current = dfaStates_[state];
+            if (current.match || current.dead) {
+                return current.match;
+            }
+            int next = current.next[byteClass_[p[i]]];
+            state = next >= 0 ? next : step(state, p[i]);
+        }
+        empty = empty && used == 0;
+    }
+    return dfaStates_[state].match || matchesAtEnd(state, empty);
+}
+
+bool Regex::find(const char* data, size_t size, size_t from, size_t& start, size_t& end) const {
+    if (from > size) {
+        return false;
+    }
+    // 折叠后匹配长度可能与字面量不同，不区分大小写时交给 NFA 计算范围
+    if (literalOnly_ && !ignoreCase_) {
+        size_t pos = prefilter_ ? prefilter_->find(data + from, size - from) : 0;
+        if (pos == SEARCH_NOT_FOUND) {
+            return false;
+        }
+        start = from + pos;
+        end = start + literal_.size();
+        return true;
+    }
+    if (prefilter_ && prefilter_->find(data + from, size - from) == SEARCH_NOT_FOUND) {
+        return false;
+    }
+
+    // Pike VM：线程按起点升序排列，同一状态只保留起点最早的线程
+    std::vector<PikeThread>& current = pikeCurrent_;
+    std::vector<PikeThread>& next = pikeNext_;
+    std::vector<int>& closure = pikeClosure_;
+    current.clear();
+
+    auto addThreads = [&](std::vector<PikeThread>& list, int state, size_t origin, size_t pos) {
+        closure.clear();
+        addClosure(closure, state, pos == 0, pos == size);
+        for (int s : closure) {
+            if (nfa_[s].op != NfaState::LINE_END) {
+                list.push_back(PikeThread{ s, origin });
+            }
+        }
+    };
+
+    bool found = false;
+    size_t bestStart = 0;
+    size_t bestEnd = 0;
+
+    nextGeneration(mark_, markGeneration_);
+    addThreads(current, nfaStart_, from, from);
+
+    for (size_t pos = from;; pos++) {
+        for (const PikeThread& t : current) {
+            if (found && t.start > bestStart) {
+                break;
+            }
+            if (nfa_[t.state].op == NfaState::MATCH &&
+                (!found || t.start < bestStart || (t.start == bestStart && pos > bestEnd))) {
+                found = true;
+                bestStart = t.start;
+                bestEnd = pos;
+            }
+        }
+        if (pos == size) {
+            break;
+        }
+
+        nextGeneration(mark_, markGeneration_);
+        next.clear();
+        unsigned char byte = static_cast<unsigned char>(data[pos]);
+        for (const PikeThread& t : current) {
+            if (found && t.start > bestStart) {
+                break;
+            }
+            const NfaState& st = nfa_[t.state];
+            if (st.op == NfaState::RANGE && st.lo <= byte && byte <= st.hi) {
+                addThreads(next, st.out, t.start, pos + 1);
+            }
+        }
+        if (!found) {
+            addThreads(next, nfaStart_, pos + 1, pos + 1);
+        }
+        current.swap(next);
+        if (current.empty() && found) {
+            break;
+        }
+    }
+
+    if (found) {
+        start = bestStart;
+        end = bestEnd;
+    }
+    return found;
+}
+
+size_t Regex::findAll(const LineBlock* head, LineNo lineNo, std::vector<MatchPosition>& out,
+                      bool asciiText) const {
+    if (!search(head, asciiText)) {
+        return 0;
+    }
+
+    const char* data = head ? head->data() : "";
+    size_t size = head ? head->used() : 0;
+    if (head && head->next()) {
+        scratch_.clear();
+        for (const LineBlock* block = head; block; block = block->next()) {
+            scratch_.append(block->data(), block->used());
+        }
+        data = scratch_.data();
+        size = scratch_.size();
+    }
+
+    size_t count = 0;
+    size_t from = 0;
+    size_t start = 0;
+    size_t end = 0;
+    while (find(data, size, from, start, end)) {
+        if (end > start) {
+            out.push_back(MatchPosition{ lineNo, start, end - start });
+            count++;
+            from = end;
+        } else {
+            // 空匹配：跳过一个完整的码点后继续
+            from = start + 1;
+            while (from < size && (static_cast<unsigned char>(data[from]) & 0xC0) == 0x80) {
+                from++;
+            }
+        }
+        if (from > size) {
+            break;
+        }
+    }
+    return count;
+}
+
+RegexCache::RegexCache(size_t capacity)
+    : capacity_(capacity == 0 ? 1 : capacity), hits_(0), misses_(0) {
+}
+
+std::shared_ptr<Regex> RegexCache::get(const std::string& pattern, bool ignoreCase) {
+    std::string key = (ignoreCase ? "i/" : "/") + pattern;
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        hits_++;
+        return it->second->second;
+    }
+
+    misses_++;
+    std::shared_ptr<Regex> regex = std::make_shared<Regex>(pattern, ignoreCase);
+    entries_.emplace_front(key, regex);
+    index_[key] = entries_.begin();
+    if (entries_.size() > capacity_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+    return regex;
+}
+
+} // namespace line_editor
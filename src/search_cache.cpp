@@ -0,0 +1,156 @@
+#include "search_cache.h"
+#include <algorithm>
+#include <numeric>
+
+namespace line_editor {
+
+namespace {
+
+// 插入 count 行后，row 及其之后的行下移
+void shiftForInsert(std::vector<int>& rows, int row, int count) {
+    for (int& r : rows) {
+        if (r >= row) {
+            r += count;
+        }
+    }
+}
+
+// 删除 [row, row + count) 后，其中的行被丢弃，之后的行上移
+void shiftForErase(std::vector<int>& rows, int row, int count) {
+    rows.erase(std::remove_if(rows.begin(), rows.end(),
+                              [&](int r) { return r >= row && r < row + count; }),
+               rows.end());
+    for (int& r : rows) {
+        if (r >= row + count) {
+            r -= count;
+        }
+    }
+}
+
+} // anonymous namespace
+
+SearchCache::SearchCache(size_t capacity, size_t maxJournal)
+    : capacity_(capacity == 0 ? 1 : capacity), maxJournal_(maxJournal == 0 ? 1 : maxJournal),
+      journalBase_(0), hits_(0), misses_(0), rescanned_(0) {
+}
+
+void SearchCache::noteInsert(int row, int count) {
+    if (count > 0) {
+        record(Edit::INSERT, row, count);
+    }
+}
+
+void SearchCache::noteErase(int row, int count) {
+    if (count > 0) {
+        record(Edit::ERASE, row, count);
+    }
+}
+
+void SearchCache::noteChange(int row) {
+    record(Edit::CHANGE, row, 1);
+}
+
+void SearchCache::invalidate() {
+    entries_.clear();
+    index_.clear();
+    journalBase_ += journal_.size();
+    journal_.clear();
+}
+
+void SearchCache::record(Edit::Kind kind, int row, int count) {
+    if (entries_.empty()) {
+        return;
+    }
+    journal_.push_back(Edit{ kind, row, count });
+    if (journal_.size() <= maxJournal_) {
+        return;
+    }
+
+    // 日志过长：丢弃落后最多的条目，它们下次查找时重新全量扫描
+    size_t keepFrom = journalBase_ + journal_.size() - maxJournal_ / 2;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->synced < keepFrom) {
+            index_.erase(it->key);
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    trimJournal();
+}
+
+void SearchCache::trimJournal() {
+    size_t end = journalBase_ + journal_.size();
+    size_t oldest = end;
+    for (const Entry& entry : entries_) {
+        oldest = std::min(oldest, entry.synced);
+    }
+    journal_.erase(journal_.begin(), journal_.begin() + static_cast<std::ptrdiff_t>(oldest - journalBase_));
+    journalBase_ = oldest;
+}
+
+SearchCache::Entry& SearchCache::refresh(const std::string& key, int rowCount, std::vector<int>& dirty) {
+    size_t end = journalBase_ + journal_.size();
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        misses_++;
+        entries_.push_front(Entry{ key, std::vector<int>(), end });
+        index_[key] = entries_.begin();
+        if (entries_.size() > capacity_) {
+            index_.erase(entries_.back().key);
+            entries_.pop_back();
+            trimJournal();
+        }
+        dirty.resize(static_cast<size_t>(std::max(rowCount, 0)));
+        std::iota(dirty.begin(), dirty.end(), 0);
+        return entries_.front();
+    }
+
+    hits_++;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    Entry& entry = entries_.front();
+    for (size_t i = entry.synced - journalBase_; i < journal_.size(); i++) {
+        const Edit& edit = journal_[i];
+        switch (edit.kind) {
+            case Edit::INSERT:
+                shiftForInsert(entry.rows, edit.row, edit.count);
+                shiftForInsert(dirty, edit.row, edit.count);
+                for (int r = edit.row; r < edit.row + edit.count; r++) {
+                    dirty.push_back(r);
+                }
+                break;
+            case Edit::ERASE:
+                shiftForErase(entry.rows, edit.row, edit.count);
+                shiftForErase(dirty, edit.row, edit.count);
+                break;
+            case Edit::CHANGE:
+                dirty.push_back(edit.row);
+                break;
+        }
+    }
+    entry.synced = end;
+    trimJournal();
+
+    // 需要重新检查的行先从旧结果中去掉，检查后再合并回来
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    if (!dirty.empty()) {
+        entry.rows.erase(std::remove_if(entry.rows.begin(), entry.rows.end(),
+                                        [&](int r) { return std::binary_search(dirty.begin(), dirty.end(), r); }),
+                         entry.rows.end());
+    }
+    rescanned_ += dirty.size();
+    return entry;
+}
+
+void SearchCache::merge(Entry& entry, const std::vector<int>& matched) {
+    if (matched.empty()) {
+        return;
+    }
+    size_t middle = entry.rows.size();
+    entry.rows.insert(entry.rows.end(), matched.begin(), matched.end());
+    std::inplace_merge(entry.rows.begin(), entry.rows.begin() + static_cast<std::ptrdiff_t>(middle),
+                       entry.rows.end());
+}
+
+} // namespace line_editor
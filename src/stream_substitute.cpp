@@ -0,0 +1,153 @@
+#include "stream_substitute.h"
+#include "error.h"
+#include "file_manager.h"
+#include "ordered_pipeline.h"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+namespace line_editor {
+
+StreamSubstituter::StreamSubstituter(const std::string& oldStr, const std::string& newStr,
+                                     const SubstituteOptions& options)
+    : searcher_(oldStr), newStr_(newStr), options_(options) {
+    if (oldStr.empty()) {
+        throw EditorException(ErrorCode::MISSING_PARAMETER, "替换需要非空的旧字符串");
+    }
+    // 替换按行进行，块也只在换行处切开，跨行的模式无法匹配
+    if (oldStr.find('\n') != std::string::npos) {
+        throw EditorException(ErrorCode::INVALID_FORMAT, "旧字符串不能包含换行");
+    }
+    if (options_.chunkBytes == 0) {
+        options_.chunkBytes = SubstituteOptions::DEFAULT_CHUNK_BYTES;
+    }
+    if (options_.threads == 0) {
+        options_.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options_.maxInFlight == 0) {
+        options_.maxInFlight = 2 * static_cast<size_t>(options_.threads);
+    }
+}
+
+size_t StreamSubstituter::substituteLines(const char* data, size_t size, std::string& out) const {
+    size_t oldLen = searcher_.pattern().size();
+    size_t count = 0;
+    size_t from = 0;
+    while (from < size) {
+        size_t pos = searcher_.find(data + from, size - from);
+        if (pos == SEARCH_NOT_FOUND) {
+            break;
+        }
+        pos += from;
+        out.append(data + from, pos - from);
+        out += newStr_;
+        count++;
+        from = pos + oldLen;
+        if (!options_.global) {
+            // 只替换每行第一处：本行其余部分原样复制，从下一行继续查找
+            const void* newline = std::memchr(data + from, '\n', size - from);
+            size_t next = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) + 1 : size;
+            out.append(data + from, next - from);
+            from = next;
+        }
+    }
+    out.append(data + from, size - from);
+    return count;
+}
+
+namespace {
+
+struct Done {
+    std::string output;
+    size_t substitutions = 0;
+};
+
+} // anonymous namespace
+
+template <typename Read, typename Write>
+SubstituteStats StreamSubstituter::pump(Read read, Write write) const {
+    SubstituteStats stats;
+    std::string carry;
+    bool eof = false;
+
+    // 块在最后一个换行处切开，剩下的半行留到下一块重新拼接
+    auto nextChunk = [&](std::string& chunk) {
+        while (!eof) {
+            // 比一块还长的行要跨越多次读入：缓冲按倍数扩大，累计复制与行长成线性
+            size_t old = carry.size();
+            if (carry.capacity() < old + options_.chunkBytes) {
+                carry.reserve(std::max(old + options_.chunkBytes, 2 * carry.capacity()));
+            }
+            carry.resize(old + options_.chunkBytes);
+            size_t n = read(&carry[old], options_.chunkBytes);
+            carry.resize(old + n);
+            stats.bytesRead += n;
+            eof = n == 0;
+
+            if (!eof) {
+                // 之前留下的半行里没有换行，只需查找新读入的字节
+                size_t cut = std::string_view(carry.data() + old, n).rfind('\n');
+                if (cut == std::string_view::npos) {
+                    continue;
+                }
+                chunk = std::move(carry);
+                carry = std::string();
+                carry.assign(chunk, old + cut + 1, std::string::npos);
+                chunk.resize(old + cut + 1);
+            } else if (carry.empty()) {
+                return false;
+            } else {
+                chunk = std::move(carry);
+                carry = std::string();
+            }
+            stats.chunks++;
+            return true;
+        }
+        return false;
+    };
+
+    runOrderedPipeline<std::string>(options_.threads, options_.maxInFlight, nextChunk,
+        [this]() {
+            return [this](const std::string& chunk) {
+                Done result;
+                result.output.reserve(chunk.size());
+                result.substitutions = substituteLines(chunk.data(), chunk.size(), result.output);
+                return result;
+            };
+        },
+        [&](const Done& result) {
+            write(result.output.data(), result.output.size());
+            stats.bytesWritten += result.output.size();
+            stats.substitutions += result.substitutions;
+            return true;
+        });
+    return stats;
+}
+
+SubstituteStats StreamSubstituter::run(FileManager& fileMgr) const {
+    try {
+        return pump(
+            [&](char* data, size_t size) { return fileMgr.readRaw(data, size); },
+            [&](const char* data, size_t size) { fileMgr.writeRaw(data, size); });
+    } catch (...) {
+        fileMgr.abandon();
+        throw;
+    }
+}
+
+SubstituteStats StreamSubstituter::run(std::istream& in, std::ostream& out) const {
+    return pump(
+        [&](char* data, size_t size) {
+            in.read(data, static_cast<std::streamsize>(size));
+            return static_cast<size_t>(in.gcount());
+        },
+        [&](const char* data, size_t size) {
+            out.write(data, static_cast<std::streamsize>(size));
+            if (!out) {
+                throw EditorException(ErrorCode::FILE_WRITE_FAILED, "Failed to write to output stream");
+            }
+        });
+}
+
+} // namespace line_editor
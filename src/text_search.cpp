@@ -0,0 +1,472 @@
+#include "text_search.h"
+#include "case_fold.h"
+#include "encoding_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LINE_EDITOR_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace line_editor {
+
+namespace {
+
+#ifdef LINE_EDITOR_HAVE_SSE2
+inline unsigned lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+inline unsigned char foldAscii(unsigned char c) {
+    return static_cast<unsigned>(c - 'A') < 26u ? static_cast<unsigned char>(c | 0x20) : c;
+}
+
+#ifdef LINE_EDITOR_HAVE_SSE2
+// Fold 为 true 时把 16 个字节中的 A-Z 转为小写：加偏移后 A-Z 落在有符号比较的最小区间
+template <bool Fold>
+inline __m128i loadBytes(const char* p) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    if (Fold) {
+        __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - 'A')));
+        __m128i upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(-128 + 26)));
+        v = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    }
+    return v;
+}
+#endif
+
+// 比较 needle 的 [1, needleLen - 1) 字节
+template <bool Fold>
+inline bool middleMatches(const char* data, const char* needle, size_t needleLen) {
+    if (needleLen <= 2) {
+        return true;
+    }
+    if (!Fold) {
+        return std::memcmp(data + 1, needle + 1, needleLen - 2) == 0;
+    }
+    size_t i = 1;
+#ifdef LINE_EDITOR_HAVE_SSE2
+    // 长模式逐 16 字节折叠后比较
+    for (; i + 16 < needleLen; i += 16) {
+        __m128i eq = _mm_cmpeq_epi8(loadBytes<true>(data + i),
+                                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(needle + i)));
+        if (_mm_movemask_epi8(eq) != 0xFFFF) {
+            return false;
+        }
+    }
+#endif
+    for (; i + 1 < needleLen; i++) {
+        if (foldAscii(static_cast<unsigned char>(data[i])) != static_cast<unsigned char>(needle[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <bool Fold>
+inline bool byteMatches(char c, char needleByte) {
+    return Fold ? foldAscii(static_cast<unsigned char>(c)) == static_cast<unsigned char>(needleByte)
+                : c == needleByte;
+}
+
+// 在起点 [0, limit) 中查找首尾字节都命中且中间字节比较通过的位置，
+// 调用方保证 limit + needleLen - 1 <= 可读长度。Fold 时 needle 须为小写
+template <bool Fold>
+size_t scanCandidates(const char* data, size_t limit, const char* needle, size_t needleLen) {
+    const size_t last = needleLen - 1;
+    size_t i = 0;
+
+#ifdef LINE_EDITOR_HAVE_SSE2
+    if (limit >= 16) {
+        // 首尾字节同时命中的位置才需要 memcmp，误报率远低于只看首字节
+        const __m128i first = _mm_set1_epi8(needle[0]);
+        const __m128i tail = _mm_set1_epi8(needle[last]);
+
+        // 长缓冲一次过滤 64 个起点，四组结果或在一起，没有候选时直接跳过
+        while (i + 64 <= limit) {
+            const char* p = data + i;
+            __m128i m0 = _mm_and_si128(_mm_cmpeq_epi8(loadBytes<Fold>(p), first),
+                                       _mm_cmpeq_epi8(loadBytes<Fold>(p + last), tail));
+            __m128i m1 = _mm_and_si128(_mm_cmpeq_epi8(loadBytes<Fold>(p + 16), first),
+                                       _mm_cmpeq_epi8(loadBytes<Fold>(p + 16 + last), tail));
+            __m128i m2 = _mm_and_si128(_mm_cmpeq_epi8(loadBytes<Fold>(p + 32), first),
+                                       _mm_cmpeq_epi8(loadBytes<Fold>(p + 32 + last), tail));
+            __m128i m3 = _mm_and_si128(_mm_cmpeq_epi8(loadBytes<Fold>(p + 48), first),
+                                       _mm_cmpeq_epi8(loadBytes<Fold>(p + 48 + last), tail));
+            __m128i any = _mm_or_si128(_mm_or_si128(m0, m1), _mm_or_si128(m2, m3));
+            if (_mm_movemask_epi8(any) != 0) {
+                break;
+            }
+            i += 64;
+        }
+
+        while (true) {
+            // 最后一步与前一步重叠，避免标量收尾
+            size_t at = i + 16 <= limit ? i : limit - 16;
+            __m128i a = loadBytes<Fold>(data + at);
+            __m128i b = loadBytes<Fold>(data + at + last);
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, tail))));
+            mask &= ~0u << (i - at);
+            while (mask != 0) {
+                unsigned bit = lowestBit(mask);
+                if (middleMatches<Fold>(data + at + bit, needle, needleLen)) {
+                    return at + bit;
+                }
+                mask &= mask - 1;
+            }
+            if (at + 16 >= limit) {
+                return SEARCH_NOT_FOUND;
+            }
+            i = at + 16;
+        }
+    }
+#endif
+
+    for (; i < limit; ++i) {
+        if (byteMatches<Fold>(data[i], needle[0]) && byteMatches<Fold>(data[i + last], needle[last]) &&
+            middleMatches<Fold>(data + i, needle, needleLen)) {
+            return i;
+        }
+    }
+    return SEARCH_NOT_FOUND;
+}
+
+// 从 block 的 offset 处开始，跨块比较 needle 的全部字节
+template <bool Fold>
+bool matchesAcross(const LineBlock* block, size_t offset, const char* needle, size_t needleLen) {
+    size_t matched = 0;
+    while (block && matched < needleLen) {
+        size_t avail = block->used() - offset;
+        size_t take = needleLen - matched < avail ? needleLen - matched : avail;
+        const char* data = block->data() + offset;
+        if (!Fold) {
+            if (std::memcmp(data, needle + matched, take) != 0) {
+                return false;
+            }
+        } else {
+            for (size_t i = 0; i < take; i++) {
+                if (!byteMatches<true>(data[i], needle[matched + i])) {
+                    return false;
+                }
+            }
+        }
+        matched += take;
+        block = block->next();
+        offset = 0;
+    }
+    return matched == needleLen;
+}
+
+// 在 [start, end) 中找下一个可能的首字节；Fold 时字母的大小写两种形式都算
+template <bool Fold>
+size_t nextFirstByte(const char* data, size_t start, size_t end, char first) {
+    const void* hit = std::memchr(data + start, first, end - start);
+    size_t pos = hit ? static_cast<size_t>(static_cast<const char*>(hit) - data) : SEARCH_NOT_FOUND;
+    if (Fold && static_cast<unsigned>(first - 'a') < 26u) {
+        size_t limit = pos == SEARCH_NOT_FOUND ? end : pos;
+        const void* upper = std::memchr(data + start, first - 0x20, limit - start);
+        if (upper) {
+            pos = static_cast<size_t>(static_cast<const char*>(upper) - data);
+        }
+    }
+    return pos;
+}
+
+// 块链查找的骨架：inBlock 负责完全落在单个块内的匹配，
+// 起点在块尾、终点在后续块中的候选用 memchr 找首字节后跨块核对
+template <bool Fold, typename InBlockFind>
+size_t scanBlocks(const LineBlock* head, const char* needle, size_t needleLen, InBlockFind inBlock) {
+    if (needleLen == 0) {
+        return 0;
+    }
+
+    size_t base = 0;
+    for (const LineBlock* block = head; block; block = block->next()) {
+        const char* data = block->data();
+        size_t used = block->used();
+
+        // 完全落在本块内的匹配总是早于从本块尾部起跨界的匹配
+        size_t pos = inBlock(data, used);
+        if (pos != SEARCH_NOT_FOUND) {
+            return base + pos;
+        }
+
+        if (block->next()) {
+            size_t start = used >= needleLen ? used - needleLen + 1 : 0;
+            while (start < used) {
+                size_t offset = nextFirstByte<Fold>(data, start, used, needle[0]);
+                if (offset == SEARCH_NOT_FOUND) {
+                    break;
+                }
+                if (matchesAcross<Fold>(block, offset, needle, needleLen)) {
+                    return base + offset;
+                }
+                start = offset + 1;
+            }
+        }
+
+        base += used;
+    }
+    return SEARCH_NOT_FOUND;
+}
+
+// scanBlocks 的全部匹配版本：每处不重叠的匹配以链内偏移调用 emit，
+// resume 记录上一处匹配的结束位置，跨块匹配之后的块从它开始查找
+template <bool Fold, typename InBlockFind, typename Emit>
+void scanBlocksAll(const LineBlock* head, const char* needle, size_t needleLen, InBlockFind inBlock, Emit emit) {
+    size_t base = 0;
+    size_t resume = 0;
+    for (const LineBlock* block = head; block; block = block->next()) {
+        const char* data = block->data();
+        size_t used = block->used();
+        size_t from = resume > base ? resume - base : 0;
+
+        while (from < used) {
+            size_t pos = inBlock(data + from, used - from);
+            if (pos == SEARCH_NOT_FOUND) {
+                break;
+            }
+            emit(base + from + pos);
+            from += pos + needleLen;
+        }
+
+        // 块内匹配都在跨界候选之前结束，跨界候选只需从两者中较后的位置开始
+        if (block->next()) {
+            size_t start = std::max(from, used >= needleLen ? used - needleLen + 1 : 0);
+            while (start < used) {
+                size_t offset = nextFirstByte<Fold>(data, start, used, needle[0]);
+                if (offset == SEARCH_NOT_FOUND) {
+                    break;
+                }
+                if (matchesAcross<Fold>(block, offset, needle, needleLen)) {
+                    emit(base + offset);
+                    start = offset + needleLen;
+                } else {
+                    start = offset + 1;
+                }
+            }
+            from = std::max(from, start);
+        }
+
+        resume = std::max(resume, base + from);
+        base += used;
+    }
+}
+
+} // anonymous namespace
+
+size_t findBytes(const char* haystack, size_t size, const char* needle, size_t needleLen) {
+    if (needleLen == 0) {
+        return 0;
+    }
+    if (needleLen > size) {
+        return SEARCH_NOT_FOUND;
+    }
+    if (needleLen == 1) {
+        const void* hit = std::memchr(haystack, needle[0], size);
+        return hit ? static_cast<size_t>(static_cast<const char*>(hit) - haystack) : SEARCH_NOT_FOUND;
+    }
+    return scanCandidates<false>(haystack, size - needleLen + 1, needle, needleLen);
+}
+
+size_t findBytesIgnoreCase(const char* haystack, size_t size, const char* needle, size_t needleLen) {
+    if (needleLen == 0) {
+        return 0;
+    }
+    if (needleLen > size) {
+        return SEARCH_NOT_FOUND;
+    }
+    if (needleLen == 1 && static_cast<unsigned>(foldAscii(static_cast<unsigned char>(needle[0])) - 'a') >= 26u) {
+        // 不是字母时大小写无关，直接 memchr
+        return findBytes(haystack, size, needle, 1);
+    }
+    return scanCandidates<true>(haystack, size - needleLen + 1, needle, needleLen);
+}
+
+size_t findInBlocks(const LineBlock* head, const char* needle, size_t needleLen) {
+    return scanBlocks<false>(head, needle, needleLen, [&](const char* data, size_t size) {
+        return findBytes(data, size, needle, needleLen);
+    });
+}
+
+// 模式长度达到此值时 Horspool 的平均跳跃才能胜过首尾字节过滤；
+// 有 SSE2 时向量过滤每步检查 64 个起点，门槛相应更高
+#ifdef LINE_EDITOR_HAVE_SSE2
+constexpr size_t HORSPOOL_MIN_LENGTH = 32;
+#else
+constexpr size_t HORSPOOL_MIN_LENGTH = 8;
+#endif
+
+Searcher::Searcher(const std::string& pattern, bool ignoreCase)
+    : pattern_(pattern), strategy_(Strategy::EMPTY), ignoreCase_(ignoreCase),
+      foldedAscii_(false), asciiSafe_(false) {
+    size_t m = pattern_.size();
+    if (m == 0) {
+        strategy_ = Strategy::EMPTY;
+    } else if (ignoreCase_) {
+        strategy_ = Strategy::CASE_FOLD;
+    } else if (m == 1) {
+        strategy_ = Strategy::SINGLE_BYTE;
+    } else if (m < HORSPOOL_MIN_LENGTH) {
+        strategy_ = Strategy::VECTOR_FILTER;
+    } else {
+        strategy_ = Strategy::HORSPOOL;
+    }
+
+    std::fill(shift_, shift_ + 256, m);
+    for (size_t i = 0; i + 1 < m; ++i) {
+        shift_[static_cast<unsigned char>(pattern_[i])] = m - 1 - i;
+    }
+
+    if (ignoreCase_) {
+        foldUtf8(pattern_.data(), pattern_.size(), folded_);
+        foldedAscii_ = isAscii(folded_.data(), folded_.size());
+        asciiSafe_ = foldedAscii_;
+        std::vector<uint32_t> orbit;
+        for (size_t i = 0; asciiSafe_ && i < folded_.size(); ++i) {
+            caseOrbit(static_cast<unsigned char>(folded_[i]), orbit);
+            asciiSafe_ = orbit.back() < 0x80;
+        }
+    }
+}
+
+size_t Searcher::findHorspool(const char* data, size_t size) const {
+    const size_t m = pattern_.size();
+    if (m > size) {
+        return SEARCH_NOT_FOUND;
+    }
+
+    const char* p = pattern_.data();
+    const char lastChar = p[m - 1];
+    size_t i = 0;
+    while (i + m <= size) {
+        char c = data[i + m - 1];
+        if (c == lastChar && std::memcmp(data + i, p, m - 1) == 0) {
+            return i;
+        }
+        i += shift_[static_cast<unsigned char>(c)];
+    }
+    return SEARCH_NOT_FOUND;
+}
+
+size_t Searcher::findInBlock(const char* data, size_t size) const {
+    if (strategy_ == Strategy::HORSPOOL) {
+        return findHorspool(data, size);
+    }
+    return findBytes(data, size, pattern_.data(), pattern_.size());
+}
+
+size_t Searcher::findFolded(const char* data, size_t size) const {
+    std::string text;
+    std::vector<size_t> origin;
+    foldUtf8(data, size, text, &origin);
+    size_t pos = findBytes(text.data(), text.size(), folded_.data(), folded_.size());
+    return pos == SEARCH_NOT_FOUND ? SEARCH_NOT_FOUND : origin[pos];
+}
+
+size_t Searcher::find(const char* data, size_t size) const {
+    if (strategy_ == Strategy::CASE_FOLD) {
+        if (!foldedAscii_) {
+            return findFolded(data, size);
+        }
+        size_t pos = findBytesIgnoreCase(data, size, folded_.data(), folded_.size());
+        if (asciiSafe_) {
+            return pos;
+        }
+        // 只有含非 ASCII 字节的匹配才会被 ASCII 折叠漏掉；到匹配结束为止都是 ASCII 时结果可信
+        size_t checked = pos == SEARCH_NOT_FOUND ? size : pos + folded_.size();
+        if (isAscii(data, checked)) {
+            return pos;
+        }
+        return findFolded(data, size);
+    }
+    return findInBlock(data, size);
+}
+
+size_t Searcher::find(const LineBlock* head, bool asciiText) const {
+    if (strategy_ == Strategy::EMPTY) {
+        return 0;
+    }
+    if (strategy_ == Strategy::CASE_FOLD) {
+        if (foldedAscii_ && (asciiText || asciiSafe_)) {
+            return scanBlocks<true>(head, folded_.data(), folded_.size(), [this](const char* data, size_t size) {
+                return findBytesIgnoreCase(data, size, folded_.data(), folded_.size());
+            });
+        }
+        if (asciiText) {
+            // ASCII 文本折叠后仍是 ASCII，不可能包含非 ASCII 的模式
+            return SEARCH_NOT_FOUND;
+        }
+        std::string text;
+        for (const LineBlock* block = head; block; block = block->next()) {
+            text.append(block->data(), block->used());
+        }
+        return findFolded(text.data(), text.size());
+    }
+    return scanBlocks<false>(head, pattern_.data(), pattern_.size(), [this](const char* data, size_t size) {
+        return findInBlock(data, size);
+    });
+}
+
+size_t Searcher::findAll(const LineBlock* head, LineNo lineNo, std::vector<MatchPosition>& out,
+                         bool asciiText) const {
+    if (strategy_ == Strategy::EMPTY) {
+        return 0;
+    }
+    size_t before = out.size();
+    if (strategy_ == Strategy::CASE_FOLD) {
+        if (foldedAscii_ && (asciiText || asciiSafe_)) {
+            // ASCII 折叠不改变长度，匹配长度就是模式长度
+            scanBlocksAll<true>(head, folded_.data(), folded_.size(),
+                [this](const char* data, size_t size) {
+                    return findBytesIgnoreCase(data, size, folded_.data(), folded_.size());
+                },
+                [&](size_t offset) { out.push_back(MatchPosition{ lineNo, offset, folded_.size() }); });
+        } else if (!asciiText) {
+            // 折叠可能改变字节数：在折叠后的副本上查找，再映射回原文的起止位置
+            std::string text;
+            for (const LineBlock* block = head; block; block = block->next()) {
+                text.append(block->data(), block->used());
+            }
+            std::string folded;
+            std::vector<size_t> origin;
+            foldUtf8(text.data(), text.size(), folded, &origin);
+            size_t from = 0;
+            while (from < folded.size()) {
+                size_t pos = findBytes(folded.data() + from, folded.size() - from, folded_.data(), folded_.size());
+                if (pos == SEARCH_NOT_FOUND) {
+                    break;
+                }
+                pos += from;
+                size_t end = pos + folded_.size();
+                size_t begin = origin[pos];
+                size_t originEnd = end < folded.size() ? origin[end] : text.size();
+                out.push_back(MatchPosition{ lineNo, begin, originEnd - begin });
+                from = end;
+            }
+        }
+        return out.size() - before;
+    }
+    scanBlocksAll<false>(head, pattern_.data(), pattern_.size(),
+        [this](const char* data, size_t size) {
+            return findInBlock(data, size);
+        },
+        [&](size_t offset) { out.push_back(MatchPosition{ lineNo, offset, pattern_.size() }); });
+    return out.size() - before;
+}
+
+} // namespace line_editor
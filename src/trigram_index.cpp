@@ -0,0 +1,584 @@
+#include "trigram_index.h"
+#include "encoding_utils.h"
+#include "error.h"
+#include "file_manager.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <utility>
+
+namespace line_editor {
+
+namespace {
+
+const char INDEX_MAGIC[8] = { 'L', 'E', 'T', 'R', 'I', 'G', 'R', 'M' };
+constexpr uint32_t INDEX_VERSION = 1;
+// 按本机字节序写入，读取时据此拒绝其他字节序的机器生成的索引
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+// 每积累这么多块，就把块内出现的 (trigram, 块号) 排序后写出一段
+constexpr size_t RUN_BLOCKS = 256;
+// 指纹覆盖索引范围开头和结尾各至多这么多字节
+constexpr size_t FINGERPRINT_BYTES = 4096;
+constexpr uint32_t TRIGRAM_SPACE = 1u << 24;
+// 合并时每段的读缓冲（条目数）
+constexpr size_t RUN_BUFFER_ENTRIES = 8192;
+
+struct Header {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t version;
+    uint64_t fileSize;          // 构建时的文件大小和修改时间
+    int64_t mtime;
+    uint64_t indexedBytes;      // 索引覆盖 [BOM 之后, indexedBytes)，止于最后一个换行之后
+    uint64_t indexedLines;
+    uint64_t fingerprint;
+    uint64_t blockBytes;
+    uint64_t blockCount;
+    uint64_t trigramCount;
+    uint64_t blocksOffset;
+    uint64_t postingsOffset;
+    uint64_t directoryOffset;
+};
+
+struct BlockEntry {
+    uint64_t begin;
+    uint64_t firstLine;
+};
+
+// 目录按 trigram 升序排列，offset 相对于倒排表区的起点
+struct DirectoryEntry {
+    uint32_t trigram;
+    uint32_t count;
+    uint64_t offset;
+};
+
+template <typename T>
+T load(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+unsigned char foldAscii(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+}
+
+// 不区分大小写时 trigram 只能由这样的字节组成：ASCII，且没有非 ASCII 的折叠变体
+// （k 与开尔文符号 U+212A、s 与长 s U+017F 折叠相同，文本中可能是多字节形式）
+bool foldSafe(unsigned char c) {
+    c = foldAscii(c);
+    return c < 0x80 && c != 'k' && c != 's';
+}
+
+uint32_t trigramKey(unsigned char a, unsigned char b, unsigned char c) {
+    return (static_cast<uint32_t>(foldAscii(a)) << 16) | (static_cast<uint32_t>(foldAscii(b)) << 8) |
+           foldAscii(c);
+}
+
+uint64_t fnv1a(uint64_t hash, const char* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// 索引范围开头和结尾的 FNV-1a，加上长度
+uint64_t fingerprint(const char* data, size_t size) {
+    size_t head = std::min(size, FINGERPRINT_BYTES);
+    size_t tailStart = std::max(head, size - std::min(size, FINGERPRINT_BYTES));
+    uint64_t hash = fnv1a(14695981039346656037ULL, data, head);
+    hash = fnv1a(hash, data + tailStart, size - tailStart);
+    return (hash ^ size) * 1099511628211ULL;
+}
+
+void putVarint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void writeBytes(std::ofstream& out, const void* data, size_t size, const std::string& path) {
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    if (!out) {
+        throw EditorException(ErrorCode::FILE_WRITE_FAILED, "写入索引失败: " + path);
+    }
+}
+
+// 顺序读取临时文件中的一段已排序条目
+class RunReader {
+public:
+    RunReader(std::ifstream& in, uint64_t first, uint64_t count)
+        : in_(&in), next_(first), remaining_(count), pos_(0) {}
+
+    bool next(uint64_t& value) {
+        if (pos_ == buffer_.size()) {
+            if (remaining_ == 0) {
+                return false;
+            }
+            size_t n = static_cast<size_t>(std::min<uint64_t>(remaining_, RUN_BUFFER_ENTRIES));
+            buffer_.resize(n);
+            in_->seekg(static_cast<std::streamoff>(next_ * sizeof(uint64_t)));
+            in_->read(reinterpret_cast<char*>(buffer_.data()),
+                      static_cast<std::streamsize>(n * sizeof(uint64_t)));
+            if (!*in_) {
+                throw EditorException(ErrorCode::FILE_OPEN_FAILED, "读取索引临时文件失败");
+            }
+            next_ += n;
+            remaining_ -= n;
+            pos_ = 0;
+        }
+        value = buffer_[pos_++];
+        return true;
+    }
+
+private:
+    std::ifstream* in_;
+    uint64_t next_;
+    uint64_t remaining_;
+    std::vector<uint64_t> buffer_;
+    size_t pos_;
+};
+
+// 析构时删除仍然存在的临时文件
+struct TempFiles {
+    std::vector<std::string> paths;
+    ~TempFiles() {
+        for (const std::string& path : paths) {
+            std::remove(path.c_str());
+        }
+    }
+};
+
+} // anonymous namespace
+
+void TrigramIndex::build(const std::string& path, const std::string& indexPath, size_t blockBytes,
+                         const std::atomic<bool>* cancel) {
+    MappedFile file;
+    if (!file.open(path)) {
+        throw EditorException(ErrorCode::FILE_OPEN_FAILED, "无法映射文件: " + path);
+    }
+    const char* data = file.data();
+    size_t size = file.size();
+    size_t bom = detectUtf8Bom(data, size);
+    blockBytes = std::max<size_t>(blockBytes, 1);
+
+    // 只索引到最后一个换行为止，之后的半行可能还会被追加
+    size_t indexed = size;
+    while (indexed > bom && data[indexed - 1] != '\n') {
+        indexed--;
+    }
+
+    TempFiles temps;
+    std::string runsPath = FileManager::createTempFileNear(indexPath);
+    temps.paths.push_back(runsPath);
+    std::ofstream runsOut(runsPath, std::ios::binary | std::ios::trunc);
+    if (!runsOut) {
+        throw EditorException(ErrorCode::FILE_OPEN_FAILED, "无法创建索引临时文件: " + runsPath);
+    }
+
+    // 第一遍：按块收集出现过的 trigram，每 RUN_BLOCKS 块排序写出一段
+    std::vector<BlockEntry> blocks;
+    std::vector<std::pair<uint64_t, uint64_t>> runs;
+    uint64_t runEntries = 0;
+    std::vector<uint64_t> pairs;
+    std::vector<uint64_t> seen(TRIGRAM_SPACE / 64, 0);
+    std::vector<uint32_t> touched;
+    auto flushRun = [&]() {
+        if (pairs.empty()) {
+            return;
+        }
+        std::sort(pairs.begin(), pairs.end());
+        writeBytes(runsOut, pairs.data(), pairs.size() * sizeof(uint64_t), runsPath);
+        runs.push_back(std::make_pair(runEntries, static_cast<uint64_t>(pairs.size())));
+        runEntries += pairs.size();
+        pairs.clear();
+    };
+
+    uint64_t line = 1;
+    size_t pos = bom;
+    while (pos < indexed) {
+        if (cancel && *cancel) {
+            throw EditorException(ErrorCode::FILE_WRITE_FAILED, "索引构建已取消");
+        }
+        size_t end = std::min(indexed, pos + blockBytes);
+        if (end < indexed) {
+            const void* newline = std::memchr(data + end - 1, '\n', indexed - end + 1);
+            end = static_cast<size_t>(static_cast<const char*>(newline) - data) + 1;
+        }
+        uint32_t id = static_cast<uint32_t>(blocks.size());
+        blocks.push_back(BlockEntry{ pos, line });
+
+        uint32_t key = 0;
+        int run = 0;
+        for (size_t i = pos; i < end; i++) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c == '\n') {
+                run = 0;
+                line++;
+                continue;
+            }
+            key = ((key << 8) | foldAscii(c)) & (TRIGRAM_SPACE - 1);
+            if (++run >= 3) {
+                uint64_t bit = 1ULL << (key & 63);
+                uint64_t& word = seen[key >> 6];
+                if (!(word & bit)) {
+                    word |= bit;
+                    touched.push_back(key);
+                }
+            }
+        }
+        for (uint32_t trigram : touched) {
+            pairs.push_back((static_cast<uint64_t>(trigram) << 32) | id);
+            seen[trigram >> 6] = 0;
+        }
+        touched.clear();
+        if (blocks.size() % RUN_BLOCKS == 0) {
+            flushRun();
+        }
+        pos = end;
+    }
+    flushRun();
+    runsOut.close();
+    if (!runsOut) {
+        throw EditorException(ErrorCode::FILE_WRITE_FAILED, "写入索引临时文件失败: " + runsPath);
+    }
+
+    // 第二遍：多路归并各段，同一 trigram 的块号自然升序，差分编码后依次写出
+    std::string tempPath = FileManager::createTempFileNear(indexPath);
+    temps.paths.push_back(tempPath);
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw EditorException(ErrorCode::FILE_OPEN_FAILED, "无法创建索引文件: " + tempPath);
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.version = INDEX_VERSION;
+    header.fileSize = size;
+    header.mtime = file.mtime();
+    header.indexedBytes = indexed;
+    header.indexedLines = line - 1;
+    header.fingerprint = fingerprint(data, indexed);
+    header.blockBytes = blockBytes;
+    header.blockCount = blocks.size();
+    header.blocksOffset = sizeof(Header);
+    header.postingsOffset = header.blocksOffset + blocks.size() * sizeof(BlockEntry);
+    writeBytes(out, &header, sizeof(header), tempPath);
+    writeBytes(out, blocks.data(), blocks.size() * sizeof(BlockEntry), tempPath);
+
+    std::ifstream runsIn(runsPath, std::ios::binary);
+    std::vector<RunReader> readers;
+    for (const auto& run : runs) {
+        readers.emplace_back(runsIn, run.first, run.second);
+    }
+    typedef std::pair<uint64_t, size_t> HeapItem;
+    std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+    for (size_t r = 0; r < readers.size(); r++) {
+        uint64_t value;
+        if (readers[r].next(value)) {
+            heap.push(HeapItem(value, r));
+        }
+    }
+
+    std::vector<DirectoryEntry> directory;
+    std::string postings;
+    uint64_t postingsBytes = 0;
+    uint32_t current = 0;
+    uint32_t count = 0;
+    uint32_t prev = 0;
+    auto finishTrigram = [&]() {
+        if (count == 0) {
+            return;
+        }
+        directory.push_back(DirectoryEntry{ current, count, postingsBytes });
+        writeBytes(out, postings.data(), postings.size(), tempPath);
+        postingsBytes += postings.size();
+        postings.clear();
+        count = 0;
+    };
+    while (!heap.empty()) {
+        HeapItem item = heap.top();
+        heap.pop();
+        uint32_t trigram = static_cast<uint32_t>(item.first >> 32);
+        uint32_t id = static_cast<uint32_t>(item.first);
+        if (count == 0 || trigram != current) {
+            finishTrigram();
+            current = trigram;
+            prev = 0;
+        }
+        putVarint(postings, id - prev);
+        prev = id;
+        count++;
+
+        uint64_t value;
+        if (readers[item.second].next(value)) {
+            heap.push(HeapItem(value, item.second));
+        }
+    }
+    finishTrigram();
+    runsIn.close();
+
+    header.trigramCount = directory.size();
+    header.directoryOffset = header.postingsOffset + postingsBytes;
+    writeBytes(out, directory.data(), directory.size() * sizeof(DirectoryEntry), tempPath);
+    out.seekp(0);
+    writeBytes(out, &header, sizeof(header), tempPath);
+    out.close();
+    if (!out) {
+        throw EditorException(ErrorCode::FILE_WRITE_FAILED, "写入索引失败: " + tempPath);
+    }
+
+    if (cancel && *cancel) {
+        throw EditorException(ErrorCode::FILE_WRITE_FAILED, "索引构建已取消");
+    }
+    if (!FileManager::commitTempFile(tempPath, indexPath)) {
+        throw EditorException(ErrorCode::FILE_WRITE_FAILED, "无法替换索引文件: " + indexPath);
+    }
+    temps.paths.pop_back();
+}
+
+bool TrigramIndex::isCurrent(const std::string& path) {
+    MappedFile file;
+    TrigramIndex index;
+    return file.open(path) && index.open(sidecarPath(path)) && index.usableFor(file);
+}
+
+bool TrigramIndex::open(const std::string& indexPath) {
+    close();
+    if (!file_.open(indexPath)) {
+        return false;
+    }
+    size_t size = file_.size();
+    if (size < sizeof(Header)) {
+        close();
+        return false;
+    }
+    Header header = load<Header>(file_.data());
+    bool valid = std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+                 header.byteOrder == BYTE_ORDER_MARK && header.version == INDEX_VERSION &&
+                 header.indexedBytes <= header.fileSize && header.blocksOffset == sizeof(Header) &&
+                 header.blockCount <= (size - sizeof(Header)) / sizeof(BlockEntry) &&
+                 header.postingsOffset == header.blocksOffset + header.blockCount * sizeof(BlockEntry) &&
+                 header.directoryOffset >= header.postingsOffset && header.directoryOffset <= size &&
+                 header.trigramCount == (size - header.directoryOffset) / sizeof(DirectoryEntry) &&
+                 (size - header.directoryOffset) % sizeof(DirectoryEntry) == 0;
+    if (!valid) {
+        close();
+        return false;
+    }
+
+    blockCount_ = static_cast<size_t>(header.blockCount);
+    trigramCount_ = static_cast<size_t>(header.trigramCount);
+    fileSize_ = header.fileSize;
+    mtime_ = header.mtime;
+    indexedBytes_ = header.indexedBytes;
+    indexedLines_ = header.indexedLines;
+    fingerprint_ = header.fingerprint;
+    blocksOffset_ = header.blocksOffset;
+    postingsOffset_ = header.postingsOffset;
+    directoryOffset_ = header.directoryOffset;
+    return true;
+}
+
+bool TrigramIndex::usableFor(const MappedFile& file) const {
+    // 指纹只覆盖索引范围的首尾，不能证明中间未变，所以大小和修改时间必须都相同；
+    // 文件变长也可能是在中间插入，不当作只在末尾追加
+    return isOpen() && file.size() == fileSize_ && file.mtime() == mtime_ &&
+           fingerprint(file.data(), static_cast<size_t>(indexedBytes_)) == fingerprint_;
+}
+
+void TrigramIndex::block(size_t i, unsigned long long& begin, unsigned long long& firstLine) const {
+    BlockEntry entry = load<BlockEntry>(file_.data() + blocksOffset_ + i * sizeof(BlockEntry));
+    begin = entry.begin;
+    firstLine = entry.firstLine;
+}
+
+bool TrigramIndex::lookup(uint32_t trigram, uint32_t& count, unsigned long long& offset) const {
+    const char* directory = file_.data() + directoryOffset_;
+    size_t lo = 0;
+    size_t hi = trigramCount_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        DirectoryEntry entry = load<DirectoryEntry>(directory + mid * sizeof(DirectoryEntry));
+        if (entry.trigram < trigram) {
+            lo = mid + 1;
+        } else if (entry.trigram > trigram) {
+            hi = mid;
+        } else {
+            count = entry.count;
+            offset = entry.offset;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TrigramIndex::decode(unsigned long long offset, uint32_t count, std::vector<uint32_t>& blocks) const {
+    blocks.clear();
+    if (offset > directoryOffset_ - postingsOffset_) {
+        return false;
+    }
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(file_.data() + postingsOffset_ + offset);
+    const unsigned char* end = reinterpret_cast<const unsigned char*>(file_.data() + directoryOffset_);
+    blocks.reserve(count);
+    uint64_t id = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t delta = 0;
+        int shift = 0;
+        while (true) {
+            if (p == end || shift > 28) {
+                return false;
+            }
+            unsigned char byte = *p++;
+            delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        id += delta;
+        if (id >= blockCount_) {
+            return false;
+        }
+        blocks.push_back(static_cast<uint32_t>(id));
+    }
+    return true;
+}
+
+bool TrigramIndex::literalBlocks(const std::string& literal, bool ignoreCase,
+                                 std::vector<uint32_t>& blocks) const {
+    blocks.clear();
+    // 行内不含换行，这样的字面量不会出现在任何一行中
+    if (literal.find('\n') != std::string::npos) {
+        return true;
+    }
+
+    std::vector<uint32_t> trigrams;
+    for (size_t i = 0; i + 3 <= literal.size(); i++) {
+        unsigned char a = static_cast<unsigned char>(literal[i]);
+        unsigned char b = static_cast<unsigned char>(literal[i + 1]);
+        unsigned char c = static_cast<unsigned char>(literal[i + 2]);
+        if (ignoreCase && !(foldSafe(a) && foldSafe(b) && foldSafe(c))) {
+            continue;
+        }
+        trigrams.push_back(trigramKey(a, b, c));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    if (trigrams.empty()) {
+        return false;
+    }
+
+    // 从最短的倒排表开始求交集
+    std::vector<std::pair<uint32_t, unsigned long long>> lists;
+    for (uint32_t trigram : trigrams) {
+        uint32_t count;
+        unsigned long long offset;
+        if (!lookup(trigram, count, offset)) {
+            return true;
+        }
+        lists.push_back(std::make_pair(count, offset));
+    }
+    std::sort(lists.begin(), lists.end());
+
+    if (!decode(lists[0].second, lists[0].first, blocks)) {
+        return false;
+    }
+    std::vector<uint32_t> list;
+    std::vector<uint32_t> merged;
+    for (size_t i = 1; i < lists.size() && !blocks.empty(); i++) {
+        if (lists[i].first >= blockCount_) {
+            break;
+        }
+        if (!decode(lists[i].second, lists[i].first, list)) {
+            return false;
+        }
+        merged.clear();
+        std::set_intersection(blocks.begin(), blocks.end(), list.begin(), list.end(),
+                              std::back_inserter(merged));
+        blocks.swap(merged);
+    }
+    return true;
+}
+
+IndexCandidates TrigramIndex::candidates(const MappedFile& file, const std::vector<std::string>& literals,
+                                         bool ignoreCase) const {
+    IndexCandidates result;
+    bool all = literals.empty();
+    std::vector<char> selected;
+    if (!all) {
+        selected.assign(blockCount_, 0);
+        std::vector<uint32_t> blocks;
+        for (const std::string& literal : literals) {
+            if (!literalBlocks(literal, ignoreCase, blocks)) {
+                all = true;
+                break;
+            }
+            for (uint32_t id : blocks) {
+                selected[id] = 1;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < blockCount_; i++) {
+        if (!all && !selected[i]) {
+            continue;
+        }
+        unsigned long long begin;
+        unsigned long long firstLine;
+        block(i, begin, firstLine);
+        unsigned long long end = indexedBytes_;
+        if (i + 1 < blockCount_) {
+            unsigned long long nextLine;
+            block(i + 1, end, nextLine);
+        }
+        if (!result.ranges.empty() && result.ranges.back().end == begin) {
+            result.ranges.back().end = static_cast<size_t>(end);
+        } else {
+            result.ranges.push_back(LineRange{ static_cast<size_t>(begin), static_cast<size_t>(end),
+                                               static_cast<LineNo>(firstLine) });
+        }
+        result.candidateBlocks++;
+    }
+
+    // 索引之后追加的部分（包括结尾没有换行的半行）总是整段查找
+    if (file.size() > indexedBytes_) {
+        size_t begin = static_cast<size_t>(indexedBytes_);
+        result.ranges.push_back(LineRange{ begin, file.size(), static_cast<LineNo>(indexedLines_ + 1) });
+        result.tailBytes = file.size() - begin;
+    }
+    return result;
+}
+
+BackgroundIndexBuild::BackgroundIndexBuild(const std::string& path, size_t blockBytes)
+    : finished_(false), cancel_(false) {
+    thread_ = std::thread([this, path, blockBytes]() {
+        try {
+            TrigramIndex::build(path, TrigramIndex::sidecarPath(path), blockBytes, &cancel_);
+        } catch (const std::exception& e) {
+            error_ = e.what();
+        }
+        finished_ = true;
+    });
+}
+
+BackgroundIndexBuild::~BackgroundIndexBuild() {
+    wait();
+}
+
+void BackgroundIndexBuild::wait() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+} // namespace line_editor
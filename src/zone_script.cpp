@@ -0,0 +1,144 @@
+#include "zone_script.h"
+#include "command_parser.h"
+#include "editor.h"
+#include "error.h"
+#include "file_manager.h"
+#include "ordered_pipeline.h"
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace line_editor {
+
+namespace {
+
+struct Job {
+    unsigned long long firstZone = 0;
+    std::vector<std::vector<std::string>> zones;
+};
+
+struct Done {
+    std::string data;
+    std::string output;
+    std::string errors;
+    unsigned long long zones = 0;
+    unsigned long long failedZone = 0;
+    size_t failedLine = 0;
+};
+
+// 在 editor 上依次执行任务中的每个活区，遇到出错的活区就停下
+Done runJob(Editor& editor, const std::string& script, const Job& job) {
+    Done done;
+    std::ostringstream output;
+    std::ostringstream errors;
+    for (size_t i = 0; i < job.zones.size(); i++) {
+        std::istringstream commands(script);
+        size_t failedLine = editor.runZone(job.zones[i], commands, done.data, output, errors);
+        done.zones++;
+        if (failedLine != 0) {
+            done.failedZone = job.firstZone + i;
+            done.failedLine = failedLine;
+            break;
+        }
+    }
+    done.output = output.str();
+    done.errors = errors.str();
+    return done;
+}
+
+} // anonymous namespace
+
+ZoneScript::ZoneScript(const std::string& script, const ZoneScriptOptions& options)
+    : script_(script), options_(options) {
+    // 每个活区都从第 1 行编号，n、g 和 M 在单个活区里没有意义；q 要停止整个编辑，
+    // 逐活区执行时却只能结束当前活区的脚本，其后的活区照样被编辑
+    CommandParser parser;
+    std::istringstream lines(script);
+    std::string line;
+    size_t lineNo = 0;
+    bool insertText = false;
+    while (std::getline(lines, line)) {
+        lineNo++;
+        if (insertText) {
+            insertText = !line.empty();
+            continue;
+        }
+        if (line.empty() || line[0] == '/') {
+            continue;
+        }
+        ParseResult parsed = parser.tryParse(line);
+        if (!parsed.ok()) {
+            continue;
+        }
+        CommandType type = parsed.command.type;
+        if (type == CommandType::NEXT_ZONE || type == CommandType::GOTO || type == CommandType::FILE_MATCH ||
+            type == CommandType::QUIT) {
+            throw EditorException(ErrorCode::UNKNOWN_COMMAND,
+                "脚本第 " + std::to_string(lineNo) + " 行: 逐活区执行时不能使用跨活区或结束编辑的命令 '" + line + "'");
+        }
+        insertText = type == CommandType::INSERT && parsed.command.text.empty();
+    }
+
+    if (options_.zoneLines <= 0) {
+        options_.zoneLines = ZONE_LOAD_LINES;
+    }
+    if (options_.zonesPerJob == 0) {
+        options_.zonesPerJob = 1;
+    }
+    if (options_.threads == 0) {
+        options_.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options_.maxInFlight == 0) {
+        options_.maxInFlight = 2 * static_cast<size_t>(options_.threads);
+    }
+}
+
+ZoneScriptStats ZoneScript::run(FileManager& fileMgr, std::ostream& results, std::ostream& errors) const {
+    ZoneScriptStats stats;
+    unsigned long long zones = 0;
+
+    auto read = [&](Job& job) {
+        job.firstZone = zones + 1;
+        while (job.zones.size() < options_.zonesPerJob) {
+            std::vector<std::string> lines;
+            int count = fileMgr.readLines(lines, options_.zoneLines);
+            if (count == 0) {
+                break;
+            }
+            stats.linesRead += static_cast<unsigned long long>(count);
+            job.zones.push_back(std::move(lines));
+        }
+        zones += job.zones.size();
+        return !job.zones.empty();
+    };
+
+    // 每个工作线程用自己的编辑器执行任务
+    auto makeWorker = [this]() {
+        return [this, editor = std::make_unique<Editor>()](const Job& job) {
+            return runJob(*editor, script_, job);
+        };
+    };
+
+    // 写出一个任务的结果；任务中有活区出错时返回 false，其后的输出都不再需要
+    auto write = [&](const Done& result) {
+        // 结果和错误可能写到同一个流，错误总在出错活区的结果之后
+        results.write(result.output.data(), static_cast<std::streamsize>(result.output.size()));
+        errors.write(result.errors.data(), static_cast<std::streamsize>(result.errors.size()));
+        stats.zones += result.zones;
+        if (result.failedLine != 0) {
+            stats.failedZone = result.failedZone;
+            stats.failedLine = result.failedLine;
+            return false;
+        }
+        fileMgr.writeRaw(result.data.data(), result.data.size());
+        stats.bytesWritten += result.data.size();
+        return true;
+    };
+
+    runOrderedPipeline<Job>(options_.threads, options_.maxInFlight, read, makeWorker, write);
+    return stats;
+}
+
+} // namespace line_editor
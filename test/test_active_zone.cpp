@@ -192,6 +192,29 @@ TEST(ActiveZone_MaxLines) {
     return true;
 }
 
+// Test: ActiveZone addressed past 2^31 lines
+TEST(ActiveZone_LargeLineNumbers) {
+    ActiveZone zone;
+    const LineNo start = 5000000000LL;
+    zone.setStartLineNo(start);
+
+    zone.appendLine(new Line("first"));
+    zone.appendLine(new Line("second"));
+    zone.appendLine(new Line("third"));
+
+    ASSERT_STR_EQ(zone.getLineByNumber(start + 1)->getText(), "second");
+
+    auto matches = zone.findPattern("third");
+    ASSERT_EQ(matches.size(), 1);
+    ASSERT_TRUE(matches[0] == start + 2);
+
+    zone.deleteRange(0, start);
+    ASSERT_EQ(zone.lineCount(), 2);
+    ASSERT_STR_EQ(zone.head()->getText(), "second");
+
+    return true;
+}
+
 // Register tests
 REGISTER_TEST(ActiveZone, ActiveZone_Create);
 REGISTER_TEST(ActiveZone, ActiveZone_AppendLine);
@@ -203,3 +226,4 @@ REGISTER_TEST(ActiveZone, ActiveZone_FindPattern);
 REGISTER_TEST(ActiveZone, ActiveZone_ReplaceInLine);
 REGISTER_TEST(ActiveZone, ActiveZone_Clear);
 REGISTER_TEST(ActiveZone, ActiveZone_MaxLines);
+REGISTER_TEST(ActiveZone, ActiveZone_LargeLineNumbers);
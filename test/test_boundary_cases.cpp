@@ -506,7 +506,7 @@ TEST(ActiveZone_FindEmptyPattern) {
     zone.appendLine(new Line("Line 2"));
 
     // 空模式应该匹配所有行
-    std::vector<int> matches = zone.findPattern("");
+    std::vector<LineNo> matches = zone.findPattern("");
 
     ASSERT_EQ(matches.size(), 2);
 
@@ -520,7 +520,7 @@ TEST(ActiveZone_FindNonExistentPattern) {
     zone.appendLine(new Line("Line 1"));
     zone.appendLine(new Line("Line 2"));
 
-    std::vector<int> matches = zone.findPattern("xyz");
+    std::vector<LineNo> matches = zone.findPattern("xyz");
 
     ASSERT_EQ(matches.size(), 0);
 
@@ -974,9 +974,9 @@ TEST(Executor_UnknownCommand) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_FALSE(result.success);
-    ASSERT_TRUE(result.message.find("未知") != std::string::npos ||
-                result.message.find("Unknown") != std::string::npos);
+    ASSERT_FALSE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("未知") != std::string::npos ||
+                result.message(cmd).find("Unknown") != std::string::npos);
 
     return true;
 }
@@ -992,7 +992,7 @@ TEST(Executor_DeleteFromEmptyZone) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.ok());
 
     return true;
 }
@@ -1009,9 +1009,9 @@ TEST(Executor_PrintEmptyZonePages) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
-    ASSERT_TRUE(result.message.find("空") != std::string::npos ||
-                result.message.find("empty") != std::string::npos);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("空") != std::string::npos ||
+                result.message(cmd).find("empty") != std::string::npos);
 
     return true;
 }
@@ -1030,9 +1030,9 @@ TEST(Executor_PrintNegativePage) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.ok());
     // 负页码应该显示第1页
-    ASSERT_TRUE(result.message.find("第 1 页") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("第 1 页") != std::string::npos);
 
     return true;
 }
@@ -1052,7 +1052,7 @@ TEST(Executor_ReplaceEmptyOldStr) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_FALSE(result.success);
+    ASSERT_FALSE(result.ok());
 
     return true;
 }
@@ -1072,10 +1072,10 @@ TEST(Executor_MatchEmptyPattern) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.ok());
     // 空模式应该匹配所有行
-    ASSERT_TRUE(result.message.find("1") != std::string::npos);
-    ASSERT_TRUE(result.message.find("2") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("1") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("2") != std::string::npos);
 
     return true;
 }
@@ -1094,9 +1094,9 @@ TEST(Executor_MatchNonExistentPattern) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
-    ASSERT_TRUE(result.message.find("未找到") != std::string::npos ||
-                result.message.find("not found") != std::string::npos);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("未找到") != std::string::npos ||
+                result.message(cmd).find("not found") != std::string::npos);
 
     return true;
 }
@@ -0,0 +1,217 @@
+#include "../include/case_fold.h"
+#include "../include/command_parser.h"
+#include "../include/line.h"
+#include "../include/regex_engine.h"
+#include "../include/text_search.h"
+#include "test_framework.h"
+#include <cctype>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+std::string lowerAscii(std::string text) {
+    for (char& c : text) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return text;
+}
+
+size_t expectedIgnoreCase(const std::string& text, const std::string& needle) {
+    size_t pos = lowerAscii(text).find(lowerAscii(needle));
+    return pos == std::string::npos ? SEARCH_NOT_FOUND : pos;
+}
+
+} // anonymous namespace
+
+// Test: 简单大小写折叠的典型码点
+TEST(CaseFold_SimpleFold) {
+    ASSERT_EQ(simpleFold('A'), static_cast<uint32_t>('a'));
+    ASSERT_EQ(simpleFold('z'), static_cast<uint32_t>('z'));
+    ASSERT_EQ(simpleFold('@'), static_cast<uint32_t>('@'));
+    ASSERT_EQ(simpleFold(0x00C9), 0x00E9u);     // É -> é
+    ASSERT_EQ(simpleFold(0x0100), 0x0101u);     // Ā -> ā
+    ASSERT_EQ(simpleFold(0x0101), 0x0101u);
+    ASSERT_EQ(simpleFold(0x212A), static_cast<uint32_t>('k'));   // 开尔文符号
+    ASSERT_EQ(simpleFold(0x017F), static_cast<uint32_t>('s'));   // 长 s
+    ASSERT_EQ(simpleFold(0x03A3), 0x03C3u);     // Σ -> σ
+    ASSERT_EQ(simpleFold(0x03C2), 0x03C3u);     // ς -> σ
+    ASSERT_EQ(simpleFold(0x0410), 0x0430u);     // А -> а
+    ASSERT_EQ(simpleFold(0x00DF), 0x00DFu);     // ß 只有完全折叠，简单折叠不变
+    ASSERT_EQ(simpleFold(0x1E9E), 0x00DFu);     // ẞ -> ß
+    ASSERT_EQ(simpleFold(0x4E2D), 0x4E2Du);     // 中
+    ASSERT_EQ(simpleFold(0x10400), 0x10428u);   // 德瑟雷特字母
+
+    std::vector<uint32_t> orbit;
+    caseOrbit('k', orbit);
+    ASSERT_EQ(orbit.size(), 3);
+    ASSERT_EQ(orbit[0], static_cast<uint32_t>('K'));
+    ASSERT_EQ(orbit[2], 0x212Au);
+    caseOrbit('1', orbit);
+    ASSERT_EQ(orbit.size(), 1);
+
+    return true;
+}
+
+// Test: 折叠 UTF-8 文本并记录每个输出字节的来源偏移
+TEST(CaseFold_FoldUtf8) {
+    std::string out;
+    std::vector<size_t> origin;
+    std::string text = "A\xE2\x84\xAA" "\xC3\x89x\xFF";    // A, 开尔文符号, É, x, 非法字节
+    foldUtf8(text.data(), text.size(), out, &origin);
+
+    ASSERT_STR_EQ(out, "ak\xC3\xA9x\xFF");
+    ASSERT_EQ(origin.size(), out.size());
+    ASSERT_EQ(origin[0], 0);
+    ASSERT_EQ(origin[1], 1);
+    ASSERT_EQ(origin[2], 4);
+    ASSERT_EQ(origin[3], 4);
+    ASSERT_EQ(origin[4], 6);
+    ASSERT_EQ(origin[5], 7);
+
+    return true;
+}
+
+// Test: ASCII 向量折叠查找与逐字节小写后的 find 一致
+TEST(CaseFold_FindBytesIgnoreCase) {
+    std::string text;
+    for (int i = 0; i < 500; i++) {
+        char c = static_cast<char>('a' + (i * 7 + i / 11) % 26);
+        text += (i % 3 == 0) ? static_cast<char>(std::toupper(c)) : c;
+        if (i % 17 == 0) {
+            text += "[@]_`{";       // 紧邻字母的标点不能被折叠
+        }
+    }
+
+    size_t lengths[] = { 1, 2, 3, 15, 16, 17, 40, 70 };
+    for (size_t len : lengths) {
+        for (size_t start = 0; start + len <= text.size(); start += 5) {
+            std::string needle = lowerAscii(text.substr(start, len));
+            if (findBytesIgnoreCase(text.data(), text.size(), needle.data(), needle.size()) !=
+                expectedIgnoreCase(text, needle)) {
+                return false;
+            }
+        }
+    }
+
+    ASSERT_EQ(findBytesIgnoreCase("ABC[", 4, "{", 1), SEARCH_NOT_FOUND);
+    ASSERT_EQ(findBytesIgnoreCase("ABC@", 4, "`", 1), SEARCH_NOT_FOUND);
+    ASSERT_EQ(findBytesIgnoreCase("xxABC", 5, "abc", 3), 2);
+
+    return true;
+}
+
+// Test: 块链上的不区分大小写查找，包括跨块匹配
+TEST(CaseFold_SearcherOnBlocks) {
+    std::string text;
+    for (int i = 0; i < 300; i++) {
+        char c = static_cast<char>('a' + (i * 5 + i / 7) % 26);
+        text += (i % 2 == 0) ? static_cast<char>(std::toupper(c)) : c;
+    }
+    Line line(text.c_str());
+
+    size_t lengths[] = { 1, 3, 16, 79, 81 };
+    for (size_t len : lengths) {
+        for (size_t start = 0; start + len <= text.size(); start += 13) {
+            std::string needle = text.substr(start, len);
+            for (char& c : needle) {
+                c = static_cast<char>(std::isupper(static_cast<unsigned char>(c))
+                    ? std::tolower(static_cast<unsigned char>(c)) : std::toupper(static_cast<unsigned char>(c)));
+            }
+            Searcher searcher(needle, true);
+            if (searcher.find(line.head(), true) != expectedIgnoreCase(text, needle) ||
+                searcher.find(line.head(), false) != expectedIgnoreCase(text, needle) ||
+                searcher.find(text.data(), text.size()) != expectedIgnoreCase(text, needle)) {
+                return false;
+            }
+        }
+    }
+
+    ASSERT_TRUE(Searcher("X", true).strategy() == Searcher::Strategy::CASE_FOLD);
+    ASSERT_TRUE(Searcher("", true).matches(line.head()));
+
+    return true;
+}
+
+// Test: 非 ASCII 行按 Unicode 简单折叠匹配
+TEST(CaseFold_UnicodeLines) {
+    Line greek("ΟΔΥΣΣΕΥΣ returned");
+    ASSERT_TRUE(greek.containsIgnoreCase("οδυσσευς"));
+    ASSERT_TRUE(greek.containsIgnoreCase("RETURNED"));
+    ASSERT_FALSE(greek.contains("RETURNED"));
+
+    Line kelvin("273 \xE2\x84\xAA");        // 开尔文符号
+    ASSERT_TRUE(kelvin.containsIgnoreCase("273 k"));
+    ASSERT_TRUE(kelvin.containsIgnoreCase("273 K"));
+
+    Line ascii("Temperature 300 K");
+    ASSERT_TRUE(ascii.isAscii());
+    ASSERT_TRUE(ascii.containsIgnoreCase("300 \xE2\x84\xAA"));
+    ASSERT_TRUE(ascii.containsIgnoreCase("TEMPERATURE"));
+    ASSERT_FALSE(ascii.containsIgnoreCase("é"));
+
+    Line mixed("Café CRÈME");
+    ASSERT_TRUE(mixed.containsIgnoreCase("café crème"));
+    ASSERT_FALSE(mixed.containsIgnoreCase("creme"));
+
+    std::string text = "Straße \xE1\xBA\x9E";     // ẞ 折叠为 ß
+    Searcher sharp("STRAẞE", true);
+    ASSERT_EQ(sharp.find(text.data(), text.size()), 0);
+
+    return true;
+}
+
+// Test: 正则的 i 标志，以及 m/.../i 的解析
+TEST(CaseFold_RegexFlag) {
+    Regex word("^error: [a-z]+ k$", true);
+    std::string a = "ERROR: Disk K";
+    std::string b = "Error: disk \xE2\x84\xAA";
+    std::string c = "error: disk 9";
+    ASSERT_TRUE(word.search(a.data(), a.size()));
+    ASSERT_TRUE(word.search(b.data(), b.size()));
+    ASSERT_FALSE(word.search(c.data(), c.size()));
+
+    Regex negated("^[^k]+$", true);
+    std::string d = "abc";
+    std::string e = "abK";
+    ASSERT_TRUE(negated.search(d.data(), d.size()));
+    ASSERT_FALSE(negated.search(e.data(), e.size()));
+
+    // 纯字面量直接由折叠查找器判断，find 仍返回原文中的范围
+    Regex literal("timeout", true);
+    Line line("Connection TIMEOUT after 30s");
+    ASSERT_TRUE(literal.search(line.head(), line.isAscii()));
+    size_t start = 0;
+    size_t end = 0;
+    std::string text = line.getText();
+    ASSERT_TRUE(literal.find(text.data(), text.size(), start, end));
+    ASSERT_EQ(start, 11);
+    ASSERT_EQ(end, 18);
+    ASSERT_FALSE(Regex("timeout").search(line.head()));
+
+    CommandParser parser;
+    Command cmd = parser.parse("m/timeout/i");
+    ASSERT_TRUE(cmd.regex);
+    ASSERT_TRUE(cmd.ignoreCase);
+    ASSERT_FALSE(parser.parse("m/timeout/").ignoreCase);
+    try {
+        parser.parse("m/timeout/ix");
+        return false;
+    } catch (const EditorException&) {
+    }
+
+    RegexCache cache;
+    ASSERT_TRUE(cache.get("abc") != cache.get("abc", true));
+    ASSERT_TRUE(cache.get("abc", true)->ignoreCase());
+
+    return true;
+}
+
+REGISTER_TEST(CaseFold, CaseFold_SimpleFold);
+REGISTER_TEST(CaseFold, CaseFold_FoldUtf8);
+REGISTER_TEST(CaseFold, CaseFold_FindBytesIgnoreCase);
+REGISTER_TEST(CaseFold, CaseFold_SearcherOnBlocks);
+REGISTER_TEST(CaseFold, CaseFold_UnicodeLines);
+REGISTER_TEST(CaseFold, CaseFold_RegexFlag);
@@ -99,7 +99,7 @@ TEST(Executor_Insert) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.ok());
     ASSERT_EQ(zone.lineCount(), 1);
     ASSERT_STR_EQ(zone.getLine(0)->getText().c_str(), "Hello World");
 
@@ -125,7 +125,7 @@ TEST(Executor_InsertMiddle) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.ok());
     ASSERT_EQ(zone.lineCount(), 4);
     ASSERT_STR_EQ(zone.getLine(2)->getText().c_str(), "Inserted Line");
     ASSERT_STR_EQ(zone.getLine(3)->getText().c_str(), "Line 3");
@@ -149,7 +149,7 @@ TEST(Executor_DeleteSingle) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.ok());
     ASSERT_EQ(zone.lineCount(), 2);
     ASSERT_STR_EQ(zone.getLine(0)->getText().c_str(), "Line 1");
     ASSERT_STR_EQ(zone.getLine(1)->getText().c_str(), "Line 3");
@@ -174,7 +174,7 @@ TEST(Executor_DeleteRange) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.ok());
     ASSERT_EQ(zone.lineCount(), 2);
     ASSERT_STR_EQ(zone.getLine(0)->getText().c_str(), "Line 1");
     ASSERT_STR_EQ(zone.getLine(1)->getText().c_str(), "Line 5");
@@ -198,11 +198,11 @@ TEST(Executor_Print) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
-    ASSERT_TRUE(!result.output.empty());
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(!result.output().empty());
     // 第1页应该包含20行
     size_t newlineCount = 0;
-    for (char c : result.output) {
+    for (char c : result.output()) {
         if (c == '\n') newlineCount++;
     }
     ASSERT_EQ(newlineCount, 20);
@@ -226,11 +226,11 @@ TEST(Executor_PrintSecondPage) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
-    ASSERT_TRUE(!result.output.empty());
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(!result.output().empty());
     // 第2页应该包含5行
     size_t newlineCount = 0;
-    for (char c : result.output) {
+    for (char c : result.output()) {
         if (c == '\n') newlineCount++;
     }
     ASSERT_EQ(newlineCount, 5);
@@ -254,9 +254,9 @@ TEST(Executor_PrintPageOutOfRange) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.ok());
     // 应该显示最后一页
-    ASSERT_TRUE(result.message.find("第 2 页") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("第 2 页") != std::string::npos);
 
     return true;
 }
@@ -278,13 +278,46 @@ TEST(Executor_Replace) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.ok());
     ASSERT_STR_EQ(zone.getLine(0)->getText().c_str(), "Hello Universe");
     ASSERT_STR_EQ(zone.getLine(1)->getText().c_str(), "Goodbye World");
 
     return true;
 }
 
+// Test: 范围全局替换报告替换次数
+TEST(Executor_ReplaceRange) {
+    ActiveZone zone(100);
+    FileManager fileMgr;
+    CommandExecutor executor(zone, fileMgr);
+
+    zone.appendLine(new Line("a-a-a"));
+    zone.appendLine(new Line("b"));
+    zone.appendLine(new Line("a"));
+    zone.appendLine(new Line("a-a"));
+
+    CommandParser parser;
+    Command cmd = parser.parse("s1 3@a@x@g");
+    ExecutionResult result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("共 4 处") != std::string::npos);
+    ASSERT_STR_EQ(zone.getLine(0)->getText().c_str(), "x-x-x");
+    ASSERT_STR_EQ(zone.getLine(2)->getText().c_str(), "x");
+    ASSERT_STR_EQ(zone.getLine(3)->getText().c_str(), "a-a");
+
+    cmd = parser.parse("s1 4@-@+@");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("共 2 处") != std::string::npos);
+    ASSERT_STR_EQ(zone.getLine(0)->getText().c_str(), "x+x-x");
+    ASSERT_STR_EQ(zone.getLine(3)->getText().c_str(), "a+a");
+
+    result = executor.execute(parser.parse("s2 3@zzz@y@g"));
+    ASSERT_FALSE(result.ok());
+
+    return true;
+}
+
 // Test: 模式匹配
 TEST(Executor_Match) {
     ActiveZone zone(100);
@@ -301,9 +334,9 @@ TEST(Executor_Match) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
-    ASSERT_TRUE(result.message.find("1") != std::string::npos);
-    ASSERT_TRUE(result.message.find("2") != std::string::npos);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("1") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("2") != std::string::npos);
 
     return true;
 }
@@ -319,8 +352,8 @@ TEST(Executor_Quit) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
-    ASSERT_TRUE(result.shouldExit);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.shouldExit());
 
     return true;
 }
@@ -348,7 +381,7 @@ TEST(Executor_NextZone_WriteOutput) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(result.ok());
 
     // 关闭文件管理器以刷新缓冲区
     fileMgr.close();
@@ -379,8 +412,8 @@ TEST(Executor_PrintEmptyZone) {
 
     ExecutionResult result = executor.execute(cmd);
 
-    ASSERT_TRUE(result.success);
-    ASSERT_TRUE(result.message.find("空") != std::string::npos);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("空") != std::string::npos);
 
     return true;
 }
@@ -406,10 +439,94 @@ TEST(Executor_MultiplePages) {
 
         ExecutionResult result = executor.execute(cmd);
 
-        ASSERT_TRUE(result.success);
-        ASSERT_TRUE(result.message.find("第 " + std::to_string(page + 1) + " 页") != std::string::npos);
+        ASSERT_TRUE(result.ok());
+        ASSERT_TRUE(result.message(cmd).find("第 " + std::to_string(page + 1) + " 页") != std::string::npos);
+    }
+
+    return true;
+}
+
+// Test: 开启高亮后，p 用反显标出最近一次 m 查找在该页的每处匹配
+TEST(Executor_PrintHighlight) {
+    ActiveZone zone(100);
+    FileManager fileMgr;
+    CommandExecutor executor(zone, fileMgr);
+    CommandParser parser;
+    zone.appendLine(new Line("error and error"));
+    zone.appendLine(new Line("ok"));
+    zone.appendLine(new Line("ERROR 42"));
+
+    // 未开启时输出不变
+    executor.execute(parser.parse("merror"));
+    ExecutionResult plain = executor.execute(parser.parse("p"));
+    ASSERT_STR_EQ(plain.output(), zone.display(0));
+
+    executor.setHighlight(true);
+    ExecutionResult result = executor.execute(parser.parse("p"));
+    std::string expected = std::string("   1 ") + HIGHLIGHT_BEGIN + "error" + HIGHLIGHT_END + " and " +
+                           HIGHLIGHT_BEGIN + "error" + HIGHLIGHT_END + "\n   2 ok\n   3 ERROR 42\n";
+    ASSERT_STR_EQ(result.output(), expected);
+
+    executor.execute(parser.parse("m/e?rror \\d+/i"));
+    result = executor.execute(parser.parse("p"));
+    ASSERT_TRUE(result.output().find(std::string(HIGHLIGHT_BEGIN) + "ERROR 42" + HIGHLIGHT_END) != std::string::npos);
+    ASSERT_TRUE(result.output().find(std::string("   1 error and error\n")) != std::string::npos);
+
+    std::vector<MatchPosition> matches;
+    ASSERT_EQ(zone.findMatches(Searcher("error"), matches), 2);
+    ASSERT_EQ(zone.findMatches(Regex("error", true), matches), 3);
+    ASSERT_EQ(matches.size(), 5);
+    ASSERT_EQ(matches[4].lineNo, 3);
+    ASSERT_EQ(matches[4].column, 0);
+    ASSERT_EQ(matches[1].column, 10);
+
+    return true;
+}
+
+// Test: 结果只记录状态和载荷，消息在需要时才按命令格式化；常见错误不经过异常
+TEST(Executor_StructuredResult) {
+    ActiveZone zone(100);
+    FileManager fileMgr;
+    CommandExecutor executor(zone, fileMgr);
+    CommandParser parser;
+    for (int i = 1; i <= 5; ++i) {
+        zone.appendLine(new Line(("Line " + std::to_string(i)).c_str()));
     }
 
+    Command cmd = parser.parse("mLine");
+    ExecutionResult result = executor.execute(cmd);
+    ASSERT_TRUE(result.status == ExecStatus::OK);
+    ASSERT_TRUE(result.kind == ResultKind::MATCHED);
+    ASSERT_TRUE(result.get<MatchPayload>() != nullptr);
+    ASSERT_EQ(result.lines().size(), 5);
+    ASSERT_STR_EQ(result.message(cmd), "模式 'Line' 在以下行中找到: 1, 2, 3, 4, 5");
+
+    cmd = parser.parse("d2 3");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.kind == ResultKind::DELETED);
+    ASSERT_EQ(result.count, 2);
+    // 编辑命令的结果没有载荷
+    ASSERT_TRUE(std::holds_alternative<std::monostate>(result.payload));
+    ASSERT_STR_EQ(result.message(cmd), "已删除第 2 到 3 行");
+
+    cmd = parser.parse("s1@nothing@x@");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.status == ExecStatus::FAILED);
+    ASSERT_TRUE(result.error == ErrorCode::PATTERN_NOT_FOUND);
+    ASSERT_STR_EQ(result.message(cmd), CommandExecutor::replaceNotFoundMessage(cmd));
+
+    // 超出活区的行号由 validate 报告，不抛出异常
+    ParseError invalid;
+    ASSERT_FALSE(parser.validate(parser.parse("d9"), 1, zone.lineCount(), invalid));
+    ASSERT_TRUE(invalid.code == ErrorCode::LINE_NUMBER_OUT_OF_RANGE);
+    ASSERT_FALSE(invalid.message().empty());
+    ASSERT_TRUE(parser.validate(parser.parse("d3"), 1, zone.lineCount(), invalid));
+
+    // 起止颠倒的范围为空
+    ASSERT_EQ(zone.deleteRange(3, 2), 0);
+    ASSERT_EQ(zone.deleteRange(2, 9), 2);
+    ASSERT_EQ(zone.lineCount(), 1);
+
     return true;
 }
 
@@ -422,8 +539,11 @@ REGISTER_TEST(CommandExecutor, Executor_Print);
 REGISTER_TEST(CommandExecutor, Executor_PrintSecondPage);
 REGISTER_TEST(CommandExecutor, Executor_PrintPageOutOfRange);
 REGISTER_TEST(CommandExecutor, Executor_Replace);
+REGISTER_TEST(CommandExecutor, Executor_ReplaceRange);
 REGISTER_TEST(CommandExecutor, Executor_Match);
 REGISTER_TEST(CommandExecutor, Executor_Quit);
 REGISTER_TEST(CommandExecutor, Executor_NextZone_WriteOutput);
 REGISTER_TEST(CommandExecutor, Executor_PrintEmptyZone);
 REGISTER_TEST(CommandExecutor, Executor_MultiplePages);
+REGISTER_TEST(CommandExecutor, Executor_PrintHighlight);
+REGISTER_TEST(CommandExecutor, Executor_StructuredResult);
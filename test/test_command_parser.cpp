@@ -1,5 +1,7 @@
 #include "../include/command_parser.h"
 #include "test_framework.h"
+#include <string>
+#include <string_view>
 
 using namespace line_editor;
 
@@ -83,6 +85,38 @@ TEST(Parser_Replace) {
     return true;
 }
 
+// Test: 范围与全局替换，结尾的 @ 和 @g
+TEST(Parser_ReplaceRange) {
+    CommandParser parser;
+    Command cmd = parser.parse("s3 12@old@new@g");
+    ASSERT_TRUE(cmd.type == CommandType::REPLACE);
+    ASSERT_EQ(cmd.lineNo, 3);
+    ASSERT_EQ(cmd.lineNo2, 12);
+    ASSERT_STR_EQ(cmd.oldStr.c_str(), "old");
+    ASSERT_STR_EQ(cmd.newStr.c_str(), "new");
+    ASSERT_TRUE(cmd.global);
+
+    cmd = parser.parse("s2@old@new@");
+    ASSERT_EQ(cmd.lineNo2, 0);
+    ASSERT_STR_EQ(cmd.newStr.c_str(), "new");
+    ASSERT_FALSE(cmd.global);
+
+    // @ 之后不是标志时属于新字符串
+    cmd = parser.parse("s2@at@a@b");
+    ASSERT_STR_EQ(cmd.newStr.c_str(), "a@b");
+    ASSERT_FALSE(cmd.global);
+
+    bool invalid = false;
+    try {
+        parser.validate(parser.parse("s5 3@a@b@g"), 1, 10);
+    } catch (const EditorException&) {
+        invalid = true;
+    }
+    ASSERT_TRUE(invalid);
+
+    return true;
+}
+
 // Test: Parse match command
 TEST(Parser_Match) {
     CommandParser parser;
@@ -127,6 +161,116 @@ TEST(Parser_CaseInsensitive) {
     return true;
 }
 
+// Test: Line numbers beyond 32 bits and overflow detection
+TEST(Parser_LargeLineNumber) {
+    CommandParser parser;
+    Command cmd = parser.parse("d3000000000 3000000005");
+
+    ASSERT_TRUE(cmd.lineNo == 3000000000LL);
+    ASSERT_TRUE(cmd.lineNo2 == 3000000005LL);
+    ASSERT_TRUE(CommandParser::parseLineNumber(" +42") == 42);
+
+    bool overflow = false;
+    try {
+        parser.parse("s99999999999999999999@a@b");
+    } catch (const EditorException& e) {
+        overflow = (e.code() == ErrorCode::INVALID_FORMAT);
+    }
+    ASSERT_TRUE(overflow);
+
+    bool invalid = false;
+    try {
+        CommandParser::parseLineNumber("abc");
+    } catch (const EditorException&) {
+        invalid = true;
+    }
+    ASSERT_TRUE(invalid);
+
+    return true;
+}
+
+// Test: tryParse 的文本字段直接指向输入，不复制
+TEST(Parser_ViewFields) {
+    CommandParser parser;
+    std::string input = "  s3 7@old@new@g  ";
+    ParseResult result = parser.tryParse(input);
+
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.command.type == CommandType::REPLACE);
+    ASSERT_EQ(result.command.lineNo, 3);
+    ASSERT_EQ(result.command.lineNo2, 7);
+    ASSERT_TRUE(result.command.oldStr == "old");
+    ASSERT_TRUE(result.command.newStr == "new");
+    ASSERT_TRUE(result.command.global);
+    ASSERT_TRUE(result.command.oldStr.data() == input.data() + 7);
+    ASSERT_TRUE(result.command.raw.data() == input.data());
+
+    std::string insert = "i2 hello world";
+    result = parser.tryParse(insert);
+    ASSERT_TRUE(result.command.text.data() == insert.data() + 3);
+    ASSERT_TRUE(result.command.text == "hello world");
+
+    // 正则的 \/ 转义和多模式列表在 toCommand 时才解码
+    result = parser.tryParse("m/a\\/b/i");
+    ASSERT_TRUE(result.command.pattern == "a\\/b");
+    Command cmd = result.command.toCommand();
+    ASSERT_STR_EQ(cmd.pattern.c_str(), "a/b");
+    ASSERT_TRUE(cmd.ignoreCase);
+
+    result = parser.tryParse("m|x\\|y||z");
+    ASSERT_TRUE(result.command.patternList == "x\\|y||z");
+    cmd = result.command.toCommand();
+    ASSERT_EQ(cmd.patterns.size(), 2);
+    ASSERT_STR_EQ(cmd.patterns[0].c_str(), "x|y");
+    ASSERT_STR_EQ(cmd.patterns[1].c_str(), "z");
+
+    return true;
+}
+
+// Test: 格式错误作为结果返回，消息在需要时才拼接，与 parse 抛出的异常一致
+TEST(Parser_ViewErrors) {
+    CommandParser parser;
+    struct Case {
+        const char* input;
+        ErrorCode code;
+        const char* message;
+    };
+    const Case cases[] = {
+        { "i", ErrorCode::MISSING_PARAMETER, "插入命令需要行号: i<行号>" },
+        { "dabc", ErrorCode::INVALID_FORMAT, "无效的行号: abc" },
+        { "d1 x", ErrorCode::INVALID_FORMAT, "无效的行号: x" },
+        { "s99999999999999999999@a@b", ErrorCode::INVALID_FORMAT, "行号超出范围: 99999999999999999999" },
+        { "s1@a", ErrorCode::INVALID_FORMAT, "替换命令需要两个 @ 分隔符: s<行号>@<旧字符串>@<新字符串>" },
+        { "m/a/x", ErrorCode::INVALID_FORMAT, "未知的正则标志: x" },
+        { "m||", ErrorCode::MISSING_PARAMETER, "多模式查找需要: m|<模式1>|<模式2>..." },
+        { "M", ErrorCode::MISSING_PARAMETER, "全文件查找需要模式: M<模式>、M/正则/ 或 M|<模式1>|<模式2>..." },
+        { "g0", ErrorCode::LINE_NUMBER_OUT_OF_RANGE, "跳转行号必须从 1 开始" },
+        { "pz", ErrorCode::INVALID_FORMAT, "无效的页码: z" },
+    };
+    for (const Case& c : cases) {
+        ParseResult result = parser.tryParse(c.input);
+        if (result.ok() || result.error.code != c.code || result.error.message() != c.message) {
+            return false;
+        }
+        try {
+            parser.parse(c.input);
+            return false;
+        } catch (const EditorException& e) {
+            if (e.code() != c.code || std::string(e.what()) != c.message) {
+                return false;
+            }
+        }
+    }
+
+    LineNo value = 0;
+    ParseError error;
+    ASSERT_TRUE(CommandParser::parseLineNumber(std::string_view(" +42xyz"), value, error));
+    ASSERT_EQ(value, 42);
+    ASSERT_FALSE(CommandParser::parseLineNumber(std::string_view("-"), value, error));
+
+    return true;
+}
+
 // Register tests
 REGISTER_TEST(CommandParser, Parser_Insert);
 REGISTER_TEST(CommandParser, Parser_InsertWithText);
@@ -135,7 +279,11 @@ REGISTER_TEST(CommandParser, Parser_DeleteRange);
 REGISTER_TEST(CommandParser, Parser_NextZone);
 REGISTER_TEST(CommandParser, Parser_Print);
 REGISTER_TEST(CommandParser, Parser_Replace);
+REGISTER_TEST(CommandParser, Parser_ReplaceRange);
 REGISTER_TEST(CommandParser, Parser_Match);
 REGISTER_TEST(CommandParser, Parser_Quit);
 REGISTER_TEST(CommandParser, Parser_Unknown);
 REGISTER_TEST(CommandParser, Parser_CaseInsensitive);
+REGISTER_TEST(CommandParser, Parser_LargeLineNumber);
+REGISTER_TEST(CommandParser, Parser_ViewFields);
+REGISTER_TEST(CommandParser, Parser_ViewErrors);
@@ -0,0 +1,218 @@
+#include "../include/compression.h"
+#include "../include/file_manager.h"
+#include "../include/error.h"
+#include "test_framework.h"
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#ifdef _WIN32
+#include <windows.h>
+#undef DELETE
+#undef INSERT
+#endif
+
+using namespace line_editor;
+
+namespace {
+
+// 跨平台获取临时目录
+std::string getTempDir() {
+#ifdef _WIN32
+    char tempPath[MAX_PATH];
+    DWORD result = GetTempPathA(MAX_PATH, tempPath);
+    if (result > 0 && result < MAX_PATH) {
+        return std::string(tempPath);
+    }
+    return ".";
+#else
+    const char* tmp = std::getenv("TMPDIR");
+    if (tmp) return tmp;
+    tmp = std::getenv("TEMP");
+    if (tmp) return tmp;
+    tmp = std::getenv("TMP");
+    if (tmp) return tmp;
+    return "/tmp";
+#endif
+}
+
+// 带扩展名的临时文件路径，析构时删除
+class TempPath {
+    std::string path_;
+public:
+    explicit TempPath(const std::string& suffix) {
+        std::string tempDir = getTempDir();
+        if (!tempDir.empty() && tempDir.back() != '/' && tempDir.back() != '\\') {
+#ifdef _WIN32
+            tempDir += '\\';
+#else
+            tempDir += '/';
+#endif
+        }
+        path_ = tempDir + "line_editor_test_" + std::to_string(rand()) + suffix;
+    }
+
+    TempPath(const TempPath&) = delete;
+    TempPath& operator=(const TempPath&) = delete;
+
+    ~TempPath() {
+        std::remove(path_.c_str());
+    }
+
+    std::string path() const { return path_; }
+
+    std::string readBinary() const {
+        std::ifstream ifs(path_, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(ifs)),
+                           std::istreambuf_iterator<char>());
+    }
+};
+
+// 通过 FileManager 写出再读回，返回读到的全部行
+bool roundTrip(Compression compression, const std::vector<std::string>& lines,
+               std::vector<std::string>& readBack) {
+    TempPath file(compression == Compression::GZIP ? ".gz" : ".zst");
+
+    {
+        FileManager writer;
+        writer.openOutput(file.path());
+        if (writer.outputCompression() != compression) return false;
+        writer.writeLines(lines);
+        writer.close();
+    }
+
+    std::string raw = file.readBinary();
+    if (detectCompression(raw.data(), raw.size()) != compression) return false;
+
+    FileManager reader;
+    reader.openInput(file.path());
+    if (reader.inputCompression() != compression) return false;
+
+    readBack.clear();
+    std::vector<std::string> batch;
+    while (reader.readLines(batch, 80) > 0) {
+        readBack.insert(readBack.end(), batch.begin(), batch.end());
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// Test: 根据魔数识别压缩格式
+TEST(Compression_DetectMagic) {
+    ASSERT_TRUE(detectCompression("\x1F\x8B\x08\x00", 4) == Compression::GZIP);
+    ASSERT_TRUE(detectCompression("\x28\xB5\x2F\xFD", 4) == Compression::ZSTD);
+    ASSERT_TRUE(detectCompression("Line", 4) == Compression::NONE);
+    ASSERT_TRUE(detectCompression("\x1F", 1) == Compression::NONE);
+    ASSERT_TRUE(detectCompression("", 0) == Compression::NONE);
+
+    return true;
+}
+
+// Test: 根据扩展名选择输出压缩
+TEST(Compression_FromFilename) {
+    ASSERT_TRUE(compressionFromFilename("log.txt.gz") == Compression::GZIP);
+    ASSERT_TRUE(compressionFromFilename("log.zst") == Compression::ZSTD);
+    ASSERT_TRUE(compressionFromFilename("log.txt") == Compression::NONE);
+    ASSERT_TRUE(compressionFromFilename("gz") == Compression::NONE);
+
+    return true;
+}
+
+// Test: gzip 多块数据往返
+TEST(Compression_GzipRoundTrip) {
+    if (!isCompressionSupported(Compression::GZIP)) {
+        return true;
+    }
+
+    std::vector<std::string> lines;
+    for (int i = 0; i < 50000; i++) {
+        lines.push_back("log entry " + std::to_string(i) + " status=" + std::to_string(i % 7));
+    }
+
+    std::vector<std::string> readBack;
+    ASSERT_TRUE(roundTrip(Compression::GZIP, lines, readBack));
+    ASSERT_EQ(readBack.size(), lines.size());
+    ASSERT_TRUE(readBack == lines);
+
+    return true;
+}
+
+// Test: zstd 往返
+TEST(Compression_ZstdRoundTrip) {
+    if (!isCompressionSupported(Compression::ZSTD)) {
+        return true;
+    }
+
+    std::vector<std::string> lines = { "alpha", "", "gamma" };
+    std::vector<std::string> readBack;
+    ASSERT_TRUE(roundTrip(Compression::ZSTD, lines, readBack));
+    ASSERT_TRUE(readBack == lines);
+
+    return true;
+}
+
+// Test: 截断的压缩输入报告错误
+TEST(Compression_TruncatedInput) {
+    if (!isCompressionSupported(Compression::GZIP)) {
+        return true;
+    }
+
+    TempPath file(".gz");
+    {
+        FileManager writer;
+        writer.openOutput(file.path());
+        for (int i = 0; i < 1000; i++) {
+            writer.writeLine("line " + std::to_string(i));
+        }
+        writer.close();
+    }
+
+    std::string raw = file.readBinary();
+    {
+        std::ofstream ofs(file.path(), std::ios::binary | std::ios::trunc);
+        ofs.write(raw.data(), static_cast<std::streamsize>(raw.size() / 2));
+    }
+
+    FileManager reader;
+    reader.openInput(file.path());
+
+    bool caught = false;
+    try {
+        std::vector<std::string> batch;
+        while (reader.readLines(batch, 80) > 0) {
+        }
+    } catch (const EditorException& e) {
+        caught = true;
+        ASSERT_EQ(static_cast<int>(e.code()), static_cast<int>(ErrorCode::COMPRESSION_FAILED));
+    }
+    ASSERT_TRUE(caught);
+
+    return true;
+}
+
+// Test: 未压缩文件仍按原样读取并跳过 BOM
+TEST(Compression_PlainInputUnchanged) {
+    TempPath file(".txt");
+    {
+        std::ofstream ofs(file.path(), std::ios::binary);
+        ofs << "\xEF\xBB\xBFLine 1\nLine 2\n";
+    }
+
+    FileManager fm;
+    fm.openInput(file.path());
+    ASSERT_TRUE(fm.inputCompression() == Compression::NONE);
+
+    std::vector<std::string> lines;
+    ASSERT_EQ(fm.readLines(lines, 10), 2);
+    ASSERT_STR_EQ(lines[0], "Line 1");
+    ASSERT_STR_EQ(lines[1], "Line 2");
+
+    return true;
+}
+
+REGISTER_TEST(Compression, Compression_DetectMagic);
+REGISTER_TEST(Compression, Compression_FromFilename);
+REGISTER_TEST(Compression, Compression_GzipRoundTrip);
+REGISTER_TEST(Compression, Compression_ZstdRoundTrip);
+REGISTER_TEST(Compression, Compression_TruncatedInput);
+REGISTER_TEST(Compression, Compression_PlainInputUnchanged);
@@ -0,0 +1,173 @@
+#include "../include/edit_plan.h"
+#include "../include/active_zone.h"
+#include "../include/editor.h"
+#include "test_framework.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+void fill(ActiveZone& zone, int lines) {
+    for (int i = 0; i < lines; i++) {
+        std::string text = "line " + std::to_string(i) + (i % 3 == 0 ? " error" : " ok");
+        zone.appendLine(new Line(text.c_str()));
+    }
+}
+
+std::string contents(const ActiveZone& zone) {
+    std::string text;
+    for (const Line* line = zone.head(); line; line = line->next()) {
+        text += line->getText();
+        text += '\n';
+    }
+    return text;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+} // anonymous namespace
+
+// Test: 随机的插入、删除、替换编译成计划后一次执行，与逐条执行的结果相同，包括挤掉开头的行
+TEST(EditPlan_MatchesSequential) {
+    for (int maxLines : { 12, 40 }) {
+        ActiveZone sequential(maxLines);
+        ActiveZone planned(maxLines);
+        sequential.setStartLineNo(5);
+        planned.setStartLineNo(5);
+        fill(sequential, 10);
+        fill(planned, 10);
+        // 执行前缓存一个模式，检查 apply 正确记录了修改
+        planned.findPattern("error");
+
+        EditPlan plan(planned.startLineNo(), planned.lineCount(), planned.maxLines());
+        std::vector<size_t> expected;
+        unsigned seed = 3;
+        for (int i = 0; i < 300; i++) {
+            seed = seed * 1103515245u + 12345u;
+            unsigned roll = (seed >> 16) % 10;
+            LineNo span = plan.lineCount();
+            LineNo at = plan.startLineNo() + (span > 0 ? static_cast<LineNo>((seed >> 8) % span) : 0);
+            if (roll < 4 || span < 3) {
+                std::string text = "new " + std::to_string(i) + " error";
+                sequential.insert(at, text.c_str());
+                plan.insert(at, text);
+            } else if (roll < 7) {
+                LineNo last = std::min(plan.endLineNo(), at + 1);
+                sequential.deleteRange(at, last);
+                plan.erase(at, last);
+            } else {
+                LineNo last = std::min(plan.endLineNo(), at + 4);
+                std::string oldStr = roll == 9 ? "error" : "o";
+                expected.push_back(sequential.replaceInRange(at, last, oldStr, "E", roll == 8));
+                plan.substitute(at, last, oldStr, "E", roll == 8);
+            }
+            if (plan.startLineNo() != sequential.startLineNo() || plan.lineCount() != sequential.lineCount()) {
+                return false;
+            }
+        }
+
+        // 被删除的行上的替换只在需要时计入，次数为 0 的替换必须一致
+        std::vector<size_t> counts = planned.apply(plan);
+        ASSERT_EQ(counts.size(), expected.size());
+        for (size_t id = 0; id < counts.size(); id++) {
+            if ((counts[id] == 0) != (expected[id] == 0)) {
+                return false;
+            }
+        }
+        ASSERT_STR_EQ(contents(planned), contents(sequential));
+        ASSERT_EQ(planned.startLineNo(), sequential.startLineNo());
+        ASSERT_TRUE(planned.findPattern("error") == sequential.findPattern("error"));
+        ASSERT_TRUE(planned.findPattern("new") == sequential.findPattern("new"));
+    }
+    return true;
+}
+
+// Test: 插入后又删除的行、施加在随后被删除的行上的替换不会到达活区
+TEST(EditPlan_DropsCancelledEdits) {
+    EditPlan plan(1, 3, 100);
+    plan.insert(1, "temp");
+    plan.substitute(2, 2, "m", "M", false);
+    plan.erase(2, 2);
+    plan.substitute(1, 1, "t", "T", true);
+    plan.substitute(3, 3, "hr", "HR", false);
+    plan.erase(3, 3);
+    ASSERT_EQ(plan.commands(), 6);
+    ASSERT_EQ(plan.droppedInserts(), 1);
+    ASSERT_EQ(plan.droppedSubstitutions(), 2);
+    ASSERT_EQ(plan.patterns().size(), 3);
+    ASSERT_EQ(plan.lineCount(), 2);
+    ASSERT_EQ(plan.rows()[1].origin, 1);
+
+    ActiveZone zone;
+    zone.appendLine(new Line("top"));
+    zone.appendLine(new Line("two"));
+    zone.appendLine(new Line("three"));
+    std::vector<size_t> counts = zone.apply(plan);
+    // 只在被删除的行上匹配的替换也算替换了内容
+    ASSERT_EQ(counts.size(), 3);
+    ASSERT_EQ(counts[0], 1);
+    ASSERT_EQ(counts[1], 1);
+    ASSERT_EQ(counts[2], 1);
+    ASSERT_STR_EQ(contents(zone), "Top\ntwo\n");
+
+    // 行号范围与活区不符时拒绝执行
+    EditPlan stale(2, 3, 100);
+    try {
+        zone.apply(stale);
+        return false;
+    } catch (const EditorException& e) {
+        ASSERT_TRUE(e.code() == ErrorCode::INVALID_RANGE);
+    }
+    return true;
+}
+
+// Test: 脚本中连续的编辑命令按计划执行；计划中没有匹配的替换按它所在的脚本行报错
+TEST(EditPlan_Script) {
+    const char* dir = std::getenv("TMPDIR");
+    std::string path = std::string(dir ? dir : "/tmp") + "/line_editor_edit_plan.txt";
+    std::string outPath = path + ".out";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "alpha\nbeta\ngamma\n";
+    }
+
+    {
+        Editor editor;
+        ASSERT_TRUE(editor.init(path, outPath));
+        ASSERT_TRUE(editor.runScript({ "i0", "first", "", "s2@al@Al@", "d4", "i3", "last", "", "s1 4@a@o@g" }));
+        ASSERT_STR_EQ(readFile(outPath), "first\nAlpho\nbeto\nlost\n");
+    }
+
+    {
+        Editor editor;
+        ASSERT_TRUE(editor.init(path, outPath));
+        std::ostringstream err;
+        std::streambuf* oldErr = std::cerr.rdbuf(err.rdbuf());
+        bool ok = editor.runScript({ "i3", "gone", "", "s4@go@GO@", "d4", "d1", "s1@beta@B@", "s1@zzz@Z@", "s1@B@b@" });
+        std::cerr.rdbuf(oldErr);
+        ASSERT_FALSE(ok);
+        ASSERT_TRUE(err.str().find("脚本第 8 行出错") != std::string::npos);
+        // 与逐条执行一样放弃全部输出
+        ASSERT_TRUE(readFile(outPath).empty());
+    }
+
+    std::remove(path.c_str());
+    std::remove(outPath.c_str());
+    return true;
+}
+
+REGISTER_TEST(EditPlan, EditPlan_MatchesSequential);
+REGISTER_TEST(EditPlan, EditPlan_DropsCancelledEdits);
+REGISTER_TEST(EditPlan, EditPlan_Script);
@@ -135,6 +135,17 @@ TempFile createTestInputFile() {
     );
 }
 
+// 用给定的命令驱动 Editor::run，屏蔽终端输出
+void runSession(Editor& editor, const std::string& commands) {
+    std::istringstream in(commands);
+    std::ostringstream out;
+    std::streambuf* oldIn = std::cin.rdbuf(in.rdbuf());
+    std::streambuf* oldOut = std::cout.rdbuf(out.rdbuf());
+    editor.run();
+    std::cin.rdbuf(oldIn);
+    std::cout.rdbuf(oldOut);
+}
+
 } // anonymous namespace
 
 // Test: 编辑器初始化
@@ -152,14 +163,17 @@ TEST(Editor_Init) {
     return true;
 }
 
-// Test: 输入输出文件不能相同
+// Test: 输入输出文件相同时原地编辑
 TEST(Editor_SameInputOutputFile) {
     TempFile file("test content");
 
     Editor editor;
     bool success = editor.init(file.path(), file.path());
 
-    ASSERT_FALSE(success);
+    ASSERT_TRUE(success);
+    runSession(editor, "s1@test@edited\nq\n");
+
+    ASSERT_STR_EQ(file.readContent(), "edited content\n");
 
     return true;
 }
@@ -346,7 +360,7 @@ TEST(Editor_ActiveZoneFindPattern) {
     zone.appendLine(new Line("Hello Universe"));
     zone.appendLine(new Line("Goodbye World"));
 
-    std::vector<int> matches = zone.findPattern("Hello");
+    std::vector<LineNo> matches = zone.findPattern("Hello");
 
     ASSERT_EQ(matches.size(), 2);
     ASSERT_EQ(matches[0], 1);
@@ -488,6 +502,146 @@ TEST(Editor_FullWorkflow) {
     return true;
 }
 
+// Test: 退出时活区之后的输入原样写入输出
+TEST(Editor_QuitPassesThroughTail) {
+    std::string content;
+    for (int i = 1; i <= 300; i++) {
+        content += "Line " + std::to_string(i) + "\n";
+    }
+    TempFile inputFile(content);
+    TempFile outputFile;
+
+    Editor editor;
+    ASSERT_TRUE(editor.init(inputFile.path(), outputFile.path()));
+    runSession(editor, "d1\nq\n");
+
+    std::string expected = content.substr(content.find("Line 2\n"));
+    ASSERT_TRUE(outputFile.readContent() == expected);
+
+    return true;
+}
+
+// Test: 脚本模式执行命令，插入文本取自后续行且不输出界面信息
+TEST(Editor_RunScript) {
+    TempFile inputFile("alpha\nbeta\ngamma\n");
+    TempFile outputFile;
+
+    Editor editor;
+    ASSERT_TRUE(editor.init(inputFile.path(), outputFile.path()));
+
+    std::ostringstream out;
+    std::streambuf* oldOut = std::cout.rdbuf(out.rdbuf());
+    editor.runScript({ "d1", "i1", "inserted", "", "s3@gamma@delta" });
+    std::cout.rdbuf(oldOut);
+
+    ASSERT_STR_EQ(outputFile.readContent(), "beta\ninserted\ndelta\n");
+    ASSERT_TRUE(out.str().empty());
+
+    return true;
+}
+
+// Test: 脚本模式只写出 p 和 m 的结果，全部成功时返回 true
+TEST(Editor_RunScriptOutput) {
+    TempFile inputFile("alpha\nbeta\ngamma\n");
+    TempFile outputFile;
+
+    Editor editor;
+    ASSERT_TRUE(editor.init(inputFile.path(), outputFile.path()));
+
+    std::ostringstream out;
+    std::streambuf* oldOut = std::cout.rdbuf(out.rdbuf());
+    std::istringstream script("mta\ns2@beta@BETA@\nmzzz\np\n");
+    bool ok = editor.runScript(script);
+    std::cout.rdbuf(oldOut);
+
+    ASSERT_TRUE(ok);
+    ASSERT_STR_EQ(outputFile.readContent(), "alpha\nBETA\ngamma\n");
+    std::string printed = out.str();
+    ASSERT_TRUE(printed.find("模式 'ta' 在以下行中找到: 2\n") == 0);
+    ASSERT_TRUE(printed.find("未找到模式 'zzz'\n") != std::string::npos);
+    ASSERT_TRUE(printed.find("BETA") != std::string::npos);
+    ASSERT_TRUE(printed.find("已") == std::string::npos);
+
+    return true;
+}
+
+// Test: 脚本中的命令出错时停止执行、放弃输出并返回 false，错误信息带脚本行号
+TEST(Editor_RunScriptStopsOnError) {
+    TempFile inputFile("alpha\nbeta\ngamma\n");
+    TempFile outputFile;
+
+    Editor editor;
+    ASSERT_TRUE(editor.init(inputFile.path(), outputFile.path()));
+
+    std::ostringstream err;
+    std::streambuf* oldErr = std::cerr.rdbuf(err.rdbuf());
+    bool ok = editor.runScript({ "i1", "inserted", "", "d9", "d1" });
+    std::cerr.rdbuf(oldErr);
+
+    ASSERT_FALSE(ok);
+    ASSERT_TRUE(err.str().find("脚本第 4 行出错") != std::string::npos);
+    ASSERT_TRUE(outputFile.readContent().empty());
+    ASSERT_EQ(editor.zone().lineCount(), 4);
+
+    return true;
+}
+
+// Test: 脚本模式的输出先写临时文件：n 已经写出活区后再出错，原有的输出文件保持原样
+TEST(Editor_RunScriptKeepsOutput) {
+    std::string input;
+    for (int i = 1; i <= 200; i++) {
+        input += "line " + std::to_string(i) + "\n";
+    }
+    TempFile inputFile(input);
+    TempFile outputFile("previous\n");
+
+    {
+        Editor editor;
+        editor.setAtomicOutput(true);
+        ASSERT_TRUE(editor.init(inputFile.path(), outputFile.path()));
+        std::ostringstream err;
+        std::streambuf* oldErr = std::cerr.rdbuf(err.rdbuf());
+        bool ok = editor.runScript({ "n", "s5@zzz@y@" });
+        std::cerr.rdbuf(oldErr);
+        ASSERT_FALSE(ok);
+    }
+    ASSERT_STR_EQ(outputFile.readContent(), "previous\n");
+
+    {
+        Editor editor;
+        editor.setAtomicOutput(true);
+        ASSERT_TRUE(editor.init(inputFile.path(), outputFile.path()));
+        ASSERT_TRUE(editor.runScript({ "n", "s85@line@LINE@" }));
+    }
+    std::string expected = input;
+    expected.replace(expected.find("line 85"), 4, "LINE");
+    ASSERT_STR_EQ(outputFile.readContent(), expected);
+
+    return true;
+}
+
+// Test: 脚本模式原地编辑时不直接回写：长度不变的替换之后再出错，原文件保持原样
+TEST(Editor_RunScriptKeepsInPlaceFile) {
+    std::string input;
+    for (int i = 1; i <= 200; i++) {
+        input += std::to_string(i) + "\n";
+    }
+    TempFile file(input);
+
+    Editor editor;
+    editor.setAtomicOutput(true);
+    ASSERT_TRUE(editor.init(file.path(), file.path()));
+    std::ostringstream err;
+    std::streambuf* oldErr = std::cerr.rdbuf(err.rdbuf());
+    bool ok = editor.runScript({ "s1@1@9@", "n", "s999@zzz@y@" });
+    std::cerr.rdbuf(oldErr);
+
+    ASSERT_FALSE(ok);
+    ASSERT_STR_EQ(file.readContent(), input);
+
+    return true;
+}
+
 // 注册测试
 REGISTER_TEST(EditorIntegration, Editor_Init);
 REGISTER_TEST(EditorIntegration, Editor_SameInputOutputFile);
@@ -508,3 +662,9 @@ REGISTER_TEST(EditorIntegration, Editor_ActiveZoneMaxLines);
 REGISTER_TEST(EditorIntegration, Editor_FileManagerRead);
 REGISTER_TEST(EditorIntegration, Editor_FileManagerWrite);
 REGISTER_TEST(EditorIntegration, Editor_FullWorkflow);
+REGISTER_TEST(EditorIntegration, Editor_QuitPassesThroughTail);
+REGISTER_TEST(EditorIntegration, Editor_RunScript);
+REGISTER_TEST(EditorIntegration, Editor_RunScriptOutput);
+REGISTER_TEST(EditorIntegration, Editor_RunScriptStopsOnError);
+REGISTER_TEST(EditorIntegration, Editor_RunScriptKeepsOutput);
+REGISTER_TEST(EditorIntegration, Editor_RunScriptKeepsInPlaceFile);
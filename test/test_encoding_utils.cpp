@@ -0,0 +1,195 @@
+#include "../include/encoding_utils.h"
+#include "../include/file_manager.h"
+#include "../include/error.h"
+#include "test_framework.h"
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#ifdef _WIN32
+#include <windows.h>
+#undef DELETE
+#undef INSERT
+#endif
+
+using namespace line_editor;
+
+namespace {
+
+// 跨平台获取临时目录
+std::string getTempDir() {
+#ifdef _WIN32
+    char tempPath[MAX_PATH];
+    DWORD result = GetTempPathA(MAX_PATH, tempPath);
+    if (result > 0 && result < MAX_PATH) {
+        return std::string(tempPath);
+    }
+    return ".";
+#else
+    const char* tmp = std::getenv("TMPDIR");
+    if (tmp) return tmp;
+    tmp = std::getenv("TEMP");
+    if (tmp) return tmp;
+    tmp = std::getenv("TMP");
+    if (tmp) return tmp;
+    return "/tmp";
+#endif
+}
+
+// 测试用临时文件管理（二进制写入）
+class TempFile {
+    std::string path_;
+public:
+    explicit TempFile(const std::string& content) {
+        std::string tempDir = getTempDir();
+        if (!tempDir.empty() && tempDir.back() != '/' && tempDir.back() != '\\') {
+#ifdef _WIN32
+            tempDir += '\\';
+#else
+            tempDir += '/';
+#endif
+        }
+        path_ = tempDir + "line_editor_test_" + std::to_string(rand()) + ".txt";
+        std::ofstream ofs(path_, std::ios::binary | std::ios::trunc);
+        ofs << content;
+    }
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    ~TempFile() {
+        std::remove(path_.c_str());
+    }
+
+    std::string path() const { return path_; }
+};
+
+bool valid(const std::string& s) {
+    return validateUtf8(s.data(), s.size());
+}
+
+} // anonymous namespace
+
+// Test: 纯 ASCII 检测（覆盖向量路径和尾部）
+TEST(Encoding_IsAscii) {
+    std::string text(200, 'a');
+    ASSERT_TRUE(isAscii(text.data(), text.size()));
+    ASSERT_TRUE(isAscii("", 0));
+
+    for (size_t pos : {0u, 15u, 16u, 63u, 64u, 130u, 199u}) {
+        std::string t = text;
+        t[pos] = static_cast<char>(0xC3);
+        ASSERT_FALSE(isAscii(t.data(), t.size()));
+    }
+
+    return true;
+}
+
+// Test: 合法 UTF-8
+TEST(Encoding_ValidUtf8) {
+    ASSERT_TRUE(valid("hello"));
+    ASSERT_TRUE(valid("caf\xC3\xA9"));
+    ASSERT_TRUE(valid("\xE4\xB8\xAD\xE6\x96\x87"));              // 中文
+    ASSERT_TRUE(valid("\xF0\x9F\x98\x80"));                      // U+1F600
+    ASSERT_TRUE(valid("\xF4\x8F\xBF\xBF"));                      // U+10FFFF
+    ASSERT_TRUE(valid(std::string(100, 'x') + "\xE2\x82\xAC" + std::string(100, 'y')));
+
+    return true;
+}
+
+// Test: 非法 UTF-8
+TEST(Encoding_InvalidUtf8) {
+    ASSERT_FALSE(valid("\x80"));                  // 孤立的续字节
+    ASSERT_FALSE(valid("\xC0\xAF"));              // 过长编码
+    ASSERT_FALSE(valid("\xE0\x80\xAF"));          // 过长编码
+    ASSERT_FALSE(valid("\xED\xA0\x80"));          // 代理区
+    ASSERT_FALSE(valid("\xF4\x90\x80\x80"));      // 超出 U+10FFFF
+    ASSERT_FALSE(valid("\xF5\x80\x80\x80"));
+    ASSERT_FALSE(valid("abc\xE4\xB8"));           // 截断
+    ASSERT_FALSE(valid(std::string(70, 'x') + "\xFF"));
+
+    return true;
+}
+
+// Test: 按最大非法子序列替换为 U+FFFD
+TEST(Encoding_RepairUtf8) {
+    std::string out;
+
+    ASSERT_EQ(repairUtf8("ok", 2, out), 0u);
+    ASSERT_STR_EQ(out, "ok");
+
+    std::string bad = "a\xE4\xB8" "b";            // 截断的三字节序列算一处
+    ASSERT_EQ(repairUtf8(bad.data(), bad.size(), out), 1u);
+    ASSERT_STR_EQ(out, "a\xEF\xBF\xBD" "b");
+
+    bad = "\xC0\xAF";                              // 两个非法字节各算一处
+    ASSERT_EQ(repairUtf8(bad.data(), bad.size(), out), 2u);
+    ASSERT_STR_EQ(out, "\xEF\xBF\xBD\xEF\xBF\xBD");
+
+    ASSERT_TRUE(valid(out));
+
+    return true;
+}
+
+// Test: 解析模式名
+TEST(Encoding_ParseMode) {
+    Utf8Mode mode = Utf8Mode::PASS_THROUGH;
+    ASSERT_TRUE(parseUtf8Mode("reject", mode));
+    ASSERT_TRUE(mode == Utf8Mode::REJECT);
+    ASSERT_TRUE(parseUtf8Mode("replace", mode));
+    ASSERT_TRUE(mode == Utf8Mode::REPLACE);
+    ASSERT_TRUE(parseUtf8Mode("pass", mode));
+    ASSERT_TRUE(mode == Utf8Mode::PASS_THROUGH);
+    ASSERT_FALSE(parseUtf8Mode("strict", mode));
+
+    return true;
+}
+
+// Test: 加载时按模式处理非法行
+TEST(Encoding_FileManagerModes) {
+    TempFile file("good\nba\xFF" "d\nend\n");
+
+    {
+        FileManager fm;
+        fm.openInput(file.path());
+        std::vector<std::string> lines;
+        fm.readLines(lines, 10);
+        ASSERT_EQ(lines.size(), 3u);
+        ASSERT_STR_EQ(lines[1], "ba\xFF" "d");
+        ASSERT_EQ(fm.invalidUtf8Lines(), 0);
+    }
+
+    {
+        FileManager fm;
+        fm.setUtf8Mode(Utf8Mode::REPLACE);
+        fm.openInput(file.path());
+        std::vector<std::string> lines;
+        fm.readLines(lines, 10);
+        ASSERT_EQ(lines.size(), 3u);
+        ASSERT_STR_EQ(lines[1], "ba\xEF\xBF\xBD" "d");
+        ASSERT_EQ(fm.invalidUtf8Lines(), 1);
+    }
+
+    {
+        FileManager fm;
+        fm.setUtf8Mode(Utf8Mode::REJECT);
+        fm.openInput(file.path());
+        std::vector<std::string> lines;
+        bool caught = false;
+        try {
+            fm.readLines(lines, 10);
+        } catch (const EditorException& e) {
+            caught = true;
+            ASSERT_EQ(static_cast<int>(e.code()), static_cast<int>(ErrorCode::INVALID_ENCODING));
+        }
+        ASSERT_TRUE(caught);
+    }
+
+    return true;
+}
+
+REGISTER_TEST(Encoding, Encoding_IsAscii);
+REGISTER_TEST(Encoding, Encoding_ValidUtf8);
+REGISTER_TEST(Encoding, Encoding_InvalidUtf8);
+REGISTER_TEST(Encoding, Encoding_RepairUtf8);
+REGISTER_TEST(Encoding, Encoding_ParseMode);
+REGISTER_TEST(Encoding, Encoding_FileManagerModes);
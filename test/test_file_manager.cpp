@@ -0,0 +1,345 @@
+#include "../include/file_manager.h"
+#include "../include/error.h"
+#include "test_framework.h"
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#ifdef _WIN32
+#include <windows.h>
+#undef DELETE
+#undef INSERT
+#endif
+
+using namespace line_editor;
+
+namespace {
+
+// 跨平台获取临时目录
+std::string getTempDir() {
+#ifdef _WIN32
+    char tempPath[MAX_PATH];
+    DWORD result = GetTempPathA(MAX_PATH, tempPath);
+    if (result > 0 && result < MAX_PATH) {
+        return std::string(tempPath);
+    }
+    return ".";
+#else
+    const char* tmp = std::getenv("TMPDIR");
+    if (tmp) return tmp;
+    tmp = std::getenv("TEMP");
+    if (tmp) return tmp;
+    tmp = std::getenv("TMP");
+    if (tmp) return tmp;
+    return "/tmp";
+#endif
+}
+
+// 测试用临时文件管理
+class TempFile {
+    std::string path_;
+public:
+    explicit TempFile(const std::string& content, const std::string& suffix = ".txt") {
+        std::string tempDir = getTempDir();
+        if (!tempDir.empty() && tempDir.back() != '/' && tempDir.back() != '\\') {
+#ifdef _WIN32
+            tempDir += '\\';
+#else
+            tempDir += '/';
+#endif
+        }
+        path_ = tempDir + "line_editor_test_" + std::to_string(rand()) + suffix;
+        std::ofstream ofs(path_, std::ios::binary | std::ios::trunc);
+        ofs << content;
+    }
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    ~TempFile() {
+        std::remove(path_.c_str());
+    }
+
+    std::string path() const { return path_; }
+
+    std::string readContent() const {
+        std::ifstream ifs(path_, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(ifs)),
+                           std::istreambuf_iterator<char>());
+    }
+};
+
+std::string numberedLines(int count) {
+    std::string content;
+    for (int i = 1; i <= count; i++) {
+        content += "Line " + std::to_string(i) + "\n";
+    }
+    return content;
+}
+
+} // anonymous namespace
+
+// Test: 剩余输入原样追加到输出
+TEST(FileManager_CopyRemainingInput) {
+    std::string content = numberedLines(200);
+    TempFile input(content);
+    TempFile output("");
+
+    FileManager fm;
+    fm.openInput(input.path());
+    fm.openOutput(output.path());
+
+    std::vector<std::string> lines;
+    ASSERT_EQ(fm.readLines(lines, 80), 80);
+    fm.writeLines(lines);
+
+    unsigned long long copied = fm.copyRemainingInput();
+    ASSERT_TRUE(fm.isInputEof());
+    fm.close();
+
+    ASSERT_EQ(copied, content.size() - content.find("Line 81"));
+    ASSERT_TRUE(output.readContent() == content);
+
+    return true;
+}
+
+// Test: 没有末尾换行的输入保持原样
+TEST(FileManager_CopyRemainingKeepsMissingNewline) {
+    TempFile input("a\nb\nc");
+    TempFile output("");
+
+    FileManager fm;
+    fm.openInput(input.path());
+    fm.openOutput(output.path());
+
+    fm.writeLine(fm.readLine());
+    fm.copyRemainingInput();
+    fm.writeLine("");   // 复制之后继续写入应追加在末尾
+    fm.close();
+
+    ASSERT_STR_EQ(output.readContent(), "a\nb\nc\n");
+
+    return true;
+}
+
+// Test: 输入已读完时不复制
+TEST(FileManager_CopyRemainingAtEof) {
+    TempFile input("only\n");
+    TempFile output("");
+
+    FileManager fm;
+    fm.openInput(input.path());
+    fm.openOutput(output.path());
+
+    std::vector<std::string> lines;
+    fm.readLines(lines, 80);
+    fm.writeLines(lines);
+    ASSERT_EQ(fm.copyRemainingInput(), 0u);
+    fm.close();
+
+    ASSERT_STR_EQ(output.readContent(), "only\n");
+
+    return true;
+}
+
+// Test: 压缩输入走流缓冲复制路径
+TEST(FileManager_CopyRemainingCompressed) {
+    if (!isCompressionSupported(Compression::GZIP)) {
+        return true;
+    }
+
+    std::string content = numberedLines(500);
+    TempFile compressed("", ".gz");
+    {
+        FileManager writer;
+        writer.openOutput(compressed.path());
+        for (size_t pos = 0; pos < content.size(); ) {
+            size_t nl = content.find('\n', pos);
+            writer.writeLine(content.substr(pos, nl - pos));
+            pos = nl + 1;
+        }
+        writer.close();
+    }
+
+    TempFile output("");
+    FileManager fm;
+    fm.openInput(compressed.path());
+    fm.openOutput(output.path());
+
+    std::vector<std::string> lines;
+    fm.readLines(lines, 80);
+    fm.writeLines(lines);
+    fm.copyRemainingInput();
+    fm.close();
+
+    ASSERT_TRUE(output.readContent() == content);
+
+    return true;
+}
+
+// Test: 等长修改直接回写原文件
+TEST(FileManager_InPlaceSameLengthPatch) {
+    std::string content = numberedLines(200);
+    TempFile file(content);
+
+    FileManager fm;
+    ASSERT_TRUE(fm.openInPlace(file.path()));
+    ASSERT_TRUE(fm.isPatchingInPlace());
+
+    std::vector<std::string> lines;
+    fm.readLines(lines, 80);
+    lines[4] = "LINE 5";
+    fm.writeLines(lines);
+
+    // 读下一段时确认长度一致，仍在原文件上回写
+    fm.readLines(lines, 80);
+    ASSERT_TRUE(fm.isPatchingInPlace());
+    fm.writeLines(lines);
+    fm.close();
+
+    std::string expected = content;
+    expected.replace(expected.find("Line 5\n"), 6, "LINE 5");
+    ASSERT_TRUE(file.readContent() == expected);
+
+    return true;
+}
+
+// Test: 长度变化后改写临时文件并替换原文件
+TEST(FileManager_InPlaceLengthChange) {
+    std::string content = numberedLines(200);
+    TempFile file(content);
+
+    FileManager fm;
+    fm.openInPlace(file.path());
+
+    std::vector<std::string> lines;
+    fm.readLines(lines, 80);
+    lines.erase(lines.begin());
+    fm.writeLines(lines);
+
+    fm.readLines(lines, 80);
+    ASSERT_FALSE(fm.isPatchingInPlace());
+    ASSERT_STR_EQ(fm.outputFilename(), file.path());
+    fm.writeLines(lines);
+    fm.close();
+
+    ASSERT_TRUE(file.readContent() == content.substr(content.find("Line 2\n")));
+
+    return true;
+}
+
+// Test: 不同路径指向同一文件
+TEST(FileManager_IsSameFile) {
+    TempFile file("x\n");
+    TempFile other("y\n");
+
+    ASSERT_TRUE(FileManager::isSameFile(file.path(), file.path()));
+    ASSERT_FALSE(FileManager::isSameFile(file.path(), other.path()));
+    ASSERT_FALSE(FileManager::isSameFile(file.path(), ""));
+    ASSERT_FALSE(FileManager::isSameFile(STDIO_FILENAME, STDIO_FILENAME));
+#ifndef _WIN32
+    std::string path = file.path();
+    std::string dotted = path.substr(0, path.find_last_of('/')) + "/./" +
+                         path.substr(path.find_last_of('/') + 1);
+    ASSERT_TRUE(FileManager::isSameFile(file.path(), dotted));
+#endif
+
+    return true;
+}
+
+// Test: 预读不消费数据，位置只计算已交出的字节
+TEST(FdStream_PeekAndPosition) {
+    TempFile file("\x1F\x8B rest of data\n");
+
+    FdStreamBuf buf;
+    ASSERT_TRUE(buf.open(file.path(), FdStreamBuf::Mode::READ));
+
+    char magic[2] = {0};
+    ASSERT_EQ(static_cast<int>(buf.peek(magic, 2)), 2);
+    ASSERT_TRUE(magic[0] == '\x1F' && magic[1] == '\x8B');
+    ASSERT_EQ(buf.position(), 0);
+
+    std::istream in(&buf);
+    std::string first;
+    std::getline(in, first);
+    ASSERT_STR_EQ(first, "\x1F\x8B rest of data");
+    ASSERT_EQ(buf.position(), 16);
+    ASSERT_TRUE(buf.close());
+
+    return true;
+}
+
+// Test: 描述符之间复制指定长度和剩余全部数据
+TEST(FdStream_CopyFdData) {
+    std::string content;
+    for (int i = 0; i < 10000; i++) {
+        content += "row " + std::to_string(i) + "\n";
+    }
+    TempFile source(content);
+    TempFile target("");
+
+    FdStreamBuf in, out;
+    ASSERT_TRUE(in.open(source.path(), FdStreamBuf::Mode::READ));
+    ASSERT_TRUE(out.open(target.path(), FdStreamBuf::Mode::WRITE));
+
+    ASSERT_EQ(copyFdData(in.fd(), out.fd(), 100), 100ULL);
+    ASSERT_EQ(copyFdData(in.fd(), out.fd()), static_cast<unsigned long long>(content.size() - 100));
+    ASSERT_TRUE(out.close());
+
+    ASSERT_TRUE(target.readContent() == content);
+
+    return true;
+}
+
+// Test: 绕过页缓存时内容与普通读写一致（含非对齐的收尾和尾部复制）
+TEST(FileManager_CacheBypassRoundTrip) {
+    std::string content;
+    for (int i = 0; i < 30000; i++) {
+        content += "bypass line " + std::to_string(i) + "\n";
+    }
+    content += "no newline at end";
+    TempFile input(content);
+    TempFile output("");
+
+    {
+        FileManager fm;
+        fm.setCacheBypass(true);
+        fm.openInput(input.path());
+        fm.openOutput(output.path());
+
+        std::vector<std::string> lines;
+        ASSERT_EQ(fm.readLines(lines, 10000), 10000);
+        fm.writeLines(lines);
+        fm.copyRemainingInput();
+        fm.close();
+    }
+    ASSERT_TRUE(output.readContent() == content);
+
+    {
+        FileManager fm;
+        fm.setCacheBypass(true);
+        fm.openInput(output.path());
+        std::vector<std::string> lines;
+        std::string last;
+        long long total = 0;
+        int n;
+        while ((n = fm.readLines(lines, 4096)) > 0) {
+            total += n;
+            last = lines.back();
+        }
+        ASSERT_EQ(total, 30001);
+        ASSERT_STR_EQ(last, "no newline at end");
+    }
+
+    return true;
+}
+
+REGISTER_TEST(FileManager, FileManager_CopyRemainingInput);
+REGISTER_TEST(FileManager, FileManager_CopyRemainingKeepsMissingNewline);
+REGISTER_TEST(FileManager, FileManager_CopyRemainingAtEof);
+REGISTER_TEST(FileManager, FileManager_CopyRemainingCompressed);
+REGISTER_TEST(FileManager, FileManager_InPlaceSameLengthPatch);
+REGISTER_TEST(FileManager, FileManager_InPlaceLengthChange);
+REGISTER_TEST(FileManager, FileManager_IsSameFile);
+REGISTER_TEST(FileManager, FdStream_PeekAndPosition);
+REGISTER_TEST(FileManager, FdStream_CopyFdData);
+REGISTER_TEST(FileManager, FileManager_CacheBypassRoundTrip);
@@ -0,0 +1,315 @@
+#include "../include/file_search.h"
+#include "../include/active_zone.h"
+#include "../include/command_executor.h"
+#include "../include/command_parser.h"
+#include "../include/file_manager.h"
+#include "test_framework.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+// 按 std::getline 的规则逐行检查
+template <typename Pred>
+std::vector<LineNo> bruteForce(const std::string& text, Pred pred) {
+    std::vector<LineNo> lines;
+    size_t start = 0;
+    LineNo lineNo = 1;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        if (pred(text.substr(start, end - start))) {
+            lines.push_back(lineNo);
+        }
+        lineNo++;
+        start = end + 1;
+    }
+    return lines;
+}
+
+std::string randomText(unsigned seed, size_t size) {
+    static const char alphabet[] = "abcab\n\r";
+    std::string text;
+    for (size_t i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        text += alphabet[(seed >> 16) % 7];
+    }
+    return text;
+}
+
+std::string tempPath(const std::string& name) {
+    const char* dir = std::getenv("TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/line_editor_file_search_" + name;
+}
+
+} // anonymous namespace
+
+// Test: 任意分块和线程数下，结果都与逐行查找一致且按行号排序
+TEST(FileSearch_MatchesBruteForce) {
+    size_t chunks[] = { 1, 7, 64, 1 << 20 };
+    unsigned threads[] = { 1, 3, 8 };
+    for (unsigned round = 0; round < 12; round++) {
+        std::string text = randomText(round + 1, round * 97 + (round % 2 ? 0 : 1));
+        Searcher searcher("ab");
+        std::vector<LineNo> expected = bruteForce(text, [](const std::string& line) {
+            return line.find("ab") != std::string::npos;
+        });
+        for (size_t chunk : chunks) {
+            for (unsigned t : threads) {
+                ParallelSearchOptions options;
+                options.chunkBytes = chunk;
+                options.threads = t;
+                if (findLinesParallel(text.data(), text.size(), searcher, options) != expected) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Test: 空行、末尾无换行的行、\r 保留在行内
+TEST(FileSearch_LineBoundaries) {
+    std::string text = "x\n\nab\r\nzz\nab";
+    ParallelSearchOptions options;
+    options.chunkBytes = 3;
+    options.threads = 2;
+
+    std::vector<LineNo> lines = findLinesParallel(text.data(), text.size(), Searcher("ab"), options);
+    ASSERT_EQ(lines.size(), 2);
+    ASSERT_EQ(lines[0], 3);
+    ASSERT_EQ(lines[1], 5);
+
+    Regex crlf("b\r$");
+    lines = findLinesParallel(text.data(), text.size(), crlf, options);
+    ASSERT_EQ(lines.size(), 1);
+    ASSERT_EQ(lines[0], 3);
+
+    Regex empty("^$");
+    lines = findLinesParallel(text.data(), text.size(), empty, options);
+    ASSERT_EQ(lines.size(), 1);
+    ASSERT_EQ(lines[0], 2);
+
+    ASSERT_TRUE(findLinesParallel(text.data(), text.size(), Searcher("b\nz"), options).empty());
+    ASSERT_TRUE(findLinesParallel(nullptr, 0, Searcher("ab"), options).empty());
+
+    return true;
+}
+
+// Test: 正则（含不区分大小写）与多模式在多线程下与逐行结果一致
+TEST(FileSearch_RegexAndMulti) {
+    std::string text;
+    for (int i = 0; i < 3000; i++) {
+        text += (i % 7 == 0) ? "ERROR code=" : "info code=";
+        text += std::to_string(i * 13 % 1000);
+        text += (i % 11 == 0) ? " Timeout\n" : "\n";
+    }
+    ParallelSearchOptions options;
+    options.chunkBytes = 4096;
+    options.threads = 4;
+
+    Regex regex("^error code=\\d+5 timeout$", true);
+    std::vector<LineNo> expected = bruteForce(text, [&](const std::string& line) {
+        return regex.search(line.data(), line.size());
+    });
+    ASSERT_FALSE(expected.empty());
+    ASSERT_TRUE(findLinesParallel(text.data(), text.size(), regex, options) == expected);
+
+    Regex noLiteral("^[a-z]+ code=9");
+    expected = bruteForce(text, [&](const std::string& line) {
+        return noLiteral.search(line.data(), line.size());
+    });
+    ASSERT_TRUE(findLinesParallel(text.data(), text.size(), noLiteral, options) == expected);
+
+    MultiSearcher multi({ "=123", "=7\n", "Timeout" });
+    expected = bruteForce(text, [](const std::string& line) {
+        return line.find("=123") != std::string::npos || line.find("Timeout") != std::string::npos;
+    });
+    ASSERT_TRUE(findLinesParallel(text.data(), text.size(), multi, options) == expected);
+
+    return true;
+}
+
+// Test: 映射文件；空文件和不存在的文件
+TEST(FileSearch_MappedFile) {
+    std::string path = tempPath("mapped.txt");
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "one\ntwo\nthree\n";
+    }
+    MappedFile file;
+    ASSERT_TRUE(file.open(path));
+    ASSERT_EQ(file.size(), 14);
+    ASSERT_EQ(std::string(file.data(), 3), "one");
+    std::vector<LineNo> lines = findLinesParallel(file.data(), file.size(), Searcher("t"));
+    ASSERT_EQ(lines.size(), 2);
+    ASSERT_EQ(lines[0], 2);
+    file.close();
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    }
+    ASSERT_TRUE(file.open(path));
+    ASSERT_EQ(file.size(), 0);
+    ASSERT_TRUE(file.data() == nullptr);
+    file.close();
+    std::remove(path.c_str());
+
+    ASSERT_FALSE(file.open(path));
+    ASSERT_FALSE(file.isOpen());
+
+    return true;
+}
+
+// Test: M 与 m 的区分，g<行号> 的解析
+TEST(FileSearch_ParseCommand) {
+    CommandParser parser;
+    ASSERT_TRUE(parser.parse("M disk").type == CommandType::FILE_MATCH);
+    ASSERT_STR_EQ(parser.parse("M disk").pattern, " disk");
+    ASSERT_TRUE(parser.parse("m disk").type == CommandType::MATCH);
+
+    Command regex = parser.parse("M/err\\d/i");
+    ASSERT_TRUE(regex.type == CommandType::FILE_MATCH);
+    ASSERT_TRUE(regex.regex);
+    ASSERT_TRUE(regex.ignoreCase);
+    ASSERT_EQ(parser.parse("M|a|b").patterns.size(), 2);
+
+    Command jump = parser.parse("g120");
+    ASSERT_TRUE(jump.type == CommandType::GOTO);
+    ASSERT_EQ(jump.lineNo, 120);
+
+    const char* invalid[] = { "M", "g", "g0", "gx" };
+    for (const char* input : invalid) {
+        try {
+            parser.parse(input);
+            return false;
+        } catch (const EditorException&) {
+        }
+    }
+
+    return true;
+}
+
+// Test: 在输入文件上执行 M，再用 g 跳到命中行所在的活区
+TEST(FileSearch_ExecuteAndJump) {
+    std::string inPath = tempPath("input.txt");
+    std::string outPath = tempPath("output.txt");
+    {
+        std::ofstream out(inPath, std::ios::binary);
+        out << "\xEF\xBB\xBF";
+        for (int i = 1; i <= 300; i++) {
+            out << "line " << i << (i % 100 == 50 ? " needle" : "") << "\n";
+        }
+    }
+
+    ActiveZone zone;
+    FileManager fileMgr;
+    fileMgr.openInput(inPath);
+    fileMgr.openOutput(outPath);
+    std::vector<std::string> lines;
+    fileMgr.readLines(lines, 80);
+    for (const std::string& line : lines) {
+        zone.appendLine(new Line(line.c_str()));
+    }
+    CommandExecutor executor(zone, fileMgr);
+    CommandParser parser;
+
+    Command cmd = parser.parse("Mneedle");
+    ExecutionResult result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("3 行中找到: 50, 150, 250") != std::string::npos);
+
+    cmd = parser.parse("M/^line 1$/");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("1 行中找到: 1\n") != std::string::npos);
+
+    cmd = parser.parse("g150");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_EQ(zone.startLineNo(), 81);
+    Line* hit = zone.getLineByNumber(150);
+    ASSERT_TRUE(hit != nullptr);
+    ASSERT_STR_EQ(hit->getText(), "line 150 needle");
+
+    cmd = parser.parse("g40");
+    result = executor.execute(cmd);
+    ASSERT_FALSE(result.ok());
+    cmd = parser.parse("g301");
+    result = executor.execute(cmd);
+    ASSERT_FALSE(result.ok());
+
+    fileMgr.close();
+    std::remove(inPath.c_str());
+    std::remove(outPath.c_str());
+
+    FileManager noInput;
+    CommandExecutor standalone(zone, noInput);
+    ASSERT_FALSE(standalone.execute(parser.parse("Mneedle")).ok());
+    ASSERT_FALSE(standalone.execute(parser.parse("g1")).ok());
+
+    return true;
+}
+
+// Test: 活区编辑过之后，g 报告目标输入行现在所在的活区行号
+TEST(FileSearch_JumpAfterEdit) {
+    std::string inPath = tempPath("edited.txt");
+    {
+        std::ofstream out(inPath, std::ios::binary);
+        for (int i = 1; i <= 200; i++) {
+            out << "line " << i << "\n";
+        }
+    }
+
+    ActiveZone zone;
+    FileManager fileMgr;
+    fileMgr.openInput(inPath);
+    CommandExecutor executor(zone, fileMgr);
+    CommandParser parser;
+    ASSERT_TRUE(executor.execute(parser.parse("n")).ok());
+
+    executor.execute(parser.parse("d1 10"));
+    Command cmd = parser.parse("g50");
+    ExecutionResult result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_EQ(result.lineNo, 40);
+    ASSERT_STR_EQ(result.message(cmd), "输入第 50 行位于活区第 40 行（跳过 0 个活区）");
+    ASSERT_STR_EQ(zone.getLineByNumber(result.lineNo)->getText(), "line 50");
+
+    // 按编辑计划执行的插入和删除同样保留每行的来源
+    EditPlan plan(zone.startLineNo(), zone.lineCount(), zone.maxLines());
+    plan.insert(0, "new");
+    plan.erase(2, 3);
+    zone.apply(plan);
+    result = executor.execute(parser.parse("g60"));
+    ASSERT_TRUE(result.ok());
+    ASSERT_STR_EQ(zone.getLineByNumber(result.lineNo)->getText(), "line 60");
+
+    executor.execute(parser.parse("s49@line@LINE@"));
+    result = executor.execute(parser.parse("g60"));
+    ASSERT_EQ(result.lineNo, 49);
+    ASSERT_STR_EQ(zone.getLineByNumber(49)->getText(), "LINE 60");
+
+    executor.execute(parser.parse("d49"));
+    ASSERT_FALSE(executor.execute(parser.parse("g60")).ok());
+
+    fileMgr.close();
+    std::remove(inPath.c_str());
+    return true;
+}
+
+REGISTER_TEST(FileSearch, FileSearch_MatchesBruteForce);
+REGISTER_TEST(FileSearch, FileSearch_LineBoundaries);
+REGISTER_TEST(FileSearch, FileSearch_RegexAndMulti);
+REGISTER_TEST(FileSearch, FileSearch_MappedFile);
+REGISTER_TEST(FileSearch, FileSearch_ParseCommand);
+REGISTER_TEST(FileSearch, FileSearch_ExecuteAndJump);
+REGISTER_TEST(FileSearch, FileSearch_JumpAfterEdit);
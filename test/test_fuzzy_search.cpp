@@ -0,0 +1,255 @@
+#include "../include/fuzzy_search.h"
+#include "../include/active_zone.h"
+#include "../include/command_executor.h"
+#include "../include/command_parser.h"
+#include "../include/error.h"
+#include "../include/file_manager.h"
+#include "../include/file_search.h"
+#include "../include/line.h"
+#include "test_framework.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+// Sellers 动态规划：text 中某个子串与 pattern 的最小编辑距离
+int bestDistance(const std::string& pattern, const std::string& text) {
+    size_t m = pattern.size();
+    std::vector<int> column(m + 1);
+    for (size_t i = 0; i <= m; i++) {
+        column[i] = static_cast<int>(i);
+    }
+    int best = column[m];
+    for (char c : text) {
+        int diagonal = column[0];
+        column[0] = 0;
+        for (size_t i = 1; i <= m; i++) {
+            int up = column[i];
+            column[i] = std::min({ up + 1, column[i - 1] + 1, diagonal + (pattern[i - 1] == c ? 0 : 1) });
+            diagonal = up;
+        }
+        best = std::min(best, column[m]);
+    }
+    return best;
+}
+
+struct Random {
+    unsigned state;
+    unsigned next(unsigned range) {
+        state = state * 1103515245u + 12345u;
+        return (state >> 16) % range;
+    }
+    std::string text(size_t length, unsigned alphabet) {
+        std::string s;
+        for (size_t i = 0; i < length; i++) {
+            s += static_cast<char>('a' + next(alphabet));
+        }
+        return s;
+    }
+    // 对 source 做 edits 次随机插入、删除或替换
+    std::string corrupt(std::string source, int edits) {
+        for (int e = 0; e < edits && !source.empty(); e++) {
+            size_t at = next(static_cast<unsigned>(source.size()));
+            switch (next(3)) {
+                case 0: source.insert(at, 1, 'x'); break;
+                case 1: source.erase(at, 1); break;
+                default: source[at] = 'y'; break;
+            }
+        }
+        return source;
+    }
+};
+
+bool compileFails(const std::string& pattern, int maxErrors) {
+    try {
+        FuzzySearcher searcher(pattern, maxErrors);
+    } catch (const EditorException& e) {
+        return e.code() == ErrorCode::INVALID_PATTERN;
+    }
+    return false;
+}
+
+std::string tempPath(const std::string& name) {
+    const char* dir = std::getenv("TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/line_editor_fuzzy_" + name;
+}
+
+} // anonymous namespace
+
+// Test: 单字和多字的位并行比对与动态规划的结果一致，连续缓冲和块链两条路径相同
+TEST(Fuzzy_AgreesWithDp) {
+    Random random{ 2024 };
+    size_t lengths[] = { 3, 8, 63, 64, 65, 130, 200 };
+    for (size_t m : lengths) {
+        for (int k = 0; k <= 3 && static_cast<size_t>(k) < m; k++) {
+            for (int round = 0; round < 12; round++) {
+                std::string pattern = random.text(m, 4);
+                FuzzySearcher searcher(pattern, k);
+                std::string text = random.text(random.next(300), 4);
+                if (round % 2 == 0) {
+                    // 一半的文本中嵌入至多 k + 1 处改动的模式，覆盖刚好匹配和差一点的情况
+                    text.insert(random.next(static_cast<unsigned>(text.size()) + 1),
+                                random.corrupt(pattern, static_cast<int>(random.next(static_cast<unsigned>(k) + 2))));
+                }
+                bool expected = bestDistance(pattern, text) <= k;
+                Line line(text.c_str());
+                if (searcher.matches(text.data(), text.size()) != expected ||
+                    searcher.matches(line.head()) != expected ||
+                    searcher.verify(line.head()) != expected) {
+                    return false;
+                }
+            }
+        }
+    }
+    ASSERT_EQ(FuzzySearcher(std::string(130, 'a'), 1).wordCount(), 3);
+
+    return true;
+}
+
+// Test: 片段划分和参数检查
+TEST(Fuzzy_PiecesAndErrors) {
+    FuzzySearcher searcher("connection", 2);
+    std::vector<std::string> pieces = searcher.pieceLiterals();
+    ASSERT_EQ(pieces.size(), 3);
+    ASSERT_STR_EQ(pieces[0] + pieces[1] + pieces[2], "connection");
+
+    // 片段太短时不做预过滤，仍然正确
+    FuzzySearcher shortPieces("abcd", 2);
+    ASSERT_TRUE(shortPieces.pieces().empty());
+    ASSERT_TRUE(shortPieces.matches("xxaxcdxx", 8));
+    ASSERT_FALSE(shortPieces.matches("xxxxxxxx", 8));
+
+    ASSERT_TRUE(searcher.matches("conection refused", 17));
+    ASSERT_TRUE(searcher.matches("cOnnectlon", 10));
+    ASSERT_FALSE(searcher.matches("cOnnEctlon", 10));
+
+    ASSERT_TRUE(compileFails("", 1));
+    ASSERT_TRUE(compileFails("ab", 2));
+    ASSERT_TRUE(compileFails("abcdefghijklmn", 10));
+    ASSERT_TRUE(compileFails("abc", -1));
+
+    return true;
+}
+
+// Test: 整文件并行近似查找与逐行比对一致，包括按区间查找
+TEST(Fuzzy_FileParallel) {
+    Random random{ 99 };
+    std::string pattern = "timeout while flushing";
+    std::string data;
+    std::vector<LineNo> expected;
+    for (LineNo no = 1; no <= 3000; no++) {
+        std::string line = random.text(random.next(60), 6);
+        if (no % 37 == 0) {
+            line += random.corrupt(pattern, static_cast<int>(random.next(4)));
+        }
+        if (bestDistance(pattern, line) <= 2) {
+            expected.push_back(no);
+        }
+        data += line;
+        if (no < 3000) {
+            data += '\n';
+        }
+    }
+    ASSERT_TRUE(expected.size() > 40);
+
+    FuzzySearcher searcher(pattern, 2);
+    ParallelSearchOptions options;
+    options.threads = 3;
+    options.chunkBytes = 4096;
+    ASSERT_TRUE(findLinesParallel(data.data(), data.size(), searcher, options) == expected);
+
+    // 两个区间各自从给定的行号起算
+    size_t middle = data.find('\n', data.size() / 2) + 1;
+    LineNo middleLine = static_cast<LineNo>(std::count(data.begin(), data.begin() + static_cast<std::ptrdiff_t>(middle), '\n')) + 1;
+    std::vector<LineRange> ranges = { LineRange{ 0, middle, 1 }, LineRange{ middle, data.size(), middleLine } };
+    ASSERT_TRUE(findLinesParallel(data.data(), ranges, searcher, options) == expected);
+
+    // 片段太短时逐行比对
+    FuzzySearcher dense("abcd", 2);
+    std::vector<LineNo> lines = findLinesParallel(data.data(), data.size(), dense, options);
+    size_t count = 0;
+    size_t start = 0;
+    for (LineNo no = 1; start <= data.size(); no++) {
+        size_t end = data.find('\n', start);
+        end = end == std::string::npos ? data.size() : end;
+        if (bestDistance("abcd", data.substr(start, end - start)) <= 2) {
+            if (count >= lines.size() || lines[count] != no) {
+                return false;
+            }
+            count++;
+        }
+        start = end + 1;
+    }
+    ASSERT_EQ(lines.size(), count);
+
+    return true;
+}
+
+// Test: m~k 和 M~k 命令
+TEST(Fuzzy_MatchCommand) {
+    CommandParser parser;
+    Command cmd = parser.parse("m~2timeout");
+    ASSERT_TRUE(cmd.fuzzy);
+    ASSERT_EQ(cmd.maxErrors, 2);
+    ASSERT_STR_EQ(cmd.pattern, "timeout");
+    try {
+        parser.parse("m~x");
+        return false;
+    } catch (const EditorException& e) {
+        ASSERT_TRUE(e.code() == ErrorCode::INVALID_FORMAT);
+    }
+    try {
+        parser.parse("M~1");
+        return false;
+    } catch (const EditorException& e) {
+        ASSERT_TRUE(e.code() == ErrorCode::MISSING_PARAMETER);
+    }
+
+    std::string path = tempPath("command.txt");
+    std::string outPath = tempPath("command_out.txt");
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "disk timeout\nok\ndisk timeuot\nok\ndisk tmeout\nnothing\n";
+    }
+    ActiveZone zone;
+    FileManager fileMgr;
+    fileMgr.openInput(path);
+    fileMgr.openOutput(outPath);
+    CommandExecutor executor(zone, fileMgr);
+    for (const char* text : { "disk timeout", "ok", "disk timeuot", "ok", "disk tmeout", "nothing" }) {
+        zone.appendLine(new Line(text));
+    }
+
+    cmd = parser.parse("m~1timeout");
+    ExecutionResult result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("在以下行中找到: 1, 5") != std::string::npos);
+    cmd = parser.parse("m~2timeout");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.message(cmd).find("在以下行中找到: 1, 3, 5") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("编辑距离 ≤ 2") != std::string::npos);
+    cmd = parser.parse("m~9timeout");
+    result = executor.execute(cmd);
+    ASSERT_FALSE(result.ok());
+
+    cmd = parser.parse("M~2timeout");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("在输入文件的 3 行中找到: 1, 3, 5") != std::string::npos);
+
+    fileMgr.close();
+    std::remove(path.c_str());
+    std::remove(outPath.c_str());
+    return true;
+}
+
+REGISTER_TEST(Fuzzy, Fuzzy_AgreesWithDp);
+REGISTER_TEST(Fuzzy, Fuzzy_PiecesAndErrors);
+REGISTER_TEST(Fuzzy, Fuzzy_FileParallel);
+REGISTER_TEST(Fuzzy, Fuzzy_MatchCommand);
@@ -0,0 +1,143 @@
+#include "../include/incremental_search.h"
+#include "../include/active_zone.h"
+#include "../include/editor.h"
+#include "test_framework.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+std::vector<LineNo> bruteForce(const ActiveZone& zone, const std::string& pattern) {
+    std::vector<LineNo> lines;
+    LineNo no = zone.startLineNo();
+    for (const Line* line = zone.head(); line; line = line->next(), no++) {
+        if (line->getText().find(pattern) != std::string::npos) {
+            lines.push_back(no);
+        }
+    }
+    return lines;
+}
+
+bool sameLines(const std::vector<IncrementalSearch::Hit>& hits, const std::vector<LineNo>& expected) {
+    if (hits.size() != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < hits.size(); i++) {
+        if (hits[i].lineNo != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// Test: 模式加长时只检查上一次的命中，缩短时直接取回缓存
+TEST(IncrementalSearch_Narrowing) {
+    ActiveZone zone(2000);
+    zone.setStartLineNo(11);
+    for (int i = 0; i < 1000; i++) {
+        std::string text = "line " + std::to_string(i);
+        text += i % 3 == 0 ? " error" : " ok";
+        text += i % 7 == 0 ? " disk" : "";
+        zone.appendLine(new Line(text.c_str()));
+    }
+
+    IncrementalSearch search(zone);
+    ASSERT_TRUE(sameLines(search.type('e'), bruteForce(zone, "e")));
+    ASSERT_EQ(search.checkedLines(), 1000);
+    size_t previous = search.hits().size();
+    std::string typed = "e";
+    for (char c : std::string("rror disk")) {
+        typed += c;
+        if (!sameLines(search.type(c), bruteForce(zone, typed)) || search.checkedLines() != previous) {
+            return false;
+        }
+        previous = search.hits().size();
+    }
+    ASSERT_EQ(search.cachedPatterns(), 10);
+
+    // 退格取回缓存，不检查任何行
+    ASSERT_TRUE(sameLines(search.backspace(), bruteForce(zone, "error dis")));
+    ASSERT_EQ(search.checkedLines(), 0);
+    ASSERT_STR_EQ(search.pattern(), "error dis");
+
+    // 改掉中间的字符：退回到共同前缀 "err" 再加长
+    ASSERT_TRUE(sameLines(search.update("errxr"), bruteForce(zone, "errxr")));
+    ASSERT_EQ(search.cachedPatterns(), 4);
+    ASSERT_TRUE(search.hits().empty());
+
+    ASSERT_TRUE(search.update("").empty());
+    ASSERT_EQ(search.cachedPatterns(), 0);
+
+    return true;
+}
+
+// Test: 多字节字符逐字节输入时按已完整的部分查找，退格删除整个字符
+TEST(IncrementalSearch_Utf8) {
+    ActiveZone zone;
+    zone.appendLine(new Line("中文 abc"));
+    zone.appendLine(new Line("中国"));
+    zone.appendLine(new Line("abc"));
+
+    IncrementalSearch search(zone);
+    std::string zhong = "中";
+    std::string wen = "文";
+    for (char c : zhong) {
+        search.type(c);
+    }
+    ASSERT_EQ(search.hits().size(), 2);
+    search.type(wen[0]);
+    ASSERT_EQ(search.hits().size(), 2);
+    ASSERT_EQ(search.checkedLines(), 0);
+    search.type(wen[1]);
+    search.type(wen[2]);
+    ASSERT_EQ(search.hits().size(), 1);
+    ASSERT_EQ(search.hits()[0].lineNo, 1);
+
+    ASSERT_EQ(search.backspace().size(), 2);
+    ASSERT_STR_EQ(search.pattern(), zhong);
+    ASSERT_TRUE(search.backspace().empty());
+    ASSERT_TRUE(search.pattern().empty());
+
+    return true;
+}
+
+// Test: /<按键> 命令依次输入按键（DEL 删除），确认的模式按 m 执行
+TEST(IncrementalSearch_Command) {
+    const char* dir = std::getenv("TMPDIR");
+    std::string path = std::string(dir ? dir : "/tmp") + "/line_editor_incremental.txt";
+    std::string outPath = path + ".out";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "alpha\nbeta gamma\ngamma\n";
+    }
+
+    Editor editor;
+    ASSERT_TRUE(editor.init(path, outPath));
+    std::ostringstream out;
+    std::streambuf* oldOut = std::cout.rdbuf(out.rdbuf());
+    bool ok = editor.runScript({ "/gx\x7f" "amma" });
+    std::cout.rdbuf(oldOut);
+    ASSERT_TRUE(ok);
+    // 按键 g x DEL a m m a 得到模式 gamma，按 m 命令报告匹配的行
+    ASSERT_STR_EQ(out.str(), "模式 'gamma' 在以下行中找到: 2, 3\n");
+    const SearchCache& cache = editor.zone().searchCache();
+    ASSERT_EQ(cache.size(), 1);
+    ASSERT_EQ(cache.misses(), 1);
+
+    std::remove(path.c_str());
+    std::remove(outPath.c_str());
+    return true;
+}
+
+REGISTER_TEST(IncrementalSearch, IncrementalSearch_Narrowing);
+REGISTER_TEST(IncrementalSearch, IncrementalSearch_Utf8);
+REGISTER_TEST(IncrementalSearch, IncrementalSearch_Command);
@@ -1,5 +1,7 @@
 #include "../include/line.h"
 #include "test_framework.h"
+#include <cstring>
+#include <string>
 
 using namespace line_editor;
 
@@ -127,6 +129,73 @@ TEST(Line_OneOverBlock) {
     return true;
 }
 
+// Test: ASCII flag follows the text
+TEST(Line_AsciiFlag) {
+    Line line("plain ascii");
+    ASSERT_TRUE(line.isAscii());
+
+    line.setText("中文");
+    ASSERT_FALSE(line.isAscii());
+
+    line.replace("中文", "ok");
+    ASSERT_TRUE(line.isAscii());
+
+    Line empty;
+    ASSERT_TRUE(empty.isAscii());
+
+    return true;
+}
+
+// Test: 全部替换时只改写第一处匹配之后的块，块链与逐次 std::string 替换一致
+TEST(Line_ReplaceAllBlockLocal) {
+    std::string text;
+    for (int i = 0; i < 40; i++) {
+        text += "item" + std::to_string(i) + ", ";
+    }
+    const char* replacements[] = { "ITEM", "it", "", "element-" };
+    for (const char* newStr : replacements) {
+        Line line(text.c_str());
+        const LineBlock* head = line.head();
+        std::string expected = text;
+        size_t count = 0;
+        for (size_t pos = expected.find("item"); pos != std::string::npos;
+             pos = expected.find("item", pos + std::strlen(newStr))) {
+            expected.replace(pos, 4, newStr);
+            count++;
+        }
+
+        ASSERT_EQ(line.replace(Searcher("item"), newStr, true), count);
+        ASSERT_STR_EQ(line.getText(), expected);
+        ASSERT_EQ(line.length(), expected.size());
+        ASSERT_TRUE(line.head() == head);   // 第一处匹配在首块，首块原地复用
+    }
+
+    // 匹配在后面的块时前面的块不动；只替换第一处
+    std::string tail = std::string(170, '-') + "old old";
+    Line line(tail.c_str());
+    char* firstBlock = line.head()->data();
+    ASSERT_EQ(line.replace(Searcher("old"), "new", false), 1);
+    ASSERT_STR_EQ(line.getText(), std::string(170, '-') + "new old");
+    ASSERT_TRUE(line.head()->data() == firstBlock);
+
+    // 删光整行、跨块匹配、无匹配
+    Line whole((std::string(79, 'x') + "yz").c_str());
+    ASSERT_EQ(whole.replace(Searcher("xy"), "", true), 1);
+    ASSERT_STR_EQ(whole.getText(), std::string(78, 'x') + "z");
+    ASSERT_EQ(whole.replace(Searcher(std::string(78, 'x') + "z"), "", true), 1);
+    ASSERT_TRUE(whole.isEmpty());
+    ASSERT_EQ(whole.replace(Searcher("x"), "y", true), 0);
+
+    Line unicode("a中a");
+    ASSERT_EQ(unicode.replace(Searcher("中"), "b", true), 1);
+    ASSERT_TRUE(unicode.isAscii());
+    ASSERT_EQ(unicode.replace(Searcher("a"), "é", true), 2);
+    ASSERT_FALSE(unicode.isAscii());
+    ASSERT_STR_EQ(unicode.getText(), "ébé");
+
+    return true;
+}
+
 // Register tests
 REGISTER_TEST(Line, Line_CreateEmpty);
 REGISTER_TEST(Line, Line_CreateWithText);
@@ -138,3 +207,5 @@ REGISTER_TEST(Line, Line_Replace);
 REGISTER_TEST(Line, Line_SetEmpty);
 REGISTER_TEST(Line, Line_ExactlyFullBlock);
 REGISTER_TEST(Line, Line_OneOverBlock);
+REGISTER_TEST(Line, Line_AsciiFlag);
+REGISTER_TEST(Line, Line_ReplaceAllBlockLocal);
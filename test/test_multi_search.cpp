@@ -0,0 +1,178 @@
+#include "../include/multi_search.h"
+#include "../include/active_zone.h"
+#include "../include/command_executor.h"
+#include "../include/command_parser.h"
+#include "../include/file_manager.h"
+#include "../include/line.h"
+#include "test_framework.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+std::vector<size_t> bruteForce(const std::vector<std::string>& patterns, const std::string& text) {
+    std::vector<size_t> found;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        if (text.find(patterns[i]) != std::string::npos) {
+            found.push_back(i);
+        }
+    }
+    return found;
+}
+
+std::string tempPath(const std::string& name) {
+    const char* dir = std::getenv("TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/line_editor_multi_" + name;
+}
+
+} // anonymous namespace
+
+// Test: 相互重叠、互为后缀的模式都能报告
+TEST(MultiSearch_OverlappingPatterns) {
+    std::vector<std::string> patterns = { "he", "she", "his", "hers" };
+    MultiSearcher searcher(patterns);
+
+    std::vector<size_t> found;
+    searcher.matchedPatterns("ushers", 6, found);
+    ASSERT_EQ(found.size(), 3);
+    ASSERT_EQ(found[0], 0);
+    ASSERT_EQ(found[1], 1);
+    ASSERT_EQ(found[2], 3);
+
+    searcher.matchedPatterns("this", 4, found);
+    ASSERT_EQ(found.size(), 1);
+    ASSERT_EQ(found[0], 2);
+
+    searcher.matchedPatterns("xyz", 3, found);
+    ASSERT_TRUE(found.empty());
+    ASSERT_FALSE(searcher.matchesAny("xyz", 3));
+    ASSERT_TRUE(searcher.matchesAny("ahisb", 5));
+
+    return true;
+}
+
+// Test: 随机文本上与逐个 std::string::find 一致，块链与连续缓冲一致
+TEST(MultiSearch_MatchesBruteForce) {
+    std::vector<std::string> patterns = { "abc", "bca", "a", "cab", "abcabc", "ccc", "bb", "abc" };
+    MultiSearcher searcher(patterns);
+
+    unsigned seed = 99;
+    std::vector<size_t> found;
+    for (int round = 0; round < 300; round++) {
+        std::string text;
+        size_t len = round % 250;
+        for (size_t i = 0; i < len; i++) {
+            seed = seed * 1103515245 + 12345;
+            text += static_cast<char>('a' + (seed >> 16) % 4);
+        }
+        std::vector<size_t> expected = bruteForce(patterns, text);
+
+        searcher.matchedPatterns(text.data(), text.size(), found);
+        if (found != expected) {
+            return false;
+        }
+        Line line(text.c_str());
+        searcher.matchedPatterns(line.head(), found);
+        if (found != expected) {
+            return false;
+        }
+        if (searcher.matchesAny(line.head()) != !expected.empty()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Test: 空模式匹配任何输入；无模式时什么都不匹配
+TEST(MultiSearch_EmptyPatterns) {
+    MultiSearcher withEmpty({ "x", "" });
+    std::vector<size_t> found;
+    withEmpty.matchedPatterns("abc", 3, found);
+    ASSERT_EQ(found.size(), 1);
+    ASSERT_EQ(found[0], 1);
+    ASSERT_TRUE(withEmpty.matchesAny(nullptr));
+
+    MultiSearcher none({});
+    ASSERT_FALSE(none.matchesAny("abc", 3));
+    ASSERT_EQ(none.stateCount(), 1);
+
+    return true;
+}
+
+// Test: m|a|b 与 m<文件 的解析
+TEST(MultiSearch_ParseCommand) {
+    CommandParser parser;
+    Command cmd = parser.parse("m|E100|E2\\|x||E3|");
+    ASSERT_EQ(cmd.patterns.size(), 3);
+    ASSERT_STR_EQ(cmd.patterns[0], "E100");
+    ASSERT_STR_EQ(cmd.patterns[1], "E2|x");
+    ASSERT_STR_EQ(cmd.patterns[2], "E3");
+
+    Command file = parser.parse("m< codes.txt");
+    ASSERT_STR_EQ(file.patternFile, "codes.txt");
+    ASSERT_TRUE(file.patterns.empty());
+
+    try {
+        parser.parse("m||");
+        return false;
+    } catch (const EditorException& e) {
+        ASSERT_EQ(static_cast<int>(e.code()), static_cast<int>(ErrorCode::MISSING_PARAMETER));
+    }
+
+    return true;
+}
+
+// Test: 执行多模式查找，报告每行命中的模式
+TEST(MultiSearch_ExecuteOnZone) {
+    ActiveZone zone;
+    zone.setStartLineNo(10);
+    zone.appendLine(new Line("E100 disk full"));
+    zone.appendLine(new Line("ok"));
+    zone.appendLine(new Line((std::string(78, '.') + "E200 and E100").c_str()));
+    FileManager fileMgr;
+    CommandExecutor executor(zone, fileMgr);
+
+    CommandParser parser;
+    Command cmd = parser.parse("m|E100|E200|E300");
+    ExecutionResult result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("2/3") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("10: E100") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("12: E100, E200") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("11:") == std::string::npos);
+
+    std::string path = tempPath("codes.txt");
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "E300\r\n\r\nE200\n";
+    }
+    cmd = parser.parse("m<" + path);
+    result = executor.execute(cmd);
+    std::remove(path.c_str());
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("1/2") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("12: E200") != std::string::npos);
+
+    cmd = parser.parse("m|nothing");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("未找到") != std::string::npos);
+
+    cmd = parser.parse("m<" + tempPath("missing.txt"));
+    result = executor.execute(cmd);
+    ASSERT_FALSE(result.ok());
+
+    return true;
+}
+
+REGISTER_TEST(MultiSearch, MultiSearch_OverlappingPatterns);
+REGISTER_TEST(MultiSearch, MultiSearch_MatchesBruteForce);
+REGISTER_TEST(MultiSearch, MultiSearch_EmptyPatterns);
+REGISTER_TEST(MultiSearch, MultiSearch_ParseCommand);
+REGISTER_TEST(MultiSearch, MultiSearch_ExecuteOnZone);
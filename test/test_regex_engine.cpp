@@ -0,0 +1,334 @@
+#include "../include/regex_engine.h"
+#include "../include/active_zone.h"
+#include "../include/command_parser.h"
+#include "../include/error.h"
+#include "../include/line.h"
+#include "test_framework.h"
+#include <chrono>
+#include <regex>
+#include <string>
+
+using namespace line_editor;
+
+namespace {
+
+bool matches(const std::string& pattern, const std::string& text) {
+    Regex regex(pattern);
+    bool flat = regex.search(text.data(), text.size());
+    Line line(text.c_str());
+    // 连续缓冲和块链两条路径必须一致
+    if (flat != regex.search(line.head())) {
+        throw std::logic_error("block search disagrees for " + pattern);
+    }
+    return flat;
+}
+
+bool compileFails(const std::string& pattern) {
+    try {
+        Regex regex(pattern);
+    } catch (const EditorException& e) {
+        return e.code() == ErrorCode::INVALID_PATTERN;
+    }
+    return false;
+}
+
+std::string span(const std::string& pattern, const std::string& text) {
+    Regex regex(pattern);
+    size_t start = 0;
+    size_t end = 0;
+    if (!regex.find(text.data(), text.size(), start, end)) {
+        return "<none>";
+    }
+    return std::to_string(start) + ":" + text.substr(start, end - start);
+}
+
+} // anonymous namespace
+
+// Test: 字面量、字符类、转义与重复
+TEST(Regex_BasicSyntax) {
+    ASSERT_TRUE(matches("hello", "say hello world"));
+    ASSERT_FALSE(matches("hello", "say help"));
+    ASSERT_TRUE(matches("h.llo", "hallo"));
+    ASSERT_TRUE(matches("colou?r", "color"));
+    ASSERT_TRUE(matches("colou?r", "colour"));
+    ASSERT_TRUE(matches("ab*c", "ac"));
+    ASSERT_TRUE(matches("ab+c", "abbbc"));
+    ASSERT_FALSE(matches("ab+c", "ac"));
+    ASSERT_TRUE(matches("x[0-9]{3}y", "x123y"));
+    ASSERT_FALSE(matches("x[0-9]{3}y", "x12y"));
+    ASSERT_TRUE(matches("x[0-9]{2,}y", "x12345y"));
+    ASSERT_TRUE(matches("x[0-9]{1,2}y", "x12y"));
+    ASSERT_FALSE(matches("x[0-9]{1,2}y", "x123y"));
+    ASSERT_TRUE(matches("[^a-z]", "abc1"));
+    ASSERT_FALSE(matches("[^a-z]", "abc"));
+    ASSERT_TRUE(matches("\\d+\\.\\d+", "pi=3.14"));
+    ASSERT_FALSE(matches("\\d+\\.\\d+", "pi=3x14"));
+    ASSERT_TRUE(matches("\\w+\\s\\w+", "two words"));
+    ASSERT_TRUE(matches("\\S", "  x "));
+    ASSERT_FALSE(matches("\\S", "   "));
+    ASSERT_TRUE(matches("[\\d_]", "a_b"));
+    ASSERT_TRUE(matches("a{,2}", "a{,2}"));
+    ASSERT_TRUE(matches("\\x41B", "AB"));
+
+    return true;
+}
+
+// Test: 锚点、分组与选择
+TEST(Regex_AnchorsAndAlternation) {
+    ASSERT_TRUE(matches("^abc", "abcdef"));
+    ASSERT_FALSE(matches("^abc", "xabc"));
+    ASSERT_TRUE(matches("def$", "abcdef"));
+    ASSERT_FALSE(matches("def$", "defx"));
+    ASSERT_TRUE(matches("^$", ""));
+    ASSERT_FALSE(matches("^$", "x"));
+    ASSERT_TRUE(matches("^(cat|dog)s?$", "dogs"));
+    ASSERT_FALSE(matches("^(cat|dog)s?$", "cows"));
+    ASSERT_TRUE(matches("error|warn", "a warning"));
+    ASSERT_TRUE(matches("(ab)+$", "xababab"));
+    ASSERT_TRUE(matches("", "anything"));
+    ASSERT_TRUE(matches("a|", "b"));
+
+    return true;
+}
+
+// Test: '.' 和字符类按 UTF-8 码点匹配
+TEST(Regex_Utf8) {
+    ASSERT_TRUE(matches("^.$", "中"));
+    ASSERT_FALSE(matches("^..$", "中"));
+    ASSERT_TRUE(matches("^[一-龥]+$", "编辑器"));
+    ASSERT_FALSE(matches("^[一-龥]+$", "编辑er"));
+    ASSERT_TRUE(matches("^[^a]$", "é"));
+    ASSERT_TRUE(matches("编.器", "行编辑器"));
+    ASSERT_TRUE(matches("^😀{2}$", "😀😀"));
+
+    return true;
+}
+
+// Test: find 返回最左最长的匹配
+TEST(Regex_FindSpan) {
+    ASSERT_STR_EQ(span("a+", "xxaaay"), "2:aaa");
+    ASSERT_STR_EQ(span("ab|abcd", "zabcd"), "1:abcd");
+    ASSERT_STR_EQ(span("\\d+", "v10.25"), "1:10");
+    ASSERT_STR_EQ(span("b*", "abb"), "0:");
+    ASSERT_STR_EQ(span("x$", "xax"), "2:x");
+    ASSERT_STR_EQ(span("literal", "a literal here"), "2:literal");
+    ASSERT_STR_EQ(span("q", "abc"), "<none>");
+    ASSERT_STR_EQ(span("中.", "行中文"), "3:中文");
+
+    return true;
+}
+
+// Test: 语法错误抛出 INVALID_PATTERN
+TEST(Regex_CompileErrors) {
+    ASSERT_TRUE(compileFails("(abc"));
+    ASSERT_TRUE(compileFails("abc)"));
+    ASSERT_TRUE(compileFails("[abc"));
+    ASSERT_TRUE(compileFails("*a"));
+    ASSERT_TRUE(compileFails("a|+"));
+    ASSERT_TRUE(compileFails("[z-a]"));
+    ASSERT_TRUE(compileFails("a{3,1}"));
+    ASSERT_TRUE(compileFails("a{1001}"));
+    ASSERT_TRUE(compileFails("\\q"));
+    ASSERT_TRUE(compileFails("abc\\"));
+    ASSERT_TRUE(compileFails("(a{1000}){1000}"));
+    ASSERT_FALSE(compileFails("a{1000}"));
+
+    return true;
+}
+
+// Test: 与 std::regex 对比随机输入上的查找结果
+TEST(Regex_AgreesWithStdRegex) {
+    const char* patterns[] = {
+        "a(b|c)*d", "^(ab|a)*c$", "[a-c]{2,3}d", "(a|b)*a(a|b){3}", "b+$", "^a?b?c?d?$",
+        "(ab|ba)+", "[^ab]c", "d\\w*a",
+    };
+    unsigned seed = 12345;
+    for (const char* pattern : patterns) {
+        Regex regex(pattern);
+        std::regex reference(pattern);
+        for (int i = 0; i < 300; i++) {
+            std::string text;
+            size_t len = (seed >> 8) % 24;
+            for (size_t j = 0; j < len; j++) {
+                seed = seed * 1103515245 + 12345;
+                text += static_cast<char>('a' + (seed >> 16) % 5);
+            }
+            seed = seed * 1103515245 + 12345;
+            if (regex.search(text.data(), text.size()) != std::regex_search(text, reference)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Test: 回溯引擎的病态模式在长输入上仍是线性时间
+TEST(Regex_HostilePatternsStayLinear) {
+    std::string text(20000, 'a');
+    auto start = std::chrono::steady_clock::now();
+
+    ASSERT_FALSE(matches("(a*)*b", text));
+    ASSERT_FALSE(matches("(a|aa)*c", text));
+    ASSERT_FALSE(matches("(a|a)*$x", text));
+    ASSERT_TRUE(matches("^(a+)+$", text));
+    ASSERT_STR_EQ(span("(a|aa)*b", text + "b"), "0:" + text + "b");
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_TRUE(seconds < 5.0);
+
+    return true;
+}
+
+// Test: DFA 缓存有上限，超出时清空后结果仍正确
+TEST(Regex_DfaCacheBounded) {
+    // 倒数第 10 个字符为 a：DFA 需要约 2^10 个状态
+    Regex small("a[ab]{9}$", false, 16 * 1024);
+    Regex large("a[ab]{9}$");
+
+    unsigned seed = 7;
+    for (int i = 0; i < 200; i++) {
+        std::string text;
+        for (int j = 0; j < 200; j++) {
+            seed = seed * 1103515245 + 12345;
+            text += (seed >> 16) & 1 ? 'a' : 'b';
+        }
+        bool expected = text[text.size() - 10] == 'a';
+        if (small.search(text.data(), text.size()) != expected ||
+            large.search(text.data(), text.size()) != expected) {
+            return false;
+        }
+    }
+
+    ASSERT_TRUE(small.dfaCacheResets() > 0);
+    ASSERT_TRUE(small.dfaStates() < large.dfaStates());
+    ASSERT_EQ(large.dfaCacheResets(), 0);
+
+    return true;
+}
+
+// Test: 必需字面量预过滤
+TEST(Regex_RequiredLiteral) {
+    ASSERT_STR_EQ(Regex("timeout").requiredLiteral(), "timeout");
+    ASSERT_STR_EQ(Regex("\\d+ms timeout after").requiredLiteral(), "ms timeout after");
+    ASSERT_STR_EQ(Regex("(fo)+bar").requiredLiteral(), "bar");
+    ASSERT_STR_EQ(Regex("(connection)+x?").requiredLiteral(), "connection");
+    ASSERT_STR_EQ(Regex("cat|dog").requiredLiteral(), "");
+
+    return true;
+}
+
+// Test: 编译结果按模式缓存，超出容量时淘汰最久未用的
+TEST(Regex_Cache) {
+    RegexCache cache(2);
+    std::shared_ptr<Regex> a = cache.get("a+");
+    ASSERT_TRUE(cache.get("a+") == a);
+    cache.get("b+");
+    cache.get("a+");
+    cache.get("c+");        // 淘汰 b+
+
+    ASSERT_EQ(cache.size(), 2);
+    ASSERT_EQ(cache.hits(), 2);
+    ASSERT_EQ(cache.misses(), 3);
+    ASSERT_TRUE(cache.get("a+") == a);
+    cache.get("b+");
+    ASSERT_EQ(cache.misses(), 4);
+
+    try {
+        cache.get("(");
+        return false;
+    } catch (const EditorException& e) {
+        ASSERT_EQ(static_cast<int>(e.code()), static_cast<int>(ErrorCode::INVALID_PATTERN));
+    }
+
+    return true;
+}
+
+// Test: m/正则/ 的解析和活区查找
+TEST(Regex_MatchCommand) {
+    CommandParser parser;
+    Command cmd = parser.parse("m/^id=\\d+\\/x$/");
+    ASSERT_TRUE(cmd.regex);
+    ASSERT_STR_EQ(cmd.pattern, "^id=\\d+/x$");
+
+    Command plain = parser.parse("m/usr");
+    ASSERT_FALSE(plain.regex);
+    ASSERT_STR_EQ(plain.pattern, "/usr");
+
+    try {
+        parser.parse("m/abc/z");
+        return false;
+    } catch (const EditorException&) {
+    }
+
+    ActiveZone zone;
+    zone.setStartLineNo(1);
+    zone.appendLine(new Line("id=1/x"));
+    zone.appendLine(new Line("id=22/y"));
+    zone.appendLine(new Line(("id=333/" + std::string(200, 'z') + "/x").c_str()));
+    zone.appendLine(new Line("id=4444/x"));
+
+    std::vector<LineNo> found = zone.findPattern(Regex(cmd.pattern));
+    ASSERT_EQ(found.size(), 2);
+    ASSERT_EQ(found[0], 1);
+    ASSERT_EQ(found[1], 4);
+
+    return true;
+}
+
+// Test: findAll 报告每处不重叠的最左最长匹配，多块的行与 std::regex 一致
+TEST(Regex_FindAll) {
+    std::string text;
+    for (int i = 0; i < 120; i++) {
+        text += "id" + std::to_string(i * 37 % 1000) + (i % 3 ? "-" : "--x");
+    }
+    Line line(text.c_str());
+    ASSERT_TRUE(line.head()->next() != nullptr);
+
+    const char* patterns[] = { "\\d+", "-+x?", "d\\d" };
+    for (const char* pattern : patterns) {
+        std::vector<MatchPosition> matches;
+        Regex regex(pattern);
+        regex.findAll(line.head(), 3, matches, true);
+        std::regex reference(pattern);
+        auto it = std::sregex_iterator(text.begin(), text.end(), reference);
+        size_t count = 0;
+        for (; it != std::sregex_iterator(); ++it, ++count) {
+            if (count >= matches.size() || matches[count].lineNo != 3 ||
+                matches[count].column != static_cast<size_t>(it->position()) ||
+                matches[count].length != static_cast<size_t>(it->length())) {
+                return false;
+            }
+        }
+        ASSERT_EQ(matches.size(), count);
+    }
+
+    // ^ 只在行首匹配；空匹配不报告，之后的非空匹配照常报告
+    std::vector<MatchPosition> matches;
+    Line abab("abab");
+    ASSERT_EQ(Regex("^ab").findAll(abab.head(), 1, matches), 1);
+    matches.clear();
+    Line stars("a\xE4\xB8\xADxxb x");
+    ASSERT_EQ(Regex("x*").findAll(stars.head(), 1, matches), 2);
+    ASSERT_EQ(matches[0].column, 4);
+    ASSERT_EQ(matches[0].length, 2);
+    ASSERT_EQ(matches[1].column, 8);
+    matches.clear();
+    ASSERT_EQ(Regex("X+B", true).findAll(stars.head(), 1, matches, stars.isAscii()), 1);
+    ASSERT_EQ(Regex("nothing").findAll(stars.head(), 1, matches), 0);
+
+    return true;
+}
+
+REGISTER_TEST(Regex, Regex_BasicSyntax);
+REGISTER_TEST(Regex, Regex_AnchorsAndAlternation);
+REGISTER_TEST(Regex, Regex_Utf8);
+REGISTER_TEST(Regex, Regex_FindSpan);
+REGISTER_TEST(Regex, Regex_CompileErrors);
+REGISTER_TEST(Regex, Regex_AgreesWithStdRegex);
+REGISTER_TEST(Regex, Regex_HostilePatternsStayLinear);
+REGISTER_TEST(Regex, Regex_DfaCacheBounded);
+REGISTER_TEST(Regex, Regex_RequiredLiteral);
+REGISTER_TEST(Regex, Regex_Cache);
+REGISTER_TEST(Regex, Regex_MatchCommand);
+REGISTER_TEST(Regex, Regex_FindAll);
@@ -0,0 +1,194 @@
+#include "../include/search_cache.h"
+#include "../include/active_zone.h"
+#include "../include/command_executor.h"
+#include "../include/command_parser.h"
+#include "../include/file_manager.h"
+#include "test_framework.h"
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+// 逐行检查，不经过缓存
+std::vector<LineNo> bruteForce(ActiveZone& zone, const std::string& pattern) {
+    std::vector<LineNo> lines;
+    LineNo no = zone.startLineNo();
+    for (Line* line = zone.head(); line; line = line->next(), no++) {
+        if (line->getText().find(pattern) != std::string::npos) {
+            lines.push_back(no);
+        }
+    }
+    return lines;
+}
+
+// 记录 matchRows 被要求检查的行
+struct RowChecker {
+    std::vector<bool> matches;
+    std::vector<int>* checked;
+
+    void operator()(const std::vector<int>& rows, std::vector<int>& out) const {
+        for (int row : rows) {
+            checked->push_back(row);
+            if (matches[static_cast<size_t>(row)]) {
+                out.push_back(row);
+            }
+        }
+    }
+};
+
+} // anonymous namespace
+
+// Test: 日志回放：插入和删除使命中行移位，只重新检查插入或改动过的行
+TEST(SearchCache_Journal) {
+    SearchCache cache;
+    std::vector<int> checked;
+    RowChecker checker{ { true, false, true, false, true }, &checked };
+
+    std::vector<int> rows = cache.query("k", 5, checker);
+    ASSERT_EQ(rows.size(), 3);
+    ASSERT_EQ(checked.size(), 5);
+    ASSERT_EQ(cache.misses(), 1);
+
+    // 在第 1 行前插入两行（一行命中），删除原来的第 4 行，改动原来的第 2 行
+    cache.noteInsert(1, 2);
+    cache.noteErase(5, 1);
+    cache.noteChange(4);
+    checker.matches = { true, true, false, false, false, false };
+    checked.clear();
+    rows = cache.query("k", 6, checker);
+    ASSERT_EQ(checked.size(), 3);
+    ASSERT_EQ(checked[0], 1);
+    ASSERT_EQ(checked[1], 2);
+    ASSERT_EQ(checked[2], 4);
+    ASSERT_EQ(rows.size(), 3);
+    ASSERT_EQ(rows[0], 0);
+    ASSERT_EQ(rows[1], 1);
+    ASSERT_EQ(rows[2], 5);
+    ASSERT_EQ(cache.hits(), 1);
+    ASSERT_EQ(cache.rescannedRows(), 3);
+
+    // 没有编辑时不检查任何行
+    checked.clear();
+    ASSERT_EQ(cache.query("k", 6, checker).size(), 3);
+    ASSERT_TRUE(checked.empty());
+
+    cache.invalidate();
+    ASSERT_EQ(cache.size(), 0);
+    cache.query("k", 6, checker);
+    ASSERT_EQ(cache.misses(), 2);
+
+    return true;
+}
+
+// Test: 日志过长时丢弃落后的条目，结果仍然正确
+TEST(SearchCache_JournalLimit) {
+    SearchCache cache(4, 8);
+    std::vector<int> checked;
+    RowChecker checker{ { true, false, true }, &checked };
+    cache.query("a", 3, checker);
+    for (int i = 0; i < 20; i++) {
+        cache.noteChange(1);
+    }
+    checked.clear();
+    std::vector<int> rows = cache.query("a", 3, checker);
+    ASSERT_EQ(cache.misses(), 2);
+    ASSERT_EQ(checked.size(), 3);
+    ASSERT_EQ(rows.size(), 2);
+
+    return true;
+}
+
+// Test: 随机编辑之间重复查找，缓存结果始终与逐行查找一致
+TEST(SearchCache_ZoneRandomEdits) {
+    ActiveZone zone(40);
+    for (int i = 0; i < 30; i++) {
+        zone.appendLine(new Line(i % 3 == 0 ? "alpha beta" : "gamma"));
+    }
+
+    unsigned seed = 12345;
+    auto next = [&](unsigned range) {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<LineNo>((seed >> 16) % range);
+    };
+    Regex regex("bet+a");
+    for (int round = 0; round < 400; round++) {
+        LineNo first = zone.startLineNo();
+        LineNo count = zone.lineCount();
+        switch (next(6)) {
+            case 0:
+                zone.insert(first - 1 + next(static_cast<unsigned>(count) + 1), next(2) ? "x beta" : "y");
+                break;
+            case 1:
+                if (count > 5) {
+                    LineNo start = first + next(static_cast<unsigned>(count));
+                    zone.deleteRange(start, start + next(3));
+                }
+                break;
+            case 2:
+                zone.replaceInLine(first + next(static_cast<unsigned>(count)), "beta", "delta");
+                break;
+            case 3:
+                zone.replaceInRange(first, first + next(static_cast<unsigned>(count)), "gamma", "gamma beta", false);
+                break;
+            case 4:
+                if (count > 5) {
+                    delete (next(2) ? zone.removeFirst() : zone.removeLast());
+                }
+                break;
+            default:
+                zone.appendLine(new Line("beta tail"));
+                break;
+        }
+
+        std::vector<LineNo> expected = bruteForce(zone, "beta");
+        if (zone.findPattern(Searcher("beta")) != expected || zone.findPattern(regex) != expected) {
+            return false;
+        }
+    }
+    ASSERT_TRUE(zone.searchCache().hits() > 0);
+    ASSERT_EQ(zone.searchCache().misses(), 2);
+
+    return true;
+}
+
+// Test: m 命令报告缓存命中，换活区后缓存失效
+TEST(SearchCache_ExecuteMatch) {
+    ActiveZone zone;
+    for (int i = 1; i <= 50; i++) {
+        zone.appendLine(new Line(i % 10 == 0 ? "error here" : "ok"));
+    }
+    FileManager fileMgr;
+    CommandExecutor executor(zone, fileMgr);
+    CommandParser parser;
+
+    Command cmd = parser.parse("merror");
+    ExecutionResult result = executor.execute(cmd);
+    ASSERT_TRUE(result.ok());
+    ASSERT_TRUE(result.message(cmd).find("缓存命中") == std::string::npos);
+
+    executor.execute(parser.parse("d10"));
+    executor.execute(parser.parse("s5@ok@error"));
+    cmd = parser.parse("merror");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.message(cmd).find("5, 19, 29, 39, 49") != std::string::npos);
+    ASSERT_TRUE(result.message(cmd).find("缓存命中，重新检查 1 行") != std::string::npos);
+
+    cmd = parser.parse("m/ERR/i");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.message(cmd).find("缓存命中") == std::string::npos);
+    cmd = parser.parse("m/ERR/i");
+    result = executor.execute(cmd);
+    ASSERT_TRUE(result.message(cmd).find("缓存命中，重新检查 0 行") != std::string::npos);
+
+    executor.execute(parser.parse("n"));
+    ASSERT_EQ(zone.searchCache().size(), 0);
+
+    return true;
+}
+
+REGISTER_TEST(SearchCache, SearchCache_Journal);
+REGISTER_TEST(SearchCache, SearchCache_JournalLimit);
+REGISTER_TEST(SearchCache, SearchCache_ZoneRandomEdits);
+REGISTER_TEST(SearchCache, SearchCache_ExecuteMatch);
@@ -0,0 +1,202 @@
+#include "../include/stream_substitute.h"
+#include "../include/command_parser.h"
+#include "../include/file_manager.h"
+#include "test_framework.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace line_editor;
+
+namespace {
+
+// 逐行的参考实现
+std::string reference(const std::string& text, const std::string& oldStr,
+                      const std::string& newStr, bool global) {
+    std::string out;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        size_t next = (end == std::string::npos) ? text.size() : end + 1;
+        std::string line = text.substr(start, (end == std::string::npos ? text.size() : end) - start);
+        for (size_t pos = line.find(oldStr); pos != std::string::npos;
+             pos = global ? line.find(oldStr, pos + newStr.size()) : std::string::npos) {
+            line.replace(pos, oldStr.size(), newStr);
+        }
+        out += line;
+        if (end != std::string::npos) {
+            out += '\n';
+        }
+        start = next;
+    }
+    return out;
+}
+
+std::string sampleText(unsigned seed, size_t lines) {
+    std::string text;
+    for (size_t i = 0; i < lines; i++) {
+        seed = seed * 1103515245 + 12345;
+        size_t length = (seed >> 16) % 300;
+        for (size_t j = 0; j < length; j++) {
+            seed = seed * 1103515245 + 12345;
+            text += "ab-c"[(seed >> 16) % 4];
+        }
+        text += '\n';
+    }
+    text += "abc ab abc";     // 末尾没有换行
+    return text;
+}
+
+std::string tempPath(const std::string& name) {
+    const char* dir = std::getenv("TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/line_editor_substitute_" + name;
+}
+
+} // anonymous namespace
+
+// Test: 每行第一处与全部替换
+TEST(StreamSubstitute_Lines) {
+    SubstituteOptions options;
+    options.threads = 1;
+    StreamSubstituter first("ab", "X", options);
+    std::string out;
+    std::string text = "ab ab\nab\n\ncab";
+    ASSERT_EQ(first.substituteLines(text.data(), text.size(), out), 3);
+    ASSERT_STR_EQ(out, "X ab\nX\n\ncX");
+
+    options.global = true;
+    StreamSubstituter all("ab", "", options);
+    out.clear();
+    ASSERT_EQ(all.substituteLines(text.data(), text.size(), out), 4);
+    ASSERT_STR_EQ(out, " \n\n\nc");
+
+    return true;
+}
+
+// Test: 任意块大小、线程数和流水线深度下输出与逐行替换一致，跨块的匹配不会丢失
+TEST(StreamSubstitute_Pipeline) {
+    std::string text = sampleText(7, 400);
+    size_t chunks[] = { 1, 5, 64, 4096 };
+    unsigned threads[] = { 1, 2, 5 };
+    size_t depths[] = { 1, 3 };
+    for (int global = 0; global < 2; global++) {
+        std::string expected = reference(text, "abc", "<ABC>", global != 0);
+        for (size_t chunk : chunks) {
+            for (unsigned t : threads) {
+                for (size_t depth : depths) {
+                    SubstituteOptions options;
+                    options.threads = t;
+                    options.chunkBytes = chunk;
+                    options.maxInFlight = depth;
+                    options.global = global != 0;
+                    std::istringstream in(text);
+                    std::ostringstream out;
+                    SubstituteStats stats = StreamSubstituter("abc", "<ABC>", options).run(in, out);
+                    if (out.str() != expected || stats.bytesRead != text.size() ||
+                        stats.bytesWritten != expected.size()) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Test: 比一块长得多的行跨越多次读入，整行留在同一块中替换；末尾没有换行的长行同样处理
+TEST(StreamSubstitute_LongLine) {
+    const size_t chunk = 4096;
+    std::string longLine;
+    while (longLine.size() < 9 * chunk) {
+        longLine += "xyz abc ";
+    }
+    std::string text = "abc\nshort abc\n" + longLine + "\nabc abc\n" + longLine;
+    for (int global = 0; global < 2; global++) {
+        std::string expected = reference(text, "abc", "<ABC>", global != 0);
+        for (unsigned t : { 1u, 3u }) {
+            SubstituteOptions options;
+            options.threads = t;
+            options.chunkBytes = chunk;
+            options.global = global != 0;
+            std::istringstream in(text);
+            std::ostringstream out;
+            SubstituteStats stats = StreamSubstituter("abc", "<ABC>", options).run(in, out);
+            ASSERT_TRUE(out.str() == expected);
+            ASSERT_EQ(stats.bytesRead, text.size());
+            // 长行之前的短行、长行连同其后的短行、末尾的长行，各成一块
+            ASSERT_TRUE(stats.chunks <= 3);
+        }
+    }
+
+    return true;
+}
+
+// Test: 非法的旧字符串，以及 <旧>@<新>[@g] 的解析
+TEST(StreamSubstitute_Invalid) {
+    const char* invalid[] = { "", "a\nb" };
+    for (const char* oldStr : invalid) {
+        try {
+            StreamSubstituter substituter(oldStr, "x");
+            return false;
+        } catch (const EditorException&) {
+        }
+    }
+
+    std::string oldStr;
+    std::string newStr;
+    bool global = false;
+    CommandParser::parseReplacement("http:@https:@g", oldStr, newStr, global);
+    ASSERT_STR_EQ(oldStr, "http:");
+    ASSERT_STR_EQ(newStr, "https:");
+    ASSERT_TRUE(global);
+    CommandParser::parseReplacement("a@b@c", oldStr, newStr, global);
+    ASSERT_STR_EQ(newStr, "b@c");
+    ASSERT_FALSE(global);
+    try {
+        CommandParser::parseReplacement("no-separator", oldStr, newStr, global);
+        return false;
+    } catch (const EditorException&) {
+    }
+
+    return true;
+}
+
+// Test: 原地替换文件，长度变化时经临时文件替换；BOM 与逐行读取一样被跳过
+TEST(StreamSubstitute_InPlaceFile) {
+    std::string path = tempPath("inplace.txt");
+    std::string text = sampleText(3, 200);
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "\xEF\xBB\xBF" << text;
+    }
+
+    SubstituteOptions options;
+    options.threads = 3;
+    options.chunkBytes = 512;
+    options.global = true;
+    FileManager fileMgr;
+    fileMgr.openInPlace(path);
+    SubstituteStats stats = StreamSubstituter("ab", "abab", options).run(fileMgr);
+    fileMgr.close();
+
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream content;
+    content << in.rdbuf();
+    std::remove(path.c_str());
+
+    std::string expected = reference(text, "ab", "abab", true);
+    ASSERT_TRUE(content.str() == expected);
+    ASSERT_TRUE(stats.substitutions > 0);
+    ASSERT_EQ(stats.bytesWritten, expected.size());
+
+    return true;
+}
+
+REGISTER_TEST(StreamSubstitute, StreamSubstitute_Lines);
+REGISTER_TEST(StreamSubstitute, StreamSubstitute_Pipeline);
+REGISTER_TEST(StreamSubstitute, StreamSubstitute_LongLine);
+REGISTER_TEST(StreamSubstitute, StreamSubstitute_Invalid);
+REGISTER_TEST(StreamSubstitute, StreamSubstitute_InPlaceFile);
@@ -0,0 +1,211 @@
+#include "../include/text_search.h"
+#include "../include/line.h"
+#include "test_framework.h"
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+size_t expected(const std::string& text, const std::string& needle) {
+    size_t pos = text.find(needle);
+    return pos == std::string::npos ? SEARCH_NOT_FOUND : pos;
+}
+
+// 用 std::string::find 逐个找出不重叠的匹配起点
+std::vector<size_t> expectedAll(const std::string& text, const std::string& needle) {
+    std::vector<size_t> offsets;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + needle.size())) {
+        offsets.push_back(pos);
+    }
+    return offsets;
+}
+
+bool sameOffsets(const std::vector<MatchPosition>& matches, const std::vector<size_t>& offsets, size_t length) {
+    if (matches.size() != offsets.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < matches.size(); i++) {
+        if (matches[i].lineNo != 7 || matches[i].column != offsets[i] || matches[i].length != length) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// Test: 连续缓冲中的查找与 std::string::find 一致
+TEST(TextSearch_FindBytes) {
+    std::string text = "the quick brown fox jumps over the lazy dog, the end";
+
+    ASSERT_EQ(findBytes(text.data(), text.size(), "the", 3), 0);
+    ASSERT_EQ(findBytes(text.data(), text.size(), "lazy", 4), text.find("lazy"));
+    ASSERT_EQ(findBytes(text.data(), text.size(), "end", 3), text.size() - 3);
+    ASSERT_EQ(findBytes(text.data(), text.size(), "z", 1), text.find('z'));
+    ASSERT_EQ(findBytes(text.data(), text.size(), "og", 2), text.find("og"));
+    ASSERT_EQ(findBytes(text.data(), text.size(), "cat", 3), SEARCH_NOT_FOUND);
+    ASSERT_EQ(findBytes(text.data(), 3, "the quick", 9), SEARCH_NOT_FOUND);
+    ASSERT_EQ(findBytes(text.data(), text.size(), "", 0), 0);
+
+    return true;
+}
+
+// Test: 首尾字节命中但中间不同的候选不会误报
+TEST(TextSearch_FalseCandidates) {
+    std::string text(200, 'a');
+    text += "abca";
+    std::string needle = "abca";
+
+    ASSERT_EQ(findBytes(text.data(), text.size(), "aXa", 3), SEARCH_NOT_FOUND);
+    ASSERT_EQ(findBytes(text.data(), text.size(), needle.data(), needle.size()), expected(text, needle));
+
+    return true;
+}
+
+// Test: 块链中各个位置、各种长度的子串都能找到，包括跨块的匹配
+TEST(TextSearch_AcrossBlocks) {
+    std::string text;
+    for (int i = 0; i < 300; i++) {
+        text += static_cast<char>('a' + (i * 7 + i / 13) % 26);
+    }
+    Line line(text.c_str());
+
+    size_t lengths[] = { 1, 2, 3, 5, 16, 17, 79, 80, 81, 120 };
+    for (size_t len : lengths) {
+        for (size_t start = 0; start + len <= text.size(); start += 3) {
+            std::string needle = text.substr(start, len);
+            if (findInBlocks(line.head(), needle.data(), needle.size()) != expected(text, needle)) {
+                return false;
+            }
+        }
+    }
+
+    std::string missing = text.substr(70, 20);
+    missing[10] = '#';
+    ASSERT_EQ(findInBlocks(line.head(), missing.data(), missing.size()), SEARCH_NOT_FOUND);
+    ASSERT_EQ(findInBlocks(nullptr, "x", 1), SEARCH_NOT_FOUND);
+
+    return true;
+}
+
+// Test: Line::find 使用块链查找
+TEST(TextSearch_LineFind) {
+    std::string text(78, '-');
+    text += "needle";
+    text += std::string(100, '-');
+    Line line(text.c_str());
+
+    ASSERT_EQ(line.find("needle"), 78);
+    ASSERT_TRUE(line.contains("-needle-"));
+    ASSERT_FALSE(line.contains("needles"));
+    ASSERT_TRUE(line.replace("needle", "pin"));
+    ASSERT_EQ(line.find("pin"), 78);
+
+    return true;
+}
+
+// Test: 按模式长度选择查找策略
+TEST(TextSearch_SearcherStrategy) {
+    ASSERT_TRUE(Searcher("").strategy() == Searcher::Strategy::EMPTY);
+    ASSERT_TRUE(Searcher("x").strategy() == Searcher::Strategy::SINGLE_BYTE);
+    ASSERT_TRUE(Searcher("err").strategy() == Searcher::Strategy::VECTOR_FILTER);
+    ASSERT_TRUE(Searcher("connection refused by the remote peer").strategy() == Searcher::Strategy::HORSPOOL);
+
+    return true;
+}
+
+// Test: 各种策略在连续缓冲和块链上都与 std::string::find 一致
+TEST(TextSearch_SearcherMatchesFind) {
+    std::string text;
+    unsigned state = 12345;
+    for (int i = 0; i < 2000; i++) {
+        state = state * 1103515245u + 12345u;
+        text += static_cast<char>('a' + (state >> 16) % 4);
+    }
+    Line line(text.substr(0, 500).c_str());
+    std::string lineText = line.getText();
+
+    size_t lengths[] = { 1, 3, 7, 8, 16, 31, 32, 40, 90 };
+    for (size_t len : lengths) {
+        for (size_t start = 0; start + len <= 500; start += 37) {
+            Searcher searcher(text.substr(start, len));
+            if (searcher.find(text.data(), text.size()) != expected(text, searcher.pattern())) {
+                return false;
+            }
+            if (searcher.find(line.head()) != expected(lineText, searcher.pattern())) {
+                return false;
+            }
+        }
+    }
+
+    Searcher absent(std::string(20, 'z'));
+    ASSERT_EQ(absent.find(text.data(), text.size()), SEARCH_NOT_FOUND);
+    ASSERT_FALSE(absent.matches(line.head()));
+    ASSERT_TRUE(Searcher("").matches(nullptr));
+
+    return true;
+}
+
+// Test: findAll 一遍找出全部不重叠的匹配，包括跨块的匹配和不区分大小写的匹配
+TEST(TextSearch_FindAll) {
+    std::string text;
+    unsigned state = 777;
+    for (int i = 0; i < 700; i++) {
+        state = state * 1103515245u + 12345u;
+        text += static_cast<char>('a' + (state >> 16) % 3);
+    }
+    Line line(text.c_str());
+    ASSERT_TRUE(line.head()->next() != nullptr);
+
+    std::vector<MatchPosition> matches;
+    size_t lengths[] = { 1, 2, 3, 4, 9, 33, 70 };
+    for (size_t len : lengths) {
+        for (size_t start = 0; start + len <= text.size(); start += 53) {
+            std::string needle = text.substr(start, len);
+            matches.clear();
+            Searcher searcher(needle);
+            searcher.findAll(line.head(), 7, matches, true);
+            if (!sameOffsets(matches, expectedAll(text, needle), len)) {
+                return false;
+            }
+
+            std::string upper = needle;
+            for (char& c : upper) {
+                c = static_cast<char>(c - 'a' + 'A');
+            }
+            matches.clear();
+            Searcher folded(upper, true);
+            folded.findAll(line.head(), 7, matches, true);
+            if (!sameOffsets(matches, expectedAll(text, needle), len)) {
+                return false;
+            }
+        }
+    }
+
+    // 重叠的候选只报告靠前的一个
+    Line repeated("aaaaaaa");
+    matches.clear();
+    ASSERT_EQ(Searcher("aa").findAll(repeated.head(), 1, matches), 3);
+    ASSERT_EQ(matches[2].column, 4);
+    ASSERT_EQ(Searcher("").findAll(repeated.head(), 1, matches), 0);
+
+    // 开尔文符号折叠为 k，匹配长度按原文计算
+    Line kelvin("K\xE2\x84\xAAk");
+    matches.clear();
+    ASSERT_EQ(Searcher("k", true).findAll(kelvin.head(), 1, matches, kelvin.isAscii()), 3);
+    ASSERT_EQ(matches[1].column, 1);
+    ASSERT_EQ(matches[1].length, 3);
+    ASSERT_EQ(matches[2].column, 4);
+
+    return true;
+}
+
+REGISTER_TEST(TextSearch, TextSearch_FindBytes);
+REGISTER_TEST(TextSearch, TextSearch_FalseCandidates);
+REGISTER_TEST(TextSearch, TextSearch_AcrossBlocks);
+REGISTER_TEST(TextSearch, TextSearch_LineFind);
+REGISTER_TEST(TextSearch, TextSearch_SearcherStrategy);
+REGISTER_TEST(TextSearch, TextSearch_SearcherMatchesFind);
+REGISTER_TEST(TextSearch, TextSearch_FindAll);
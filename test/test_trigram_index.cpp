@@ -0,0 +1,286 @@
+#include "../include/trigram_index.h"
+#include "../include/active_zone.h"
+#include "../include/command_executor.h"
+#include "../include/command_parser.h"
+#include "../include/encoding_utils.h"
+#include "../include/file_manager.h"
+#include "test_framework.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+std::string tempPath(const std::string& name) {
+    const char* dir = std::getenv("TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/line_editor_trigram_" + name;
+}
+
+void writeFile(const std::string& path, const std::string& text, bool append = false) {
+    std::ofstream out(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    out << text;
+}
+
+std::string sampleText(int lines) {
+    std::string text = "\xEF\xBB\xBF";
+    for (int i = 1; i <= lines; i++) {
+        text += "host" + std::to_string(i % 17) + " status=ok latency=" + std::to_string(i * 31 % 997);
+        if (i % 97 == 0) {
+            text += " ERROR disk timeout";
+        }
+        if (i % 250 == 0) {
+            text += " temp 300\xE2\x84\xAA";    // 开尔文符号
+        }
+        text += "\n";
+    }
+    text += "tail without newline ERROR disk";
+    return text;
+}
+
+// 同一个匹配器分别做整文件查找和按索引候选区间查找，结果必须一致
+template <typename Matcher>
+bool sameAsFullScan(const TrigramIndex& index, const MappedFile& file, const Matcher& matcher,
+                    const std::vector<std::string>& literals, bool ignoreCase, size_t& candidateBlocks) {
+    size_t bom = detectUtf8Bom(file.data(), file.size());
+    std::vector<LineNo> expected = findLinesParallel(file.data() + bom, file.size() - bom, matcher);
+    IndexCandidates candidates = index.candidates(file, literals, ignoreCase);
+    candidateBlocks = candidates.candidateBlocks;
+    return !expected.empty() && findLinesParallel(file.data(), candidates.ranges, matcher) == expected;
+}
+
+} // anonymous namespace
+
+// Test: 字面量、正则（含不区分大小写）和多模式经索引缩小范围后，结果与整文件查找一致
+TEST(TrigramIndex_Queries) {
+    std::string path = tempPath("queries.txt");
+    std::string indexPath = TrigramIndex::sidecarPath(path);
+    writeFile(path, sampleText(3000));
+    TrigramIndex::build(path, indexPath, 1024);
+
+    MappedFile file;
+    ASSERT_TRUE(file.open(path));
+    TrigramIndex index;
+    ASSERT_TRUE(index.open(indexPath));
+    ASSERT_TRUE(index.usableFor(file));
+    ASSERT_TRUE(TrigramIndex::isCurrent(path));
+    ASSERT_TRUE(index.blockCount() > 50);
+
+    size_t blocks = 0;
+    ASSERT_TRUE(sameAsFullScan(index, file, Searcher("ERROR disk"), { "ERROR disk" }, false, blocks));
+    ASSERT_TRUE(blocks > 0 && blocks < index.blockCount() / 2);
+
+    Regex regex("error \\w+ timeout$", true);
+    ASSERT_TRUE(sameAsFullScan(index, file, regex, { regex.requiredLiteral() }, true, blocks));
+    ASSERT_TRUE(blocks < index.blockCount() / 2);
+
+    // K 与开尔文符号折叠相同，含 k 的 trigram 不能用来排除块
+    Regex kelvin("300k", true);
+    ASSERT_TRUE(sameAsFullScan(index, file, kelvin, { kelvin.requiredLiteral() }, true, blocks));
+
+    MultiSearcher multi({ "timeout", "latency=5\n", "host3 status" });
+    ASSERT_TRUE(sameAsFullScan(index, file, multi, multi.patterns(), false, blocks));
+
+    // 短于 3 字节的字面量无法缩小范围
+    ASSERT_TRUE(sameAsFullScan(index, file, Searcher("=9"), { "=9" }, false, blocks));
+    ASSERT_EQ(blocks, index.blockCount());
+
+    IndexCandidates none = index.candidates(file, { "no such text" }, false);
+    ASSERT_EQ(none.candidateBlocks, 0);
+    ASSERT_EQ(none.ranges.size(), 1);        // 只剩结尾没有换行的半行
+
+    index.close();
+    file.close();
+    std::remove(path.c_str());
+    std::remove(indexPath.c_str());
+    return true;
+}
+
+// Test: 文件追加、改动或截短后索引都失效
+TEST(TrigramIndex_Staleness) {
+    std::string path = tempPath("stale.txt");
+    std::string indexPath = TrigramIndex::sidecarPath(path);
+    std::string text = sampleText(800);
+    writeFile(path, text);
+    TrigramIndex::build(path, indexPath, 512);
+
+    MappedFile file;
+    TrigramIndex index;
+    ASSERT_TRUE(index.open(indexPath));
+    ASSERT_TRUE(file.open(path));
+    ASSERT_TRUE(index.usableFor(file));
+    file.close();
+
+    // 追加
+    writeFile(path, "\nappended ERROR disk line\nmore\n", true);
+    ASSERT_TRUE(file.open(path));
+    ASSERT_FALSE(index.usableFor(file));
+    ASSERT_FALSE(TrigramIndex::isCurrent(path));
+    file.close();
+
+    // 同样长度但内容不同
+    text[100] = (text[100] == 'x') ? 'y' : 'x';
+    writeFile(path, text);
+    ASSERT_TRUE(file.open(path));
+    ASSERT_FALSE(index.usableFor(file));
+    file.close();
+
+    // 截短
+    writeFile(path, "short\n");
+    ASSERT_TRUE(file.open(path));
+    ASSERT_FALSE(index.usableFor(file));
+    file.close();
+
+    index.close();
+    std::remove(path.c_str());
+    std::remove(indexPath.c_str());
+    return true;
+}
+
+// Test: 在中间插入一行使文件变长、首尾不变时索引也失效；编辑器改写文件后删掉它的索引
+TEST(TrigramIndex_InsertInMiddle) {
+    std::string path = tempPath("insert.txt");
+    std::string indexPath = TrigramIndex::sidecarPath(path);
+    std::string text = sampleText(20000);
+    writeFile(path, text);
+    TrigramIndex::build(path, indexPath, 4096);
+    ASSERT_TRUE(TrigramIndex::isCurrent(path));
+
+    std::string edited = text;
+    edited.insert(edited.find('\n', edited.size() / 2) + 1, "inserted ERRR line\n");
+    writeFile(path, edited);
+    MappedFile file;
+    ASSERT_TRUE(file.open(path));
+    TrigramIndex index;
+    ASSERT_TRUE(index.open(indexPath));
+    ASSERT_FALSE(index.usableFor(file));
+    ASSERT_FALSE(TrigramIndex::isCurrent(path));
+    index.close();
+    file.close();
+
+    // 原地编辑：在第 10000 行前插入一行，提交后不留下索引
+    writeFile(path, text);
+    TrigramIndex::build(path, indexPath, 4096);
+    {
+        FileManager fileMgr;
+        fileMgr.openInPlace(path);
+        for (int i = 1; i < 10000; i++) {
+            fileMgr.writeLine(fileMgr.readLine());
+        }
+        fileMgr.writeLine("inserted ERRR line");
+        fileMgr.close();
+    }
+    ASSERT_FALSE(index.open(indexPath));
+
+    // 原子输出覆盖同一个文件时同样删掉索引
+    TrigramIndex::build(path, indexPath, 4096);
+    {
+        FileManager fileMgr;
+        fileMgr.setAtomicOutput(true);
+        fileMgr.openInput(path);
+        fileMgr.openOutput(path);
+        fileMgr.writeLine(fileMgr.readLine());
+        fileMgr.copyRemainingInput();
+        fileMgr.close();
+    }
+    ASSERT_FALSE(index.open(indexPath));
+
+    // 长度不变的原地回写也删掉索引
+    TrigramIndex::build(path, indexPath, 4096);
+    {
+        FileManager fileMgr;
+        fileMgr.openInPlace(path);
+        std::string line = fileMgr.readLine();
+        fileMgr.writeLine(std::string(line.size(), 'x'));
+        fileMgr.close();
+    }
+    ASSERT_FALSE(index.open(indexPath));
+
+    std::remove(path.c_str());
+    return true;
+}
+
+// Test: 缺失、截断或格式不符的索引文件不会被打开
+TEST(TrigramIndex_Corrupt) {
+    std::string path = tempPath("corrupt.txt");
+    std::string indexPath = TrigramIndex::sidecarPath(path);
+    writeFile(path, sampleText(300));
+
+    TrigramIndex index;
+    ASSERT_FALSE(index.open(indexPath));
+    ASSERT_FALSE(TrigramIndex::isCurrent(path));
+
+    TrigramIndex::build(path, indexPath, 256);
+    std::string content;
+    {
+        std::ifstream in(indexPath, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    writeFile(indexPath, content.substr(0, content.size() - 5));
+    ASSERT_FALSE(index.open(indexPath));
+    writeFile(indexPath, std::string(content.size(), 'x'));
+    ASSERT_FALSE(index.open(indexPath));
+
+    // 空文件也能建索引
+    writeFile(path, "");
+    TrigramIndex::build(path, indexPath);
+    ASSERT_TRUE(index.open(indexPath));
+    ASSERT_EQ(index.blockCount(), 0);
+    ASSERT_TRUE(TrigramIndex::isCurrent(path));
+    index.close();
+
+    std::remove(path.c_str());
+    std::remove(indexPath.c_str());
+    return true;
+}
+
+// Test: 后台构建索引后，M 只查找候选块并报告相同的行号
+TEST(TrigramIndex_BackgroundAndExecute) {
+    std::string path = tempPath("execute.txt");
+    std::string outPath = tempPath("execute_out.txt");
+    std::string indexPath = TrigramIndex::sidecarPath(path);
+    writeFile(path, sampleText(2000));
+
+    ActiveZone zone;
+    FileManager fileMgr;
+    fileMgr.openInput(path);
+    fileMgr.openOutput(outPath);
+    CommandExecutor executor(zone, fileMgr);
+    CommandParser parser;
+    Command cmd = parser.parse("MERROR disk");
+    ExecutionResult plain = executor.execute(cmd);
+    ASSERT_TRUE(plain.ok());
+    ASSERT_TRUE(plain.message(cmd).find("索引") == std::string::npos);
+
+    {
+        BackgroundIndexBuild build(path, 4096);
+        build.wait();
+        ASSERT_TRUE(build.finished());
+        ASSERT_TRUE(build.error().empty());
+    }
+    ASSERT_TRUE(TrigramIndex::isCurrent(path));
+
+    cmd = parser.parse("MERROR disk");
+    ExecutionResult indexed = executor.execute(cmd);
+    ASSERT_TRUE(indexed.ok());
+    ASSERT_TRUE(indexed.message(cmd).find("（索引: 查找 ") != std::string::npos);
+    // 去掉索引说明后与整文件查找的结果相同
+    std::string list = indexed.message(cmd).substr(0, indexed.message(cmd).find("（索引"));
+    ASSERT_STR_EQ(list, plain.message(cmd).substr(0, plain.message(cmd).find("\n")));
+
+    fileMgr.close();
+    std::remove(path.c_str());
+    std::remove(outPath.c_str());
+    std::remove(indexPath.c_str());
+    return true;
+}
+
+REGISTER_TEST(TrigramIndex, TrigramIndex_Queries);
+REGISTER_TEST(TrigramIndex, TrigramIndex_Staleness);
+REGISTER_TEST(TrigramIndex, TrigramIndex_InsertInMiddle);
+REGISTER_TEST(TrigramIndex, TrigramIndex_Corrupt);
+REGISTER_TEST(TrigramIndex, TrigramIndex_BackgroundAndExecute);
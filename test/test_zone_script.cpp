@@ -0,0 +1,184 @@
+#include "../include/zone_script.h"
+#include "../include/editor.h"
+#include "../include/file_manager.h"
+#include "test_framework.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace line_editor;
+
+namespace {
+
+std::string tempPath(const std::string& name) {
+    const char* dir = std::getenv("TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/line_editor_zone_" + name;
+}
+
+void writeFile(const std::string& path, const std::string& content) {
+    std::ofstream out(path, std::ios::binary);
+    out << content;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+struct Run {
+    ZoneScriptStats stats;
+    std::string data;
+    std::string results;
+    std::string errors;
+};
+
+Run runZones(const std::string& input, const std::string& script, unsigned threads, size_t zonesPerJob) {
+    std::string inPath = tempPath("in.txt");
+    std::string outPath = tempPath("out.txt");
+    writeFile(inPath, input);
+
+    ZoneScriptOptions options;
+    options.threads = threads;
+    options.zonesPerJob = zonesPerJob;
+    ZoneScript zoneScript(script, options);
+    FileManager fileMgr;
+    fileMgr.openInput(inPath);
+    fileMgr.openOutput(outPath);
+    std::ostringstream results;
+    std::ostringstream errors;
+    Run run;
+    run.stats = zoneScript.run(fileMgr, results, errors);
+    fileMgr.close();
+    run.data = readFile(outPath);
+    run.results = results.str();
+    run.errors = errors.str();
+
+    std::remove(inPath.c_str());
+    std::remove(outPath.c_str());
+    return run;
+}
+
+std::string sampleInput(int lines) {
+    std::string text;
+    for (int i = 0; i < lines; i++) {
+        text += "row " + std::to_string(i) + (i % 7 == 0 ? " ERROR disk" : " ok") + "\n";
+    }
+    return text;
+}
+
+} // anonymous namespace
+
+// Test: 多线程执行与单线程逐个活区执行的输出逐字节相同，单个活区与只含该活区的脚本模式相同
+TEST(ZoneScript_MatchesSequential) {
+    std::string input = sampleInput(1000);
+    std::string script = "i0\nheader\n\nd3 4\ns1 20@ok@OK@g\nmERROR\ni5 note\np\n";
+
+    Run single = runZones(input, script, 1, 1);
+    ASSERT_EQ(single.stats.failedLine, 0);
+    ASSERT_EQ(single.stats.zones, 13);
+    ASSERT_EQ(single.stats.linesRead, 1000);
+    for (unsigned threads : { 2u, 4u }) {
+        Run parallel = runZones(input, script, threads, 3);
+        ASSERT_EQ(parallel.stats.zones, 13);
+        ASSERT_STR_EQ(parallel.data, single.data);
+        ASSERT_STR_EQ(parallel.results, single.results);
+        ASSERT_TRUE(parallel.errors.empty());
+    }
+
+    // 逐个活区用脚本模式执行作为参考
+    std::string inPath = tempPath("zone.txt");
+    std::string outPath = tempPath("zone.out");
+    std::string data;
+    std::string results;
+    std::istringstream lines(input);
+    std::string line;
+    std::string zone;
+    int count = 0;
+    auto runReference = [&]() {
+        writeFile(inPath, zone);
+        Editor editor;
+        editor.init(inPath, outPath);
+        std::ostringstream out;
+        std::streambuf* oldOut = std::cout.rdbuf(out.rdbuf());
+        std::istringstream commands(script);
+        bool ok = editor.runScript(commands);
+        std::cout.rdbuf(oldOut);
+        data += readFile(outPath);
+        results += out.str();
+        zone.clear();
+        count = 0;
+        return ok;
+    };
+    while (std::getline(lines, line)) {
+        zone += line + "\n";
+        if (++count == ZONE_LOAD_LINES && !runReference()) {
+            return false;
+        }
+    }
+    if (count > 0 && !runReference()) {
+        return false;
+    }
+    ASSERT_STR_EQ(single.data, data);
+    ASSERT_STR_EQ(single.results, results);
+
+    std::remove(inPath.c_str());
+    std::remove(outPath.c_str());
+    return true;
+}
+
+// Test: 第一个出错的活区之前的结果照常写出，之后的活区不再执行
+TEST(ZoneScript_StopsAtFailedZone) {
+    std::string input;
+    for (int i = 0; i < 400; i++) {
+        input += i == 200 ? "missing\n" : "key=" + std::to_string(i) + "\n";
+    }
+    // 第 3 个活区的第 41 行没有 key
+    std::string script = "m=1\ns41@key@KEY@\n";
+    std::string expected;
+    for (unsigned threads : { 1u, 3u }) {
+        Run run = runZones(input, script, threads, 1);
+        ASSERT_EQ(run.stats.failedZone, 3);
+        ASSERT_EQ(run.stats.failedLine, 2);
+        ASSERT_TRUE(run.errors.find("错误: ") == 0);
+        // 第 3 个活区的 m 结果也已写出
+        ASSERT_EQ(std::count(run.results.begin(), run.results.end(), '\n'), 3);
+        if (expected.empty()) {
+            expected = run.results;
+        }
+        ASSERT_STR_EQ(run.results, expected);
+    }
+    return true;
+}
+
+// Test: 跨活区的命令在执行前就被拒绝；插入的文本不当作命令检查
+TEST(ZoneScript_RejectsZoneCrossing) {
+    // q 只能结束当前活区的脚本，其后的活区仍会被编辑
+    for (const char* script : { "p\nn\n", "d1\ng100\n", "M/x/\n", "s1@1@X@\nq\n" }) {
+        try {
+            ZoneScript zoneScript(script);
+            return false;
+        } catch (const EditorException& e) {
+            ASSERT_TRUE(std::string(e.what()).find("跨活区") != std::string::npos);
+        }
+    }
+    try {
+        ZoneScript zoneScript("p\ng100\n");
+        return false;
+    } catch (const EditorException& e) {
+        ASSERT_TRUE(std::string(e.what()).find("脚本第 2 行") == 0);
+    }
+    ZoneScript inserts("i1\nn\ng2\nq\n\np\n");
+    ASSERT_TRUE(inserts.options().threads > 0);
+    return true;
+}
+
+REGISTER_TEST(ZoneScript, ZoneScript_MatchesSequential);
+REGISTER_TEST(ZoneScript, ZoneScript_StopsAtFailedZone);
+REGISTER_TEST(ZoneScript, ZoneScript_RejectsZoneCrossing);